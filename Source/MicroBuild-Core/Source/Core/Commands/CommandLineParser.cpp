@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Commands/CommandArgument.h"
 #include "Core/Commands/Command.h"
 #include "Core/Helpers/Strings.h"
+#include "Core/Helpers/Time.h"
 
 #include "FreeImage.h"
 
@@ -66,6 +67,10 @@ bool CommandLineParser::PreParse(int argc, char* argv[])
 		{
 			LogSetSilent(true);
 		}
+		else if (commandName.find("--trace=") == 0)
+		{
+			Time::StartTrace(commandName.substr(strlen("--trace=")));
+		}
 	}
 
 	return true;
@@ -80,6 +85,12 @@ bool CommandLineParser::Parse(int argc, char* argv[])
 		{
 			const char* commandName = argv[i];
 
+			// Trace option is handled during pre-parse.
+			if (strncmp(commandName, "--trace=", strlen("--trace=")) == 0)
+			{
+				continue;
+			}
+
 			// Skip the - and -- at the start of the command name.
 			if (strcmp(commandName, "-") == 0)
 			{
@@ -123,6 +134,11 @@ bool CommandLineParser::Parse(int argc, char* argv[])
 					i++;
 					continue;
 				}
+				else if (argumentName.find("--trace=") == 0)
+				{
+					i++;
+					continue;
+				}
 
 				// Command seperator.
 				if (argumentName == ";")
@@ -367,6 +383,14 @@ void CommandLineParser::PrintHelp()
 	}
 	Log(LogSeverity::Info, "\t%s\n",
 		silentExampleString.c_str());
+
+	std::string traceExampleString = "--trace=<file>";
+	while (traceExampleString.size() < CommandArgumentBase::ExampleStringPadding)
+	{
+		traceExampleString.push_back(' ');
+	}
+	Log(LogSeverity::Info, "\t%s\n",
+		traceExampleString.c_str());
 }
 
 }; // namespace MicroBuild
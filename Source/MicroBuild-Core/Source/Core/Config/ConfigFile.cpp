@@ -23,20 +23,228 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Platform/Platform.h"
 #include "Core/Helpers/Strings.h"
 #include "Core/Helpers/Time.h"
+#include "Core/Helpers/BinaryBuffer.h"
 
 #include <sstream>
 
 namespace MicroBuild {
 
+namespace {
+
+// Results of operators, same as the text the results have always been 
+// converted to so they compare equal to literal 1's and 0's.
+const std::string g_trueResult = "1";
+const std::string g_falseResult = "0";
+
+// Source of the ids that identify which group map a group or key belongs to.
+std::atomic<uint64_t> g_nextGroupsOwner(1);
+
+bool ResultToBool(const std::string* result)
+{
+	if (result == &g_trueResult)
+	{
+		return true;
+	}
+	else if (result == &g_falseResult)
+	{
+		return false;
+	}
+	return ((float)atof(result->c_str()) != 0);
+}
+
+float ResultToFloat(const std::string* result)
+{
+	return (float)atof(result->c_str());
+}
+
+void CompileExpression(
+	const ConfigFileExpression& expression,
+	ConfigFileCondition& condition)
+{
+	ConfigFileCondition::Instruction instruction;
+	instruction.Operator = expression.Operator;
+	instruction.Invert = expression.Invert;
+
+	switch (expression.Operator)
+	{
+	case TokenType::Expression:
+		{
+			assert(expression.Children.size() == 1);
+			CompileExpression(expression.Children[0], condition);
+
+			// Only does anything if the result needs inverting.
+			if (!expression.Invert)
+			{
+				return;
+			}
+			break;
+		}
+	case TokenType::Not:
+		{
+			assert(expression.Children.size() == 1);
+			CompileExpression(expression.Children[0], condition);
+			break;
+		}
+	case TokenType::Greater:
+	case TokenType::GreaterEqual:
+	case TokenType::Less:
+	case TokenType::LessEqual:
+	case TokenType::Equal:
+	case TokenType::NotEqual:
+	case TokenType::MatchEqual:
+	case TokenType::And:
+	case TokenType::Or:
+		{
+			assert(expression.Children.size() == 2);
+			CompileExpression(expression.Children[0], condition);
+			CompileExpression(expression.Children[1], condition);
+			break;
+		}
+	case TokenType::Literal:
+		{
+			assert(expression.Children.size() == 0);
+			instruction.Operand = (uint32_t)condition.Literals.size();
+			condition.Literals.push_back(expression.Value);
+			break;
+		}
+	default:
+		{
+			// Evaluates to false, operands are never looked at.
+			instruction.Operator = TokenType::Unknown;
+			break;
+		}
+	}
+
+	condition.Instructions.push_back(instruction);
+}
+
+void WriteCondition(BinaryBufferWriter& writer, const ConfigFileCondition& condition)
+{
+	writer.Write<uint32_t>((uint32_t)condition.Instructions.size());
+	for (const ConfigFileCondition::Instruction& instruction : condition.Instructions)
+	{
+		writer.Write<int32_t>((int32_t)instruction.Operator);
+		writer.Write<uint8_t>(instruction.Invert ? 1 : 0);
+		writer.Write<uint32_t>(instruction.Operand);
+	}
+
+	writer.Write<uint32_t>((uint32_t)condition.Literals.size());
+	for (const std::string& literal : condition.Literals)
+	{
+		writer.WriteString(literal);
+	}
+}
+
+bool ReadCondition(BinaryBufferReader& reader, ConfigFileCondition& condition)
+{
+	uint32_t instructionCount = 0;
+	if (!reader.Read(instructionCount))
+	{
+		return false;
+	}
+
+	// Operands are checked once the literals are read, so a malformed 
+	// condition can't push anything out of bounds or underflow the stack.
+	size_t stackDepth = 0;
+
+	condition.Instructions.resize(instructionCount);
+	for (ConfigFileCondition::Instruction& instruction : condition.Instructions)
+	{
+		int32_t op = 0;
+		uint8_t invert = 0;
+
+		if (!reader.Read(op) ||
+			!reader.Read(invert) ||
+			!reader.Read(instruction.Operand))
+		{
+			return false;
+		}
+
+		instruction.Operator = (TokenType)op;
+		instruction.Invert = (invert != 0);
+
+		switch (instruction.Operator)
+		{
+		case TokenType::Literal:
+		case TokenType::Unknown:
+			{
+				stackDepth++;
+				break;
+			}
+		case TokenType::Expression:
+		case TokenType::Not:
+			{
+				if (stackDepth < 1)
+				{
+					return false;
+				}
+				break;
+			}
+		case TokenType::If:
+			{
+				if (stackDepth < 1)
+				{
+					return false;
+				}
+				stackDepth--;
+				break;
+			}
+		default:
+			{
+				if (stackDepth < 2)
+				{
+					return false;
+				}
+				stackDepth--;
+				break;
+			}
+		}
+	}
+
+	uint32_t literalCount = 0;
+	if (!reader.Read(literalCount))
+	{
+		return false;
+	}
+
+	condition.Literals.resize(literalCount);
+	for (std::string& literal : condition.Literals)
+	{
+		if (!reader.ReadString(literal))
+		{
+			return false;
+		}
+	}
+
+	for (const ConfigFileCondition::Instruction& instruction : condition.Instructions)
+	{
+		if (instruction.Operator == TokenType::Literal &&
+			instruction.Operand >= literalCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}; // namespace
+
 ConfigFile::ConfigFile()
 	: m_tokenIndex(0)
+	, m_groups(std::make_shared<ConfigFileGroupMap>())
+	, m_groupsOwner(g_nextGroupsOwner++)
+	, m_bGroupsShared(false)
 {
 }
 
 ConfigFile::ConfigFile(const ConfigFile& other)
 	: m_path(other.m_path)
+	, m_sourceFiles(other.m_sourceFiles)
 	, m_tokenIndex(0)
 	, m_currentGroup("")
+	, m_groupsOwner(0)
+	, m_bGroupsShared(false)
 {
 	CopyFrom(other);
 }
@@ -48,66 +256,87 @@ ConfigFile::~ConfigFile()
 
 void ConfigFile::Clear()
 {
-	for (auto groupIter : m_groups)
-	{
-		for (auto keyIter : groupIter.second->Keys)
-		{
-			for (auto valueIter : keyIter.second->Values)
-			{
-				delete valueIter;
-			}
-
-			delete keyIter.second;
-		}
-
-		delete groupIter.second;
-	}
-
-	m_groups.clear();
+	m_groups = std::make_shared<ConfigFileGroupMap>();
+	m_groupsOwner = g_nextGroupsOwner++;
+	m_bGroupsShared = false;
+	m_valueStates.clear();
 }
 
 void ConfigFile::operator=(const ConfigFile& other)
 {
 	m_path = other.m_path;
+	m_sourceFiles = other.m_sourceFiles;
 	CopyFrom(other);
 }
 
 void ConfigFile::CopyFrom(const ConfigFile& other)
 {
-	Clear();
+	// Groups are shared until one of the files modifies them, so only the
+	// resolve state needs copying.
+	m_groups = other.m_groups;
+	m_groupsOwner = other.m_groupsOwner;
+	m_bGroupsShared = true;
+	other.m_bGroupsShared = true;
+	m_valueStates = other.m_valueStates;
+	m_environmentLookups = other.m_environmentLookups;
+}
 
-	for (auto groupIter : other.m_groups)
+ConfigFileGroup* ConfigFile::GetMutableGroup(const std::string& group)
+{
+	if (m_bGroupsShared)
 	{
-		ConfigFileGroup* group = new ConfigFileGroup();
-		group->Name = groupIter.second->Name;
-
-		for (auto keyIter : groupIter.second->Keys)
-		{
-			ConfigFileKey* key = new ConfigFileKey();
-			key->Name = keyIter.second->Name;
+		m_groups = std::make_shared<ConfigFileGroupMap>(*m_groups);
+		m_groupsOwner = g_nextGroupsOwner++;
+		m_bGroupsShared = false;
+	}
 
-			for (auto valueIter : keyIter.second->Values)
-			{
-				ConfigFileValue* keyValue = new ConfigFileValue();
-				keyValue->Value = valueIter->Value;
-				keyValue->Conditions = valueIter->Conditions;
-				keyValue->ConditionResult = valueIter->ConditionResult;
-				keyValue->HasResolvedCondition = valueIter->HasResolvedCondition;
-				keyValue->HasResolvedValue = valueIter->HasResolvedValue;
-				keyValue->ResolvedValue = valueIter->ResolvedValue;
-
-				key->Values.push_back(keyValue);
-			}
+	std::shared_ptr<ConfigFileGroup>& result = (*m_groups)[group];
+	if (result == nullptr)
+	{
+		result = std::make_shared<ConfigFileGroup>();
+		result->Name = group;
+		result->Owner = m_groupsOwner;
+	}
+	else if (result->Owner != m_groupsOwner)
+	{
+		result = std::make_shared<ConfigFileGroup>(*result);
+		result->Owner = m_groupsOwner;
+	}
 
-			group->Keys.insert(
-				std::pair<std::string, ConfigFileKey*>(key->Name, key)
-				);
-		}
+	return result.get();
+}
 
-		m_groups.insert(
-			std::pair<std::string, ConfigFileGroup*>(group->Name, group)
-			);
+ConfigFileKey* ConfigFile::GetMutableKey(ConfigFileGroup* group, const std::string& key)
+{
+	std::shared_ptr<ConfigFileKey>& result = group->Keys[key];
+	if (result == nullptr)
+	{
+		result = std::make_shared<ConfigFileKey>();
+		result->Name = key;
+		result->Owner = m_groupsOwner;
+	}
+	else if (result->Owner != m_groupsOwner)
+	{
+		result = std::make_shared<ConfigFileKey>(*result);
+		result->Owner = m_groupsOwner;
 	}
+
+	return result.get();
+}
+
+std::shared_ptr<const ConfigFileValue> ConfigFile::CreateValue(
+	const std::string& value,
+	const std::shared_ptr<const ConfigFileCondition>& condition,
+	const ConfigFileValueState& state)
+{
+	std::shared_ptr<ConfigFileValue> result = std::make_shared<ConfigFileValue>();
+	result->Value = value;
+	result->Condition = condition;
+	result->StateIndex = m_valueStates.size();
+
+	m_valueStates.push_back(state);
+
+	return result;
 }
 
 bool ConfigFile::EndOfTokens()
@@ -220,14 +449,9 @@ bool ConfigFile::ParseGroup()
 
 	std::string groupName = CurrentToken().Literal;
 
-	auto iter = m_groups.find(groupName);
-	if (iter == m_groups.end())
+	if (m_groups->find(groupName) == m_groups->end())
 	{
-		ConfigFileGroup* group = new ConfigFileGroup();
-		group->Name = groupName;
-		m_groups.insert(
-			std::pair<std::string, ConfigFileGroup*>(groupName, group)
-		);
+		GetMutableGroup(groupName);
 	}
 
 	m_currentGroup = groupName;
@@ -248,27 +472,12 @@ bool ConfigFile::ParseAssignment()
 		return false;
 	}
 
-	ConfigFileValue* keyValue = new ConfigFileValue();
-	keyValue->Value = CurrentToken().Literal;
-	keyValue->Conditions = m_expressionStack;
-	keyValue->ConditionResult = true;
+	ConfigFileGroup* group = GetMutableGroup(m_currentGroup);
+	ConfigFileKey* key = GetMutableKey(group, keyName);
 
-	ConfigFileGroup* group = m_groups[m_currentGroup];
-
-	auto iter = group->Keys.find(keyName);
-	if (iter == group->Keys.end())
-	{
-		ConfigFileKey* key = new ConfigFileKey();
-		key->Name = keyName;
-		key->Values.push_back(keyValue);
-		group->Keys.insert(
-			std::pair<std::string, ConfigFileKey*>(keyName, key)
-		);
-	}
-	else
-	{
-		iter->second->Values.push_back(keyValue);
-	}
+	key->Values.push_back(CreateValue(
+		CurrentToken().Literal,
+		m_conditionStack.empty() ? nullptr : m_conditionStack.back()));
 
 	return true;
 }
@@ -447,12 +656,14 @@ bool ConfigFile::ParseIf()
 	}
 	
 	m_expressionStack.push_back(condition);
+	m_conditionStack.push_back(CompileConditions());
 
 	if (!ParseBlock())
 	{
 		return false;
 	}
 
+	m_conditionStack.pop_back();
 	m_expressionStack.pop_back();
 	
 	if (!ExpectToken(TokenType::Close_Brace))
@@ -466,6 +677,7 @@ bool ConfigFile::ParseIf()
 
 		condition.Invert = !condition.Invert;
 		m_expressionStack.push_back(condition);
+		m_conditionStack.push_back(CompileConditions());
 
 		if (PeekToken().Type == TokenType::If)
 		{
@@ -490,6 +702,7 @@ bool ConfigFile::ParseIf()
 			}
 		}
 
+		m_conditionStack.pop_back();
 		m_expressionStack.pop_back();
 
 	}
@@ -497,6 +710,22 @@ bool ConfigFile::ParseIf()
 	return true;
 }
 
+std::shared_ptr<const ConfigFileCondition> ConfigFile::CompileConditions()
+{
+	std::shared_ptr<ConfigFileCondition> result = std::make_shared<ConfigFileCondition>();
+
+	for (const ConfigFileExpression& expression : m_expressionStack)
+	{
+		CompileExpression(expression, *result);
+
+		ConfigFileCondition::Instruction instruction;
+		instruction.Operator = TokenType::If;
+		result->Instructions.push_back(instruction);
+	}
+
+	return result;
+}
+
 bool ConfigFile::ParseBlock()
 {
 	for(;;)
@@ -565,15 +794,13 @@ bool ConfigFile::Parse(
 	m_path = path;
 	m_tokenIndex = 0;
 	m_currentGroup = "";
-	m_groups.clear();
 	m_expressionStack.clear();
+	m_conditionStack.clear();
+
+	Clear();
 
 	// Insert the global group.
-	ConfigFileGroup* globalGroup = new ConfigFileGroup();
-	globalGroup->Name = "";
-	m_groups.insert(
-		std::pair<std::string, ConfigFileGroup*>(globalGroup->Name, globalGroup)
-	);
+	GetMutableGroup("");
 
 	// Break the file down into tokens.
 	if (!m_tokenizer.Tokenize(path, includePaths))
@@ -581,10 +808,13 @@ bool ConfigFile::Parse(
 		return false;
 	}
 
+	m_sourceFiles = m_tokenizer.GetFiles();
+
 	// Parse tokens into a key/value representation.
 	{
 		Time::TimedScope scope(
-			Strings::Format("[%s] Parsing", path.ToString().c_str())
+			Strings::Format("[%s] Parsing", path.ToString().c_str()),
+			"Config"
 		);
 
 		while (!EndOfTokens())
@@ -607,13 +837,13 @@ bool ConfigFile::Serialize(const Platform::Path& path)
 	stream << "; Modifying this file manually may cause incorrect functionality.\n";
 	stream << "\n";
 
-	for (auto groupIter : m_groups)
+	for (auto& groupIter : *m_groups)
 	{
 		stream << "[" << groupIter.second->Name << "]\n";
 
-		for (auto keyIter : groupIter.second->Keys)
+		for (auto& keyIter : groupIter.second->Keys)
 		{
-			for (auto valueIter : keyIter.second->Values)
+			for (auto& valueIter : keyIter.second->Values)
 			{
 				stream << keyIter.second->Name << "=" << valueIter->Value  << "\n";
 			}
@@ -631,8 +861,13 @@ void ConfigFile::SetOrAddValue(
 	const std::string& value,
 	bool bOverwrite)
 {
-	std::vector<std::string> values;
-	values.push_back(value);
+	if (bOverwrite && HasOnlyValues(group, key, &value, 1))
+	{
+		return;
+	}
+
+	std::vector<std::shared_ptr<const ConfigFileValue>> values;
+	values.push_back(CreateValue(value, nullptr));
 
 	SetOrAddValue_Internal(group, key, values, bOverwrite);
 }
@@ -643,83 +878,102 @@ void ConfigFile::SetOrAddValue(
 	const std::vector<std::string>& value,
 	bool bOverwrite)
 {
-	SetOrAddValue_Internal(group, key, value, bOverwrite);
+	if (bOverwrite && HasOnlyValues(group, key, value.data(), value.size()))
+	{
+		return;
+	}
+
+	std::vector<std::shared_ptr<const ConfigFileValue>> values;
+	values.reserve(value.size());
+
+	for (const std::string& subValue : value)
+	{
+		values.push_back(CreateValue(subValue, nullptr));
+	}
+
+	SetOrAddValue_Internal(group, key, values, bOverwrite);
+}
+
+bool ConfigFile::HasOnlyValues(
+	const std::string& group,
+	const std::string& key,
+	const std::string* values,
+	size_t valueCount) const
+{
+	auto groupIter = m_groups->find(group);
+	if (groupIter == m_groups->end())
+	{
+		return false;
+	}
+
+	auto keyIter = groupIter->second->Keys.find(key);
+	if (keyIter == groupIter->second->Keys.end() ||
+		keyIter->second->Values.size() != valueCount)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < valueCount; i++)
+	{
+		const ConfigFileValue* value = keyIter->second->Values[i].get();
+		if (value->Condition != nullptr || value->Value != values[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
 }
 
-std::vector<ConfigFileValue*> ConfigFile::SetOrAddValue_Internal(
+void ConfigFile::SetOrAddValue_Internal(
 	const std::string& group,
 	const std::string& key,
-	const std::vector<std::string>& values,
+	const std::vector<std::shared_ptr<const ConfigFileValue>>& values,
 	bool bOverwrite,
 	bool bAddAtStart)
 {
-	// Create group if it dosen't exist.
-	auto iter = m_groups.find(group);
-	if (iter == m_groups.end())
-	{
-		ConfigFileGroup* newGroup = new ConfigFileGroup();
-		newGroup->Name = group;
-		m_groups.insert(
-			std::pair<std::string, ConfigFileGroup*>(newGroup->Name, newGroup)
-		);
-	}
+	// Create group and key if they don't exist.
+	ConfigFileGroup* realGroup = GetMutableGroup(group);
+	ConfigFileKey* realKey = GetMutableKey(realGroup, key);
 
-	std::vector<ConfigFileValue*> keyValues;
-	for (const std::string& value : values)
+	if (bOverwrite)
 	{
-		ConfigFileValue* keyValue = new ConfigFileValue();
-		keyValue->Value = value;
-		keyValue->ConditionResult = true;
-		keyValues.push_back(keyValue);
+		realKey->Values.clear();
 	}
-	
-	ConfigFileGroup* realGroup = m_groups[group];
 
-	// Create key if it dosesn't exist, otherwise add it.
-	auto keyIter = realGroup->Keys.find(key);
-	if (keyIter == realGroup->Keys.end())
+	if (bAddAtStart)
 	{
-		ConfigFileKey* newKey = new ConfigFileKey();
-		newKey->Name = key;
-		newKey->Values.insert(
-			newKey->Values.end(), keyValues.begin(), keyValues.end()
+		realKey->Values.insert(
+			realKey->Values.begin(), values.begin(), values.end()
 		);
-		realGroup->Keys.insert(
-			std::pair<std::string, ConfigFileKey*>(newKey->Name, newKey)
-			);
 	}
 	else
 	{
-		if (bOverwrite)
-		{
-			for (auto subIter : keyIter->second->Values)
-			{
-				delete subIter;
-			}
-			keyIter->second->Values.clear();
-		}
-
-		if (bAddAtStart)
-		{
-			keyIter->second->Values.insert(
-				keyIter->second->Values.begin(), keyValues.begin(), keyValues.end()
-			);
-		}
-		else
-		{
-			keyIter->second->Values.insert(
-				keyIter->second->Values.end(), keyValues.begin(), keyValues.end()
-			);
-		}
+		realKey->Values.insert(
+			realKey->Values.end(), values.begin(), values.end()
+		);
 	}
-
-	return keyValues;
 }
 
 bool ConfigFile::ResolveTokenReplacement(
 	const std::string& key,
 	const std::string& group,
 	std::string& result)
+{
+	const std::string* value = FindTokenReplacement(key, group);
+	if (value == nullptr)
+	{
+		result = "";
+		return false;
+	}
+
+	result = *value;
+	return true;
+}
+
+const std::string* ConfigFile::FindTokenReplacement(
+	const std::string& key,
+	const std::string& group)
 {
 	std::string finalKey = key;
 	std::string finalGroup = group;
@@ -735,19 +989,17 @@ bool ConfigFile::ResolveTokenReplacement(
 		bIsExplicitGroup = true;
 	}
 
-	result = "";
-
-	auto iter = m_groups.find(finalGroup);
-	if (iter != m_groups.end())
+	auto iter = m_groups->find(finalGroup);
+	if (iter != m_groups->end())
 	{
-		ConfigFileGroup* newGroup = iter->second;
+		const ConfigFileGroup* newGroup = iter->second.get();
 		auto keyIter = newGroup->Keys.find(finalKey);
 		
 		// If key is not in the group we are in, and group was not
 		// explicitly set, then try and find it in the global scope.
 		if (keyIter == newGroup->Keys.end() && !bIsExplicitGroup)
 		{
-			newGroup = m_groups.at("");
+			newGroup = m_groups->at("").get();
 			keyIter = newGroup->Keys.find(finalKey);
 		}
 		
@@ -755,301 +1007,255 @@ bool ConfigFile::ResolveTokenReplacement(
 		{
 			for (auto viter = keyIter->second->Values.rbegin(); viter != keyIter->second->Values.rend(); viter++)
 			{
-				ConfigFileValue* value = *viter;
+				const ConfigFileValue* value = viter->get();
 
-				if (!value->HasResolvedCondition)
+				if (!m_valueStates[value->StateIndex].HasResolvedCondition)
 				{
-					value->HasResolvedCondition = true;
-					value->ConditionResult = EvaluateConditions(
-						value->Conditions, newGroup->Name);
+					bool bConditionResult = EvaluateCondition(
+						value->Condition.get(), newGroup->Name);
+
+					m_valueStates[value->StateIndex].HasResolvedCondition = true;
+					m_valueStates[value->StateIndex].ConditionResult = bConditionResult;
 				}
 
-				if (value->ConditionResult)
+				if (m_valueStates[value->StateIndex].ConditionResult)
 				{
-					if (!value->HasResolvedValue)
+					if (!m_valueStates[value->StateIndex].HasResolvedValue)
 					{
-						value->HasResolvedValue = true;
-						value->ResolvedValue = ReplaceTokens(
+						std::string resolvedValue = ReplaceTokens(
 							value->Value,
 							newGroup->Name
 						);
-					}
 
-					result = value->ResolvedValue;
+						m_valueStates[value->StateIndex].HasResolvedValue = true;
+						m_valueStates[value->StateIndex].ResolvedValue = resolvedValue;
+					}
 
-					return true;
+					return &m_valueStates[value->StateIndex].ResolvedValue;
 				}
 			}
 		}
 	}
 
-	return false;
+	return nullptr;
 }
 
-std::string ConfigFile::ReplaceTokens(
-	const std::string& value,
-	const std::string& baseGroup
-	)
+const std::string& ConfigFile::ResolveToken(
+	const std::string& key,
+	const std::string& baseGroup)
 {
-	std::string result = value;
+	std::pair<std::string, std::string> tokenKey(baseGroup, key);
 
-	for(;;)
+	auto iter = m_resolvedTokens.find(tokenKey);
+	if (iter != m_resolvedTokens.end())
 	{
-		size_t start_offset = result.find("$(");
-		if (start_offset != std::string::npos)
-		{
-			size_t end_offset = result.find(")", start_offset);
-			
-			std::string key = result.substr(
-				start_offset + 2,
-				(end_offset - start_offset) - 2);
-
-			std::string resolvedToken;
-			bool res = ResolveTokenReplacement(
-				key, 
-				baseGroup,
-				resolvedToken);
-
-			if (!res)
-			{
-				std::string envVar = Platform::GetEnvironmentVariable(key);
-				if (!envVar.empty())
-				{
-					resolvedToken = envVar;
-				}
-				else
-				{
-					// todo: emit a warning here?
-					resolvedToken = "[Invalid Token Expansion]";
-				}	
-			}
+		return iter->second;
+	}
+
+	std::string resolvedToken;
+	bool res = ResolveTokenReplacement(
+		key, 
+		baseGroup,
+		resolvedToken);
 
-			result.erase(
-				result.begin() + start_offset,
-				result.begin() + end_offset + 1);
+	if (!res)
+	{
+		std::string envVar = Platform::GetEnvironmentVariable(key);
+		m_environmentLookups.insert(key);
 
-			result.insert(
-				start_offset, 
-				resolvedToken);
+		if (!envVar.empty())
+		{
+			resolvedToken = envVar;
 		}
 		else
 		{
-			break;
-		}
+			// todo: emit a warning here?
+			resolvedToken = "[Invalid Token Expansion]";
+		}	
 	}
 
-	return result;
+	return m_resolvedTokens[tokenKey] = resolvedToken;
 }
 
-ConfigFileExpressionResult ConfigFile::EvaluateExpression(
-	ConfigFileExpression& expression,
-	const std::string& baseGroup)
+std::string ConfigFile::ReplaceTokens(
+	const std::string& value,
+	const std::string& baseGroup
+	)
 {
-	ConfigFileExpressionResult result;
-
-	switch (expression.Operator)
+	size_t startOffset = value.find("$(");
+	if (startOffset == std::string::npos)
 	{
-	case TokenType::Expression:
-		{
-			assert(expression.Children.size() == 1);
-			result = EvaluateExpression(expression.Children[0], baseGroup);
-			break;
-		}
-	case TokenType::Not:
-		{
-			assert(expression.Children.size() == 1);
-			result = EvaluateExpression(expression.Children[0], baseGroup);
-			result = !result.ToBool();
-			break;
-		}
-	case TokenType::Greater:
-		{
-			assert(expression.Children.size() == 2);
+		return value;
+	}
 
-			ConfigFileExpressionResult lValueResult =
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
+	// Copy everything between tokens to the output in a single pass, rather
+	// than editing the value in place once per token.
+	std::string result;
+	result.reserve(value.size());
 
-			result = (lValueResult.ToFloat() > rValueResult.ToFloat());
+	size_t offset = 0;
 
-			break;
-		}
-	case TokenType::GreaterEqual:
+	while (startOffset != std::string::npos)
+	{
+		size_t endOffset = value.find(')', startOffset);
+		if (endOffset == std::string::npos)
 		{
-			assert(expression.Children.size() == 2);
-
-			ConfigFileExpressionResult lValueResult =
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
-
-			result = (lValueResult.ToFloat() >= rValueResult.ToFloat());
-
 			break;
 		}
-	case TokenType::Less:
-		{
-			assert(expression.Children.size() == 2);
 
-			ConfigFileExpressionResult lValueResult =
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
+		result.append(value, offset, startOffset - offset);
+		result += ResolveToken(
+			value.substr(startOffset + 2, (endOffset - startOffset) - 2),
+			baseGroup);
 
-			result = (lValueResult.ToFloat() < rValueResult.ToFloat());
-
-			break;
-		}
-	case TokenType::LessEqual:
-		{
-			assert(expression.Children.size() == 2);
+		offset = endOffset + 1;
+		startOffset = value.find("$(", offset);
+	}
 
-			ConfigFileExpressionResult lValueResult =
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
+	result.append(value, offset, std::string::npos);
 
-			result = (lValueResult.ToFloat() <= rValueResult.ToFloat());
+	return result;
+}
 
-			break;
-		}
-	case TokenType::Equal:
-		{
-			assert(expression.Children.size() == 2);
+bool ConfigFile::EvaluateCondition(
+	const ConfigFileCondition* condition,
+	const std::string& groupName)
+{
+	if (condition == nullptr)
+	{
+		return true;
+	}
 
-			ConfigFileExpressionResult lValueResult =
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
+	// Literals can resolve keys with conditions of their own, which get 
+	// evaluated above ours on the stack, so it's only accessed by index.
+	size_t base = m_evaluationStack.size();
+	bool bResult = true;
 
-			result = (lValueResult.Result == rValueResult.Result);
+	for (const ConfigFileCondition::Instruction& instruction : condition->Instructions)
+	{
+		const std::string* result = nullptr;
 
-			break;
-		}
-	case TokenType::NotEqual:
+		switch (instruction.Operator)
 		{
-			assert(expression.Children.size() == 2);
+		case TokenType::If:
+			{
+				bResult = ResultToBool(m_evaluationStack.back());
+				m_evaluationStack.pop_back();
+				break;
+			}
+		case TokenType::Literal:
+			{
+				const std::string& literal = condition->Literals[instruction.Operand];
+				result = FindTokenReplacement(literal, groupName);
+				if (result == nullptr)
+				{
+					result = &literal;
+				}
+				break;
+			}
+		case TokenType::Expression:
+			{
+				result = m_evaluationStack.back();
+				m_evaluationStack.pop_back();
+				break;
+			}
+		case TokenType::Not:
+			{
+				result = ResultToBool(m_evaluationStack.back()) ? &g_falseResult : &g_trueResult;
+				m_evaluationStack.pop_back();
+				break;
+			}
+		case TokenType::Unknown:
+			{
+				result = &g_falseResult;
+				break;
+			}
+		default:
+			{
+				const std::string* rValue = m_evaluationStack.back();
+				m_evaluationStack.pop_back();
+				const std::string* lValue = m_evaluationStack.back();
+				m_evaluationStack.pop_back();
 
-			ConfigFileExpressionResult lValueResult =
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
+				bool bValue = false;
 
-			result = (lValueResult.Result != rValueResult.Result);
+				switch (instruction.Operator)
+				{
+				case TokenType::Greater:
+					bValue = (ResultToFloat(lValue) > ResultToFloat(rValue));
+					break;
+				case TokenType::GreaterEqual:
+					bValue = (ResultToFloat(lValue) >= ResultToFloat(rValue));
+					break;
+				case TokenType::Less:
+					bValue = (ResultToFloat(lValue) < ResultToFloat(rValue));
+					break;
+				case TokenType::LessEqual:
+					bValue = (ResultToFloat(lValue) <= ResultToFloat(rValue));
+					break;
+				case TokenType::Equal:
+					bValue = (*lValue == *rValue);
+					break;
+				case TokenType::NotEqual:
+					bValue = (*lValue != *rValue);
+					break;
+				case TokenType::MatchEqual:
+					bValue = Strings::IsMatch(*lValue, *rValue);
+					break;
+				case TokenType::And:
+					bValue = ResultToBool(lValue) && ResultToBool(rValue);
+					break;
+				case TokenType::Or:
+					bValue = ResultToBool(lValue) || ResultToBool(rValue);
+					break;
+				default:
+					break;
+				}
 
-			break;
+				result = bValue ? &g_trueResult : &g_falseResult;
+				break;
+			}
 		}
-	case TokenType::MatchEqual:
-		{
-			assert(expression.Children.size() == 2);
-
-			ConfigFileExpressionResult lValueResult =
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
 
-			result = Strings::IsMatch(lValueResult.Result, rValueResult.Result);
-
-			break;
-		}
-	case TokenType::And:
+		if (!bResult)
 		{
-			assert(expression.Children.size() == 2);
-
-			ConfigFileExpressionResult lValueResult =
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
-
-			result = lValueResult.ToBool() && rValueResult.ToBool();
-
 			break;
 		}
-	case TokenType::Or:
-		{
-			assert(expression.Children.size() == 2);
 
-			ConfigFileExpressionResult lValueResult = 
-				EvaluateExpression(expression.Children[0], baseGroup);
-			ConfigFileExpressionResult rValueResult =
-				EvaluateExpression(expression.Children[1], baseGroup);
-
-			result = lValueResult.ToBool() || rValueResult.ToBool();
-
-			break;
-		}
-	case TokenType::Literal:
+		if (result != nullptr)
 		{
-			assert(expression.Children.size() == 0);
-
-			bool ret = ResolveTokenReplacement(
-				expression.Value, baseGroup, result.Result
-			);
-
-
-			if (!ret)
+			if (instruction.Invert)
 			{
-				result.Result = expression.Value;
+				result = ResultToBool(result) ? &g_falseResult : &g_trueResult;
 			}
 
-			break;
-		}
-		default:
-		{			
-			result = false;
+			m_evaluationStack.push_back(result);
 		}
 	}
 
-	if (expression.Invert)
-	{
-		result = !result.ToBool();
-	}
-
-	return result;
-}
-
-bool ConfigFile::EvaluateConditions(
-	std::vector<ConfigFileExpression>& conditions, 
-	std::string groupName)
-{
-	bool bResult = true;
-	
-	// todo: fix this, this should be totally unneccessary, without it
-	//		 at the moment we end up with some invalidated-iter problems.
-	std::vector<ConfigFileExpression> copy = conditions;
-
-	for (ConfigFileExpression& cond : copy)
-	{
-		if (!EvaluateExpression(cond, groupName).ToBool())
-		{
-			bResult = false;
-			break;
-		}
-	}
+	m_evaluationStack.resize(base);
 
 	return bResult;
 }
 
 void ConfigFile::Resolve()
 {
+	// Tokens can resolve differently once values have changed, so nothing
+	// is reused from a previous resolve.
+	m_resolvedTokens.clear();
+
 	// Go through each key value and do token replacement.
 	{
 		Time::TimedScope scope(
 			Strings::Format("[%s] Pre Resolve Setup",
-				m_path.ToString().c_str())
+				m_path.ToString().c_str()),
+			"Config"
 			);
 
-		for (auto groupIter : m_groups)
+		for (ConfigFileValueState& state : m_valueStates)
 		{
-			for (auto keyIter : groupIter.second->Keys)
-			{
-				for (auto valueIter : keyIter.second->Values)
-				{
-					valueIter->HasResolvedValue = false;
-					valueIter->HasResolvedCondition = false;
-				}
-			}
+			state.HasResolvedValue = false;
+			state.HasResolvedCondition = false;
 		}
 	}
 
@@ -1057,22 +1263,25 @@ void ConfigFile::Resolve()
 	{
 		Time::TimedScope scope(
 			Strings::Format("[%s] Expression Evaluation",
-				m_path.ToString().c_str())
+				m_path.ToString().c_str()),
+			"Config"
 			);
 
-		for (auto groupIter : m_groups)
+		for (auto& groupIter : *m_groups)
 		{
-			for (auto keyIter : groupIter.second->Keys)
+			for (auto& keyIter : groupIter.second->Keys)
 			{
-				for (auto valueIter : keyIter.second->Values)
+				for (auto& valueIter : keyIter.second->Values)
 				{
-					if (!valueIter->HasResolvedCondition)
+					if (!m_valueStates[valueIter->StateIndex].HasResolvedCondition)
 					{
-						valueIter->HasResolvedCondition = true;
-						valueIter->ConditionResult = EvaluateConditions(
-							valueIter->Conditions,
+						bool bConditionResult = EvaluateCondition(
+							valueIter->Condition.get(),
 							groupIter.second->Name
 						);
+
+						m_valueStates[valueIter->StateIndex].HasResolvedCondition = true;
+						m_valueStates[valueIter->StateIndex].ConditionResult = bConditionResult;
 					}
 				}
 			}
@@ -1083,36 +1292,57 @@ void ConfigFile::Resolve()
 	{
 		Time::TimedScope scope(
 			Strings::Format("[%s] Token Replacement",
-				m_path.ToString().c_str())
+				m_path.ToString().c_str()),
+			"Config"
 			);
 
-		for (auto groupIter : m_groups)
+		// Keys are shared with copies of this file, so renames are applied 
+		// once we are done iterating over them.
+		std::vector<std::pair<std::pair<std::string, std::string>, std::string>> resolvedKeyNames;
+
+		for (auto& groupIter : *m_groups)
 		{
-			for (auto keyIter : groupIter.second->Keys)
+			for (auto& keyIter : groupIter.second->Keys)
 			{
 				if (!keyIter.second->HasResolvedName)
 				{
-					keyIter.second->HasResolvedName = true;
-					keyIter.second->Name = ReplaceTokens(
+					std::string resolvedName = ReplaceTokens(
 						keyIter.second->Name,
 						groupIter.second->Name
 					);
+
+					if (resolvedName != keyIter.second->Name)
+					{
+						resolvedKeyNames.push_back(std::make_pair(std::make_pair(groupIter.first, keyIter.first), resolvedName));
+					}
 				}
 
-				for (auto valueIter : keyIter.second->Values)
+				for (auto& valueIter : keyIter.second->Values)
 				{
-					if (!valueIter->HasResolvedValue)
+					if (!m_valueStates[valueIter->StateIndex].HasResolvedValue)
 					{
-						valueIter->HasResolvedValue = true;
-						valueIter->ResolvedValue = ReplaceTokens(
+						std::string resolvedValue = ReplaceTokens(
 							valueIter->Value,
 							groupIter.second->Name
 						);
+
+						m_valueStates[valueIter->StateIndex].HasResolvedValue = true;
+						m_valueStates[valueIter->StateIndex].ResolvedValue = resolvedValue;
 					}
 				}
 			}
 		}
+
+		for (auto& resolvedKeyName : resolvedKeyNames)
+		{
+			ConfigFileGroup* group = GetMutableGroup(resolvedKeyName.first.first);
+			ConfigFileKey* key = GetMutableKey(group, resolvedKeyName.first.second);
+			key->HasResolvedName = true;
+			key->Name = resolvedKeyName.second;
+		}
 	}
+
+	m_resolvedTokens.clear();
 }
 
 std::vector<ConfigFile::KeyValuePair> ConfigFile::GetPairs(
@@ -1120,19 +1350,20 @@ std::vector<ConfigFile::KeyValuePair> ConfigFile::GetPairs(
 {
 	std::vector<ConfigFile::KeyValuePair> result;
 
-	auto iter = m_groups.find(group);
-	if (iter != m_groups.end())
+	auto iter = m_groups->find(group);
+	if (iter != m_groups->end())
 	{
-		ConfigFileGroup* newGroup = iter->second;
-		for (auto key : newGroup->Keys)
+		const ConfigFileGroup* newGroup = iter->second.get();
+		for (auto& key : newGroup->Keys)
 		{
-			for (auto value : key.second->Values)
+			for (auto& value : key.second->Values)
 			{
-				if (value->ConditionResult)
+				const ConfigFileValueState& state = m_valueStates[value->StateIndex];
+				if (state.ConditionResult)
 				{
 					ConfigFile::KeyValuePair pair(
 						key.second->Name,
-						value->ResolvedValue
+						state.ResolvedValue
 					);
 
 					result.push_back(pair);
@@ -1150,18 +1381,19 @@ std::vector<std::string> ConfigFile::GetValues(
 {
 	std::vector<std::string> result;
 
-	auto iter = m_groups.find(group);
-	if (iter != m_groups.end())
+	auto iter = m_groups->find(group);
+	if (iter != m_groups->end())
 	{
-		ConfigFileGroup* newGroup = iter->second;
+		const ConfigFileGroup* newGroup = iter->second.get();
 		auto keyIter = newGroup->Keys.find(key);
 		if (keyIter != newGroup->Keys.end())
 		{
-			for (const ConfigFileValue* value : keyIter->second->Values)
+			for (auto& value : keyIter->second->Values)
 			{
-				if (value->ConditionResult)
+				const ConfigFileValueState& state = m_valueStates[value->StateIndex];
+				if (state.ConditionResult)
 				{
-					result.push_back(value->ResolvedValue);
+					result.push_back(state.ResolvedValue);
 				}
 			}
 		}
@@ -1201,16 +1433,17 @@ std::vector<std::string> ConfigFile::GetUnresolvedValues(
 {
 	std::vector<std::string> result;
 
-	auto iter = m_groups.find(group);
-	if (iter != m_groups.end())
+	auto iter = m_groups->find(group);
+	if (iter != m_groups->end())
 	{
-		ConfigFileGroup* newGroup = iter->second;
+		const ConfigFileGroup* newGroup = iter->second.get();
 		auto keyIter = newGroup->Keys.find(key);
 		if (keyIter != newGroup->Keys.end())
 		{
-			for (const ConfigFileValue* value : keyIter->second->Values)
+			for (auto& value : keyIter->second->Values)
 			{
-				if (value->ConditionResult)
+				const ConfigFileValueState& state = m_valueStates[value->StateIndex];
+				if (state.ConditionResult)
 				{
 					result.push_back(value->Value);
 				}
@@ -1256,7 +1489,7 @@ bool ConfigFile::HasValue(
 
 void ConfigFile::Merge(const ConfigFile& file)
 {
-	for (auto& groupIter : file.m_groups)
+	for (auto& groupIter : *file.m_groups)
 	{
 		if (groupIter.second->bUnmergable)
 		{
@@ -1265,41 +1498,50 @@ void ConfigFile::Merge(const ConfigFile& file)
 
 		for (auto& keyIter : groupIter.second->Keys)
 		{
-			for (auto& valueIter : keyIter.second->Values)
+			// Values are added at the start one at a time, so they end up
+			// in front of our own values in reverse order.
+			std::vector<std::shared_ptr<const ConfigFileValue>> values;
+			values.reserve(keyIter.second->Values.size());
+
+			for (auto valueIter = keyIter.second->Values.rbegin(); valueIter != keyIter.second->Values.rend(); valueIter++)
 			{
-				std::vector<std::string> values;
-				values.push_back(valueIter->Value);
+				const ConfigFileValue* value = valueIter->get();
+
+				// The value has to be recreated in this file, as its resolve 
+				// state lives in the file it came from.
+				values.push_back(CreateValue(
+					value->Value, 
+					value->Condition, 
+					file.m_valueStates[value->StateIndex]));
+			}
 
-				std::vector<ConfigFileValue*> result = SetOrAddValue_Internal(groupIter.second->Name,
+			if (!values.empty())
+			{
+				SetOrAddValue_Internal(groupIter.second->Name,
 					keyIter.second->Name,
 					values,
 					false,
 					true);
-				
-				for (ConfigFileValue* value : result)
-				{
-					*value = ConfigFileValue(*valueIter);
-				}
 			}
 		}
 	}
+
+	m_environmentLookups.insert(
+		file.m_environmentLookups.begin(), 
+		file.m_environmentLookups.end());
 }
 
 void ConfigFile::SetGroupUnmergable(
 	const std::string& groupName,
 	bool bUnmergable)
 {
-	auto iter = m_groups.find(groupName);
-	if (iter == m_groups.end())
+	auto iter = m_groups->find(groupName);
+	if (iter != m_groups->end() && iter->second->bUnmergable == bUnmergable)
 	{
-		ConfigFileGroup* group = new ConfigFileGroup();
-		group->Name = groupName;
-		m_groups.insert(
-			std::pair<std::string, ConfigFileGroup*>(groupName, group)
-		);
+		return;
 	}
 
-	m_groups[groupName]->bUnmergable = bUnmergable;
+	GetMutableGroup(groupName)->bUnmergable = bUnmergable;
 }
 
 Platform::Path ConfigFile::GetPath() const
@@ -1307,4 +1549,270 @@ Platform::Path ConfigFile::GetPath() const
 	return m_path;
 }
 
-}; // namespace MicroBuild
\ No newline at end of file
+std::vector<Platform::Path> ConfigFile::GetSourceFiles() const
+{
+	return m_sourceFiles;
+}
+
+const std::set<std::string>& ConfigFile::GetEnvironmentLookups() const
+{
+	return m_environmentLookups;
+}
+
+void ConfigFile::WriteSnapshot(BinaryBufferWriter& writer) const
+{
+	writer.WriteString(m_path.ToString());
+
+	writer.Write<uint32_t>((uint32_t)m_sourceFiles.size());
+	for (const Platform::Path& path : m_sourceFiles)
+	{
+		writer.WriteString(path.ToString());
+	}
+
+	writer.Write<uint32_t>((uint32_t)m_environmentLookups.size());
+	for (const std::string& name : m_environmentLookups)
+	{
+		writer.WriteString(name);
+	}
+
+	// Conditions are shared between values, so they are written once and 
+	// referenced by index, zero being no condition.
+	std::vector<const ConfigFileCondition*> conditions;
+	std::map<const ConfigFileCondition*, uint32_t> conditionIndices;
+
+	for (auto& groupIter : *m_groups)
+	{
+		for (auto& keyIter : groupIter.second->Keys)
+		{
+			for (auto& value : keyIter.second->Values)
+			{
+				const ConfigFileCondition* condition = value->Condition.get();
+				if (condition != nullptr && conditionIndices.find(condition) == conditionIndices.end())
+				{
+					conditions.push_back(condition);
+					conditionIndices[condition] = (uint32_t)conditions.size();
+				}
+			}
+		}
+	}
+
+	writer.Write<uint32_t>((uint32_t)conditions.size());
+	for (const ConfigFileCondition* condition : conditions)
+	{
+		WriteCondition(writer, *condition);
+	}
+
+	writer.Write<uint32_t>((uint32_t)m_groups->size());
+	for (auto& groupIter : *m_groups)
+	{
+		const ConfigFileGroup& group = *groupIter.second;
+
+		writer.WriteString(groupIter.first);
+		writer.WriteString(group.Name);
+		writer.Write<uint8_t>(group.bUnmergable ? 1 : 0);
+
+		writer.Write<uint32_t>((uint32_t)group.Keys.size());
+		for (auto& keyIter : group.Keys)
+		{
+			const ConfigFileKey& key = *keyIter.second;
+
+			writer.WriteString(keyIter.first);
+			writer.WriteString(key.Name);
+			writer.Write<uint8_t>(key.HasResolvedName ? 1 : 0);
+
+			writer.Write<uint32_t>((uint32_t)key.Values.size());
+			for (auto& value : key.Values)
+			{
+				writer.WriteString(value->Value);
+				writer.Write<uint64_t>((uint64_t)value->StateIndex);
+
+				writer.Write<uint32_t>(value->Condition == nullptr ? 0 : conditionIndices[value->Condition.get()]);
+			}
+		}
+	}
+
+	writer.Write<uint32_t>((uint32_t)m_valueStates.size());
+	for (const ConfigFileValueState& state : m_valueStates)
+	{
+		writer.Write<uint8_t>(state.HasResolvedValue ? 1 : 0);
+		writer.WriteString(state.ResolvedValue);
+		writer.Write<uint8_t>(state.HasResolvedCondition ? 1 : 0);
+		writer.Write<uint8_t>(state.ConditionResult ? 1 : 0);
+	}
+}
+
+bool ConfigFile::ReadSnapshot(BinaryBufferReader& reader)
+{
+	Clear();
+	m_sourceFiles.clear();
+	m_environmentLookups.clear();
+
+	std::string path;
+	if (!reader.ReadString(path))
+	{
+		return false;
+	}
+	m_path = path;
+
+	uint32_t sourceFileCount = 0;
+	if (!reader.Read(sourceFileCount))
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < sourceFileCount; i++)
+	{
+		if (!reader.ReadString(path))
+		{
+			return false;
+		}
+		m_sourceFiles.push_back(path);
+	}
+
+	uint32_t lookupCount = 0;
+	if (!reader.Read(lookupCount))
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < lookupCount; i++)
+	{
+		std::string name;
+		if (!reader.ReadString(name))
+		{
+			return false;
+		}
+		m_environmentLookups.insert(name);
+	}
+
+	uint32_t conditionCount = 0;
+	if (!reader.Read(conditionCount))
+	{
+		return false;
+	}
+
+	std::vector<std::shared_ptr<const ConfigFileCondition>> conditions;
+	for (uint32_t i = 0; i < conditionCount; i++)
+	{
+		std::shared_ptr<ConfigFileCondition> condition = std::make_shared<ConfigFileCondition>();
+		if (!ReadCondition(reader, *condition))
+		{
+			return false;
+		}
+		conditions.push_back(condition);
+	}
+
+	uint32_t groupCount = 0;
+	if (!reader.Read(groupCount))
+	{
+		return false;
+	}
+
+	std::vector<size_t> stateIndices;
+
+	for (uint32_t i = 0; i < groupCount; i++)
+	{
+		std::string groupKey;
+		std::shared_ptr<ConfigFileGroup> group = std::make_shared<ConfigFileGroup>();
+		group->Owner = m_groupsOwner;
+		uint8_t unmergable = 0;
+		uint32_t keyCount = 0;
+
+		if (!reader.ReadString(groupKey) ||
+			!reader.ReadString(group->Name) ||
+			!reader.Read(unmergable) ||
+			!reader.Read(keyCount))
+		{
+			return false;
+		}
+
+		group->bUnmergable = (unmergable != 0);
+
+		for (uint32_t j = 0; j < keyCount; j++)
+		{
+			std::string keyKey;
+			std::shared_ptr<ConfigFileKey> key = std::make_shared<ConfigFileKey>();
+			key->Owner = m_groupsOwner;
+			uint8_t hasResolvedName = 0;
+			uint32_t valueCount = 0;
+
+			if (!reader.ReadString(keyKey) ||
+				!reader.ReadString(key->Name) ||
+				!reader.Read(hasResolvedName) ||
+				!reader.Read(valueCount))
+			{
+				return false;
+			}
+
+			key->HasResolvedName = (hasResolvedName != 0);
+			key->Values.reserve(valueCount);
+
+			for (uint32_t k = 0; k < valueCount; k++)
+			{
+				std::shared_ptr<ConfigFileValue> value = std::make_shared<ConfigFileValue>();
+				uint64_t stateIndex = 0;
+				uint32_t conditionIndex = 0;
+
+				if (!reader.ReadString(value->Value) ||
+					!reader.Read(stateIndex) ||
+					!reader.Read(conditionIndex) ||
+					conditionIndex > conditions.size())
+				{
+					return false;
+				}
+
+				value->StateIndex = (size_t)stateIndex;
+				if (conditionIndex > 0)
+				{
+					value->Condition = conditions[conditionIndex - 1];
+				}
+
+				stateIndices.push_back(value->StateIndex);
+				key->Values.push_back(value);
+			}
+
+			group->Keys[keyKey] = key;
+		}
+
+		(*m_groups)[groupKey] = group;
+	}
+
+	uint32_t stateCount = 0;
+	if (!reader.Read(stateCount))
+	{
+		return false;
+	}
+
+	m_valueStates.resize(stateCount);
+	for (ConfigFileValueState& state : m_valueStates)
+	{
+		uint8_t hasResolvedValue = 0;
+		uint8_t hasResolvedCondition = 0;
+		uint8_t conditionResult = 0;
+
+		if (!reader.Read(hasResolvedValue) ||
+			!reader.ReadString(state.ResolvedValue) ||
+			!reader.Read(hasResolvedCondition) ||
+			!reader.Read(conditionResult))
+		{
+			return false;
+		}
+
+		state.HasResolvedValue = (hasResolvedValue != 0);
+		state.HasResolvedCondition = (hasResolvedCondition != 0);
+		state.ConditionResult = (conditionResult != 0);
+	}
+
+	// Every value has to refer to a state we actually read.
+	for (size_t index : stateIndices)
+	{
+		if (index >= m_valueStates.size())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}; // namespace MicroBuild
@@ -22,57 +22,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Config/ConfigTokenizer.h"
 #include "Core/Helpers/StringConverter.h"
 
-namespace MicroBuild {
-
-// Result of an config file expression evaluation.
-struct ConfigFileExpressionResult
-{
-	std::string Result;
-
-	ConfigFileExpressionResult()
-		: Result("")
-	{
-	}
-
-	std::string ToString()
-	{
-		return Result;
-	}
-
-	float ToFloat()
-	{
-		return (float)atof(Result.c_str());
-	}
-
-	bool ToBool()
-	{
-		return (ToFloat() != 0);
-	}
-
-	void operator=(const float& lvalue)
-	{
-		char buffer[128];
-		sprintf(buffer, "%f", lvalue);
-		Result = buffer;
-	}
+#include <memory>
+#include <set>
+#include <atomic>
 
-	void operator=(const std::string& lvalue)
-	{
-		Result = lvalue;
-	}
-
-	void operator=(const int& lvalue)
-	{
-		char buffer[128];
-		sprintf(buffer, "%i", lvalue);
-		Result = buffer;
-	}
+namespace MicroBuild {
 
-	void operator=(const bool& lvalue)
-	{
-		Result = (lvalue ? "1" : "0");
-	}
-};
+class BinaryBufferWriter;
+class BinaryBufferReader;
 
 // A condition that determines if a key exists with the given defines/config.
 struct ConfigFileExpression
@@ -89,20 +46,64 @@ struct ConfigFileExpression
 	}
 };
 
-// An individual value associated with a key, and its conditionals.
+// The conditions a value is defined under, compiled when the file is parsed.
+// The expression trees of every enclosing if are flattened into postfix 
+// instructions that operate on a stack of strings, so evaluating them 
+// doesn't need to walk or copy the trees.
+struct ConfigFileCondition
+{
+	struct Instruction
+	{
+		// Literal pushes Literals[Operand] (or the value of the key it names), 
+		// operators pop their operands and push their result. If pops the 
+		// result of one if statements condition and stops evaluation if its
+		// false.
+		TokenType Operator;
+		bool Invert;
+		uint32_t Operand;
+
+		Instruction()
+			: Operator(TokenType::Unknown)
+			, Invert(false)
+			, Operand(0)
+		{
+		}
+	};
+
+	std::vector<Instruction> Instructions;
+	std::vector<std::string> Literals;
+};
+
+// An individual value associated with a key, and its conditionals. Values 
+// are never modified after creation so copies of a config file can share 
+// them, the result of resolving a value is stored in the file.
 struct ConfigFileValue
 {
 	std::string Value;
-	std::vector<ConfigFileExpression> Conditions;
 
-	// Post resolve values.
+	// Null if the value is unconditional. Shared by every value defined in
+	// the same block.
+	std::shared_ptr<const ConfigFileCondition> Condition;
+
+	// Index of this values resolve state in the file that created it.
+	size_t StateIndex;
+
+	ConfigFileValue()
+		: StateIndex(0)
+	{
+	}
+};
+
+// Post resolve state of a value.
+struct ConfigFileValueState
+{
 	bool HasResolvedValue;
 	std::string ResolvedValue;
 
 	bool HasResolvedCondition;
 	bool ConditionResult;
 
-	ConfigFileValue()
+	ConfigFileValueState()
 		: HasResolvedValue(false)
 		, HasResolvedCondition(false)
 		, ConditionResult(true)
@@ -115,10 +116,15 @@ struct ConfigFileKey
 {
 	std::string Name;
 	bool HasResolvedName;
-	std::vector<ConfigFileValue*> Values;
+	std::vector<std::shared_ptr<const ConfigFileValue>> Values;
+
+	// Group map this key was created for, only a file using that map can 
+	// modify it in place.
+	uint64_t Owner;
 
 	ConfigFileKey()
 		: HasResolvedName(false)
+		, Owner(0)
 	{
 	}
 };
@@ -128,9 +134,21 @@ struct ConfigFileGroup
 {
 	std::string Name;
 	bool bUnmergable;
-	std::map<std::string, ConfigFileKey*> Keys;
+	std::map<std::string, std::shared_ptr<ConfigFileKey>> Keys;
+
+	// Group map this group was created for, only a file using that map can 
+	// modify it in place.
+	uint64_t Owner;
+
+	ConfigFileGroup()
+		: bUnmergable(false)
+		, Owner(0)
+	{
+	}
 };
 
+typedef std::map<std::string, std::shared_ptr<ConfigFileGroup>> ConfigFileGroupMap;
+
 // Our base config file class. Implements a simple INI style file format.
 class ConfigFile
 {
@@ -203,6 +221,22 @@ public:
 		const std::string& group,
 		const std::string& key);
 
+	// Gets the paths of every file read when this file was parsed, including
+	// any files pulled in by include statements.
+	std::vector<Platform::Path> GetSourceFiles() const;
+
+	// Gets the names of every environment variable that was used to replace
+	// a token while resolving this file.
+	const std::set<std::string>& GetEnvironmentLookups() const;
+
+	// Writes the full state of this file, including how far it has been 
+	// resolved, so it can later be restored without parsing or resolving it.
+	virtual void WriteSnapshot(BinaryBufferWriter& writer) const;
+
+	// Restores the state written by WriteSnapshot. Returns false if the 
+	// snapshot is malformed.
+	virtual bool ReadSnapshot(BinaryBufferReader& reader);
+
 	// Flags a group as mergable or unmergable.
 	void SetGroupUnmergable(
 		const std::string& group,
@@ -271,13 +305,32 @@ public:
 
 protected:
 
-	std::vector<ConfigFileValue*> SetOrAddValue_Internal(
+	void SetOrAddValue_Internal(
 		const std::string& group,
 		const std::string& key,
-		const std::vector<std::string>& values,
+		const std::vector<std::shared_ptr<const ConfigFileValue>>& values,
 		bool bOverwrite = false,
 		bool bAddAtStart = false);
 
+	// Returns true if the key holds exactly the given unconditional values,
+	// overwriting it with them would change nothing.
+	bool HasOnlyValues(
+		const std::string& group,
+		const std::string& key,
+		const std::string* values,
+		size_t valueCount) const;
+
+	// Creates a value owned by this file, with the given resolve state.
+	std::shared_ptr<const ConfigFileValue> CreateValue(
+		const std::string& value,
+		const std::shared_ptr<const ConfigFileCondition>& condition,
+		const ConfigFileValueState& state = ConfigFileValueState());
+
+	// Gets a group or key that is safe to modify, copying it first if it
+	// is shared with another file. Both are created if they don't exist.
+	ConfigFileGroup* GetMutableGroup(const std::string& group);
+	ConfigFileKey* GetMutableKey(ConfigFileGroup* group, const std::string& key);
+
 	void Clear();
 
 	void Error(const Token& token, const char* format, ...);
@@ -307,35 +360,71 @@ protected:
 	bool ParseGroup();
 	bool ParseBlock();
 
-	bool EvaluateConditions(
-		std::vector<ConfigFileExpression>& conditions,
-		std::string groupName);
+	// Compiles the conditions currently on the expression stack.
+	std::shared_ptr<const ConfigFileCondition> CompileConditions();
 
-	ConfigFileExpressionResult EvaluateExpression(
-		ConfigFileExpression& expression, 
-		const std::string& baseGroup);
+	// Returns true if a value with the given condition exists in the group.
+	bool EvaluateCondition(
+		const ConfigFileCondition* condition,
+		const std::string& groupName);
 
 	std::string ReplaceTokens(
 		const std::string& value,
 		const std::string& baseGroup);
 
+	// Gets the value a token in the given group expands to. Results are 
+	// remembered for the rest of the resolve.
+	const std::string& ResolveToken(
+		const std::string& key,
+		const std::string& baseGroup);
+
 	bool ResolveTokenReplacement(
 		const std::string& key,
 		const std::string& group,
 		std::string& result);
 
+	// Same as ResolveTokenReplacement but returns the resolved value stored
+	// in this file, or null if the token doesn't name a key.
+	const std::string* FindTokenReplacement(
+		const std::string& key,
+		const std::string& group);
+
 	Platform::Path GetPath() const;
 
 private:
 	Platform::Path m_path;
+	std::vector<Platform::Path> m_sourceFiles;
 
 	ConfigTokenizer m_tokenizer;
 	int m_tokenIndex;
 
 	std::string m_currentGroup;
-	std::map<std::string, ConfigFileGroup*> m_groups;
+
+	// Copying a config file only shares its groups. Once shared neither file
+	// modifies the map in place, the first write clones it under a new owner
+	// id and then clones each group and key it touches that was created for
+	// another owner. Copies are made on several threads at once, so nothing 
+	// depends on reading reference counts.
+	std::shared_ptr<ConfigFileGroupMap> m_groups;
+	uint64_t m_groupsOwner;
+	mutable std::atomic<bool> m_bGroupsShared;
+
+	// Resolve state of every value created by this file (or the file it 
+	// was copied from), indexed by ConfigFileValue::StateIndex.
+	std::vector<ConfigFileValueState> m_valueStates;
+
+	std::set<std::string> m_environmentLookups;
+
+	// Values of every token expanded during the current resolve, keyed by 
+	// the group they were expanded in and the token.
+	std::map<std::pair<std::string, std::string>, std::string> m_resolvedTokens;
 
 	std::vector<ConfigFileExpression> m_expressionStack;
+	std::vector<std::shared_ptr<const ConfigFileCondition>> m_conditionStack;
+
+	// Operands of the conditions being evaluated. Evaluating a condition can
+	// resolve keys whose own conditions then get evaluated on top of it.
+	std::vector<const std::string*> m_evaluationStack;
 	
 };
 
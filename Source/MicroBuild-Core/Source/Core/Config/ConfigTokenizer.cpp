@@ -549,6 +549,11 @@ int ConfigTokenizer::GetTokenCount()
 	return (int)m_tokens.size();
 }
 
+const std::vector<Platform::Path>& ConfigTokenizer::GetFiles() const
+{
+	return m_files;
+}
+
 bool ConfigTokenizer::Tokenize(
 	const Platform::Path& path,
 	const std::vector<Platform::Path>& includePaths
@@ -559,11 +564,14 @@ bool ConfigTokenizer::Tokenize(
 	m_line = 0;
 	m_column = 0;
 	m_tokens.clear();
+	m_files.clear();
+	m_files.push_back(path);
 
 	// Read the file data.
 	{
 		Time::TimedScope scope(
-			Strings::Format("[%s] File read", path.ToString().c_str())
+			Strings::Format("[%s] File read", path.ToString().c_str()),
+			"Config"
 		);
 
 		if (!path.Exists())
@@ -588,7 +596,8 @@ bool ConfigTokenizer::Tokenize(
 	// Tokenization.
 	{
 		Time::TimedScope scope(
-			Strings::Format("[%s] Tokenization", path.ToString().c_str())
+			Strings::Format("[%s] Tokenization", path.ToString().c_str()),
+			"Config"
 		);
 
 		// Reserve a bunch of memory up front to save some resizing.
@@ -643,6 +652,10 @@ bool ConfigTokenizer::Tokenize(
 					return false;
 				}
 
+				m_files.insert(m_files.end(), 
+					subTokenizer.m_files.begin(), 
+					subTokenizer.m_files.end());
+
 				// Insert resulting tokens into correct place.
 				m_tokens.erase(m_tokens.begin() + i, m_tokens.begin() + i + 4);
 				m_tokens.insert(m_tokens.begin() + i, 
@@ -109,6 +109,9 @@ public:
 	// Gets the number of tokens that were successfully extracted.
 	int GetTokenCount();
 
+	// Gets the paths of the tokenized file and all the files it included.
+	const std::vector<Platform::Path>& GetFiles() const;
+
 protected:
 	void Error(const Token& token, const char* format, ...);
 	void UnexpectedEndOfFile(const Token& token);
@@ -129,6 +132,7 @@ protected:
 
 private:
 	std::vector<Token> m_tokens;
+	std::vector<Platform::Path> m_files;
 	std::string m_data;
 	Platform::Path m_path;
 	unsigned int m_offset;
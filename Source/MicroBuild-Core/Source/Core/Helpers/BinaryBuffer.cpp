@@ -0,0 +1,110 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "Core/Helpers/BinaryBuffer.h"
+
+#include <cstdio>
+
+namespace MicroBuild {
+
+BinaryBufferWriter::BinaryBufferWriter()
+{
+}
+
+BinaryBufferWriter::~BinaryBufferWriter()
+{
+}
+
+void BinaryBufferWriter::WriteString(const std::string& value)
+{
+	Write<uint32_t>((uint32_t)value.size());
+	m_buffer.insert(m_buffer.end(), value.begin(), value.end());
+}
+
+const std::vector<char>& BinaryBufferWriter::GetBuffer() const
+{
+	return m_buffer;
+}
+
+BinaryBufferReader::BinaryBufferReader(const std::vector<char>& buffer)
+	: m_buffer(buffer)
+	, m_offset(0)
+{
+}
+
+BinaryBufferReader::~BinaryBufferReader()
+{
+}
+
+bool BinaryBufferReader::ReadString(std::string& value)
+{
+	uint32_t length = 0;
+	if (!Read(length) || m_offset + length > m_buffer.size())
+	{
+		return false;
+	}
+
+	value.assign(m_buffer.data() + m_offset, length);
+	m_offset += length;
+	return true;
+}
+
+bool BinaryBufferReader::AtEnd() const
+{
+	return (m_offset == m_buffer.size());
+}
+
+bool ReadBinaryFile(const Platform::Path& path, std::vector<char>& data)
+{
+	FILE* file = fopen(path.ToString().c_str(), "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	bool bSuccess = (length >= 0);
+	if (bSuccess)
+	{
+		data.resize((size_t)length);
+		bSuccess = (fread(data.data(), 1, data.size(), file) == data.size());
+	}
+
+	fclose(file);
+	return bSuccess;
+}
+
+bool WriteBinaryFile(const Platform::Path& path, const std::vector<char>& data)
+{
+	FILE* file = fopen(path.ToString().c_str(), "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	bool bSuccess = (fwrite(data.data(), 1, data.size(), file) == data.size());
+	fclose(file);
+
+	return bSuccess;
+}
+
+}; // namespace MicroBuild
@@ -0,0 +1,90 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Platform/Path.h"
+
+#include <cstring>
+
+namespace MicroBuild {
+
+// Builds up a block of binary data in memory, used for compact caches that
+// are written to disk in one go.
+class BinaryBufferWriter
+{
+public:
+	BinaryBufferWriter();
+	~BinaryBufferWriter();
+
+	template <typename ValueType>
+	void Write(const ValueType& value)
+	{
+		const char* data = reinterpret_cast<const char*>(&value);
+		m_buffer.insert(m_buffer.end(), data, data + sizeof(ValueType));
+	}
+
+	// Writes a length prefixed string.
+	void WriteString(const std::string& value);
+
+	const std::vector<char>& GetBuffer() const;
+
+private:
+	std::vector<char> m_buffer;
+
+};
+
+// Reads values back out of a buffer built by a BinaryBufferWriter. Reads 
+// fail rather than running past the end of the buffer, so truncated or 
+// corrupt data can be safely rejected.
+class BinaryBufferReader
+{
+public:
+	BinaryBufferReader(const std::vector<char>& buffer);
+	~BinaryBufferReader();
+
+	template <typename ValueType>
+	bool Read(ValueType& value)
+	{
+		if (m_offset + sizeof(ValueType) > m_buffer.size())
+		{
+			return false;
+		}
+		memcpy(&value, m_buffer.data() + m_offset, sizeof(ValueType));
+		m_offset += sizeof(ValueType);
+		return true;
+	}
+
+	// Reads a length prefixed string.
+	bool ReadString(std::string& value);
+
+	// Returns true if every byte in the buffer has been read.
+	bool AtEnd() const;
+
+private:
+	const std::vector<char>& m_buffer;
+	size_t m_offset;
+
+};
+
+// Reads or writes the entire contents of a file without any newline 
+// translation, for storing buffers built with the classes above.
+bool ReadBinaryFile(const Platform::Path& path, std::vector<char>& data);
+bool WriteBinaryFile(const Platform::Path& path, const std::vector<char>& data);
+
+}; // namespace MicroBuild
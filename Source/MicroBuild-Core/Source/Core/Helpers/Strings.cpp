@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 
 #define __STDC_FORMAT_MACROS
 #include <inttypes.h>
@@ -415,6 +416,37 @@ uint64_t Hash64(const std::string& value, uint64_t start)
 	return hash;
 }
 
+uint64_t HashBuffer64(const void* data, size_t length, uint64_t start)
+{
+	const uint64_t prime = 0x100000001B3ULL;
+
+	const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+	uint64_t hash = start ^ 0xCBF29CE484222325ULL ^ (length * prime);
+
+	size_t wordCount = length / sizeof(uint64_t);
+	for (size_t i = 0; i < wordCount; i++)
+	{
+		uint64_t word;
+		memcpy(&word, bytes + (i * sizeof(uint64_t)), sizeof(uint64_t));
+
+		hash ^= word;
+		hash *= prime;
+		hash ^= (hash >> 29);
+	}
+
+	for (size_t i = wordCount * sizeof(uint64_t); i < length; i++)
+	{
+		hash ^= bytes[i];
+		hash *= prime;
+	}
+
+	hash ^= (hash >> 32);
+	hash *= prime;
+	hash ^= (hash >> 29);
+
+	return hash;
+}
+
 std::string Trim(const std::string& input)
 {
 	if (input.size() == 0)
@@ -70,6 +70,10 @@ std::string FormatVa(std::string format, va_list list);
 unsigned int Hash(const std::string& value, unsigned int start = 0);
 uint64_t Hash64(const std::string& value, uint64_t start = 0);
 
+// Hashes a block of binary data. Consumes 8 bytes per round, so its suitable
+// for hashing the contents of large files.
+uint64_t HashBuffer64(const void* data, size_t length, uint64_t start = 0);
+
 // Trims whitespace from the start and end of a value.
 std::string Trim(const std::string& input);
 
@@ -18,11 +18,170 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "PCH.h"
 #include "Core/Helpers/Time.h"
+#include "Core/Helpers/Strings.h"
 
 #include <algorithm>
 
 namespace MicroBuild {
 namespace Time {
 
+struct TraceEventRecord
+{
+	std::string Name;
+	const char* Category;
+	int ThreadId;
+	long long Start;
+	long long Duration;
+};
+
+static std::atomic<bool> g_traceEnabled(false);
+static std::atomic<int> g_traceThreadCounter(0);
+static std::mutex g_traceMutex;
+static Platform::Path g_tracePath;
+static std::chrono::high_resolution_clock::time_point g_traceStart;
+static std::vector<TraceEventRecord> g_traceEvents;
+static std::map<int, std::string> g_traceThreadNames;
+
+// Gets a small sequential id for the calling thread, OS thread ids are 
+// unwieldy to read in the trace viewer.
+static int GetTraceThreadId()
+{
+	static thread_local int s_threadId = -1;
+	if (s_threadId < 0)
+	{
+		s_threadId = g_traceThreadCounter++;
+	}
+	return s_threadId;
+}
+
+static std::string EscapeJson(const std::string& value)
+{
+	std::string result;
+	result.reserve(value.size());
+
+	for (char chr : value)
+	{
+		if (chr == '"' || chr == '\\')
+		{
+			result.push_back('\\');
+			result.push_back(chr);
+		}
+		else if ((unsigned char)chr < 0x20)
+		{
+			result += Strings::Format("\\u%04x", (int)chr);
+		}
+		else
+		{
+			result.push_back(chr);
+		}
+	}
+
+	return result;
+}
+
+void StartTrace(const Platform::Path& path)
+{
+	std::lock_guard<std::mutex> lock(g_traceMutex);
+
+	g_tracePath = path;
+	g_traceStart = std::chrono::high_resolution_clock::now();
+	g_traceEvents.clear();
+	g_traceThreadNames.clear();
+	g_traceThreadNames[GetTraceThreadId()] = "Main";
+	g_traceEnabled = true;
+}
+
+bool StopTrace()
+{
+	if (!g_traceEnabled)
+	{
+		return true;
+	}
+
+	std::lock_guard<std::mutex> lock(g_traceMutex);
+
+	g_traceEnabled = false;
+
+	std::string output = "{\"traceEvents\":[\n";
+
+	for (auto& pair : g_traceThreadNames)
+	{
+		output += Strings::Format(
+			"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"%s\"}},\n",
+			pair.first,
+			EscapeJson(pair.second).c_str()
+		);
+	}
+
+	for (size_t i = 0; i < g_traceEvents.size(); i++)
+	{
+		TraceEventRecord& record = g_traceEvents[i];
+
+		output += Strings::Format(
+			"{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%lli,\"dur\":%lli}%s\n",
+			EscapeJson(record.Name).c_str(),
+			record.Category,
+			record.ThreadId,
+			record.Start,
+			record.Duration,
+			i + 1 < g_traceEvents.size() ? "," : ""
+		);
+	}
+
+	output += "]}\n";
+
+	g_traceEvents.clear();
+	g_traceThreadNames.clear();
+
+	if (!Strings::WriteFile(g_tracePath, output))
+	{
+		Log(LogSeverity::Warning, "Failed to write trace to '%s'.\n", g_tracePath.ToString().c_str());
+		return false;
+	}
+
+	Log(LogSeverity::Info, "Trace written to '%s'.\n", g_tracePath.ToString().c_str());
+	return true;
+}
+
+bool IsTracing()
+{
+	return g_traceEnabled;
+}
+
+void TraceEvent(
+	const std::string& name,
+	const char* category,
+	std::chrono::high_resolution_clock::time_point start,
+	std::chrono::high_resolution_clock::time_point end)
+{
+	if (!g_traceEnabled)
+	{
+		return;
+	}
+
+	TraceEventRecord record;
+	record.Name = name;
+	record.Category = category;
+	record.ThreadId = GetTraceThreadId();
+
+	std::lock_guard<std::mutex> lock(g_traceMutex);
+
+	record.Start = std::chrono::duration_cast<std::chrono::microseconds>(start - g_traceStart).count();
+	record.Duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+
+	g_traceEvents.push_back(record);
+}
+
+void SetTraceThreadName(const std::string& name)
+{
+	if (!g_traceEnabled)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(g_traceMutex);
+	g_traceThreadNames[GetTraceThreadId()] = name;
+}
+
 }; // namespace Time
 }; // namespace MicroBuild
@@ -23,32 +23,51 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace MicroBuild {
 namespace Time {
 
-// Times the scope its contained within and prints out a log at the end.
+// Starts capturing timed scopes as trace events. They are written to the given
+// path as Chrome trace-event JSON (viewable in chrome://tracing) when the 
+// capture is stopped.
+void StartTrace(const Platform::Path& path);
+
+// Stops capturing and writes all captured events to disk. Does nothing if 
+// no capture is in progress.
+bool StopTrace();
+
+// Returns true if trace events are currently being captured.
+bool IsTracing();
+
+// Records an event covering the given time range on the calling thread.
+void TraceEvent(
+	const std::string& name, 
+	const char* category,
+	std::chrono::high_resolution_clock::time_point start,
+	std::chrono::high_resolution_clock::time_point end);
+
+// Sets the name shown for the calling thread in the trace.
+void SetTraceThreadName(const std::string& name);
+
+// Times the scope its contained within and records it as a trace event when
+// tracing is enabled.
 struct TimedScope
 {
 	TimedScope()
 	{
 		m_scope = "";
+		m_category = "";
 		m_start = std::chrono::high_resolution_clock::now();
-		m_bIsVerbose = true;
 	}
 
-	TimedScope(const std::string& name, bool bIsVerbose = true)
+	TimedScope(const std::string& name, const char* category = "General")
 	{
 		m_scope = name;
+		m_category = category;
 		m_start = std::chrono::high_resolution_clock::now();
-		m_bIsVerbose = bIsVerbose;
 	}
 
 	~TimedScope()
 	{
-		if (!m_scope.empty())
+		if (!m_scope.empty() && IsTracing())
 		{
-#if 0
-			float elapsedMs = GetElapsed();
-			Log(m_bIsVerbose ? LogSeverity::Verbose : LogSeverity::Warning, "%s took %.2f ms.\n",
-				m_scope.c_str(), elapsedMs);
-#endif
+			TraceEvent(m_scope, m_category, m_start, std::chrono::high_resolution_clock::now());
 		}
 	}
 
@@ -62,8 +81,8 @@ struct TimedScope
 
 private:
 	std::string m_scope;
+	const char* m_category;
 	std::chrono::high_resolution_clock::time_point m_start;
-	bool m_bIsVerbose;
 
 };
 
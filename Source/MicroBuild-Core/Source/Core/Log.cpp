@@ -27,6 +27,7 @@ namespace MicroBuild {
 
 bool g_logVerboseOn = false;
 bool g_logSilentOn = false;
+LogSinkCallback g_logSink = nullptr;
 
 void LogSetVerbose(bool bVerbose)
 {
@@ -48,6 +49,11 @@ bool LogGetSilent()
 	return g_logSilentOn;
 }
 
+void LogSetSink(LogSinkCallback sink)
+{
+	g_logSink = sink;
+}
+
 void Log(LogSeverity severity, const char* format, ...)
 {
 	if (severity == LogSeverity::Verbose && !g_logVerboseOn)
@@ -64,6 +70,12 @@ void Log(LogSeverity severity, const char* format, ...)
 	std::string result = Strings::FormatVa(format, list);
 	va_end(list);
 
+	if (g_logSink)
+	{
+		g_logSink(severity, result);
+		return;
+	}
+
 	printf("%s", result.c_str());
 	Platform::DebugOutput(result.c_str());
 
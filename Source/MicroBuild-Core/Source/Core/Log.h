@@ -18,6 +18,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #pragma once
 
+#include <functional>
+
 namespace MicroBuild {
 
 // Severity of the log message, determines color and what priority the log 
@@ -41,6 +43,13 @@ bool LogGetVerbose();
 void LogSetSilent(bool bSilent);
 bool LogGetSilent();
 
+// Redirects all log output to the given callback rather than stdout, pass 
+// nullptr to restore the default behaviour. The callback may be invoked from
+// multiple threads at once.
+typedef std::function<void(LogSeverity severity, const std::string& message)> LogSinkCallback;
+
+void LogSetSink(LogSinkCallback sink);
+
 // Writes a log to stdout in the same style as printf. Seveirty determines
 // if it will be printed (based on -verbose flag) and what color it will be
 // printed in.
@@ -21,39 +21,51 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Parallel/Jobs/JobScheduler.h"
 
 #include "Core/Helpers/Strings.h"
+#include "Core/Helpers/Time.h"
+
+#include <memory>
+#include <algorithm>
 
 namespace MicroBuild {
 
-// thread_local not supported on mac with older versions of xcode, not
-// really used at the moment so ignore.
-#if 0 
-thread_local int g_jobSchedulerthreadId = -1;
-#endif
+// Identifies which scheduler and worker the current thread belongs to, used 
+// to route newly runnable jobs to the local queue of the worker that made them
+// runnable.
+struct JobSchedulerThreadState
+{
+	JobScheduler* Scheduler;
+	int WorkerIndex;
+};
+
+thread_local JobSchedulerThreadState g_jobSchedulerThreadState = { nullptr, -1 };
 
 JobScheduler::JobScheduler(int ThreadCount)
-	: m_JobVersionCounter(-1)
+	: m_JobVersionCounter(0)
+	, m_JobBlockCount(0)
+	, m_QueuedJobCount(0)
+	, m_NextWorkerQueue(0)
+	, m_SleepingThreads(0)
+	, m_WaitingThreads(0)
 	, m_Aborting(false)
 {
 	assert(ThreadCount > 0);
 
-	// Push all empty job indices.
-	for (int i = 0; i < MaxJobCount; i++)
+	memset(m_JobBlocks, 0, sizeof(m_JobBlocks));
+
+	// Each worker needs its queue before any thread boots, as other workers 
+	// can start stealing from it immediately.
+	for (int i = 0; i < ThreadCount; i++)
 	{
-		m_FreeJobIndices.Push(i);
+		m_WorkerQueues.push_back(new WorkerQueue());
 	}
 
 	// Boot up all threads.
 	for (int i = 0; i < ThreadCount; i++)
 	{
-		std::string ThreadName = Strings::Format("Job Pool Thread %i", i);
-		
 		m_Threads.push_back(new std::thread([this, i]() {
-#if 0
-			g_jobSchedulerthreadId = i + 1;
-#else
-			MB_UNUSED_PARAMETER(i);
-#endif
-			ThreadEntryPoint();
+			g_jobSchedulerThreadState.Scheduler = this;
+			g_jobSchedulerThreadState.WorkerIndex = i;
+			ThreadEntryPoint(i);
 		}));
 	}
 }
@@ -73,22 +85,59 @@ JobScheduler::~JobScheduler()
 		delete CurrentThread;
 	}
 	m_Threads.clear();
+
+	for (auto Queue : m_WorkerQueues)
+	{
+		delete Queue;
+	}
+	m_WorkerQueues.clear();
+
+	for (int i = 0; i < m_JobBlockCount; i++)
+	{
+		delete[] m_JobBlocks[i];
+	}
+	m_JobBlockCount = 0;
 }
 
 bool JobScheduler::AllocateJob(JobHandle& Handle)
 {
-	if (m_FreeJobIndices.Pop(&Handle.Index))
-	{
-		m_Jobs[Handle.Index].Version = (m_JobVersionCounter++);
-		m_Jobs[Handle.Index].Completed = false;
-		m_Jobs[Handle.Index].Enqueued = false;
-		m_Jobs[Handle.Index].DependenciesPending = 0;
-		m_Jobs[Handle.Index].Dependencies.clear();
-		m_Jobs[Handle.Index].Dependents.clear();
-		Handle.Version = m_Jobs[Handle.Index].Version;
-		return true;
+	std::unique_lock<std::mutex> lock(m_AllocationMutex);
+
+	// Grow the arena by another block if we have run out of free jobs.
+	if (m_FreeJobIndices.empty())
+	{
+		if (m_JobBlockCount >= MaxJobBlocks)
+		{
+			return false;
+		}
+
+		int BlockIndex = m_JobBlockCount;
+		m_JobBlocks[BlockIndex] = new Job[JobBlockSize];
+		m_JobBlockCount++;
+
+		// Push in reverse so jobs get allocated in index order.
+		for (int i = JobBlockSize - 1; i >= 0; i--)
+		{
+			m_FreeJobIndices.push_back((BlockIndex * JobBlockSize) + i);
+		}
 	}
-	return false;
+
+	Handle.Index = m_FreeJobIndices.back();
+	m_FreeJobIndices.pop_back();
+
+	Job* NewJob = GetJobByIndex(Handle.Index);
+	NewJob->Completed = false;
+	NewJob->Submitted = false;
+	NewJob->Enqueued = false;
+	NewJob->DependenciesPending = 0;
+	NewJob->Cost = 0;
+	NewJob->Priority = 0;
+	NewJob->Dependencies.clear();
+	NewJob->Dependents.clear();
+	NewJob->Version = (m_JobVersionCounter++);
+	Handle.Version = NewJob->Version;
+
+	return true;
 }
 
 JobHandle JobScheduler::CreateJob(JobCallback Callback)
@@ -99,19 +148,25 @@ JobHandle JobScheduler::CreateJob(JobCallback Callback)
 
 	if (bResult)
 	{
-		m_Jobs[Handle.Index].Callback = Callback;
+		GetJobByIndex(Handle.Index)->Callback = Callback;
 	}
 
 	return Handle;
 }
 
+JobScheduler::Job* JobScheduler::GetJobByIndex(int Index)
+{
+	return &m_JobBlocks[Index / JobBlockSize][Index % JobBlockSize];
+}
+
 JobScheduler::Job* JobScheduler::GetJob(JobHandle Handle)
 {
-	if (m_Jobs[Handle.Index].Version != Handle.Version)
+	Job* Result = GetJobByIndex(Handle.Index);
+	if (Result->Version != Handle.Version)
 	{
 		return nullptr;
 	}
-	return &m_Jobs[Handle.Index];
+	return Result;
 }
 
 void JobScheduler::AddDependency(JobHandle Primary, JobHandle DependentOn)
@@ -130,48 +185,210 @@ void JobScheduler::AddDependency(JobHandle Primary, JobHandle DependentOn)
 	DependentOnJob->Dependents.push_back(Primary);
 }
 
-void JobScheduler::Enqueue(JobHandle Handle)
+void JobScheduler::SetCost(JobHandle Handle, int64_t Cost)
 {
-	// Ensure we aren't already enqueued.
 	Job* ResolvedJob = GetJob(Handle);
-	
-	assert(ResolvedJob != nullptr);// , "Parent job handle is no longer valid - its probably already been executed. Add job dependencies before enqueing them.");
 
-	if (ResolvedJob->DependenciesPending <= 0)
-	{		
-		bool expectedValue = false;
+	assert(ResolvedJob != nullptr);// "Job handle is no longer valid - its probably already been executed. Set job costs before enqueing them.");
+	assert(!ResolvedJob->Enqueued);// "Job has already been enqueued. Set job costs before enqueing jobs.");
+
+	ResolvedJob->Cost = Cost;
+}
+
+void JobScheduler::PushRunnableJob(int Index)
+{
+	// Workers push onto their own queue so the jobs they unblock stay local, 
+	// anyone else distributes jobs round-robin across all workers.
+	int QueueIndex = 0;
+	if (g_jobSchedulerThreadState.Scheduler == this)
+	{
+		QueueIndex = g_jobSchedulerThreadState.WorkerIndex;
+	}
+	else
+	{
+		QueueIndex = (m_NextWorkerQueue++) % (int)m_WorkerQueues.size();
+	}
+
+	int64_t Priority = GetJobByIndex(Index)->Priority;
+
+	WorkerQueue* Queue = m_WorkerQueues[QueueIndex];
+	{
+		std::unique_lock<std::mutex> lock(Queue->Mutex);
+		Queue->Jobs[Priority].push_back(Index);
+		Queue->TopPriority = Queue->Jobs.begin()->first;
+	}
+
+	m_QueuedJobCount++;
 
-		if (ResolvedJob->Enqueued.compare_exchange_strong(expectedValue, true))
+	// Only take the work lock if someone is actually asleep, wake a single
+	// thread as there is only a single job to run.
+	if (m_SleepingThreads > 0)
+	{
+		std::unique_lock<std::mutex> lock(m_WorkMutex);
+		m_WorkCondVar.notify_one();
+	}
+}
+
+bool JobScheduler::PopQueuedJob(int QueueIndex, bool bNewest, int* Index)
+{
+	WorkerQueue* Queue = m_WorkerQueues[QueueIndex];
+	std::unique_lock<std::mutex> lock(Queue->Mutex);
+
+	if (Queue->Jobs.empty())
+	{
+		return false;
+	}
+
+	auto Bucket = Queue->Jobs.begin();
+	if (bNewest)
+	{
+		*Index = Bucket->second.back();
+		Bucket->second.pop_back();
+	}
+	else
+	{
+		*Index = Bucket->second.front();
+		Bucket->second.pop_front();
+	}
+
+	if (Bucket->second.empty())
+	{
+		Queue->Jobs.erase(Bucket);
+	}
+
+	Queue->TopPriority = (Queue->Jobs.empty() ? INT64_MIN : Queue->Jobs.begin()->first);
+	m_QueuedJobCount--;
+
+	return true;
+}
+
+bool JobScheduler::PopRunnableJob(int WorkerIndex, int* Index)
+{
+	int QueueCount = (int)m_WorkerQueues.size();
+
+	// Find whoever holds the highest priority job, favouring our own queue on ties.
+	int BestQueue = WorkerIndex;
+	int64_t BestPriority = m_WorkerQueues[WorkerIndex]->TopPriority;
+
+	for (int i = 1; i < QueueCount; i++)
+	{
+		int QueueIndex = (WorkerIndex + i) % QueueCount;
+		int64_t Priority = m_WorkerQueues[QueueIndex]->TopPriority;
+		if (Priority > BestPriority)
 		{
-			//Log(LogSeverity::SilentInfo, "Enqueing (ResolvedJob=0x%p version=0x%08x) index=%i version=0x%08x\n", ResolvedJob, ResolvedJob->Version, Handle.Index, Handle.Version);
-	
-			if (!m_QueuedJobs.Push(Handle.Index))
+			BestQueue = QueueIndex;
+			BestPriority = Priority;
+		}
+	}
+
+	// Take the most recently queued job from our own queue, its most likely to
+	// be related to what we just ran, or steal the oldest job from someone else.
+	if (BestQueue != WorkerIndex && PopQueuedJob(BestQueue, false, Index))
+	{
+		return true;
+	}
+
+	// Someone may have beaten us to it, fall back to taking anything we can find.
+	if (PopQueuedJob(WorkerIndex, true, Index))
+	{
+		return true;
+	}
+
+	for (int i = 1; i < QueueCount; i++)
+	{
+		if (PopQueuedJob((WorkerIndex + i) % QueueCount, false, Index))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobScheduler::Enqueue(JobHandle Handle)
+{
+	// Dependencies are shared between many jobs (every task in a stage depends on 
+	// the previous stage), so track what we have already walked to avoid revisiting
+	// the same sub-trees over and over.
+	std::vector<bool> Visited;
+	{
+		std::unique_lock<std::mutex> lock(m_AllocationMutex);
+		Visited.resize(m_JobBlockCount * JobBlockSize, false);
+	}
+
+	// Gather the tree with dependencies ahead of the jobs that depend on them.
+	std::vector<int> Order;
+	EnqueueInternal(Handle, Visited, Order);
+
+	// Walk it backwards so every job's dependents are prioritized before it is, each
+	// job's priority is then the cost of the most expensive chain that runs after it.
+	for (auto Iter = Order.rbegin(); Iter != Order.rend(); Iter++)
+	{
+		Job* ResolvedJob = GetJobByIndex(*Iter);
+
+		int64_t DependentPriority = 0;
+		for (JobHandle DependentHandle : ResolvedJob->Dependents)
+		{
+			Job* DependentJob = GetJob(DependentHandle);
+			if (DependentJob != nullptr)
+			{
+				DependentPriority = std::max(DependentPriority, DependentJob->Priority);
+			}
+		}
+
+		ResolvedJob->Priority = ResolvedJob->Cost + DependentPriority;
+	}
+
+	for (int Index : Order)
+	{
+		Job* ResolvedJob = GetJobByIndex(Index);
+		if (ResolvedJob->DependenciesPending <= 0)
+		{
+			bool expectedValue = false;
+
+			if (ResolvedJob->Enqueued.compare_exchange_strong(expectedValue, true))
 			{
-				assert(false);// "Failed to enqueue job, job queue is probably full, increasing MaxJobCount may be required.");
+				PushRunnableJob(Index);
 			}
 		}
 	}
+}
+
+void JobScheduler::EnqueueInternal(JobHandle Handle, std::vector<bool>& Visited, std::vector<int>& Order)
+{
+	// Ensure we aren't already enqueued.
+	Job* ResolvedJob = GetJob(Handle);
+	
+	assert(ResolvedJob != nullptr);// , "Parent job handle is no longer valid - its probably already been executed. Add job dependencies before enqueing them.");
+
+	Visited[Handle.Index] = true;
+	ResolvedJob->Submitted = true;
 
 	// Enqueue children first.
 	for (JobHandle ChildHandle : ResolvedJob->Dependencies)
 	{
+		if (Visited[ChildHandle.Index])
+		{
+			continue;
+		}
+
+		// Anything submitted by an earlier enqueue is already being tracked, there
+		// is no need to walk back into it.
 		Job* ChildJob = GetJob(ChildHandle);
-		if (ChildJob != nullptr && !ChildJob->Enqueued)
+		if (ChildJob != nullptr && !ChildJob->Submitted)
 		{
-			Enqueue(ChildHandle);
+			EnqueueInternal(ChildHandle, Visited, Order);
 		}
 	}
 
-	{
-		std::unique_lock<std::mutex> lock(m_WorkMutex);
-		m_WorkCondVar.notify_one();
-	}
+	Order.push_back(Handle.Index);
 }
 
 bool JobScheduler::IsComplete(JobHandle Handle)
 {
-	if (m_Jobs[Handle.Index].Completed ||
-		m_Jobs[Handle.Index].Version != Handle.Version)
+	Job* ResolvedJob = GetJobByIndex(Handle.Index);
+	if (ResolvedJob->Completed ||
+		ResolvedJob->Version != Handle.Version)
 	{
 		return true;
 	}
@@ -182,60 +399,168 @@ void JobScheduler::Wait(JobHandle Handle)
 {
 	std::unique_lock<std::mutex> lock(m_WaitingMutex);
 
+	m_WaitingThreads++;
 	while (!IsComplete(Handle))
 	{
 		m_WaitingCondVar.wait(lock);
 	}
+	m_WaitingThreads--;
+}
+
+void JobScheduler::ParallelFor(int Count, const std::function<void(int)>& Callback)
+{
+	// Blocking one of our own workers on jobs queued behind everything else 
+	// would stall it, so work through the iterations here instead.
+	if (GetThreadId() >= 0)
+	{
+		ParallelForOnWorker(Count, Callback);
+		return;
+	}
+
+	JobHandle HostJob = CreateJob();
+
+	for (int i = 0; i < Count; i++)
+	{
+		JobHandle Handle = CreateJob([&Callback, i]() {
+			Callback(i);
+		});
+
+		AddDependency(HostJob, Handle);
+	}
+
+	Enqueue(HostJob);
+	Wait(HostJob);
+}
+
+void JobScheduler::ParallelForOnWorker(int Count, const std::function<void(int)>& Callback)
+{
+	struct ParallelForState
+	{
+		const std::function<void(int)>* Callback;
+		int Count;
+		std::atomic<int> NextIndex;
+		std::atomic<int> Remaining;
+		std::mutex Mutex;
+		std::condition_variable CondVar;
+	};
+
+	std::shared_ptr<ParallelForState> State = std::make_shared<ParallelForState>();
+	State->Callback = &Callback;
+	State->Count = Count;
+	State->NextIndex = 0;
+	State->Remaining = Count;
+
+	// Iterations are claimed from a shared counter, so helpers that only get to
+	// run after we have returned find nothing left and never touch the callback.
+	auto RunIterations = [](ParallelForState* State) {
+		while (true)
+		{
+			int Index = State->NextIndex++;
+			if (Index >= State->Count)
+			{
+				break;
+			}
+
+			(*State->Callback)(Index);
+
+			if (--State->Remaining == 0)
+			{
+				std::unique_lock<std::mutex> lock(State->Mutex);
+				State->CondVar.notify_all();
+			}
+		}
+	};
+
+	int HelperCount = std::min(Count, (int)m_Threads.size()) - 1;
+	for (int i = 0; i < HelperCount; i++)
+	{
+		JobHandle Handle = CreateJob([State, RunIterations]() {
+			RunIterations(State.get());
+		});
+		Enqueue(Handle);
+	}
+
+	RunIterations(State.get());
+
+	// Wait for any iterations still in flight on other workers.
+	std::unique_lock<std::mutex> lock(State->Mutex);
+	while (State->Remaining > 0)
+	{
+		State->CondVar.wait(lock);
+	}
 }
 
 void JobScheduler::RunJob(int JobIndex)
 {
-	if (m_Jobs[JobIndex].Callback != nullptr)
+	Job* RunningJob = GetJobByIndex(JobIndex);
+
+	if (RunningJob->Callback != nullptr)
 	{
-		m_Jobs[JobIndex].Callback();
+		RunningJob->Callback();
 	}
 
-	for (JobHandle& Handle : m_Jobs[JobIndex].Dependents)
+	// All of a dependents own dependencies have run by the time its pending count hits 
+	// zero, so it can go straight onto our queue without walking its tree.
+	for (JobHandle& Handle : RunningJob->Dependents)
 	{
-		int Index = (--m_Jobs[Handle.Index].DependenciesPending);
+		Job* DependentJob = GetJobByIndex(Handle.Index);
+		int Index = (--DependentJob->DependenciesPending);
 		if (Index == 0)
 		{
-			Enqueue(Handle);
+			bool expectedValue = false;
+			if (DependentJob->Enqueued.compare_exchange_strong(expectedValue, true))
+			{
+				PushRunnableJob(Handle.Index);
+			}
 		}
 	}
 
+	RunningJob->Completed = true;
+
+	// Nobody to wake up in the common case of intermediate jobs completing.
+	if (m_WaitingThreads > 0)
 	{
 		std::unique_lock<std::mutex> lock(m_WaitingMutex);
-		m_Jobs[JobIndex].Completed = true;
 		m_WaitingCondVar.notify_all();
 	}
 
-	m_FreeJobIndices.Push(JobIndex);
+	{
+		std::unique_lock<std::mutex> lock(m_AllocationMutex);
+		m_FreeJobIndices.push_back(JobIndex);
+	}
 }
 
-int JobScheduler::WaitForJob()
+int JobScheduler::WaitForJob(int WorkerIndex)
 {
-	std::unique_lock<std::mutex> lock(m_WorkMutex);
-
 	while (!m_Aborting)
 	{
 		int JobIndex = 0;
-		if (m_QueuedJobs.Pop(&JobIndex))
+		if (PopRunnableJob(WorkerIndex, &JobIndex))
 		{
 			//Log(LogSeverity::SilentInfo, "Returning job %i\n", JobIndex);
 			return JobIndex;
 		}
-		m_WorkCondVar.wait(lock);
+
+		std::unique_lock<std::mutex> lock(m_WorkMutex);
+
+		m_SleepingThreads++;
+		while (m_QueuedJobCount <= 0 && !m_Aborting)
+		{
+			m_WorkCondVar.wait(lock);
+		}
+		m_SleepingThreads--;
 	}
 
 	return -1;
 }
 
-void JobScheduler::ThreadEntryPoint()
+void JobScheduler::ThreadEntryPoint(int WorkerIndex)
 {
+	Time::SetTraceThreadName(Strings::Format("Worker %i", WorkerIndex));
+
 	while (!m_Aborting)
 	{
-		int JobIndex = WaitForJob();
+		int JobIndex = WaitForJob(WorkerIndex);
 		if (JobIndex >= 0)
 		{
 			RunJob(JobIndex);
@@ -245,18 +570,20 @@ void JobScheduler::ThreadEntryPoint()
 
 int JobScheduler::GetThreadId()
 {
-#if 1
-	return 0;
-#else
-	return g_jobSchedulerthreadId;
-#endif
+	if (g_jobSchedulerThreadState.Scheduler != this)
+	{
+		return -1;
+	}
+	return g_jobSchedulerThreadState.WorkerIndex;
 }
 
 void JobScheduler::PrintJobTree()
 {
-	for (int i = 0; i < MaxJobCount; i++)
+	std::unique_lock<std::mutex> lock(m_AllocationMutex);
+
+	for (int i = 0; i < m_JobBlockCount * JobBlockSize; i++)
 	{
-		Job* job = &m_Jobs[i];
+		Job* job = GetJobByIndex(i);
 		if (job->Completed)
 		{
 			continue;
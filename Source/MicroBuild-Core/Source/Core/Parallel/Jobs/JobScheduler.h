@@ -17,12 +17,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 #pragma once
 
-#include "Core/Parallel/Types/ConcurrentQueue.h"
+#include "Core/Platform/Platform.h"
 
+#include <cstdint>
 #include <functional>
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <deque>
+#include <map>
 #include <condition_variable>
 
 namespace MicroBuild {
@@ -54,6 +57,16 @@ private:
 // The job scheduler allows the user to create multiple small jobs which
 // will be executed in parallel by multiple threads. Individual jobs can also
 // have dependency chains to ensure defined ordering.
+//
+// Jobs are stored in an arena that grows in fixed size blocks, so there is 
+// no practical limit on how many can be in flight. Each worker thread owns
+// its own queue of runnable jobs and steals from other workers when its own
+// queue runs dry.
+//
+// Jobs can be given an estimated cost. When enqueued each job is prioritized 
+// by the total cost of the most expensive chain of jobs that depend on it, and
+// workers always pick the highest priority job available, so the longest chains
+// get started first.
 class JobScheduler
 {
 public:
@@ -61,45 +74,91 @@ public:
 	// Callback signature.
 	typedef std::function<void()> JobCallback;
 
-	// Maximum number of jobs this scheduler can manage.
-	const static int MaxJobCount = 1 * 1024;
+	// Number of jobs allocated each time the job arena grows.
+	const static int JobBlockSize = 256;
+
+	// Maximum number of blocks the job arena can grow to.
+	const static int MaxJobBlocks = 16 * 1024;
 
 private:
 
 	struct Job
 	{
-		int						Version;
+		Job()
+			: Version(-1)
+			, DependenciesPending(0)
+			, Cost(0)
+			, Priority(0)
+			, Completed(true)
+			, Submitted(false)
+			, Enqueued(false)
+		{
+		}
+
+		std::atomic<int>		Version;
 		JobCallback				Callback;
 		std::atomic<int>		DependenciesPending;
 		std::vector<JobHandle>	Dependencies;
 		std::vector<JobHandle>	Dependents;
-		bool					Completed;
+		int64_t					Cost;
+		int64_t					Priority;
+		std::atomic<bool>		Completed;
+		std::atomic<bool>		Submitted;
 		std::atomic<bool>		Enqueued;
 	};
 
+	// Runnable jobs are bucketed by priority, highest first.
+	typedef std::map<int64_t, std::deque<int>, std::greater<int64_t>> PriorityQueue;
+
+	struct WorkerQueue
+	{
+		WorkerQueue()
+			: TopPriority(INT64_MIN)
+		{
+		}
+
+		std::mutex				Mutex;
+		PriorityQueue			Jobs;
+
+		// Priority of the first bucket, readable without taking the lock.
+		std::atomic<int64_t>	TopPriority;
+	};
+
 	std::vector<std::thread*> m_Threads;
+	std::vector<WorkerQueue*> m_WorkerQueues;
 
 	std::atomic<int> m_JobVersionCounter;
 
-	ConcurrentQueue<int, MaxJobCount> m_QueuedJobs;
+	Job* m_JobBlocks[MaxJobBlocks];
+	int m_JobBlockCount;
+	std::vector<int> m_FreeJobIndices;
+	std::mutex m_AllocationMutex;
 
-	Job m_Jobs[MaxJobCount];
-	ConcurrentQueue<int, MaxJobCount> m_FreeJobIndices;
+	std::atomic<int> m_QueuedJobCount;
+	std::atomic<int> m_NextWorkerQueue;
 
+	std::atomic<int> m_SleepingThreads;
 	std::mutex m_WorkMutex;
 	std::condition_variable m_WorkCondVar;
 
+	std::atomic<int> m_WaitingThreads;
 	std::mutex m_WaitingMutex;
 	std::condition_variable m_WaitingCondVar;
 
-	bool m_Aborting;
+	std::atomic<bool> m_Aborting;
 
 private:
-	void ThreadEntryPoint();
+	void ThreadEntryPoint(int WorkerIndex);
 	bool AllocateJob(JobHandle& Handle);
+	Job* GetJobByIndex(int Index);
 	Job* GetJob(JobHandle Handle);
+	void EnqueueInternal(JobHandle Handle, std::vector<bool>& Visited, std::vector<int>& Order);
+	void PushRunnableJob(int Index);
+	bool PopRunnableJob(int WorkerIndex, int* Index);
+	bool PopQueuedJob(int QueueIndex, bool bNewest, int* Index);
 	void RunJob(int Index);
-	int WaitForJob();
+	int WaitForJob(int WorkerIndex);
+	void ParallelForOnWorker(int Count, const std::function<void(int)>& Callback);
 
 public:
 	JobScheduler(int ThreadCount);
@@ -112,15 +171,29 @@ public:
 
 	// Adds a given job as a dependency on another job. The parent job will not be run
 	// until all its dependents are executed.
+	//
+	// Either job may already have been enqueued as long as it is still waiting on other
+	// dependencies, and the caller guarantees it cannot become runnable in the meantime.
+	// This allows a running job to extend the graph of jobs that depend on it.
 	void AddDependency(JobHandle Job, JobHandle DependentOn);
 
+	// Sets the estimated cost of running the job, in whatever units the caller 
+	// likes as long as they are consistent. Must be called before the job is enqueued.
+	void SetCost(JobHandle Job, int64_t Cost);
+
 	// Adds the job to the queue of jobs that are waiting for execution. This will also enqueue
-	// all dependent tasks.
+	// all dependent tasks that have not already been enqueued.
 	void Enqueue(JobHandle Handle);
 
 	// Blocks indefinitely until the given job is complete.
 	void Wait(JobHandle Handle);
 
+	// Runs the callback once for each index in the range [0, Count) as 
+	// independent jobs, and blocks until they have all completed. When called 
+	// from one of this scheduler's workers the calling thread runs iterations 
+	// itself rather than waiting, so jobs can safely fan out work.
+	void ParallelFor(int Count, const std::function<void(int)>& Callback);
+
 	// Returns the current completion state of the given job.
 	bool IsComplete(JobHandle Handle);
 
@@ -0,0 +1,77 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PCH.h"
+#include "Core/Platform/Path.h"
+
+namespace MicroBuild {
+namespace Platform {
+
+// Describes what happened to a changed path.
+enum class FileChangeType
+{
+	Modified,
+	Added,
+	Removed,
+};
+
+// Individual change reported by a FileWatcher.
+struct FileChange
+{
+	Path			FilePath;
+	FileChangeType	Type;
+};
+
+// Watches directories for changes to the files inside them. Directories are 
+// not watched recursively, each one of interest needs to be added seperately.
+class FileWatcher
+{
+protected:
+	void* m_impl; // Semi-pimpl idiom, contains any platform specific data.
+
+public:
+
+	// No copy construction please.
+	FileWatcher(const FileWatcher& other) = delete;
+
+	// Construction.
+	FileWatcher();
+	~FileWatcher();
+
+	// Prepares the watcher for use, returns false if file watching is not 
+	// supported on this platform.
+	bool Init();
+
+	// Starts watching the given directory, returns true if it is already watched.
+	bool Watch(const Path& directory);
+
+	// Returns true if the given directory is currently being watched.
+	bool IsWatching(const Path& directory);
+
+	// Waits up to the given number of milliseconds for changes and appends them 
+	// to the given list. Renames are reported as a removal and an addition. 
+	// bOverflow is set if changes were dropped, in which case everything should 
+	// be treated as changed.
+	bool Poll(std::vector<FileChange>& changes, bool& bOverflow, int timeoutMs);
+
+};
+
+};
+};
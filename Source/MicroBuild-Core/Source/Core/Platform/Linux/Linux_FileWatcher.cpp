@@ -0,0 +1,206 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "Core/Platform/FileWatcher.h"
+
+#ifdef MB_PLATFORM_LINUX
+
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/inotify.h>
+
+namespace MicroBuild {
+namespace Platform {
+
+struct FileWatcherImpl
+{
+	int Handle;
+	std::map<int, std::string> Directories;
+	std::map<std::string, int> Watches;
+};
+
+FileWatcher::FileWatcher()
+	: m_impl(nullptr)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+	if (m_impl != nullptr)
+	{
+		FileWatcherImpl* impl = reinterpret_cast<FileWatcherImpl*>(m_impl);
+		close(impl->Handle);
+		delete impl;
+		m_impl = nullptr;
+	}
+}
+
+bool FileWatcher::Init()
+{
+	if (m_impl != nullptr)
+	{
+		return true;
+	}
+
+	int handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (handle < 0)
+	{
+		return false;
+	}
+
+	FileWatcherImpl* impl = new FileWatcherImpl();
+	impl->Handle = handle;
+	m_impl = impl;
+
+	return true;
+}
+
+bool FileWatcher::Watch(const Path& directory)
+{
+	FileWatcherImpl* impl = reinterpret_cast<FileWatcherImpl*>(m_impl);
+	if (impl == nullptr)
+	{
+		return false;
+	}
+
+	std::string directoryString = directory.ToString();
+	if (impl->Watches.find(directoryString) != impl->Watches.end())
+	{
+		return true;
+	}
+
+	int watch = inotify_add_watch(impl->Handle, directoryString.c_str(), 
+		IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | 
+		IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+
+	if (watch < 0)
+	{
+		return false;
+	}
+
+	impl->Directories[watch] = directoryString;
+	impl->Watches[directoryString] = watch;
+
+	return true;
+}
+
+bool FileWatcher::IsWatching(const Path& directory)
+{
+	FileWatcherImpl* impl = reinterpret_cast<FileWatcherImpl*>(m_impl);
+	if (impl == nullptr)
+	{
+		return false;
+	}
+
+	return impl->Watches.find(directory.ToString()) != impl->Watches.end();
+}
+
+bool FileWatcher::Poll(std::vector<FileChange>& changes, bool& bOverflow, int timeoutMs)
+{
+	FileWatcherImpl* impl = reinterpret_cast<FileWatcherImpl*>(m_impl);
+	if (impl == nullptr)
+	{
+		return false;
+	}
+
+	struct pollfd descriptor;
+	descriptor.fd = impl->Handle;
+	descriptor.events = POLLIN;
+	descriptor.revents = 0;
+
+	int result = poll(&descriptor, 1, timeoutMs);
+	if (result < 0)
+	{
+		return (errno == EINTR);
+	}
+
+	alignas(struct inotify_event) char buffer[64 * 1024];
+
+	while (true)
+	{
+		ssize_t bytesRead = read(impl->Handle, buffer, sizeof(buffer));
+		if (bytesRead <= 0)
+		{
+			break;
+		}
+
+		for (char* ptr = buffer; ptr < buffer + bytesRead; )
+		{
+			struct inotify_event* event = reinterpret_cast<struct inotify_event*>(ptr);
+			ptr += sizeof(struct inotify_event) + event->len;
+
+			if ((event->mask & IN_Q_OVERFLOW) != 0)
+			{
+				bOverflow = true;
+				continue;
+			}
+
+			auto iter = impl->Directories.find(event->wd);
+			if (iter == impl->Directories.end())
+			{
+				continue;
+			}
+
+			// The watched directory itself went away, the watch is removed 
+			// automatically so forget about it.
+			if ((event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) != 0)
+			{
+				FileChange change;
+				change.FilePath = iter->second;
+				change.Type = FileChangeType::Removed;
+				changes.push_back(change);
+
+				if ((event->mask & IN_IGNORED) == 0)
+				{
+					inotify_rm_watch(impl->Handle, event->wd);
+				}
+
+				impl->Watches.erase(iter->second);
+				impl->Directories.erase(iter);
+				continue;
+			}
+
+			if (event->len > 0)
+			{
+				FileChange change;
+				change.FilePath = Path(iter->second).AppendFragment(event->name, true);
+				change.Type = FileChangeType::Modified;
+
+				if ((event->mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+				{
+					change.Type = FileChangeType::Added;
+				}
+				else if ((event->mask & (IN_DELETE | IN_MOVED_FROM)) != 0)
+				{
+					change.Type = FileChangeType::Removed;
+				}
+
+				changes.push_back(change);
+			}
+		}
+	}
+
+	return true;
+}
+
+}; // namespace Platform
+}; // namespace MicroBuild
+
+#endif // MB_PLATFORM_LINUX
@@ -0,0 +1,261 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "Core/Platform/LocalSocket.h"
+#include "Core/Helpers/Strings.h"
+
+#ifdef MB_PLATFORM_LINUX
+
+#include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <stddef.h>
+
+namespace MicroBuild {
+namespace Platform {
+
+struct LocalSocketImpl
+{
+	int Handle;
+};
+
+// Endpoints live in the abstract socket namespace so there are no socket 
+// files to clean up. The namespace is shared by all users, so the endpoint 
+// name includes our user id and both ends refuse peers owned by another 
+// user, as anyone could bind the name first.
+static socklen_t GetSocketAddress(const std::string& name, struct sockaddr_un& address)
+{
+	std::string fullName = Strings::Format("MicroBuild.%u.%s", (unsigned int)getuid(), name.c_str());
+	fullName = fullName.substr(0, sizeof(address.sun_path) - 1);
+
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path + 1, fullName.data(), fullName.size());
+
+	return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + fullName.size());
+}
+
+static bool IsPeerSameUser(int handle)
+{
+	struct ucred credentials;
+	socklen_t credentialsLength = sizeof(credentials);
+
+	return getsockopt(handle, SOL_SOCKET, SO_PEERCRED, &credentials, &credentialsLength) == 0 &&
+		   credentials.uid == getuid();
+}
+
+static bool WriteAll(int handle, const char* data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t written = send(handle, data, length, MSG_NOSIGNAL);
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+
+		data += written;
+		length -= written;
+	}
+
+	return true;
+}
+
+static bool ReadAll(int handle, char* data, size_t length)
+{
+	while (length > 0)
+	{
+		ssize_t bytesRead = recv(handle, data, length, 0);
+		if (bytesRead <= 0)
+		{
+			if (bytesRead < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+
+		data += bytesRead;
+		length -= bytesRead;
+	}
+
+	return true;
+}
+
+LocalSocket::LocalSocket()
+	: m_impl(nullptr)
+{
+}
+
+LocalSocket::~LocalSocket()
+{
+	Close();
+}
+
+bool LocalSocket::Listen(const std::string& name)
+{
+	Close();
+
+	int handle = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (handle < 0)
+	{
+		return false;
+	}
+
+	struct sockaddr_un address;
+	socklen_t addressLength = GetSocketAddress(name, address);
+
+	if (bind(handle, reinterpret_cast<struct sockaddr*>(&address), addressLength) < 0 ||
+		listen(handle, 16) < 0)
+	{
+		close(handle);
+		return false;
+	}
+
+	LocalSocketImpl* impl = new LocalSocketImpl();
+	impl->Handle = handle;
+	m_impl = impl;
+
+	return true;
+}
+
+bool LocalSocket::Accept(LocalSocket& client, int timeoutMs)
+{
+	LocalSocketImpl* impl = reinterpret_cast<LocalSocketImpl*>(m_impl);
+	if (impl == nullptr)
+	{
+		return false;
+	}
+
+	struct pollfd descriptor;
+	descriptor.fd = impl->Handle;
+	descriptor.events = POLLIN;
+	descriptor.revents = 0;
+
+	if (poll(&descriptor, 1, timeoutMs) <= 0)
+	{
+		return false;
+	}
+
+	int handle = accept4(impl->Handle, nullptr, nullptr, SOCK_CLOEXEC);
+	if (handle < 0)
+	{
+		return false;
+	}
+
+	if (!IsPeerSameUser(handle))
+	{
+		close(handle);
+		return false;
+	}
+
+	client.Close();
+
+	LocalSocketImpl* clientImpl = new LocalSocketImpl();
+	clientImpl->Handle = handle;
+	client.m_impl = clientImpl;
+
+	return true;
+}
+
+bool LocalSocket::Connect(const std::string& name)
+{
+	Close();
+
+	int handle = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (handle < 0)
+	{
+		return false;
+	}
+
+	struct sockaddr_un address;
+	socklen_t addressLength = GetSocketAddress(name, address);
+
+	if (connect(handle, reinterpret_cast<struct sockaddr*>(&address), addressLength) < 0 ||
+		!IsPeerSameUser(handle))
+	{
+		close(handle);
+		return false;
+	}
+
+	LocalSocketImpl* impl = new LocalSocketImpl();
+	impl->Handle = handle;
+	m_impl = impl;
+
+	return true;
+}
+
+void LocalSocket::Close()
+{
+	LocalSocketImpl* impl = reinterpret_cast<LocalSocketImpl*>(m_impl);
+	if (impl != nullptr)
+	{
+		close(impl->Handle);
+		delete impl;
+		m_impl = nullptr;
+	}
+}
+
+bool LocalSocket::IsOpen()
+{
+	return (m_impl != nullptr);
+}
+
+bool LocalSocket::Send(const std::string& message)
+{
+	LocalSocketImpl* impl = reinterpret_cast<LocalSocketImpl*>(m_impl);
+	if (impl == nullptr)
+	{
+		return false;
+	}
+
+	uint32_t length = (uint32_t)message.size();
+
+	return WriteAll(impl->Handle, reinterpret_cast<const char*>(&length), sizeof(length)) &&
+		   WriteAll(impl->Handle, message.data(), message.size());
+}
+
+bool LocalSocket::Receive(std::string& message)
+{
+	LocalSocketImpl* impl = reinterpret_cast<LocalSocketImpl*>(m_impl);
+	if (impl == nullptr)
+	{
+		return false;
+	}
+
+	uint32_t length = 0;
+	if (!ReadAll(impl->Handle, reinterpret_cast<char*>(&length), sizeof(length)))
+	{
+		return false;
+	}
+
+	message.resize(length);
+	return ReadAll(impl->Handle, &message[0], length);
+}
+
+}; // namespace Platform
+}; // namespace MicroBuild
+
+#endif // MB_PLATFORM_LINUX
@@ -22,6 +22,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef MB_PLATFORM_LINUX
 
 #include <unistd.h>
+#include <cstring>
+
+extern char** environ;
 
 namespace MicroBuild {
 namespace Platform {
@@ -47,6 +50,22 @@ bool IsOperatingSystem64Bit()
 	return true;
 }
 
+std::map<std::string, std::string> GetEnvironmentVariables()
+{
+	std::map<std::string, std::string> result;
+
+	for (char** entry = environ; *entry != nullptr; entry++)
+	{
+		const char* split = strchr(*entry, '=');
+		if (split != nullptr)
+		{
+			result[std::string(*entry, split - *entry)] = split + 1;
+		}
+	}
+
+	return result;
+}
+
 void SetEnvironmentVariable(const std::string& tag, const std::string& value)
 {
 	assert(false); // TODO: Fix if this is ever actually used on linux.
@@ -24,10 +24,22 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef MB_PLATFORM_LINUX
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
 #include <spawn.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <sys/ioctl.h>
 
+// posix_spawn_file_actions_addchdir_np lets us give each spawned process its own
+// working directory, older glibc's don't have it so we fall back to vfork/exec.
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+#define MB_HAS_SPAWN_ADDCHDIR 1
+#else
+#define MB_HAS_SPAWN_ADDCHDIR 0
+#endif
+
 extern char **environ;
 
 namespace MicroBuild {
@@ -36,18 +48,84 @@ namespace Platform {
 struct Linux_Process
 {
 	bool m_attached;
+	bool m_exited;
+	bool m_outputClosed;
+	int m_exitCode;
 	pid_t m_processId;
-	posix_spawn_file_actions_t m_spawn_action;
 	int m_cout_pipe[2];
 };
 
+// Spawns the given command with its stdout/stderr redirected to outputFd and with the 
+// given working directory. We can't touch the process-wide working directory here as 
+// multiple processes are spawned in parallel by the builder.
+static int SpawnProcess(
+	pid_t* processId,
+	const char* command,
+	const char* workingDirectory,
+	int outputFd,
+	char** argv)
+{
+#if MB_HAS_SPAWN_ADDCHDIR
+
+	posix_spawn_file_actions_t spawnActions;
+	posix_spawn_file_actions_init(&spawnActions);
+	posix_spawn_file_actions_adddup2(&spawnActions, outputFd, STDOUT_FILENO);
+	posix_spawn_file_actions_adddup2(&spawnActions, outputFd, STDERR_FILENO);
+	if (workingDirectory[0] != '\0')
+	{
+		posix_spawn_file_actions_addchdir_np(&spawnActions, workingDirectory);
+	}
+
+	int result = posix_spawn(
+		processId, 
+		command,
+		&spawnActions,
+		nullptr,
+		argv,
+		environ
+	);
+
+	posix_spawn_file_actions_destroy(&spawnActions);
+
+	return result;
+
+#else
+
+	pid_t pid = vfork();
+	if (pid < 0)
+	{
+		return errno;
+	}
+	else if (pid == 0)
+	{
+		// Only async-signal-safe calls from here on.
+		if (workingDirectory[0] != '\0' && chdir(workingDirectory) != 0)
+		{
+			_exit(127);
+		}
+		dup2(outputFd, STDOUT_FILENO);
+		dup2(outputFd, STDERR_FILENO);
+		execve(command, argv, environ);
+		_exit(127);
+	}
+
+	*processId = pid;
+	return 0;
+
+#endif
+}
+
 Process::Process()
 {
 	m_impl = new Linux_Process();
+	m_readBufferOffset = 0;
 
 	Linux_Process* data = reinterpret_cast<Linux_Process*>(m_impl);
 	data->m_processId = 0;
 	data->m_attached = false;
+	data->m_exited = false;
+	data->m_outputClosed = false;
+	data->m_exitCode = 0;
 }
 
 Process::~Process()
@@ -89,41 +167,35 @@ bool Process::Open(
 
 	// Store state.
 	data->m_attached = true;
+	data->m_exited = false;
+	data->m_outputClosed = false;
+	data->m_exitCode = 0;
 
-	// Create spawn state.
-	if (pipe(data->m_cout_pipe))
+	// Create spawn state. Both ends are close-on-exec so processes spawned in
+	// parallel on other threads don't inherit them and hold our pipe open.
+	if (pipe2(data->m_cout_pipe, O_CLOEXEC))
 	{
+		data->m_attached = false;
 		return false;
 	}
-
-	posix_spawn_file_actions_init(&data->m_spawn_action);
-	posix_spawn_file_actions_addclose(&data->m_spawn_action, data->m_cout_pipe[0]);
-	posix_spawn_file_actions_adddup2(&data->m_spawn_action, data->m_cout_pipe[1], STDOUT_FILENO);
-	posix_spawn_file_actions_adddup2(&data->m_spawn_action, data->m_cout_pipe[1], STDERR_FILENO);
  
 	// Create process.
-	
-	// We have to change the working directory as posix_spawn inherits
-	// the current processes one -_-
-	Platform::Path originalWorkingDirectory = Platform::Path::GetWorkingDirectory();
-	Platform::Path::SetWorkingDirectory(workingDirectory);
+	std::string commandString = command.ToString();
+	std::string workingDirectoryString = workingDirectory.ToString();
 
-	int result = posix_spawn(
+	int result = SpawnProcess(
 		&data->m_processId, 
-		command.ToString().c_str(),
-		&data->m_spawn_action,
-		nullptr,
-		argv,
-		environ
+		commandString.c_str(),
+		workingDirectoryString.c_str(),
+		data->m_cout_pipe[1],
+		argv
 	);
 
-	Platform::Path::SetWorkingDirectory(originalWorkingDirectory);
-
 	close(data->m_cout_pipe[1]);
 
 	for (int i = 0; i < (int)argvBase.size(); i++)
 	{
-        	delete[] argv[i];
+		delete[] argv[i];
 	}
 	delete[] argv;
     
@@ -148,9 +220,6 @@ void Process::Detach()
 	data->m_attached = false;
 
 	close(data->m_cout_pipe[0]);
-	//close(data->m_cout_pipe[1]);
-
-	posix_spawn_file_actions_destroy(&data->m_spawn_action);
 }
 
 void Process::Terminate()
@@ -158,7 +227,49 @@ void Process::Terminate()
 	Linux_Process* data = reinterpret_cast<Linux_Process*>(m_impl);
 	assert(IsAttached());
 
-	kill(data->m_processId, SIGKILL);
+	if (!data->m_exited)
+	{
+		kill(data->m_processId, SIGKILL);
+	}
+}
+
+// Reaps the process if it has finished and stores its exit code, returns true
+// if the process has exited.
+static bool ReapProcess(Linux_Process* data, bool bBlock)
+{
+	if (data->m_exited)
+	{
+		return true;
+	}
+
+	int status = 0;
+	pid_t result = 0;
+	do
+	{
+		result = waitpid(data->m_processId, &status, bBlock ? 0 : WNOHANG);
+	} 
+	while (result < 0 && errno == EINTR);
+
+	if (result == data->m_processId)
+	{
+		data->m_exited = true;
+
+		if (WIFEXITED(status))
+		{
+			data->m_exitCode = WEXITSTATUS(status);
+		}
+		else if (WIFSIGNALED(status))
+		{
+			data->m_exitCode = 128 + WTERMSIG(status);
+		}
+	}
+	else if (result < 0)
+	{
+		// Already reaped, or not our child, either way its not running.
+		data->m_exited = true;
+	}
+
+	return data->m_exited;
 }
 
 bool Process::IsRunning()
@@ -166,8 +277,7 @@ bool Process::IsRunning()
 	Linux_Process* data = reinterpret_cast<Linux_Process*>(m_impl);
 	assert(IsAttached());
 
-	int result = kill(data->m_processId, 0);
-	return (result == 0);
+	return !ReapProcess(data, false);
 }
 
 bool Process::IsAttached()
@@ -182,8 +292,7 @@ bool Process::Wait()
 	Linux_Process* data = reinterpret_cast<Linux_Process*>(m_impl);
 	assert(IsAttached());
 
-	int resultCode = 0;
-	waitpid(data->m_processId, &resultCode, 0);
+	ReapProcess(data, true);
 
 	return true;
 }
@@ -193,9 +302,9 @@ int Process::GetExitCode()
 	Linux_Process* data = reinterpret_cast<Linux_Process*>(m_impl);
 	assert(IsAttached());
 
-	int resultCode = 0;
-	waitpid(data->m_processId, &resultCode, WNOHANG);
-	return resultCode;
+	ReapProcess(data, false);
+
+	return data->m_exitCode;
 }
 
 size_t Process::Internal_Write(void* buffer, uint64_t bufferLength)
@@ -212,8 +321,46 @@ size_t Process::Internal_Read(void* buffer, uint64_t bufferLength)
 	Linux_Process* data = reinterpret_cast<Linux_Process*>(m_impl);
 	assert(IsAttached());
 
-	ssize_t count = read(data->m_cout_pipe[0], buffer, bufferLength);
-	return count < 0 ? 0 : (size_t)count;
+	if (data->m_outputClosed)
+	{
+		return 0;
+	}
+
+	// Sleep in the kernel until the child writes something or closes its end.
+	pollfd pollData;
+	pollData.fd = data->m_cout_pipe[0];
+	pollData.events = POLLIN;
+	pollData.revents = 0;
+
+	while (true)
+	{
+		int result = poll(&pollData, 1, -1);
+		if (result > 0)
+		{
+			break;
+		}
+		else if (result < 0 && errno != EINTR)
+		{
+			data->m_outputClosed = true;
+			return 0;
+		}
+	}
+
+	ssize_t count = 0;
+	do
+	{
+		count = read(data->m_cout_pipe[0], buffer, bufferLength);
+	}
+	while (count < 0 && errno == EINTR);
+
+	// Zero bytes after a successful poll means every writer has gone.
+	if (count <= 0)
+	{
+		data->m_outputClosed = true;
+		return 0;
+	}
+
+	return (size_t)count;
 }
 
 void Process::Flush()
@@ -226,13 +373,28 @@ uint64_t Process::Internal_BytesLeft()
 	Linux_Process* data = reinterpret_cast<Linux_Process*>(m_impl);
 	assert(IsAttached());
 
-	size_t bytesAvailable = 0;
+	if (data->m_outputClosed)
+	{
+		return 0;
+	}
+
+	int bytesAvailable = 0;
 	int result = ioctl(data->m_cout_pipe[0], FIONREAD, &bytesAvailable);
 	
 	//Log(LogSeverity::Warning, "(BytesLeft) Result=%i Bytes=%i\n", result, (int)bytesAvailable);
 	return result >= 0 ? (uint64_t)bytesAvailable : 0;
 }
 
+bool Process::Internal_AtEnd()
+{
+	Linux_Process* data = reinterpret_cast<Linux_Process*>(m_impl);
+	assert(IsAttached());
+
+	// The pipe closing is the only reliable end marker, the process can exit while
+	// output is still buffered, or keep running after closing its stdout.
+	return data->m_outputClosed;
+}
+
 }; // namespace Platform
 }; // namespace MicroBuild
 
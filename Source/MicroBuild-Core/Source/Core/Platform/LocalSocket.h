@@ -0,0 +1,71 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "PCH.h"
+
+namespace MicroBuild {
+namespace Platform {
+
+// Stream connection between processes running on the local machine as the 
+// same user. Endpoints are identified by name rather than a network address. 
+// Messages are length-prefixed so each call to Send is matched by exactly 
+// one call to Receive on the other end.
+class LocalSocket
+{
+protected:
+	void* m_impl; // Semi-pimpl idiom, contains any platform specific data.
+
+public:
+
+	// No copy construction please.
+	LocalSocket(const LocalSocket& other) = delete;
+
+	// Construction.
+	LocalSocket();
+	~LocalSocket();
+
+	// Starts listening for connections on the endpoint with the given name. Fails
+	// if something is already listening on it.
+	bool Listen(const std::string& name);
+
+	// Waits up to the given number of milliseconds for an incoming connection 
+	// and accepts it into the given socket. Returns false if nothing connected.
+	bool Accept(LocalSocket& client, int timeoutMs);
+
+	// Connects to the endpoint with the given name.
+	bool Connect(const std::string& name);
+
+	// Closes the connection or stops listening.
+	void Close();
+
+	// Returns true if the socket is connected or listening.
+	bool IsOpen();
+
+	// Sends a single message, blocks until it has been fully written.
+	bool Send(const std::string& message);
+
+	// Receives a single message, blocks until it has been fully read. Returns
+	// false if the connection was closed.
+	bool Receive(std::string& message);
+
+};
+
+};
+};
@@ -0,0 +1,67 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "Core/Platform/FileWatcher.h"
+
+#ifdef MB_PLATFORM_MACOS
+
+namespace MicroBuild {
+namespace Platform {
+
+// TODO: Not currently supported on this platform, anything relying on file
+//		 watching falls back to its non-resident behaviour.
+
+FileWatcher::FileWatcher()
+	: m_impl(nullptr)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+bool FileWatcher::Init()
+{
+	return false;
+}
+
+bool FileWatcher::Watch(const Path& directory)
+{
+	MB_UNUSED_PARAMETER(directory);
+	return false;
+}
+
+bool FileWatcher::IsWatching(const Path& directory)
+{
+	MB_UNUSED_PARAMETER(directory);
+	return false;
+}
+
+bool FileWatcher::Poll(std::vector<FileChange>& changes, bool& bOverflow, int timeoutMs)
+{
+	MB_UNUSED_PARAMETER(changes);
+	MB_UNUSED_PARAMETER(bOverflow);
+	MB_UNUSED_PARAMETER(timeoutMs);
+	return false;
+}
+
+}; // namespace Platform
+}; // namespace MicroBuild
+
+#endif // MB_PLATFORM_MACOS
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <sys/types.h>
 #include <fcntl.h>
 #include <dirent.h>
+#include <sys/time.h>
 
 namespace MicroBuild {
 namespace Platform {
@@ -115,6 +116,56 @@ std::vector<std::string> Path::GetDirectories() const
 	return result;
 }
 
+bool Path::GetEntries(std::vector<std::string>& files, std::vector<std::string>& directories) const
+{
+	DIR* handle = opendir(m_raw.c_str());
+	if (handle == nullptr)
+	{
+		return false;
+	}
+
+	while (true)
+	{
+		struct dirent* entry = readdir(handle);
+		if (entry == nullptr)
+		{	
+			break;
+		}
+
+		if (strcmp(entry->d_name, ".") == 0 ||
+			strcmp(entry->d_name, "..") == 0)
+		{
+			continue;
+		}
+
+		// Trust d_type where the file system fills it in, links (which we 
+		// follow) and file systems that leave it unknown still need a stat.
+		unsigned char type = entry->d_type;
+		if (type == DT_UNKNOWN || type == DT_LNK)
+		{
+			struct stat attr;
+			if (stat(AppendFragment(entry->d_name, true).ToString().c_str(), &attr) != 0)
+			{
+				continue;
+			}
+
+			type = S_ISDIR(attr.st_mode) ? DT_DIR : (S_ISREG(attr.st_mode) ? DT_REG : DT_UNKNOWN);
+		}
+
+		if (type == DT_DIR)
+		{
+			directories.push_back(entry->d_name);
+		}
+		else if (type == DT_REG)
+		{
+			files.push_back(entry->d_name);
+		}
+	}
+
+	closedir(handle);
+	return true;
+}
+
 bool Path::Copy(const Path& Destination) const
 {
 	if (IsFile())
@@ -241,6 +292,32 @@ bool Path::Exists() const
 
 bool Path::Delete() const
 {
+	// Symbolic links are removed rather than followed.
+	struct stat attr;
+	if (lstat(m_raw.c_str(), &attr) == 0 && S_ISDIR(attr.st_mode))
+	{
+		std::vector<std::string> SubDirs = GetDirectories();
+		std::vector<std::string> SubFiles = GetFiles();
+
+		// Delete all sub directories.
+		for (std::string& path : SubDirs)
+		{
+			Path FullPath = (*this).AppendFragment(path, true);
+			FullPath.Delete();
+		}
+
+		// Delete all sub files.
+		for (std::string& path : SubFiles)
+		{
+			Path FullPath = (*this).AppendFragment(path, true);
+			FullPath.Delete();
+		}
+
+		// Delete the actual folder.
+		int result = rmdir(m_raw.c_str());
+		return (result == 0);
+	}
+
 	int result = unlink(m_raw.c_str());
 	return (result == 0);
 }
@@ -259,6 +336,55 @@ std::time_t Path::GetModifiedTime() const
 	}
 }
 
+uint64_t Path::GetModifiedTimeNs() const
+{
+	struct stat attr;
+	int result = stat(m_raw.c_str(), &attr);
+	if (result == 0)
+	{
+		return (uint64_t)attr.st_mtimespec.tv_sec * 1000000000ULL + (uint64_t)attr.st_mtimespec.tv_nsec;
+	}
+	else
+	{
+		return 0ULL;
+	}
+}
+
+bool Path::GetFileState(bool& isDirectory, uint64_t& modifiedTimeNs) const
+{
+	isDirectory = false;
+	modifiedTimeNs = 0ULL;
+
+	struct stat attr;
+	if (stat(m_raw.c_str(), &attr) != 0)
+	{
+		return false;
+	}
+
+	isDirectory = S_ISDIR(attr.st_mode);
+	modifiedTimeNs = (uint64_t)attr.st_mtimespec.tv_sec * 1000000000ULL + (uint64_t)attr.st_mtimespec.tv_nsec;
+	return true;
+}
+
+bool Path::Touch() const
+{
+	return utimes(m_raw.c_str(), nullptr) == 0;
+}
+
+uint64_t Path::GetSize() const
+{
+	struct stat attr;
+	int result = stat(m_raw.c_str(), &attr);
+	if (result == 0)
+	{
+		return (uint64_t)attr.st_size;
+	}
+	else
+	{
+		return 0ULL;
+	}
+}
+
 }; // namespace Platform
 }; // namespace MicroBuild
 
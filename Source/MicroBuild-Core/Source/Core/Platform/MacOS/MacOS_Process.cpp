@@ -45,6 +45,7 @@ struct MacOS_Process
 Process::Process()
 {
 	m_impl = new MacOS_Process();
+	m_readBufferOffset = 0;
 
 	MacOS_Process* data = reinterpret_cast<MacOS_Process*>(m_impl);
 	data->m_processId = 0;
@@ -234,6 +235,11 @@ uint64_t Process::Internal_BytesLeft()
 	return result >= 0 ? (uint64_t)bytesAvailable : 0;
 }
 
+bool Process::Internal_AtEnd()
+{
+	return !IsRunning() && Internal_BytesLeft() <= 0;
+}
+
 }; // namespace Platform
 }; // namespace MicroBuild
 
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Helpers/Time.h"
 
 #include <sstream>
+#include <chrono>
 
 #ifdef MB_PLATFORM_WINDOWS
 #include <direct.h>
@@ -830,246 +831,286 @@ Path Path::GetUncommonPath(Path& commonPath)
 	return uncommon;
 }
 
-struct PathMatchFragment
+// Coarsest timestamp resolution of the file systems we expect to run on 
+// (FAT stores modification times to two seconds).
+const uint64_t k_FileTimeResolutionNs = 2000000000ULL;
+
+// Gets the modification time to record for a directory that is about to be 
+// listed. If it was modified within the timestamp resolution of now, entries
+// added after we list it may not change its timestamp, so the walk can't be
+// trusted and an unstable time is returned instead. This is the same "racily
+// clean" problem git has with its index.
+uint64_t MatchFilter_StampDirectory(const Path& directory)
+{
+	bool bIsDirectory = false;
+	uint64_t modifiedTime = 0;
+	if (!directory.GetFileState(bIsDirectory, modifiedTime))
+	{
+		return 0;
+	}
+
+	uint64_t now = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+
+	if (modifiedTime + k_FileTimeResolutionNs >= now)
+	{
+		return Path::UnstableModifiedTime;
+	}
+
+	return modifiedTime;
+}
+
+// A single directory level of a compiled match filter.
+struct PathFilterSegment
 {
-	std::string full;
-	std::string remaining;
-	bool valid;
-	bool isDirectory;
+	// Matches any number of directory levels, including none.
+	bool bRecursive;
+
+	// Pattern a file or directory name has to match, may contain * wildcards.
+	std::string pattern;
 };
 
-void MatchFilter_GetDirectories_r(const Path& base, std::vector<Path>& results)
+// Match filter compiled down to a list of directory levels below its root.
+struct CompiledPathFilter
 {
-	static std::string seperatorString(1, Path::Seperator);
+	std::vector<PathFilterSegment> segments;
+};
 
-	std::vector<std::string> dirs = base.GetDirectories();
+// Position of a compiled filter (first) within its segments (second) at 
+// a given directory during the walk.
+typedef std::pair<size_t, size_t> PathFilterState;
 
-	results.reserve(results.size() + dirs.size());
+bool MatchFilter_MatchName(const std::string& name, const std::string& pattern)
+{
+	size_t nameIndex = 0;
+	size_t patternIndex = 0;
+	size_t starIndex = std::string::npos;
+	size_t starNameIndex = 0;
 
-	for (std::string& path : dirs)
+	// Iterative wildcard match, on mismatch we backtrack to the last * and
+	// let it swallow one more character.
+	while (nameIndex < name.size())
 	{
-		Path fullPath = base.AppendFragment(path, true);
-		results.push_back(fullPath);
-		MatchFilter_GetDirectories_r(fullPath, results);
+		if (patternIndex < pattern.size() && pattern[patternIndex] == '*')
+		{
+			starIndex = patternIndex++;
+			starNameIndex = nameIndex;
+		}
+		else if (patternIndex < pattern.size() && pattern[patternIndex] == name[nameIndex])
+		{
+			patternIndex++;
+			nameIndex++;
+		}
+		else if (starIndex != std::string::npos)
+		{
+			patternIndex = starIndex + 1;
+			nameIndex = ++starNameIndex;
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	while (patternIndex < pattern.size() && pattern[patternIndex] == '*')
+	{
+		patternIndex++;
 	}
+
+	return patternIndex == pattern.size();
 }
 
-std::vector<Path> MatchFilter_r(
-	const Path& base, 
-	const std::vector<std::string>& matches)
+void MatchFilter_CompileSegment(
+	const std::vector<std::string>& tokens,
+	bool bFollowedBySeperator,
+	bool& bPrefixWildcard,
+	std::vector<PathFilterSegment>& segments)
 {
-	std::vector<Path> result;
-
-	std::string seperatorString(1, Path::Seperator);
+	size_t recursiveIndex = std::string::npos;
+	for (size_t i = 0; i < tokens.size(); i++)
+	{
+		if (tokens[i] == "**")
+		{
+			recursiveIndex = i;
+		}
+	}
 
-	std::string matchType = matches[0];
-	
-	//Log(LogSeverity::Verbose, "[MatchFilter_r] %s\n", base.ToString().c_str());
+	std::string pattern = bPrefixWildcard ? "*" : "";
+	bPrefixWildcard = false;
 
-	// Nothing to match again? Game over.
-	if (matches.size() == 0)
+	if (recursiveIndex == std::string::npos)
 	{
-		if (!base.IsDirectory())
+		for (const std::string& token : tokens)
 		{
-			result.push_back(base);
+			pattern += token;
 		}
-		return result;
+
+		segments.push_back({ false, pattern });
+		return;
+	}
+
+	// Anything before a recursive wildcard in the same fragment does not 
+	// constrain the match, everything after it is matched against names 
+	// found at any depth.
+	pattern = "*";
+	for (size_t i = recursiveIndex + 1; i < tokens.size(); i++)
+	{
+		pattern += tokens[i];
 	}
 
-	// Try and match up as much as possible.
+	if (pattern == "*" && bFollowedBySeperator)
+	{
+		// A trailing **/ has to match at least one directory level, the 
+		// fragment following it is matched as a suffix.
+		segments.push_back({ false, "*" });
+		segments.push_back({ true, "" });
+		bPrefixWildcard = true;
+	}
 	else
 	{
-		std::vector<PathMatchFragment> potentialMatches;
+		segments.push_back({ true, "" });
+		segments.push_back({ false, pattern });
+	}
+}
 
-		std::vector<std::string> dirs = base.GetDirectories();
-		std::vector<std::string> files = base.GetFiles();
-		
-		potentialMatches.reserve(dirs.size() + files.size());
+void MatchFilter_Compile(
+	const std::vector<std::string>& matchStack,
+	CompiledPathFilter& filter)
+{
+	std::string seperatorString(1, Path::Seperator);
+	std::vector<std::string> tokens;
+	bool bPrefixWildcard = false;
 
-		for (std::string& path : dirs)
+	for (const std::string& token : matchStack)
+	{
+		if (token == seperatorString)
 		{
-			PathMatchFragment frag;
-			frag.full = path;
-			frag.remaining = path;
-			frag.valid = true;
-			frag.isDirectory = true;
-			potentialMatches.push_back(frag);
-
-			//Log(LogSeverity::Verbose, "[Contains] Dir:%s\n", path.c_str());
+			if (!tokens.empty())
+			{
+				MatchFilter_CompileSegment(tokens, true, bPrefixWildcard, filter.segments);
+				tokens.clear();
+			}
 		}
-
-		for (std::string& path : files)
+		else
 		{
-			PathMatchFragment frag;
-			frag.full = path;
-			frag.remaining = path;
-			frag.valid = true;
-			frag.isDirectory = false;
-			potentialMatches.push_back(frag);
-
-			//Log(LogSeverity::Verbose, "[Contains] File:%s\n", path.c_str());
+			tokens.push_back(token);
 		}
-		
-		bool bFinished = false;
+	}
 
-		std::vector<std::string> matchStack(matches);
-		while (matchStack.size() > 0 && !bFinished)
-		{
-			std::string match = matchStack[0];
-			matchStack.erase(matchStack.begin());
+	if (!tokens.empty())
+	{
+		MatchFilter_CompileSegment(tokens, false, bPrefixWildcard, filter.segments);
+	}
 
-			// Non-recursive match.
-			if (match == "*")
-			{
-				// If we are at the end, or next is a directory, we can 
-				// just accept all potentials.
-				if (matchStack.size() == 0 || 
-					matchStack[0] == seperatorString)
-				{
-					for (unsigned int i = 0; i < potentialMatches.size(); i++)
-					{
-						PathMatchFragment& frag = potentialMatches[i];
-						frag.remaining = "";
-					}
-				}
-				else
-				{
-					std::string nextFragment = matchStack[0];
+	// Walking relies on a recursive segment always being followed by a 
+	// name to match.
+	if (filter.segments.empty() || filter.segments.rbegin()->bRecursive)
+	{
+		filter.segments.push_back({ false, "*" });
+	}
+}
 
-					// Try and match up any potentials.
-					for (unsigned int i = 0; i < potentialMatches.size(); i++)
-					{
-						PathMatchFragment& frag = potentialMatches[i];
-						if (frag.valid)
-						{
-							size_t offset = frag.remaining.find(
-								nextFragment.c_str()
-							);
-
-							if (offset != std::string::npos)
-							{
-								frag.remaining.erase(
-									frag.remaining.begin(),
-									frag.remaining.begin() + offset);
-							}
-							else
-							{
-								potentialMatches[i].valid = false;
-							}
-						}
-					}
-				}
-			}
-			
-			// Recursive match.
-			else if (match == "**")
+void MatchFilter_Walk(
+	const Path& directory,
+	const std::vector<CompiledPathFilter>& filters,
+	std::vector<PathFilterState>& states,
+	bool bFilesOnly,
+	std::vector<std::vector<Path>>& results,
+	std::vector<std::vector<std::pair<Path, uint64_t>>>* visitedDirectories)
+{
+	// Recursive segments can match zero directory levels, so the segment 
+	// after them is also being matched at this level.
+	for (size_t i = 0; i < states.size(); i++)
+	{
+		const PathFilterState state = states[i];
+		if (filters[state.first].segments[state.second].bRecursive)
+		{
+			PathFilterState next(state.first, state.second + 1);
+			if (std::find(states.begin(), states.end(), next) == states.end())
 			{
-				// Get a list of all directories below this sub-directory, 
-				// try and perform a match for the reset of the stack on each
-				// of these directories.
-				std::vector<Path> subDirs;
-
-				MatchFilter_GetDirectories_r(base, subDirs);
-
-				// If we have a seperator next, we don't want
-				// to pass in the base path as matches have to be at least
-				// one directory level down.
-				if (matchStack.size() > 0 && 
-					matchStack[0] == seperatorString)
-				{
-					matchStack.erase(matchStack.begin());
-				}
-				else
-				{
-					subDirs.push_back(base);
-				}
+				states.push_back(next);
+			}
+		}
+	}
 
-				// Add a non-recursive match to check against for each directory.
-				matchStack.insert(matchStack.begin(), "*");
+	// Stamp the directory before listing it, so anything added while we are
+	// listing shows up as a change.
+	if (visitedDirectories != nullptr)
+	{
+		uint64_t modifiedTime = MatchFilter_StampDirectory(directory);
 
-				for (unsigned int i = 0; i < subDirs.size(); i++)
-				{
-					std::vector<Path> subResult =
-						MatchFilter_r(subDirs[i], matchStack);
+		for (const PathFilterState& state : states)
+		{
+			std::vector<std::pair<Path, uint64_t>>& visited = (*visitedDirectories)[state.first];
+			if (visited.empty() || visited.rbegin()->first != directory)
+			{
+				visited.push_back(std::pair<Path, uint64_t>(directory, modifiedTime));
+			}
+		}
+	}
 
-					result.reserve(subResult.size() + result.size());
+	std::vector<std::string> files;
+	std::vector<std::string> directories;
+	if (!directory.GetEntries(files, directories))
+	{
+		return;
+	}
 
-					for (Path& path : subResult)
-					{
-						result.push_back(path);
-					}
-				}
+	std::vector<std::vector<PathFilterState>> childStates(directories.size());
+
+	for (const PathFilterState& state : states)
+	{
+		const std::vector<PathFilterSegment>& segments = filters[state.first].segments;
+		const PathFilterSegment& segment = segments[state.second];
+		bool bLastSegment = (state.second + 1 == segments.size());
 
-				// No more matching at this level.
-				bFinished = true;
+		if (segment.bRecursive)
+		{
+			for (size_t i = 0; i < directories.size(); i++)
+			{
+				childStates[i].push_back(state);
 			}
+			continue;
+		}
 
-			// Expected directory.
-			else if (match == seperatorString)
+		for (size_t i = 0; i < directories.size(); i++)
+		{
+			if (MatchFilter_MatchName(directories[i], segment.pattern))
 			{
-				// Recurse into each directory.
-				for (unsigned int i = 0; i < potentialMatches.size(); i++)
+				if (!bLastSegment)
 				{
-					PathMatchFragment& frag = potentialMatches[i];
-					if (frag.remaining.empty() && frag.valid)
-					{						
-						if (frag.isDirectory)
-						{
-							std::vector<Path> subResult = 
-								MatchFilter_r(base + seperatorString + frag.full, matchStack);
-
-							for (Path& subPath : subResult)
-							{
-								result.push_back(subPath);
-							}
-						}
-					}
+					childStates[i].push_back(PathFilterState(state.first, state.second + 1));
 				}
-
-				// No more matching at this level.
-				bFinished = true;
-			}
-			
-			// Literal match.
-			else
-			{
-				for (unsigned int i = 0; i < potentialMatches.size(); i++) 
+				else if (!bFilesOnly)
 				{
-					PathMatchFragment& frag = potentialMatches[i];
-
-					if (frag.remaining.size() >= match.size() &&
-						frag.remaining.substr(0, match.size()) == match)
-					{
-						frag.remaining.erase(
-							frag.remaining.begin(), 
-							frag.remaining.begin() + match.size());
-					}
-					else
-					{
-						potentialMatches[i].valid = false;
-					}
+					results[state.first].push_back(directory.AppendFragment(directories[i], true));
 				}
 			}
 		}
 
-		// If we are not finished, but we are out of matches, see if any 
-		// potential matches are now empty.
-		if (!bFinished)
+		if (bLastSegment)
 		{
-			result.reserve(potentialMatches.size());
-
-			for (unsigned int i = 0; i < potentialMatches.size(); i++)
+			for (const std::string& file : files)
 			{
-				PathMatchFragment& frag = potentialMatches[i];
-				if (frag.remaining.empty() && frag.valid/*&& !frag.isDirectory*/)
+				if (MatchFilter_MatchName(file, segment.pattern))
 				{
-					result.push_back(base.AppendFragment(frag.full, true));
+					results[state.first].push_back(directory.AppendFragment(file, true));
 				}
 			}
 		}
 	}
-	
-	return result;
+
+	for (size_t i = 0; i < directories.size(); i++)
+	{
+		std::vector<PathFilterState>& subStates = childStates[i];
+		if (!subStates.empty())
+		{
+			std::sort(subStates.begin(), subStates.end());
+			subStates.erase(std::unique(subStates.begin(), subStates.end()), subStates.end());
+
+			MatchFilter_Walk(directory.AppendFragment(directories[i], true), filters, subStates, bFilesOnly, results, visitedDirectories);
+		}
+	}
 }
 
 bool SplitIntoMatchStack(
@@ -1177,46 +1218,88 @@ void TrimMatchStackDownToFirstWildcard(
 	);
 }
 
-std::vector<Path> Path::MatchFilter(const Path& path)
+std::vector<Path> Path::MatchFilter(const Path& path, bool bFilesOnly)
+{
+	return MatchFilters({ path }, bFilesOnly)[0];
+}
+
+std::vector<std::vector<Path>> Path::MatchFilters(
+	const std::vector<Path>& paths, 
+	bool bFilesOnly,
+	std::vector<std::vector<std::pair<Path, uint64_t>>>* visitedDirectories)
 {
 	//Time::TimedScope scope("Match Filter");
 
-	std::vector<Path> result;
+	std::vector<std::vector<Path>> results(paths.size());
+	std::vector<CompiledPathFilter> filters(paths.size());
 
-	// No match filters, early-out.
-	if (path.ToString().find('*') == std::string::npos)
+	if (visitedDirectories != nullptr)
 	{
-		result.push_back(path);
-		return result;
+		visitedDirectories->clear();
+		visitedDirectories->resize(paths.size());
 	}
 
-	// Split into wildcards and fragments.
-	std::vector<std::string> matchStack;
-	if (!SplitIntoMatchStack(path.ToString(), matchStack))
-	{
-		result.push_back(path);
-		return result;
-	}
+	// Filters are grouped by the directory their first wildcard is in, each 
+	// group is matched during a single walk of that directory.
+	std::map<std::string, std::vector<PathFilterState>> roots;
 
-	/*Log(LogSeverity::Verbose, "=== MatchFilter(%s) ===\n", path.m_raw.c_str());
-	for (auto str : matchStack)
+	for (size_t i = 0; i < paths.size(); i++)
 	{
-		Log(LogSeverity::Verbose, "[Stack] %s\n", str.c_str());
-	}*/
+		const Path& path = paths[i];
+
+		// No match filters, early-out.
+		if (path.ToString().find('*') == std::string::npos)
+		{
+			// Whether the file exists depends on its directory.
+			if (bFilesOnly && visitedDirectories != nullptr)
+			{
+				Path directory = path.GetDirectory();
+				uint64_t modifiedTime = MatchFilter_StampDirectory(directory);
+
+				(*visitedDirectories)[i].push_back(std::pair<Path, uint64_t>(directory, modifiedTime));
+			}
+
+			if (!bFilesOnly || path.IsFile())
+			{
+				results[i].push_back(path);
+			}
+			continue;
+		}
+
+		// Split into wildcards and fragments.
+		std::vector<std::string> matchStack;
+		if (!SplitIntoMatchStack(path.ToString(), matchStack))
+		{
+			results[i].push_back(path);
+			continue;
+		}
+
+		/*Log(LogSeverity::Verbose, "=== MatchFilter(%s) ===\n", path.m_raw.c_str());
+		for (auto str : matchStack)
+		{
+			Log(LogSeverity::Verbose, "[Stack] %s\n", str.c_str());
+		}*/
+
+		// If we only have one split, we are done.
+		if (matchStack.size() == 1)
+		{
+			results[i].push_back(matchStack[0]);
+			continue;
+		}
 
-	// If we only have one split, we are done.
-	if (matchStack.size() == 1)
-	{
-		result.push_back(matchStack[0]);
-	}
-	else
-	{
 		std::string subValue = "";
 		TrimMatchStackDownToFirstWildcard(matchStack, subValue);
-		result = MatchFilter_r(subValue, matchStack);
+		MatchFilter_Compile(matchStack, filters[i]);
+
+		roots[Path(subValue).ToString()].push_back(PathFilterState(i, 0));
 	}
 
-	return result;
+	for (auto& pair : roots)
+	{
+		MatchFilter_Walk(pair.first, filters, pair.second, bFilesOnly, results, visitedDirectories);
+	}
+
+	return results;
 }
 
 Path Path::GetWorkingDirectory()
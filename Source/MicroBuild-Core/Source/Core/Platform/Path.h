@@ -36,6 +36,12 @@ public:
 	// Seperator of individual path segments.
 	static char Seperator;
 
+	// Modification time stored for a directory that was listed too soon after
+	// it last changed to trust its timestamp; anything else added within the
+	// file system's timestamp resolution could share it. Never matches a real
+	// modification time, so anything validated against it is rechecked.
+	static const uint64_t UnstableModifiedTime = ~0ULL;
+
 	// Constructors.
 	Path();
 	Path(const char* Value);
@@ -96,6 +102,11 @@ public:
 	// directory this path points to.
 	std::vector<std::string> GetDirectories() const;
 
+	// Lists the names of the files and directories in the directory this 
+	// path points to in a single enumeration. Returns false if the directory
+	// could not be opened.
+	bool GetEntries(std::vector<std::string>& files, std::vector<std::string>& directories) const;
+
 	// Returns a list of fragments that make up this path.
 	std::vector<std::string> GetFragments() const;
 
@@ -166,6 +177,21 @@ public:
 	// Gets the time this path was last modified.
 	std::time_t GetModifiedTime() const;
 
+	// Gets the time this path was last modified in nanoseconds since the unix 
+	// epoch, at whatever precision the file system provides.
+	uint64_t GetModifiedTimeNs() const;
+
+	// Queries existence, type and modified time (in nanoseconds since the
+	// unix epoch) with a single file system call. Returns false and leaves
+	// the outputs zeroed if the path does not exist.
+	bool GetFileState(bool& isDirectory, uint64_t& modifiedTimeNs) const;
+
+	// Sets the modified time of this path to the current time.
+	bool Touch() const;
+
+	// Gets the size of the file this path points to in bytes.
+	uint64_t GetSize() const;
+
 	// Creates a path that represents a relative reference from this path
 	// to the given destination path.
 	Path RelativeTo(const Path& Destination) const;
@@ -176,8 +202,21 @@ public:
 	//	./MyFolder/*.ini 
 	//	./MyFolder/**/Project.ini
 	//	./**.ini
-	// Input path should be absolute.
-	static std::vector<Path> MatchFilter(const Path& path);
+	// Input path should be absolute. If bFilesOnly is set matched directories
+	// are left out of the result.
+	static std::vector<Path> MatchFilter(const Path& path, bool bFilesOnly = false);
+
+	// Same as MatchFilter but for multiple filters at once, filters that 
+	// share a root directory are matched in a single walk of it. Results are
+	// returned in the same order as the filters.
+	// If visitedDirectories is set it receives, for each filter, every 
+	// directory that was listed to match it along with its modification 
+	// time just before it was listed (zero if it could not be listed, or
+	// UnstableModifiedTime if it changed too recently to be trusted).
+	static std::vector<std::vector<Path>> MatchFilters(
+		const std::vector<Path>& paths, 
+		bool bFilesOnly = false,
+		std::vector<std::vector<std::pair<Path, uint64_t>>>* visitedDirectories = nullptr);
 
 	// Performs th same matching logic as MatchFilter to see if the given
 	// path would match the given filter.
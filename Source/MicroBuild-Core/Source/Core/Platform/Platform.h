@@ -27,6 +27,9 @@ void DebugOutput(const char* output);
 // Gets the given environment variable based on its tag.
 std::string GetEnvironmentVariable(const std::string& tag);
 
+// Gets the tag and value of every environment variable.
+std::map<std::string, std::string> GetEnvironmentVariables();
+
 // Set the given environment variable based on its tag.
 void SetEnvironmentVariable(const std::string& tag, const std::string& value);
 
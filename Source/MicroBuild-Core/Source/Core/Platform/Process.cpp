@@ -21,7 +21,6 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Helpers/Time.h"
 
 #include <cstdlib>
-#include <sstream>
 #include <cstring>
 
 namespace MicroBuild {
@@ -40,32 +39,52 @@ std::string GetEnvironmentVariable(const std::string& tag)
 	}
 }
 
-std::string Process::ReadToEnd(bool bPrintOutput)
+bool Process::FillReadBuffer()
 {
-	//Time::TimedScope scope("ReadToEnd:%s", false);
+	// Discard whatever has already been consumed before pulling in more.
+	if (m_readBufferOffset > 0)
+	{
+		m_readBuffer.erase(m_readBuffer.begin(), m_readBuffer.begin() + m_readBufferOffset);
+		m_readBufferOffset = 0;
+	}
+
+	if (Internal_AtEnd())
+	{
+		return false;
+	}
 
-	//MB_UNUSED_PARAMETER(bPrintOutput);
+	size_t originalSize = m_readBuffer.size();
+	m_readBuffer.resize(originalSize + BufferChunkSize);
 
-	std::stringstream stream;
+	size_t totalRead = (size_t)Internal_Read(m_readBuffer.data() + originalSize, BufferChunkSize);
+	m_readBuffer.resize(originalSize + totalRead);
 
-	const int bufferSize = 128;
-	std::vector<char> buffer;
-	buffer.resize(bufferSize);
+	return (totalRead > 0);
+}
 
-	while (!AtEnd())
-	{
-		size_t bytesToRead = bufferSize - 1;
-		size_t readBytes = Read(buffer.data(), bytesToRead);
-		buffer[readBytes] = '\0';
+std::string Process::ReadToEnd(bool bPrintOutput)
+{
+	//Time::TimedScope scope("ReadToEnd:%s", false);
+
+	std::string result;
 
-		if (bPrintOutput)
+	while (true)
+	{
+		size_t available = m_readBuffer.size() - m_readBufferOffset;
+		if (available > 0)
 		{
-			Log(LogSeverity::Info, "%s", buffer.data());
-		}
+			std::string chunk((const char*)m_readBuffer.data() + m_readBufferOffset, available);
+			m_readBufferOffset += available;
 
-		stream << buffer.data();
+			if (bPrintOutput)
+			{
+				Log(LogSeverity::Info, "%s", chunk.c_str());
+			}
 
-		if (readBytes == 0)
+			result += chunk;
+		}
+
+		if (!FillReadBuffer())
 		{
 			break;
 		}
@@ -73,35 +92,46 @@ std::string Process::ReadToEnd(bool bPrintOutput)
 
 	Wait();
 
-	return stream.str();
+	return result;
 }
 
 std::string Process::ReadLine()
 {
 	std::string stream;
-	stream.reserve(128);
 
-	while (!AtEnd())
+	size_t searchOffset = m_readBufferOffset;
+
+	while (true)
 	{
-		char buffer = '\0'; 
-		size_t readBytes = Read(&buffer, 1);
-		if (readBytes == 0)
+		// Look for the end of the line in what we have already buffered.
+		if (searchOffset < m_readBuffer.size())
 		{
-			break;
-		}
+			uint8_t* start = m_readBuffer.data() + m_readBufferOffset;
+			uint8_t* newline = (uint8_t*)memchr(m_readBuffer.data() + searchOffset, '\n', m_readBuffer.size() - searchOffset);
 
-		if (buffer != '\n')
-		{
-			stream.push_back(buffer);
+			if (newline != nullptr)
+			{
+				stream.assign((const char*)start, newline - start);
+				m_readBufferOffset += (newline - start) + 1;
+				break;
+			}
 		}
-		else
+
+		size_t consumed = m_readBuffer.size() - m_readBufferOffset;
+		if (!FillReadBuffer())
 		{
+			// No more output, whatever is left is the last line.
+			stream.assign((const char*)m_readBuffer.data() + m_readBufferOffset, m_readBuffer.size() - m_readBufferOffset);
+			m_readBufferOffset = m_readBuffer.size();
 			break;
 		}
+
+		// Filling the buffer compacts it, so don't rescan what we already searched.
+		searchOffset = m_readBufferOffset + consumed;
 	}
 
 	// If the result has a \r on the end, remove it to normalize line endings.
-	if (stream[stream.size() - 1] == '\r')
+	if (!stream.empty() && stream[stream.size() - 1] == '\r')
 	{
 		stream.resize(stream.size() - 1);
 	}
@@ -119,44 +149,25 @@ size_t Process::Read(void* buffer, uint64_t bufferLength)
 	uint8_t* ptr = (uint8_t*)buffer;
 	uint64_t leftToRead = bufferLength;
 
-	while (leftToRead > 0 && !AtEnd())
+	while (leftToRead > 0)
 	{
-
 		// Try and fulfill from buffer.
-		if (m_readBuffer.size() > 0)
+		size_t available = m_readBuffer.size() - m_readBufferOffset;
+		if (available > 0)
 		{
-			size_t amountToRead = (size_t)MB_MIN(m_readBuffer.size(), leftToRead);
-			memcpy(ptr, m_readBuffer.data(), amountToRead);
-
-			if (amountToRead >= m_readBuffer.size())
-			{
-				m_readBuffer.clear();
-			}
-			else
-			{
-				size_t finalSize = m_readBuffer.size() - amountToRead;
-				
-				memcpy(m_readBuffer.data(), m_readBuffer.data() + amountToRead, finalSize);
-
-				m_readBuffer.resize(finalSize);
-			}
+			size_t amountToRead = (size_t)MB_MIN(available, leftToRead);
+			memcpy(ptr, m_readBuffer.data() + m_readBufferOffset, amountToRead);
 
+			m_readBufferOffset += amountToRead;
 			leftToRead -= amountToRead;
 			ptr += amountToRead;
 		}
 
 		// If more is required, read the next chunk.
-		if (leftToRead > 0 && m_readBuffer.size() <= 0)
+		else if (!FillReadBuffer())
 		{
-			m_readBuffer.resize(BufferChunkSize);
-			size_t totalRead = (size_t)Internal_Read(m_readBuffer.data(), BufferChunkSize);
-			m_readBuffer.resize(totalRead);
-
 			// Nothing more to read at this time.
-			if (totalRead == 0)
-			{
-				break;
-			}
+			break;
 		}
 	}
 
@@ -165,13 +176,13 @@ size_t Process::Read(void* buffer, uint64_t bufferLength)
 
 uint64_t Process::BytesLeft()
 {
-	return (uint64_t)(Internal_BytesLeft() + m_readBuffer.size());
+	return (uint64_t)(Internal_BytesLeft() + (m_readBuffer.size() - m_readBufferOffset));
 }
 
 bool Process::AtEnd()
 {
 	// Early out if we have anything in the read buffer.
-	return m_readBuffer.size() <= 0 && !IsRunning() && BytesLeft() <= 0;
+	return m_readBuffer.size() <= m_readBufferOffset && Internal_AtEnd();
 }
 
 }; // namespace Platform
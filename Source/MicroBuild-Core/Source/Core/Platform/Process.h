@@ -34,10 +34,11 @@ protected:
 
 	enum
 	{
-		BufferChunkSize = 128,
+		BufferChunkSize = 64 * 1024,
 	};
 
 	std::vector<uint8_t> m_readBuffer;
+	size_t m_readBufferOffset;
 
 	// Does a blocking write from the process's stdint, blocks until entire
 	// buffer has been confumed or the process ends
@@ -50,6 +51,14 @@ protected:
 	// Returns the number of bytes left that can be read.
 	uint64_t Internal_BytesLeft();
 
+	// Returns true if the process's stdout has been fully consumed and
+	// no more output will be produced.
+	bool Internal_AtEnd();
+
+	// Reads the next chunk of stdout into the read buffer, returns
+	// false if there is nothing more to read.
+	bool FillReadBuffer();
+
 public:
 
 	// No copy construction please.
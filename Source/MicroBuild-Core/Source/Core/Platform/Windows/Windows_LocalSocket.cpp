@@ -0,0 +1,81 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "Core/Platform/LocalSocket.h"
+
+#ifdef MB_PLATFORM_WINDOWS
+
+namespace MicroBuild {
+namespace Platform {
+
+// TODO: Not currently supported on this platform.
+
+LocalSocket::LocalSocket()
+	: m_impl(nullptr)
+{
+}
+
+LocalSocket::~LocalSocket()
+{
+}
+
+bool LocalSocket::Listen(const std::string& name)
+{
+	MB_UNUSED_PARAMETER(name);
+	return false;
+}
+
+bool LocalSocket::Accept(LocalSocket& client, int timeoutMs)
+{
+	MB_UNUSED_PARAMETER(client);
+	MB_UNUSED_PARAMETER(timeoutMs);
+	return false;
+}
+
+bool LocalSocket::Connect(const std::string& name)
+{
+	MB_UNUSED_PARAMETER(name);
+	return false;
+}
+
+void LocalSocket::Close()
+{
+}
+
+bool LocalSocket::IsOpen()
+{
+	return false;
+}
+
+bool LocalSocket::Send(const std::string& message)
+{
+	MB_UNUSED_PARAMETER(message);
+	return false;
+}
+
+bool LocalSocket::Receive(std::string& message)
+{
+	MB_UNUSED_PARAMETER(message);
+	return false;
+}
+
+}; // namespace Platform
+}; // namespace MicroBuild
+
+#endif // MB_PLATFORM_WINDOWS
@@ -96,6 +96,41 @@ std::vector<std::string> Path::GetDirectories() const
 	return Result;
 }
 
+bool Path::GetEntries(std::vector<std::string>& files, std::vector<std::string>& directories) const
+{
+	WIN32_FIND_DATAA Data;
+	HANDLE Handle;
+
+	std::string Pattern = m_raw + Seperator + "*";
+
+	Handle = FindFirstFileA(Pattern.c_str(), &Data);
+	if (Handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	do
+	{
+		if (strcmp(Data.cFileName, ".") == 0 ||
+			strcmp(Data.cFileName, "..") == 0)
+		{
+			continue;
+		}
+
+		if ((Data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+		{
+			directories.push_back(Data.cFileName);
+		}
+		else
+		{
+			files.push_back(Data.cFileName);
+		}
+	} while (FindNextFileA(Handle, &Data) != 0);
+
+	FindClose(Handle);
+	return true;
+}
+
 bool Path::IsFile() const
 {
 	DWORD flags = GetFileAttributesA(m_raw.c_str());
@@ -299,6 +334,86 @@ std::time_t Path::GetModifiedTime() const
 	}
 }
 
+uint64_t Path::GetModifiedTimeNs() const
+{
+	WIN32_FILE_ATTRIBUTE_DATA Attributes;
+	BOOL Result = GetFileAttributesExA(m_raw.c_str(),
+		GetFileExInfoStandard, &Attributes);
+	if (!Result)
+	{
+		return 0ULL;
+	}
+	else
+	{
+		// File times are in 100ns intervals since 1601.
+		ULARGE_INTEGER ull;
+		ull.LowPart = Attributes.ftLastWriteTime.dwLowDateTime;
+		ull.HighPart = Attributes.ftLastWriteTime.dwHighDateTime;
+		return (ull.QuadPart - 116444736000000000ULL) * 100ULL;
+	}
+}
+
+bool Path::GetFileState(bool& isDirectory, uint64_t& modifiedTimeNs) const
+{
+	isDirectory = false;
+	modifiedTimeNs = 0ULL;
+
+	WIN32_FILE_ATTRIBUTE_DATA Attributes;
+	BOOL Result = GetFileAttributesExA(m_raw.c_str(),
+		GetFileExInfoStandard, &Attributes);
+	if (!Result)
+	{
+		return false;
+	}
+
+	// File times are in 100ns intervals since 1601.
+	ULARGE_INTEGER ull;
+	ull.LowPart = Attributes.ftLastWriteTime.dwLowDateTime;
+	ull.HighPart = Attributes.ftLastWriteTime.dwHighDateTime;
+
+	isDirectory = (Attributes.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+	modifiedTimeNs = (ull.QuadPart - 116444736000000000ULL) * 100ULL;
+	return true;
+}
+
+bool Path::Touch() const
+{
+	HANDLE Handle = CreateFileA(m_raw.c_str(), FILE_WRITE_ATTRIBUTES, 
+		FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, 
+		OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+
+	if (Handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	FILETIME Now;
+	GetSystemTimeAsFileTime(&Now);
+
+	BOOL Result = SetFileTime(Handle, nullptr, nullptr, &Now);
+	CloseHandle(Handle);
+
+	return Result != 0;
+}
+
+uint64_t Path::GetSize() const
+{
+	WIN32_FILE_ATTRIBUTE_DATA Attributes;
+	BOOL Result = GetFileAttributesExA(m_raw.c_str(),
+		GetFileExInfoStandard, &Attributes);
+	if (!Result)
+	{
+		return 0ULL;
+	}
+	else
+	{
+		ULARGE_INTEGER ull;
+		ull.LowPart = Attributes.nFileSizeLow;
+		ull.HighPart = Attributes.nFileSizeHigh;
+		return ull.QuadPart;
+	}
+}
+
 }; // namespace Platform
 }; // namespace MicroBuild
 
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef MB_PLATFORM_WINDOWS
 
 #include <Windows.h>
+#include <cstring>
 
 namespace MicroBuild {
 namespace Platform {
@@ -78,6 +79,32 @@ bool IsOperatingSystem64Bit()
 #endif
 }
 
+std::map<std::string, std::string> GetEnvironmentVariables()
+{
+	std::map<std::string, std::string> result;
+
+	char* block = GetEnvironmentStringsA();
+	if (block == nullptr)
+	{
+		return result;
+	}
+
+	// Block is a sequence of null terminated "tag=value" strings, ended by an
+	// empty string. Entries starting with = are per-drive directories.
+	for (const char* entry = block; *entry != '\0'; entry += strlen(entry) + 1)
+	{
+		const char* split = strchr(entry + 1, '=');
+		if (split != nullptr)
+		{
+			result[std::string(entry, split - entry)] = split + 1;
+		}
+	}
+
+	FreeEnvironmentStringsA(block);
+
+	return result;
+}
+
 #undef SetEnvironmentVariable
 void SetEnvironmentVariable(const std::string& tag, const std::string& value)
 {
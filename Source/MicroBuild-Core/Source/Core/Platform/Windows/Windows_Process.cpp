@@ -46,6 +46,7 @@ struct Windows_Process
 Process::Process()
 {
 	m_impl = new Windows_Process();
+	m_readBufferOffset = 0;
 
 	Windows_Process* data = reinterpret_cast<Windows_Process*>(m_impl);
 	data->m_attached = false;
@@ -415,6 +416,11 @@ uint64_t Process::Internal_BytesLeft()
 	return bytesAvailable;
 }
 
+bool Process::Internal_AtEnd()
+{
+	return !IsRunning() && Internal_BytesLeft() <= 0;
+}
+
 }; // namespace Platform
 }; // namespace MicroBuild
 
@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace MicroBuild {
 
+ExpandedPathCache BaseConfigFile::m_expandedPathCache;
+
 BaseConfigFile::BaseConfigFile()
 {
 }
@@ -139,18 +141,19 @@ void BaseConfigFile::Resolve()
 		}
 	}
 
-	// Store and use a base timestamp.
-	static time_t s_baseTime;
-	static bool s_timeSet = false;
-	if (!s_timeSet)
-	{
-		s_timeSet = true;
-		time(&s_baseTime);
-	}
+	// Store and use a base timestamp. Files are resolved from multiple 
+	// threads, so this needs to avoid the shared localtime buffer.
+	static const time_t s_baseTime = time(nullptr);
+
+	struct tm now;
+#if defined(MB_PLATFORM_WINDOWS)
+	localtime_s(&now, &s_baseTime);
+#else
+	localtime_r(&s_baseTime, &now);
+#endif
 
-	struct tm* now = localtime(&s_baseTime);
 	char buffer[64];
-	strftime(buffer, sizeof(buffer), "%d%m%Y%H%M", now);
+	strftime(buffer, sizeof(buffer), "%d%m%Y%H%M", &now);
 	std::string bufferVal = buffer;
 
 	Set_Target_Timestamp(bufferVal);
@@ -210,85 +213,158 @@ bool BaseConfigFile::ValidateVersion(std::vector<std::string>& values) const
 	return true;
 }
 
+void BaseConfigFile::OpenExpandedPathCache(const Platform::Path& path)
+{
+	m_expandedPathCache.Open(path);
+}
+
+void BaseConfigFile::SaveExpandedPathCache()
+{
+	if (!m_expandedPathCache.Save())
+	{
+		Log(LogSeverity::Warning, "Failed to write expanded path cache.\n");
+	}
+}
+
 bool BaseConfigFile::ExpandPaths(
 	std::vector<std::string>& values, bool bCanCache) 
 {
 	std::vector<std::string> original = values;
 	values.clear();
 
-	for (std::string& val : original)
+	std::vector<std::vector<std::string>> expanded(original.size());
+
+	// Anything not already cached is matched in one go, so filters that 
+	// share a directory only walk it once.
+	std::vector<Platform::Path> filters;
+	std::vector<size_t> filterIndices;
+
+	for (size_t i = 0; i < original.size(); i++)
 	{
-		if (!ExpandPath(val, values, bCanCache))
+		Platform::Path path = original[i];
+
+		if (bCanCache)
 		{
+			bool bCached = false;
+
+			for (CachedExpandedPaths& cache : m_cachedExpandedPaths)
+			{
+				if (cache.path == path)
+				{
+					expanded[i] = cache.expanded;
+					AddExpandedDirectories(cache.directories);
+					bCached = true;
+					break;
+				}
+			}
+
+			if (bCached)
+			{
+				continue;
+			}
+		}
+
+		Platform::Path resolved = ResolvePath(path);
+		if (resolved.IsRelative())
+		{
+			ValidateError(
+				"Path '%s' does not resolve to an absolute path. All paths must "
+				"be absolute. Use tokens to expand relative paths to absolute.",
+				path.ToString().c_str());
+
 			return false;
 		}
+
+		std::vector<std::pair<Platform::Path, uint64_t>> directories;
+		if (bCanCache && m_expandedPathCache.Find(resolved, expanded[i], &directories))
+		{
+			AddExpandedDirectories(directories);
+
+			CachedExpandedPaths cache;
+			cache.path = path;
+			cache.expanded = expanded[i];
+			cache.directories = directories;
+			m_cachedExpandedPaths.push_back(cache);
+			continue;
+		}
+
+		filters.push_back(resolved);
+		filterIndices.push_back(i);
 	}
 
-	return true;
-}
+	std::vector<std::vector<std::pair<Platform::Path, uint64_t>>> visitedDirectories;
+	std::vector<std::vector<Platform::Path>> matches =
+		Platform::Path::MatchFilters(filters, true, &visitedDirectories);
 
-bool BaseConfigFile::ExpandPath(Platform::Path path, 
-	std::vector<std::string>& results, 
-	bool bCanCache) 
-{
-	if (bCanCache)
+	for (size_t i = 0; i < matches.size(); i++)
 	{
-		for (CachedExpandedPaths& cache : m_cachedExpandedPaths)
+		std::vector<std::string>& result = expanded[filterIndices[i]];
+		result.reserve(matches[i].size());
+
+		for (Platform::Path& match : matches[i])
 		{
-			if (cache.path == path)
-			{
-				results.insert(
-					results.end(), 
-					cache.expanded.begin(), 
-					cache.expanded.end()
-				);
-				return true;
-			}
+			result.push_back(match.ToString());
+		}
+
+		AddExpandedDirectories(visitedDirectories[i]);
+
+		if (bCanCache)
+		{
+			CachedExpandedPaths cache;
+			cache.path = original[filterIndices[i]];
+			cache.expanded = result;
+			cache.directories = visitedDirectories[i];
+			m_cachedExpandedPaths.push_back(cache);
+
+			m_expandedPathCache.Store(filters[i], result, visitedDirectories[i]);
 		}
 	}
 
-	Platform::Path resolved = ResolvePath(path);
-	if (resolved.IsRelative())
+	for (std::vector<std::string>& result : expanded)
 	{
-		ValidateError(
-			"Path '%s' does not resolve to an absolute path. All paths must "
-			"be absolute. Use tokens to expand relative paths to absolute.",
-			path.ToString().c_str());
-
-		return false;
+		values.insert(values.end(), result.begin(), result.end());
 	}
 
-	std::vector<Platform::Path> matches =
-		Platform::Path::MatchFilter(resolved);
+	return true;
+}
 
-	size_t originalResultsSize = results.size();
-	int validCount = 0;
+void BaseConfigFile::AddExpandedDirectories(
+	const std::vector<std::pair<Platform::Path, uint64_t>>& directories)
+{
+	// The first time seen is kept, its the state the earliest expansion saw.
+	for (auto& directory : directories)
+	{
+		m_expandedDirectories.insert(
+			std::make_pair(directory.first.ToString(), directory.second));
+	}
+}
 
-	for (Platform::Path& match : matches)
+std::vector<std::pair<Platform::Path, uint64_t>> BaseConfigFile::GetExpandedDirectories() const
+{
+	std::vector<std::pair<Platform::Path, uint64_t>> result;
+	result.reserve(m_expandedDirectories.size());
+
+	for (auto& directory : m_expandedDirectories)
 	{
-		if (match.IsFile())
-		{
-			results.push_back(match.ToString());
-			validCount++;
-		}
+		result.push_back(std::make_pair(Platform::Path(directory.first), directory.second));
 	}
 
-	if (bCanCache)
+	return result;
+}
+
+bool BaseConfigFile::ExpandPath(Platform::Path path, 
+	std::vector<std::string>& results, 
+	bool bCanCache) 
+{
+	std::vector<std::string> values;
+	values.push_back(path.ToString());
+
+	if (!ExpandPaths(values, bCanCache))
 	{
-		m_cachedExpandedPaths.resize(m_cachedExpandedPaths.size() + 1);
-		
-		CachedExpandedPaths& cache = *m_cachedExpandedPaths.rbegin();
-		if (validCount > 0)
-		{
-			cache.expanded.insert(
-				cache.expanded.begin(),
-				results.begin() + originalResultsSize,
-				results.end()
-			);
-		}
-		cache.path = path;
+		return false;
 	}
 
+	results.insert(results.end(), values.begin(), values.end());
 	return true;
 }
 
@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Config/ConfigFile.h"
 #include "Core/Helpers/Strings.h"
 #include "Core/Helpers/StringConverter.h"
+#include "Core/Helpers/BinaryBuffer.h"
+#include "Schemas/Config/ExpandedPathCache.h"
 
 namespace MicroBuild {
 
@@ -43,14 +45,31 @@ public:
 	// Shows a validation error.
 	void ValidateError(const char* format, ...) const;
 
+	// Sets the file that cachable wildcard expansions are persisted to, so
+	// later runs can reuse them while the directories they walked are unchanged.
+	static void OpenExpandedPathCache(const Platform::Path& path);
+
+	// Writes any new wildcard expansions back to the persisted cache.
+	static void SaveExpandedPathCache();
+
+	// Gets every directory listed to expand wildcards in this file, along 
+	// with its modification time at the point it was listed. The expanded 
+	// values are only valid while none of these have changed.
+	std::vector<std::pair<Platform::Path, uint64_t>> GetExpandedDirectories() const;
+
 protected:
 
 	struct CachedExpandedPaths
 	{
 		std::vector<std::string> expanded;
+		std::vector<std::pair<Platform::Path, uint64_t>> directories;
 		Platform::Path path;
 	};
 
+	// Adds directories an expansion depended on to the ones this file depends on.
+	void AddExpandedDirectories(
+		const std::vector<std::pair<Platform::Path, uint64_t>>& directories);
+
 	// If path is relative it is made absolute based on the workspace file 
 	// path, otherwise it is returned as-is.
 	Platform::Path ResolvePath(Platform::Path& value) const;
@@ -82,6 +101,9 @@ protected:
 private:
 
 	std::vector<CachedExpandedPaths> m_cachedExpandedPaths;
+	std::map<std::string, uint64_t> m_expandedDirectories;
+
+	static ExpandedPathCache m_expandedPathCache;
 
 #define SCHEMA_FILE "Schemas/Config/BaseSchema.inc"
 #define SCHEMA_CLASS BaseConfigFile
@@ -0,0 +1,245 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "Schemas/Config/ExpandedPathCache.h"
+#include "Core/Helpers/Strings.h"
+#include "Core/Helpers/StringConverter.h"
+
+#include <cstdio>
+
+namespace MicroBuild {
+
+ExpandedPathCache::ExpandedPathCache()
+	: m_bDirty(false)
+{
+}
+
+ExpandedPathCache::~ExpandedPathCache()
+{
+}
+
+void ExpandedPathCache::Open(const Platform::Path& path)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_path == path)
+	{
+		return;
+	}
+
+	m_path = path;
+	m_entries.clear();
+	m_bDirty = false;
+
+	if (!Load())
+	{
+		m_entries.clear();
+	}
+}
+
+bool ExpandedPathCache::Find(
+	const Platform::Path& filter, 
+	std::vector<std::string>& expanded,
+	std::vector<std::pair<Platform::Path, uint64_t>>* directories)
+{
+	Entry entry;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto iter = m_entries.find(filter.ToString());
+		if (m_path.IsEmpty() || iter == m_entries.end())
+		{
+			return false;
+		}
+
+		entry = iter->second;
+	}
+
+	// Directories are checked outside the lock, projects expand their paths
+	// in parallel.
+	for (auto& directory : entry.Directories)
+	{
+		bool bIsDirectory = false;
+		uint64_t modifiedTime = 0;
+		directory.first.GetFileState(bIsDirectory, modifiedTime);
+
+		if (modifiedTime != directory.second)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			m_entries.erase(filter.ToString());
+			m_bDirty = true;
+
+			return false;
+		}
+	}
+
+	expanded = entry.Expanded;
+
+	if (directories != nullptr)
+	{
+		*directories = entry.Directories;
+	}
+
+	return true;
+}
+
+void ExpandedPathCache::Store(
+	const Platform::Path& filter,
+	const std::vector<std::string>& expanded,
+	const std::vector<std::pair<Platform::Path, uint64_t>>& directories)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_path.IsEmpty())
+	{
+		return;
+	}
+
+	// An expansion that saw a directory change too recently to trust would 
+	// never validate, so don't persist it, it's walked again next time.
+	for (auto& directory : directories)
+	{
+		if (directory.second == Platform::Path::UnstableModifiedTime)
+		{
+			if (m_entries.erase(filter.ToString()) > 0)
+			{
+				m_bDirty = true;
+			}
+			return;
+		}
+	}
+
+	Entry& entry = m_entries[filter.ToString()];
+	entry.Expanded = expanded;
+	entry.Directories = directories;
+
+	m_bDirty = true;
+}
+
+bool ExpandedPathCache::Load()
+{
+	std::string data;
+	if (m_path.IsEmpty() || !Strings::ReadFile(m_path, data))
+	{
+		return true;
+	}
+
+	// Cache is stored as plain text, each entry starts with a "filter <expanded> 
+	// <directories> <path>" line, followed by a line for each expanded path and 
+	// a "<time> <path>" line for each directory.
+	std::vector<std::string> lines = Strings::Split('\n', data, false, true);
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		unsigned int expandedCount = 0;
+		unsigned int directoryCount = 0;
+		int filterOffset = 0;
+
+		if (sscanf(lines[i].c_str(), "filter %u %u %n", &expandedCount, &directoryCount, &filterOffset) != 2 ||
+			filterOffset == 0 ||
+			i + expandedCount + directoryCount >= lines.size())
+		{
+			return false;
+		}
+
+		Entry& entry = m_entries[lines[i].substr(filterOffset)];
+
+		for (unsigned int j = 0; j < expandedCount; j++)
+		{
+			entry.Expanded.push_back(lines[++i]);
+		}
+
+		for (unsigned int j = 0; j < directoryCount; j++)
+		{
+			const std::string& line = lines[++i];
+
+			size_t split = line.find(' ');
+			if (split == std::string::npos)
+			{
+				return false;
+			}
+
+			uint64_t modifiedTime = 0;
+			if (!StringCast<std::string, uint64_t>(line.substr(0, split), modifiedTime))
+			{
+				return false;
+			}
+
+			entry.Directories.push_back(std::pair<Platform::Path, uint64_t>(line.substr(split + 1), modifiedTime));
+		}
+	}
+
+	return true;
+}
+
+bool ExpandedPathCache::Save()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_path.IsEmpty() || !m_bDirty)
+	{
+		return true;
+	}
+
+	std::string data;
+	for (auto& pair : m_entries)
+	{
+		data += Strings::Format("filter %u %u %s\n", (unsigned int)pair.second.Expanded.size(), (unsigned int)pair.second.Directories.size(), pair.first.c_str());
+
+		for (const std::string& path : pair.second.Expanded)
+		{
+			data += path + "\n";
+		}
+
+		for (auto& directory : pair.second.Directories)
+		{
+			data += Strings::Format("%llu %s\n", directory.second, directory.first.ToString().c_str());
+		}
+	}
+
+	Platform::Path directory = m_path.GetDirectory();
+	if (!directory.Exists() && !directory.CreateAsDirectory())
+	{
+		return false;
+	}
+
+	// Several builds can load the same workspace at once, so write through a 
+	// temporary file unique to this process and swap it in.
+	std::string tempPath = Strings::Format("%s.%llu.tmp", m_path.ToString().c_str(), 
+		(unsigned long long)std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+	if (!Strings::WriteFile(tempPath, data))
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	remove(m_path.ToString().c_str());
+	if (rename(tempPath.c_str(), m_path.ToString().c_str()) != 0)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	m_bDirty = false;
+	return true;
+}
+
+}; // namespace MicroBuild
@@ -0,0 +1,86 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Platform/Path.h"
+
+#include <map>
+#include <mutex>
+
+namespace MicroBuild {
+
+// Persistent cache of path wildcard expansions, lets repeated runs over an 
+// unchanged tree skip walking it.
+//
+// Each entry stores the files a filter expanded to along with the 
+// modification time of every directory that was listed to find them. Adding,
+// removing or renaming anything in a directory changes its modification 
+// time, so while none of them have changed the expansion is still valid.
+// Directories that changed within the file system's timestamp resolution of
+// being listed can't be trusted this way, expansions that depend on them are
+// not stored.
+class ExpandedPathCache
+{
+public:
+	ExpandedPathCache();
+	~ExpandedPathCache();
+
+	// Sets the file the cache is persisted to and loads any entries already
+	// stored in it. Does nothing if the cache is already open with the same file.
+	void Open(const Platform::Path& path);
+
+	// Writes the cache back to its file if anything has changed since it was
+	// opened or last saved.
+	bool Save();
+
+	// Retrieves the expansion stored for the given filter. Returns false if 
+	// there is none or any directory it was found in has changed. The 
+	// directories it depends on are optionally returned.
+	bool Find(
+		const Platform::Path& filter, 
+		std::vector<std::string>& expanded,
+		std::vector<std::pair<Platform::Path, uint64_t>>* directories = nullptr);
+
+	// Stores the expansion of a filter and the directories visited to find it.
+	// Nothing is stored if any directory has an unstable modification time.
+	void Store(
+		const Platform::Path& filter, 
+		const std::vector<std::string>& expanded, 
+		const std::vector<std::pair<Platform::Path, uint64_t>>& directories);
+
+private:
+	struct Entry
+	{
+		std::vector<std::string> Expanded;
+		std::vector<std::pair<Platform::Path, uint64_t>> Directories;
+	};
+
+	// Reads all entries from the cache file.
+	bool Load();
+
+private:
+	Platform::Path m_path;
+	std::mutex m_mutex;
+	bool m_bDirty;
+
+	std::map<std::string, Entry> m_entries;
+
+};
+
+}; // namespace MicroBuild
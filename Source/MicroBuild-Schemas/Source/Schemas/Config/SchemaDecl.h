@@ -29,9 +29,9 @@ private:
 
 #define START_OPTION(ValueType, Group, Key, Description) \
 	private: \
-		ValueType m_##Group##_##Key##_value; \
+		ValueType m_##Group##_##Key##_value = ValueType(); \
 	public: \
-		ValueType Get_##Group##_##Key(); \
+		const ValueType& Get_##Group##_##Key() const; \
 		void Set_##Group##_##Key(const ValueType& value); \
 	private: \
 		bool Validate_##Group##_##Key(); 
@@ -40,7 +40,7 @@ private:
 	private: \
 		std::vector<ValueType> m_##Group##_##Key##_value; \
 	public: \
-		std::vector<ValueType> Get_##Group##_##Key(); \
+		const std::vector<ValueType>& Get_##Group##_##Key() const; \
 		void Set_##Group##_##Key(const std::vector<ValueType>& value); \
 	private: \
 		bool Validate_##Group##_##Key(); 
@@ -49,7 +49,7 @@ private:
 	private: \
 		std::vector<ConfigFile::KeyValuePair> m_##Group##_value; \
 	public: \
-		std::vector<ConfigFile::KeyValuePair> Get_##Group(); \
+		const std::vector<ConfigFile::KeyValuePair>& Get_##Group() const; \
 		void Set_##Group(const std::vector<ConfigFile::KeyValuePair>& value); \
 	private: \
 		bool Validate_##Group(); 
@@ -97,4 +97,7 @@ public:
 	virtual bool Validate();
     #endif
 
+	virtual void WriteSnapshot(BinaryBufferWriter& writer) const override;
+	virtual bool ReadSnapshot(BinaryBufferReader& reader) override;
+
 // ----------------------------------------------------------------------------
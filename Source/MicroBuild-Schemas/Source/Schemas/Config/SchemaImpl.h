@@ -26,7 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 // ----------------------------------------------------------------------------
 
 #define START_OPTION(ValueType, Group, Key, Description) \
-	ValueType SCHEMA_CLASS::Get_##Group##_##Key() \
+	const ValueType& SCHEMA_CLASS::Get_##Group##_##Key() const \
 	{ \
 		return m_##Group##_##Key##_value; \
 	} \
@@ -47,7 +47,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 		bool bResult = true;
 
 #define START_ARRAY_OPTION(ValueType, Group, Key, Description) \
-	std::vector<ValueType> SCHEMA_CLASS::Get_##Group##_##Key() \
+	const std::vector<ValueType>& SCHEMA_CLASS::Get_##Group##_##Key() const \
 	{ \
 		return m_##Group##_##Key##_value; \
 	} \
@@ -75,7 +75,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 		bool bResult = true;
 
 #define START_KEY_VALUE_ARRAY_OPTION(Group, Description) \
-	std::vector<ConfigFile::KeyValuePair> SCHEMA_CLASS::Get_##Group() \
+	const std::vector<ConfigFile::KeyValuePair>& SCHEMA_CLASS::Get_##Group() const \
 	{ \
 		return m_##Group##_value; \
 	} \
@@ -155,6 +155,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 			bResult = bResult && ValidateOptions( \
 									values, options, groupName, keyName); \
 		} \
+		output.reserve(values.size()); \
 		for (std::string& result : values) \
 		{ \
 			if (!StringCast(result, converterTemp)) \
@@ -278,3 +279,153 @@ bool SCHEMA_CLASS::Validate()
 }
 
 // ----------------------------------------------------------------------------
+
+// Snapshots store the validated value of every option, so a restored file 
+// can be used without being validated again.
+
+void SCHEMA_CLASS::WriteSnapshot(BinaryBufferWriter& writer) const
+{
+#ifdef SCHEMA_IS_BASE
+	ConfigFile::WriteSnapshot(writer);
+#else
+	BaseConfigFile::WriteSnapshot(writer);
+#endif
+
+	std::string converted;
+#define START_OPTION(ValueType, Group, Key, Description) \
+	StringCast(m_##Group##_##Key##_value, converted); \
+	writer.WriteString(converted);
+#define START_ARRAY_OPTION(ValueType, Group, Key, Description) \
+	writer.Write<uint32_t>((uint32_t)m_##Group##_##Key##_value.size()); \
+	for (const ValueType& value : m_##Group##_##Key##_value) \
+	{ \
+		StringCast(value, converted); \
+		writer.WriteString(converted); \
+	}
+#define START_KEY_VALUE_ARRAY_OPTION(Group, Description) \
+	writer.Write<uint32_t>((uint32_t)m_##Group##_value.size()); \
+	for (const ConfigFile::KeyValuePair& pair : m_##Group##_value) \
+	{ \
+		writer.WriteString(pair.first); \
+		writer.WriteString(pair.second); \
+	}
+#define OPTION_RULE_REQUIRED()
+#define OPTION_RULE_ORDER_IMPORTANT()
+#define OPTION_RULE_DEFAULT(Value)
+#define OPTION_RULE_VALIDATOR(ValidatorFunction)
+#define OPTION_RULE_EXPAND_PATH_WILDCARDS(bCanCache)
+#define OPTION_RULE_OPTION(Option) 
+#define OPTION_RULE_NO_INHERIT()
+#define OPTION_RULE_ABSOLUTE_PATH()
+#define END_ARRAY_OPTION()
+#define END_OPTION()
+#define END_KEY_VALUE_ARRAY_OPTION()
+#define START_ENUM(Name) 
+#define ENUM_KEY(Name) 
+#define END_ENUM() 
+
+#include SCHEMA_FILE
+
+#undef START_OPTION
+#undef START_ARRAY_OPTION
+#undef START_KEY_VALUE_ARRAY_OPTION
+#undef OPTION_RULE_REQUIRED
+#undef OPTION_RULE_ORDER_IMPORTANT
+#undef OPTION_RULE_DEFAULT
+#undef OPTION_RULE_VALIDATOR
+#undef OPTION_RULE_EXPAND_PATH_WILDCARDS
+#undef OPTION_RULE_ABSOLUTE_PATH
+#undef OPTION_RULE_OPTION
+#undef OPTION_RULE_NO_INHERIT
+#undef END_OPTION
+#undef END_ARRAY_OPTION
+#undef END_KEY_VALUE_ARRAY_OPTION
+#undef START_ENUM
+#undef ENUM_KEY
+#undef END_ENUM
+}
+
+bool SCHEMA_CLASS::ReadSnapshot(BinaryBufferReader& reader)
+{
+#ifdef SCHEMA_IS_BASE
+	if (!ConfigFile::ReadSnapshot(reader))
+#else
+	if (!BaseConfigFile::ReadSnapshot(reader))
+#endif
+	{
+		return false;
+	}
+
+	std::string converted;
+	uint32_t count = 0;
+#define START_OPTION(ValueType, Group, Key, Description) \
+	if (!reader.ReadString(converted) || \
+		!StringCast(converted, m_##Group##_##Key##_value)) \
+	{ \
+		return false; \
+	}
+#define START_ARRAY_OPTION(ValueType, Group, Key, Description) \
+	if (!reader.Read(count)) \
+	{ \
+		return false; \
+	} \
+	m_##Group##_##Key##_value.resize(count); \
+	for (ValueType& value : m_##Group##_##Key##_value) \
+	{ \
+		if (!reader.ReadString(converted) || !StringCast(converted, value)) \
+		{ \
+			return false; \
+		} \
+	}
+#define START_KEY_VALUE_ARRAY_OPTION(Group, Description) \
+	if (!reader.Read(count)) \
+	{ \
+		return false; \
+	} \
+	m_##Group##_value.resize(count); \
+	for (ConfigFile::KeyValuePair& pair : m_##Group##_value) \
+	{ \
+		if (!reader.ReadString(pair.first) || !reader.ReadString(pair.second)) \
+		{ \
+			return false; \
+		} \
+	}
+#define OPTION_RULE_REQUIRED()
+#define OPTION_RULE_ORDER_IMPORTANT()
+#define OPTION_RULE_DEFAULT(Value)
+#define OPTION_RULE_VALIDATOR(ValidatorFunction)
+#define OPTION_RULE_EXPAND_PATH_WILDCARDS(bCanCache)
+#define OPTION_RULE_OPTION(Option) 
+#define OPTION_RULE_NO_INHERIT()
+#define OPTION_RULE_ABSOLUTE_PATH()
+#define END_ARRAY_OPTION()
+#define END_OPTION()
+#define END_KEY_VALUE_ARRAY_OPTION()
+#define START_ENUM(Name) 
+#define ENUM_KEY(Name) 
+#define END_ENUM() 
+
+#include SCHEMA_FILE
+
+#undef START_OPTION
+#undef START_ARRAY_OPTION
+#undef START_KEY_VALUE_ARRAY_OPTION
+#undef OPTION_RULE_REQUIRED
+#undef OPTION_RULE_ORDER_IMPORTANT
+#undef OPTION_RULE_DEFAULT
+#undef OPTION_RULE_VALIDATOR
+#undef OPTION_RULE_EXPAND_PATH_WILDCARDS
+#undef OPTION_RULE_ABSOLUTE_PATH
+#undef OPTION_RULE_OPTION
+#undef OPTION_RULE_NO_INHERIT
+#undef END_OPTION
+#undef END_ARRAY_OPTION
+#undef END_KEY_VALUE_ARRAY_OPTION
+#undef START_ENUM
+#undef ENUM_KEY
+#undef END_ENUM
+
+	return true;
+}
+
+// ----------------------------------------------------------------------------
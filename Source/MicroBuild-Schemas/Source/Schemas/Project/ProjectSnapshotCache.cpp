@@ -0,0 +1,281 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "Schemas/Project/ProjectSnapshotCache.h"
+#include "Schemas/Project/ProjectFile.h"
+#include "Core/Helpers/Strings.h"
+#include "Core/Helpers/BinaryBuffer.h"
+#include "Core/Platform/Platform.h"
+
+#include <cstdio>
+#include <set>
+
+namespace MicroBuild {
+
+ProjectSnapshotCache::ProjectSnapshotCache()
+{
+}
+
+ProjectSnapshotCache::~ProjectSnapshotCache()
+{
+}
+
+void ProjectSnapshotCache::Open(const Platform::Path& directory, const std::string& context)
+{
+	m_directory = directory;
+	m_context = context;
+}
+
+Platform::Path ProjectSnapshotCache::GetSnapshotPath(const Platform::Path& projectPath)
+{
+	uint64_t hash = Strings::Hash64(m_context + "|" + projectPath.ToString());
+
+	return m_directory.AppendFragment(
+		Strings::Format("%016llx.snapshot", (unsigned long long)hash), true);
+}
+
+bool ProjectSnapshotCache::GetFileContent(const Platform::Path& path, FileContent& content)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_hashMutex);
+
+		auto iter = m_fileContents.find(path.ToString());
+		if (iter != m_fileContents.end())
+		{
+			content = iter->second;
+			return true;
+		}
+	}
+
+	std::vector<char> data;
+	if (!ReadBinaryFile(path, data))
+	{
+		return false;
+	}
+
+	// The resolve timestamp is different every run, so anything that uses
+	// it has to be resolved again.
+	static const std::string volatileToken = "Timestamp)";
+
+	content.Hash = Strings::HashBuffer64(data.data(), data.size());
+	content.bVolatile = (std::search(
+		data.begin(), data.end(), 
+		volatileToken.begin(), volatileToken.end()) != data.end());
+
+	std::lock_guard<std::mutex> lock(m_hashMutex);
+	m_fileContents[path.ToString()] = content;
+
+	return true;
+}
+
+bool ProjectSnapshotCache::Load(const Platform::Path& projectPath, ProjectFile& file)
+{
+	if (m_directory.IsEmpty())
+	{
+		return false;
+	}
+
+	std::vector<char> buffer;
+	if (!ReadBinaryFile(GetSnapshotPath(projectPath), buffer))
+	{
+		return false;
+	}
+
+	BinaryBufferReader reader(buffer);
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	std::string context;
+	std::string path;
+
+	if (!reader.Read(magic) || magic != k_SnapshotMagic ||
+		!reader.Read(version) || version != k_SnapshotVersion ||
+		!reader.ReadString(context) || context != m_context ||
+		!reader.ReadString(path) || path != projectPath.ToString())
+	{
+		return false;
+	}
+
+	// Every file the project was parsed from must be unchanged.
+	uint32_t sourceFileCount = 0;
+	if (!reader.Read(sourceFileCount))
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < sourceFileCount; i++)
+	{
+		uint64_t hash = 0;
+		FileContent content;
+
+		if (!reader.ReadString(path) || 
+			!reader.Read(hash) ||
+			!GetFileContent(path, content) ||
+			content.Hash != hash)
+		{
+			return false;
+		}
+	}
+
+	// As must every environment variable it read.
+	uint32_t environmentCount = 0;
+	if (!reader.Read(environmentCount))
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < environmentCount; i++)
+	{
+		std::string name;
+		std::string value;
+
+		if (!reader.ReadString(name) ||
+			!reader.ReadString(value) ||
+			Platform::GetEnvironmentVariable(name) != value)
+		{
+			return false;
+		}
+	}
+
+	// And every directory its wildcards were expanded from.
+	uint32_t directoryCount = 0;
+	if (!reader.Read(directoryCount))
+	{
+		return false;
+	}
+
+	for (uint32_t i = 0; i < directoryCount; i++)
+	{
+		uint64_t modifiedTime = 0;
+		if (!reader.ReadString(path) ||
+			!reader.Read(modifiedTime))
+		{
+			return false;
+		}
+
+		bool bIsDirectory = false;
+		uint64_t currentModifiedTime = 0;
+		Platform::Path(path).GetFileState(bIsDirectory, currentModifiedTime);
+
+		if (currentModifiedTime != modifiedTime)
+		{
+			return false;
+		}
+	}
+
+	if (!file.ReadSnapshot(reader) || !reader.AtEnd())
+	{
+		file = ProjectFile();
+		return false;
+	}
+
+	return true;
+}
+
+bool ProjectSnapshotCache::Store(
+	const Platform::Path& projectPath,
+	ProjectFile& file,
+	const std::vector<Platform::Path>& sourceFiles)
+{
+	if (m_directory.IsEmpty())
+	{
+		return false;
+	}
+
+	BinaryBufferWriter writer;
+	writer.Write<uint32_t>(k_SnapshotMagic);
+	writer.Write<uint32_t>(k_SnapshotVersion);
+	writer.WriteString(m_context);
+	writer.WriteString(projectPath.ToString());
+
+	std::vector<std::pair<std::string, uint64_t>> hashes;
+	std::set<std::string> seenFiles;
+
+	for (const Platform::Path& sourceFile : sourceFiles)
+	{
+		if (!seenFiles.insert(sourceFile.ToString()).second)
+		{
+			continue;
+		}
+
+		FileContent content;
+		if (!GetFileContent(sourceFile, content) || content.bVolatile)
+		{
+			return false;
+		}
+
+		hashes.push_back(std::make_pair(sourceFile.ToString(), content.Hash));
+	}
+
+	writer.Write<uint32_t>((uint32_t)hashes.size());
+	for (auto& hash : hashes)
+	{
+		writer.WriteString(hash.first);
+		writer.Write<uint64_t>(hash.second);
+	}
+
+	const std::set<std::string>& environmentLookups = file.GetEnvironmentLookups();
+
+	writer.Write<uint32_t>((uint32_t)environmentLookups.size());
+	for (const std::string& name : environmentLookups)
+	{
+		writer.WriteString(name);
+		writer.WriteString(Platform::GetEnvironmentVariable(name));
+	}
+
+	std::vector<std::pair<Platform::Path, uint64_t>> directories = file.GetExpandedDirectories();
+
+	writer.Write<uint32_t>((uint32_t)directories.size());
+	for (auto& directory : directories)
+	{
+		writer.WriteString(directory.first.ToString());
+		writer.Write<uint64_t>(directory.second);
+	}
+
+	file.WriteSnapshot(writer);
+
+	if (!m_directory.Exists() && !m_directory.CreateAsDirectory())
+	{
+		return false;
+	}
+
+	// Write through a temporary file so other runs never load a partial 
+	// snapshot.
+	Platform::Path snapshotPath = GetSnapshotPath(projectPath);
+
+	std::string tempPath = Strings::Format("%s.%llu.tmp", snapshotPath.ToString().c_str(), 
+		(unsigned long long)std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+	if (!WriteBinaryFile(tempPath, writer.GetBuffer()))
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	remove(snapshotPath.ToString().c_str());
+	if (rename(tempPath.c_str(), snapshotPath.ToString().c_str()) != 0)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+}; // namespace MicroBuild
@@ -0,0 +1,91 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Platform/Path.h"
+
+#include <map>
+#include <mutex>
+
+namespace MicroBuild {
+
+class ProjectFile;
+
+// Persistent cache of resolved project files, lets repeated runs over an
+// unchanged workspace skip parsing, resolving and validating its projects.
+//
+// A snapshot holds the full state of a project file once it has been resolved
+// and validated. It is only restored if it was made in the same context (the
+// target, arguments, executable and plugins the caller describes it with), 
+// every file it was parsed from has the same contents, every environment 
+// variable it read has the same value and every directory its wildcards were
+// expanded from is unmodified.
+class ProjectSnapshotCache
+{
+public:
+	ProjectSnapshotCache();
+	~ProjectSnapshotCache();
+
+	// Sets the directory snapshots are stored in and the context they are
+	// made in, snapshots made in any other context are ignored.
+	void Open(const Platform::Path& directory, const std::string& context);
+
+	// Restores the snapshot of the project at the given path. Returns false if
+	// there is none or anything it was resolved from has changed.
+	bool Load(const Platform::Path& projectPath, ProjectFile& file);
+
+	// Stores a snapshot of a resolved and validated project. The source files
+	// should include every file that contributed to it, including those of 
+	// any file it was merged with.
+	bool Store(
+		const Platform::Path& projectPath, 
+		ProjectFile& file, 
+		const std::vector<Platform::Path>& sourceFiles);
+
+private:
+	enum
+	{
+		k_SnapshotMagic = 0x5350424D, // MBPS
+		k_SnapshotVersion = 2,
+	};
+
+	struct FileContent
+	{
+		uint64_t Hash;
+
+		// Set if the file references a token whose value changes every run,
+		// projects resolved from it can't be snapshotted.
+		bool bVolatile;
+	};
+
+	Platform::Path GetSnapshotPath(const Platform::Path& projectPath);
+
+	// Gets the hash of the given files contents, files are only read once.
+	bool GetFileContent(const Platform::Path& path, FileContent& content);
+
+private:
+	Platform::Path m_directory;
+	std::string m_context;
+
+	std::mutex m_hashMutex;
+	std::map<std::string, FileContent> m_fileContents;
+
+};
+
+}; // namespace MicroBuild
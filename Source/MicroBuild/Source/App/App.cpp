@@ -25,12 +25,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Commands/Clean.h"
 #include "App/Commands/Help.h"
 #include "App/Commands/Version.h"
+#include "App/Commands/Server.h"
+#include "App/Commands/Benchmark.h"
 
 #include "App/Ides/IdeType.h"
 
 #include "App/Ides/MSBuild/Versions/VisualStudio_2015.h"
 #include "App/Ides/MSBuild/Versions/VisualStudio_2017.h"
 #include "App/Ides/Make/Make.h"
+#include "App/Ides/Ninja/Ninja.h"
 #include "App/Ides/XCode/XCode.h"
 
 #include "Packager/Packagers/Steamworks/Steamworks_Packager.h"
@@ -86,6 +89,7 @@ App::App(int argc, char* argv[])
 	m_ides.push_back(new Ide_VisualStudio_2015());
 	m_ides.push_back(new Ide_VisualStudio_2017());
 	m_ides.push_back(new Ide_Make());
+	m_ides.push_back(new Ide_Ninja());
 	m_ides.push_back(new Ide_XCode());
 
 	m_packagers.push_back(new Steamworks_Packager());
@@ -96,10 +100,14 @@ App::App(int argc, char* argv[])
 	m_commandLineParser.RegisterCommand(new CleanCommand(this));
 	m_commandLineParser.RegisterCommand(new HelpCommand(this));
 	m_commandLineParser.RegisterCommand(new VersionCommand(this));
+	m_commandLineParser.RegisterCommand(new ServerCommand(this));
+	m_commandLineParser.RegisterCommand(new BenchmarkCommand(this));
 }
 
 App::~App()
 {
+	Time::StopTrace();
+
 	m_pluginManager.UnloadAll();
 
 	m_commandLineParser.DisposeCommands();
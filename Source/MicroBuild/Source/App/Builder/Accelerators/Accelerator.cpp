@@ -18,12 +18,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "PCH.h"
 #include "App/Builder/Accelerators/Accelerator.h"
+#include "App/Builder/BuilderToolchainCache.h"
 
 namespace MicroBuild {
 
 Accelerator::Accelerator()
 	: m_bAvailable(false)
 	, m_description("")
+	, m_toolchainCache(nullptr)
 {
 }
 
@@ -37,4 +39,26 @@ std::string Accelerator::GetDescription()
 	return m_description;
 }
 
+void Accelerator::SetToolchainCache(BuilderToolchainCache* cache)
+{
+	m_toolchainCache = cache;
+}
+
+bool Accelerator::FindCachedProbe(const std::string& key, std::map<std::string, std::string>& values)
+{
+	if (m_toolchainCache == nullptr)
+	{
+		return false;
+	}
+	return m_toolchainCache->Find(key, values);
+}
+
+void Accelerator::StoreProbe(const std::string& key, const std::map<std::string, std::string>& values, const std::vector<Platform::Path>& files)
+{
+	if (m_toolchainCache != nullptr)
+	{
+		m_toolchainCache->Store(key, values, files);
+	}
+}
+
 }; // namespace MicroBuild
@@ -25,6 +25,7 @@ namespace MicroBuild {
 
 class BuildTask;
 class Toolchain;
+class BuilderToolchainCache;
 
 // Base class for all accelerator providers.
 class Accelerator
@@ -33,6 +34,17 @@ protected:
 	bool m_bAvailable;
 	std::string m_description;
 
+	BuilderToolchainCache* m_toolchainCache;
+
+protected:
+
+	// Retrieves the results of a previous probe for this accelerator from the toolchain 
+	// cache. Returns false if there are none or they are out of date.
+	bool FindCachedProbe(const std::string& key, std::map<std::string, std::string>& values);
+
+	// Stores the results of probing for this accelerator in the toolchain cache.
+	void StoreProbe(const std::string& key, const std::map<std::string, std::string>& values, const std::vector<Platform::Path>& files);
+
 public:
 
 	// Constructor.
@@ -44,6 +56,10 @@ public:
 	// Returns true if this accelerator is available for use.
 	bool IsAvailable();
 
+	// Sets the cache that the results of finding the accelerator are stored in, or 
+	// nullptr to always probe for it. Must be set before Init is called.
+	void SetToolchainCache(BuilderToolchainCache* cache);
+
 	// Attempts to find the accelerator install, returns true if everything is available,	
 	// otherwise false.
 	virtual bool Init() = 0;
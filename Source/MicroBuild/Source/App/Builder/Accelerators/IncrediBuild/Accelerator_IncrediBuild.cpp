@@ -37,6 +37,18 @@ Accelerator_IncrediBuild::Accelerator_IncrediBuild()
 
 bool Accelerator_IncrediBuild::Init()
 {
+	// Reuse the results of a previous probe if xgConsole is unchanged.
+	std::string probeKey = Strings::Format("IncrediBuild|%s", Platform::GetEnvironmentVariable("PATH").c_str());
+
+	std::map<std::string, std::string> probe;
+	if (FindCachedProbe(probeKey, probe))
+	{
+		m_xgConsolePath = probe["XgConsolePath"];
+		m_description = probe["Description"];
+		m_bAvailable = true;
+		return true;
+	}
+
 	if (!Platform::Path::FindFile("xgConsole.exe", m_xgConsolePath))
 	{
 		return false;
@@ -54,7 +66,7 @@ bool Accelerator_IncrediBuild::Init()
 	std::vector<std::string> split = Strings::Split('\n', output);
 	if (split.size() > 2)
 	{
-		m_description = Strings::Format("IncrediBuild (Version %s)", split[2].c_str());
+		m_description = Strings::Format("IncrediBuild (Version %s)", Strings::Trim(split[2]).c_str());
 	}
 	else
 	{
@@ -62,6 +74,10 @@ bool Accelerator_IncrediBuild::Init()
 
 	}
 
+	probe["XgConsolePath"] = m_xgConsolePath.ToString();
+	probe["Description"] = m_description;
+	StoreProbe(probeKey, probe, { m_xgConsolePath });
+
 	m_bAvailable = true;
 
 	return true;
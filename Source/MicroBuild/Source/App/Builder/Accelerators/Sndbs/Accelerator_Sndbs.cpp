@@ -39,6 +39,19 @@ Accelerator_Sndbs::Accelerator_Sndbs()
 bool Accelerator_Sndbs::Init()
 {
 	Platform::Path sceRootDir = Platform::GetEnvironmentVariable("SCE_ROOT_DIR");
+
+	// Reuse the results of a previous probe if dbsbuild is unchanged.
+	std::string probeKey = Strings::Format("Sndbs|%s", sceRootDir.ToString().c_str());
+
+	std::map<std::string, std::string> probe;
+	if (FindCachedProbe(probeKey, probe))
+	{
+		m_dbsBuildPath = probe["DbsBuildPath"];
+		m_description = probe["Description"];
+		m_bAvailable = true;
+		return true;
+	}
+
 	if (!sceRootDir.Exists())
 	{
 		return false;
@@ -69,7 +82,7 @@ bool Accelerator_Sndbs::Init()
 	std::vector<std::string> split = Strings::Split(' ', output);
 	if (split.size() > 2)
 	{
-		m_description = Strings::Format("SN-DBS (Version %s)", split[1].c_str());
+		m_description = Strings::Format("SN-DBS (Version %s)", Strings::Trim(split[1]).c_str());
 	}
 	else
 	{
@@ -77,6 +90,10 @@ bool Accelerator_Sndbs::Init()
 
 	}
 
+	probe["DbsBuildPath"] = m_dbsBuildPath.ToString();
+	probe["Description"] = m_description;
+	StoreProbe(probeKey, probe, { m_dbsBuildPath });
+
 	m_bAvailable = true;
 
 	return true;
@@ -20,6 +20,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "App/Builder/Builder.h"
 #include "App/Builder/BuilderFileInfo.h"
+#include "App/Builder/BuilderDatabase.h"
+#include "App/Builder/BuilderCompileCache.h"
+#include "App/Builder/BuilderToolchainCache.h"
+#include "App/Builder/BuilderChangelogCache.h"
 
 #include "App/Builder/Toolchains/Toolchain.h"
 #include "App/Builder/Toolchains/Cpp/Clang/Toolchain_Clang.h"
@@ -50,6 +54,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Builder/Tasks/LinkTask.h"
 #include "App/Builder/Tasks/ShellCommandTask.h"
 
+#include "Core/Helpers/Time.h"
+
 #include "App/Builder/SourceControl/Providers/GitSourceControlProvider.h"
 
 #include "App/Plugin/PluginManager.h"
@@ -65,6 +71,23 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace MicroBuild {
 
+// Scheduling cost given to preparing a project, far larger than any task so it
+// always runs first. Durations of tasks are costed in milliseconds.
+static const int64_t k_PrepareProjectCost = INT32_MAX;
+
+// Gets a string representing the state of a configuration file, used to force 
+// rebuilds when the project or workspace changes.
+static std::string GetConfigurationFileState(const Platform::Path& path, bool bHashContents)
+{
+	std::string contents;
+	if (bHashContents && Strings::ReadFile(path, contents))
+	{
+		return Strings::Format("%llu", Strings::HashBuffer64(contents.data(), contents.size()));
+	}
+
+	return Strings::Format("%llu", path.GetModifiedTimeNs());
+}
+
 Builder::Builder(App* app)
 	: m_app(app)
 {
@@ -123,14 +146,18 @@ JobHandle Builder::QueueTask(
 	std::shared_ptr<BuildTask> task,
 	bool& bFailureFlag,
 	int* totalJobs,
-	std::atomic<int>* currentJobIndex)
+	std::atomic<int>* currentJobIndex,
+	BuilderDatabase* database,
+	int64_t defaultCost)
 {
 	if (totalJobs != nullptr)
 	{
 		(*totalJobs) += task->GetSubTaskCount();
 	}
 
-	JobHandle handle = scheduler.CreateJob([&scheduler, &bFailureFlag, task, totalJobs, currentJobIndex]() {
+	Platform::Path historyKey = task->GetHistoryKey();
+
+	JobHandle handle = scheduler.CreateJob([&scheduler, &bFailureFlag, task, totalJobs, currentJobIndex, database, historyKey]() {
 		if (bFailureFlag)
 		{
 			return;
@@ -146,13 +173,31 @@ JobHandle Builder::QueueTask(
 			}
 			task->SetTaskProgress(jobIndex - task->GetSubTaskCount() + 1, totalJobCount);
 		}
-		task->GetTaskThreadId(scheduler.GetThreadId());
+		task->SetTaskThreadId(scheduler.GetThreadId());
+
+		Time::TimedScope timer;
 		if (!task->Execute())
 		{
 			bFailureFlag = true;
 		}
+		else if (database != nullptr && !historyKey.IsEmpty())
+		{
+			database->StoreDuration(historyKey, (uint64_t)timer.GetElapsed());
+		}
 	});
 
+	// Cost the task by how long it took last time, so the scheduler can start the 
+	// longest running work first.
+	uint64_t duration = 0;
+	if (database != nullptr && !historyKey.IsEmpty() && database->FindDuration(historyKey, duration))
+	{
+		scheduler.SetCost(handle, (int64_t)duration);
+	}
+	else
+	{
+		scheduler.SetCost(handle, defaultCost);
+	}
+
 	if (startAfterJob)
 	{
 		scheduler.AddDependency(handle, *startAfterJob);
@@ -162,31 +207,27 @@ JobHandle Builder::QueueTask(
 	return handle;
 }
 
-void Builder::BuildDependencyList(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> projectFiles, ProjectFile& project, std::vector<ProjectFile*>& dependencyList, std::vector<ProjectFile*>& processedList)
+int64_t Builder::GetAverageTaskCost(const std::vector<std::shared_ptr<BuildTask>>& tasks, BuilderDatabase& database)
 {
-	if (std::find(processedList.begin(), processedList.end(), &project) != processedList.end())
-	{
-		return;
-	}
-	processedList.push_back(&project);
+	int64_t totalDuration = 0;
+	int64_t durationCount = 0;
 
-	std::vector<std::string> deps = project.Get_Dependencies_Dependency();
-
-	for (auto& depName : deps)
+	for (auto& task : tasks)
 	{
-		for (auto& depProject : projectFiles)
+		Platform::Path historyKey = task->GetHistoryKey();
+		uint64_t duration = 0;
+
+		if (!historyKey.IsEmpty() && database.FindDuration(historyKey, duration))
 		{
-			if (depProject->Get_Project_Name() == depName)
-			{
-				BuildDependencyList(workspaceFile, projectFiles, *depProject, dependencyList, processedList);
-			}
+			totalDuration += (int64_t)duration;
+			durationCount++;
 		}
 	}
 
-	dependencyList.push_back(&project);
+	return durationCount > 0 ? totalDuration / durationCount : 0;
 }
 
-void Builder::BuildDependencyTree(bool& bFailed, JobScheduler& scheduler, JobHandle& rootHandle, WorkspaceFile& workspaceFile, std::vector<ProjectFile*> projectFiles, ProjectFile& project, bool bRebuild, bool bBuildPackageFiles, std::vector<ProjectFile*>& processedList)
+void Builder::BuildDependencyList(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> projectFiles, ProjectFile& project, std::vector<ProjectFile*>& dependencyList, std::vector<ProjectFile*>& processedList)
 {
 	if (std::find(processedList.begin(), processedList.end(), &project) != processedList.end())
 	{
@@ -196,32 +237,19 @@ void Builder::BuildDependencyTree(bool& bFailed, JobScheduler& scheduler, JobHan
 
 	std::vector<std::string> deps = project.Get_Dependencies_Dependency();
 
-	JobHandle job = scheduler.CreateJob([=, &bFailed]() {
-		if (bFailed)
-		{
-			return;
-		}
-		WorkspaceFile wks = workspaceFile;
-		ProjectFile prj = project;
-		if (!Build(wks, projectFiles, prj, bRebuild, false, bBuildPackageFiles))
-		{
-			bFailed = true;
-		}
-	});
-	scheduler.AddDependency(rootHandle, job);
-
 	for (auto& depName : deps)
 	{
 		for (auto& depProject : projectFiles)
 		{
 			if (depProject->Get_Project_Name() == depName)
 			{
-				BuildDependencyTree(bFailed, scheduler, job, workspaceFile, projectFiles, *depProject, bRebuild, bBuildPackageFiles, processedList);
+				BuildDependencyList(workspaceFile, projectFiles, *depProject, dependencyList, processedList);
 			}
 		}
 	}
-}
 
+	dependencyList.push_back(&project);
+}
 
 bool Builder::GetSourceControlProvider(ProjectFile& project, std::shared_ptr<ISourceControlProvider>& provider)
 {
@@ -229,7 +257,7 @@ bool Builder::GetSourceControlProvider(ProjectFile& project, std::shared_ptr<ISo
 	{
 	case ESourceControlType::Git:
 		{
-			provider = std::make_shared<GitSourceControlProvider>();
+			provider = std::make_shared<GitSourceControlProvider>(&m_sourceControlCache);
 			break;
 		}
 	case ESourceControlType::None:
@@ -398,91 +426,125 @@ bool Builder::BuildChangelog(
 	std::shared_ptr<ISourceControlProvider> provider
 )
 {
-	struct ChangelogGroup
-	{
-	std::string Version;
-	std::vector<std::string> Commits;
-	};
-
-
-	int requestOffset = 0;
-	int requestChunkSize = 100;
+	typedef BuilderChangelogCache::Group ChangelogGroup;
 
 	std::string changelistTag = "[changelog]";
 	std::string changelistLegacyTag = "[changelog-legacy]";
 	std::string changelistVersionMessage = Strings::Format("[ChangeLog] Updated '%s' changelog to commit #", project.Get_Project_Name().c_str());
 
-	std::string legacyText = "";
+	// The changelog is built incrementally from the state left by the last build, so
+	// only changelists made since then need to be read.
+	Platform::Path cachePath = 
+		project.Get_Project_IntermediateDirectory()
+			.AppendFragment(project.Get_Project_Name() + ".changelog.cache", true);
 
-	std::vector<ChangelogGroup> groups;
+	std::string cacheKey = project.Get_SourceControl_Root().ToString() + "|" + changelistVersionMessage;
 
-	ChangelogGroup rootGroup;
-	rootGroup.Version = info.Changelist;
+	BuilderChangelogCache cache;
+	cache.Load(cachePath, cacheKey);
 
-	groups.push_back(rootGroup);
+	std::string lastChangelist;
+	std::string legacyText = "";
+	std::vector<ChangelogGroup> groups;
 
-	while (true)
+	auto processChangelist = [&](const SourceControlChangelist& changelist)
 	{
-		std::vector<SourceControlChangelist> history;
+		if (lastChangelist.empty())
+		{
+			lastChangelist = changelist.Id;
+		}
 
-		if (!provider->GetHistory(project.Get_SourceControl_Root(), history, requestChunkSize, requestOffset))
+		// Changelog update.
+		if (changelist.Description.compare(0, changelistVersionMessage.size(), changelistVersionMessage) == 0)
 		{
-			Log(LogSeverity::Fatal, "Failed to query source control for changelist history.\n");
-			return false;
+			ChangelogGroup group;
+			group.Version = changelist.Description.substr(changelistVersionMessage.size());
+			groups.push_back(group);
 		}
-		requestOffset += requestChunkSize;
 
-		for (auto& changelist : history)
+		// General changelist commit.
+		else
 		{
-			// Changelog update.
-			if (changelist.Description.substr(0, changelistVersionMessage.size()) == changelistVersionMessage)
-			{
-				ChangelogGroup group;
-				group.Version = changelist.Description.substr(changelistVersionMessage.size());
-				groups.push_back(group);
-			}
+			std::string lowercaseDescription = Strings::ToLowercase(changelist.Description);
 
-			// General changelist commit.
-			else
+			size_t offset = lowercaseDescription.find(changelistTag);
+			if (offset != std::string::npos)
 			{
-				size_t offset = Strings::ToLowercase(changelist.Description).find(changelistTag);
-				if (offset != std::string::npos)
-				{
-					std::string text = changelist.Description.substr(offset + changelistTag.size());
-					text = Strings::Trim(text);
+				std::string text = changelist.Description.substr(offset + changelistTag.size());
+				text = Strings::Trim(text);
 
-					std::vector<std::string> lines = Strings::Split('\n', text);
+				std::vector<std::string> lines = Strings::Split('\n', text);
 
-					ChangelogGroup& group = groups[groups.size() - 1];
+				ChangelogGroup& group = groups[groups.size() - 1];
 
-					for (auto& line : lines)
-					{
-						group.Commits.push_back(line);
-					}
+				for (auto& line : lines)
+				{
+					group.Commits.push_back(line);
 				}
-				else
+			}
+			else
+			{
+				offset = lowercaseDescription.find(changelistLegacyTag);
+				if (offset != std::string::npos)
 				{
-					offset = Strings::ToLowercase(changelist.Description).find(changelistLegacyTag);
-					if (offset != std::string::npos)
-					{
-						std::string text = changelist.Description.substr(offset + changelistLegacyTag.size());
-						legacyText += text;
-					}
+					std::string text = changelist.Description.substr(offset + changelistLegacyTag.size());
+					legacyText += text;
 				}
 			}
 		}
+	};
+
+	groups.push_back(ChangelogGroup());
+
+	if (!provider->GetHistory(project.Get_SourceControl_Root(), cache.GetLastChangelist(), processChangelist))
+	{
+		if (cache.GetLastChangelist().empty())
+		{
+			Log(LogSeverity::Fatal, "Failed to query source control for changelist history.\n");
+			return false;
+		}
+
+		// History has been rewritten since the last build, start again from scratch.
+		Log(LogSeverity::Verbose, "Changelog cache is no longer part of the history, regenerating.\n");
 
-		if (static_cast<int>(history.size()) < requestChunkSize)
+		cache = BuilderChangelogCache();
+		lastChangelist.clear();
+		legacyText.clear();
+		groups.clear();
+		groups.push_back(ChangelogGroup());
+
+		if (!provider->GetHistory(project.Get_SourceControl_Root(), "", processChangelist))
 		{
-			break;
+			Log(LogSeverity::Fatal, "Failed to query source control for changelist history.\n");
+			return false;
 		}
 	}
 
-	for (auto& group : groups)
+	if (!lastChangelist.empty())
+	{
+		cache.Merge(lastChangelist, groups, legacyText);
+
+		for (auto& group : cache.GetGroups())
+		{
+			std::sort(group.Commits.begin(), group.Commits.end());
+		}
+
+		if (!cache.Save(cachePath, cacheKey))
+		{
+			Log(LogSeverity::Warning, "Failed to write changelog cache '%s'.\n", cachePath.ToString().c_str());
+		}
+	}
+
+	groups = cache.GetGroups();
+	legacyText = cache.GetLegacyText();
+
+	if (groups.empty())
 	{
-		std::sort(group.Commits.begin(), group.Commits.end());
+		groups.push_back(ChangelogGroup());
 	}
 
+	groups[0].Version = info.Changelist;
+
 	TextStream stream;
 	stream.WriteLine("=================================================================================");
 	stream.WriteLine(" Version History");
@@ -583,45 +645,192 @@ bool Builder::BuildChangelog(
 	return true;
 }
 
+// Everything needed to build a single project that has to outlive any one of
+// the jobs building it.
+struct Builder::ProjectBuildState
+{
+	ProjectBuildState(WorkspaceFile& workspaceFile, ProjectFile& project)
+		: Workspace(workspaceFile)
+		, Project(project)
+		, ConfigurationHash(0)
+		, AcceleratorInstance(nullptr)
+		, bPrepared(false)
+		, bSkipped(false)
+		, bUpToDate(false)
+		, bTasksQueued(false)
+		, bBuildFailed(false)
+		, CurrentJobIndex(0)
+		, TotalJobs(0)
+	{
+	}
+
+	WorkspaceFile Workspace;
+	ProjectFile Project;
+
+	std::chrono::high_resolution_clock::time_point StartTime;
+	VersionNumberInfo VersionInfo;
+	uint64_t ConfigurationHash;
+
+	Platform::Path ManifestPath;
+	std::unique_ptr<BuildManifestFile> Manifest;
+	std::unique_ptr<Toolchain> ToolchainInstance;
+	Accelerator* AcceleratorInstance;
+	std::unique_ptr<BuilderCompileCache> CompileCache;
+	std::unique_ptr<BuilderDatabase> Database;
+
+	std::vector<BuilderFileInfo> FileInfos;
+	BuilderFileInfo OutputFile;
+
+	// Set once the project has been successfully prepared.
+	bool bPrepared;
+
+	// Set if the project has nothing to build, such as containers.
+	bool bSkipped;
+
+	// Set if none of the project's files, or its output, were out of date when prepared.
+	bool bUpToDate;
+
+	// Set once the tasks to build the project have been queued.
+	bool bTasksQueued;
+
+	bool bBuildFailed;
+	std::atomic<int> CurrentJobIndex;
+	int TotalJobs;
+
+	JobHandle PrepareJob;
+	JobHandle LinkGateJob;
+	JobHandle FinishJob;
+};
+
 bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> projectFileInstances, ProjectFile& project, bool bRebuild, bool bBuildDependencies, bool bBuildPackageFiles)
 {
+	std::vector<ProjectFile*> buildList;
+
 	if (bBuildDependencies)
-	{		
-		if (workspaceFile.Get_Workspace_BuildProjectsInParallel())
+	{
+		std::vector<ProjectFile*> processedList;
+		BuildDependencyList(workspaceFile, projectFileInstances, project, buildList, processedList);
+
+		// Build each project in turn if we are not building them in parallel.
+		if (!workspaceFile.Get_Workspace_BuildProjectsInParallel())
 		{
-			// Run each dependency in parallel.
-			bool bFailed = false;
+			for (auto& depProject : buildList)
+			{
+				if (!BuildProjects(workspaceFile, { depProject }, bRebuild, bBuildPackageFiles))
+				{
+					return false;
+				}
+			}
 
-			JobScheduler scheduler((int)projectFileInstances.size());
+			return true;
+		}
+	}
+	else
+	{
+		buildList.push_back(&project);
+	}
 
-			JobHandle hostJob = scheduler.CreateJob();
+	return BuildProjects(workspaceFile, buildList, bRebuild, bBuildPackageFiles);
+}
 
-			std::vector<ProjectFile*> processedList;
-			BuildDependencyTree(bFailed, scheduler, hostJob, workspaceFile, projectFileInstances, project, bRebuild, bBuildPackageFiles, processedList);
+bool Builder::BuildProjects(WorkspaceFile& workspaceFile, const std::vector<ProjectFile*>& buildList, bool bRebuild, bool bBuildPackageFiles)
+{
+	JobScheduler scheduler(Platform::GetConcurrencyFactor());
+	bool bFailed = false;
 
-			scheduler.Enqueue(hostJob);
-			scheduler.Wait(hostJob);
+	JobHandle hostJob = scheduler.CreateJob();
 
-			return !bFailed;
-		}
-		else
-		{
-			std::vector<ProjectFile*> dependencyList;
-			std::vector<ProjectFile*> processedList;
-			BuildDependencyList(workspaceFile, projectFileInstances, project, dependencyList, processedList);
+	std::vector<std::shared_ptr<ProjectBuildState>> states;
+
+	for (ProjectFile* project : buildList)
+	{
+		std::shared_ptr<ProjectBuildState> state = std::make_shared<ProjectBuildState>(workspaceFile, *project);
+
+		// Prepares the project and queues its tasks if anything is out of date.
+		state->PrepareJob = scheduler.CreateJob([this, &scheduler, &bFailed, state, bRebuild, bBuildPackageFiles]() {
+			if (bFailed)
+			{
+				return;
+			}
+			if (!PrepareProject(scheduler, *state, bRebuild, bBuildPackageFiles))
+			{
+				bFailed = true;
+				return;
+			}
+			if (!state->bSkipped && !state->bUpToDate)
+			{
+				QueueProjectTasks(scheduler, *state, &state->LinkGateJob);
+			}
+		});
 
-			for (auto& depProject : dependencyList)
+		// Runs once the projects we depend on have finished building.
+		state->LinkGateJob = scheduler.CreateJob([this, &scheduler, &bFailed, state]() {
+			if (!state->bPrepared || state->bSkipped)
 			{
-				if (!Build(workspaceFile, projectFileInstances, *depProject, bRebuild, false, bBuildPackageFiles))
+				return;
+			}
+
+			// Don't link against the output of a dependency that failed to build.
+			if (bFailed)
+			{
+				state->bBuildFailed = true;
+				return;
+			}
+
+			// Even with nothing to compile we may need to relink against the new outputs 
+			// of our dependencies, which we can only tell now they are finished.
+			if (!state->bTasksQueued)
+			{
+				if (BuilderFileInfo::CheckOutOfDate(state->OutputFile, state->ConfigurationHash, false))
 				{
-					return false;
+					QueueProjectTasks(scheduler, *state, nullptr);
 				}
 			}
+		});
 
-			return true;
+		state->FinishJob = scheduler.CreateJob([this, &bFailed, state]() {
+			if (state->bPrepared && !FinishProject(*state))
+			{
+				bFailed = true;
+			}
+		});
+
+		scheduler.AddDependency(state->LinkGateJob, state->PrepareJob);
+		scheduler.AddDependency(state->FinishJob, state->LinkGateJob);
+		scheduler.AddDependency(hostJob, state->FinishJob);
+
+		// Preparing a project makes all of its tasks available to run, so always
+		// do it ahead of any individual task.
+		scheduler.SetCost(state->PrepareJob, k_PrepareProjectCost);
+
+		// Any headers our dependencies generate exist once they have been prepared, so we
+		// can start compiling then. Only linking has to wait for them to finish.
+		for (auto& depName : state->Project.Get_Dependencies_Dependency())
+		{
+			for (auto& depState : states)
+			{
+				if (depState->Project.Get_Project_Name() == depName)
+				{
+					scheduler.AddDependency(state->PrepareJob, depState->PrepareJob);
+					scheduler.AddDependency(state->LinkGateJob, depState->FinishJob);
+				}
+			}
 		}
+
+		states.push_back(state);
 	}
 
+	scheduler.Enqueue(hostJob);
+	scheduler.Wait(hostJob);
+
+	return !bFailed;
+}
+
+bool Builder::PrepareProject(JobScheduler& scheduler, ProjectBuildState& state, bool bRebuild, bool bBuildPackageFiles)
+{
+	WorkspaceFile& workspaceFile = state.Workspace;
+	ProjectFile& project = state.Project;
+
 	// Check we have required plugins.
 	PluginManager* pluginManager = m_app->GetPluginManager();
 
@@ -653,7 +862,9 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 		}
 	}
 	
-	auto startTime = std::chrono::high_resolution_clock::now();
+	state.StartTime = std::chrono::high_resolution_clock::now();
+
+	Time::TimedScope prepareScope(Strings::Format("[%s] Prepare", project.Get_Project_Name().c_str()), "Build");
 
 	Log(LogSeverity::Info, "%s: %s (%s_%s), on %i threads\n", 
 		bRebuild ? "Rebuilding" : "Building",
@@ -664,7 +875,7 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 	);
 
 	// Try and retrieve the build version if possible.
-	VersionNumberInfo versionInfo;
+	VersionNumberInfo& versionInfo = state.VersionInfo;
 	bool bVersionInfoRequired = false;
 
 	if (bBuildPackageFiles && project.Get_Packager_BuildChangelog())
@@ -687,6 +898,8 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 		}
 	}
 
+	m_sourceControlCache.Open(workspaceFile.Get_Workspace_Location().AppendFragment("sourcecontrol.cache", true));
+
 	// Grab a source control provider if we are using one.
 	std::shared_ptr<ISourceControlProvider> provider;
 
@@ -721,14 +934,16 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 		}
 	}
 
+	bool bHashContents = (workspaceFile.Get_Workspace_ChangeDetection() == EChangeDetection::ContentHash);
+
 	// The configuration hash is used to figure out if configuration changes should
 	// require file rebuilds.
-	uint64_t configurationHash = 0;
+	uint64_t& configurationHash = state.ConfigurationHash;
 	configurationHash = Strings::Hash64(project.Get_Target_Configuration(), configurationHash);
 	configurationHash = Strings::Hash64(CastToString(project.Get_Target_Platform()), configurationHash);
 	configurationHash = Strings::Hash64(project.Get_Project_Location().ToString(), configurationHash);
-	configurationHash = Strings::Hash64(Strings::Format("%llu", project.Get_Project_File().GetModifiedTime()), configurationHash);
-	configurationHash = Strings::Hash64(Strings::Format("%llu", workspaceFile.Get_Workspace_File().GetModifiedTime()), configurationHash);
+	configurationHash = Strings::Hash64(GetConfigurationFileState(project.Get_Project_File(), bHashContents), configurationHash);
+	configurationHash = Strings::Hash64(GetConfigurationFileState(workspaceFile.Get_Workspace_File(), bHashContents), configurationHash);
 
 	Log(LogSeverity::Verbose, "Configuration Hash: %llu\n", configurationHash);
 
@@ -751,7 +966,9 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 		project.Get_Project_IntermediateDirectory()
 			.AppendFragment(project.Get_Project_Name() + ".manifest", true);
 
-	BuildManifestFile manifest(manifestPath);
+	state.ManifestPath = manifestPath;
+	state.Manifest.reset(new BuildManifestFile(manifestPath));
+	BuildManifestFile& manifest = *state.Manifest;
 	if (manifestPath.Exists())
 	{
 		if (!manifest.Read())
@@ -775,13 +992,17 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 	}
 
 	// Find the toolchain we need to build.
-	Toolchain* toolchain = GetToolchain(project, configurationHash);
+	state.ToolchainInstance.reset(GetToolchain(project, configurationHash));
+	Toolchain* toolchain = state.ToolchainInstance.get();
 	if (!toolchain)
 	{
 		Log(LogSeverity::Fatal, "No toolchain available to compile '%s'.\n", project.Get_Project_Name().c_str());
 		return false;
 	}
 
+	m_toolchainCache.Open(workspaceFile.Get_Workspace_Location().AppendFragment("toolchain.cache", true));
+	toolchain->SetToolchainCache(&m_toolchainCache);
+
 	if (!toolchain->Init())
 	{
 		Log(LogSeverity::Fatal, "Toolchain '%s' not available to compile '%s', are you sure its installed?\nIf it is installed and in a non-default dictionary, please make sure its findable through the PATH environment variable.", toolchain->GetDescription().c_str(), project.Get_Project_Name().c_str());
@@ -794,19 +1015,45 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 	{
 		accelerator = nullptr;
 	}
+	state.AcceleratorInstance = accelerator;
+
+	// Setup the compile cache if its been enabled.
+	std::unique_ptr<BuilderCompileCache>& compileCache = state.CompileCache;
+	Platform::Path cacheDirectory;
+
+	if (project.Get_CompileCache_UseCompileCache())
+	{
+		cacheDirectory = project.Get_CompileCache_Directory();
+		if (cacheDirectory.IsEmpty())
+		{
+			cacheDirectory = workspaceFile.Get_Workspace_Location().AppendFragment("CompileCache", true);
+		}
+
+		uint64_t maxSize = (uint64_t)std::max(project.Get_CompileCache_MaxSize(), 0) * 1024ULL * 1024ULL;
+
+		compileCache.reset(new BuilderCompileCache(cacheDirectory, maxSize));
+		if (!compileCache->Init())
+		{
+			Log(LogSeverity::Warning, "Failed to create compile cache directory '%s', building without cache.\n", cacheDirectory.ToString().c_str());
+			compileCache.reset();
+		}
+	}
+
+	toolchain->SetCompileCache(compileCache.get());
 
 	Log(LogSeverity::Info, "Toolchain: %s\n", toolchain->GetDescription().c_str());
 	if (accelerator)
 	{
 		Log(LogSeverity::Info, "Accelerator: %s\n", accelerator->GetDescription().c_str());
 	}
+	if (compileCache)
+	{
+		Log(LogSeverity::Info, "Compile Cache: %s\n", cacheDirectory.ToString().c_str());
+	}
 
 	Log(LogSeverity::Info, "\n");
 
-	// Setup scheduler and create main task to parent all build tasks to.
-	JobScheduler scheduler(Platform::GetConcurrencyFactor());
 	bool bBuildFailed = false;
-	JobHandle previousCommandHandle;
 
 	// Run the pre-build commands syncronously in case they update plugin source state.
 	for (auto& command : project.Get_PreBuildCommands_Command())
@@ -833,37 +1080,65 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 		m_app->GetPluginManager()->OnEvent(EPluginEvent::IbtPopulateCompileFiles, &eventData);
 	}
 
+	// Combine source files into unity files if required. This has to happen before
+	// we determine what is out of date as the unity files are what get compiled.
+	if (!toolchain->CreateUnityFiles(sourceFiles))
+	{
+		return false;
+	}
+
+	// Load the incremental build state of all files in the project.
+	Platform::Path databasePath = 
+		project.Get_Project_IntermediateDirectory()
+			.AppendFragment(project.Get_Project_Name() + ".build.db", true);
+
+	state.Database.reset(new BuilderDatabase(databasePath, bHashContents));
+	BuilderDatabase& database = *state.Database;
+	if (!database.Open())
+	{
+		Log(LogSeverity::Fatal, "Failed to open build database '%s'.\n", databasePath.ToString().c_str());
+		return false;
+	}
+
 	// Determine what files are out of date.
 	Platform::Path outputDir = project.Get_Project_IntermediateDirectory();
 	Platform::Path rootDir;
 	
 	Platform::Path::GetCommonPath(sourceFiles, rootDir);
 
-	std::vector<BuilderFileInfo> fileInfos = BuilderFileInfo::GetMultipleFileInfos(
-		sourceFiles,	
-		rootDir, 
-		outputDir,
-		configurationHash,
-		!toolchain->RequiresCompileStep()
-	);
-	
+	std::vector<BuilderFileInfo>& fileInfos = state.FileInfos;
 	bool bUpToDate = true;
-	
-	for (auto iter = fileInfos.begin(); iter != fileInfos.end(); iter++)
+
 	{
-		BuilderFileInfo& file = *iter;
-		if (file.bOutOfDate)
+		Time::TimedScope scope(Strings::Format("[%s] Up-to-date check", project.Get_Project_Name().c_str()), "Build");
+
+		fileInfos = BuilderFileInfo::GetMultipleFileInfos(
+			sourceFiles,	
+			rootDir, 
+			outputDir,
+			configurationHash,
+			!toolchain->RequiresCompileStep(),
+			&database,
+			&scheduler
+		);
+	
+		for (auto iter = fileInfos.begin(); iter != fileInfos.end(); iter++)
 		{
-			bUpToDate = false;
-			break;
+			BuilderFileInfo& file = *iter;
+			if (file.bOutOfDate)
+			{
+				bUpToDate = false;
+				break;
+			}
 		}
 	}
 
 	// Check the output manifest in case linked libraries etc have changed.
-	BuilderFileInfo outputFile;
+	BuilderFileInfo& outputFile = state.OutputFile;
 	outputFile.SourcePath			= "";
 	outputFile.OutputPath			= project.Get_Project_OutputDirectory().AppendFragment(Strings::Format("%s%s", project.Get_Project_OutputName().c_str(), project.Get_Project_OutputExtension().c_str()), true);
 	outputFile.ManifestPath			= project.Get_Project_IntermediateDirectory().AppendFragment(Strings::Format("%s.target.build.manifest", project.Get_Project_Name().c_str()), true);
+	outputFile.Database				= &database;
 	outputFile.Hash					= 0;
 	outputFile.bOutOfDate			= BuilderFileInfo::CheckOutOfDate(outputFile, configurationHash, false);
 
@@ -872,201 +1147,246 @@ bool Builder::Build(WorkspaceFile& workspaceFile, std::vector<ProjectFile*> proj
 		bUpToDate = false;
 	}
 
-	// If its a container, just 
+	// Containers have nothing to build.
 	if (project.Get_Project_OutputType() == EOutputType::Container)
 	{
 		Log(LogSeverity::SilentInfo, "%s is container, up to date.\n", project.Get_Project_Name().c_str());
-		return true;
+		state.bSkipped = true;
 	}
-	else if (bUpToDate)
-	{
-		Log(LogSeverity::SilentInfo, "%s is up to date.\n", project.Get_Project_Name().c_str());
-		return true;
-	}
-	else
-	{
-		std::atomic<int> currentJobIndex(0);
-		int totalJobs = 0;
 
-		// We have one global job that each build stage is a child of.		
-		JobHandle hostJob = scheduler.CreateJob();
+	state.bUpToDate = bUpToDate;
+	state.bPrepared = true;
 
-		// Create host jobs for each build stage.
-		std::vector<JobHandle> buildStageHostJobs;
-		for (int i = 0; i < (int)BuildStage::COUNT; i++)
-		{
-			JobHandle job = scheduler.CreateJob();
+	return true;
+}
 
-			// Host job is always dependent on the previous one executing.
-			if (i > 0)
-			{
-				scheduler.AddDependency(job, buildStageHostJobs[i - 1]);
-			}
+void Builder::QueueProjectTasks(JobScheduler& scheduler, ProjectBuildState& state, JobHandle* linkGateJob)
+{
+	// We have one global job that each build stage is a child of.		
+	JobHandle hostJob = scheduler.CreateJob();
 
-			scheduler.AddDependency(hostJob, job);
+	// Create host jobs for each build stage.
+	std::vector<JobHandle> buildStageHostJobs;
+	for (int i = 0; i < (int)BuildStage::COUNT; i++)
+	{
+		JobHandle job = scheduler.CreateJob();
 
-			buildStageHostJobs.push_back(job);
+		// Host job is always dependent on the previous one executing.
+		if (i > 0)
+		{
+			scheduler.AddDependency(job, buildStageHostJobs[i - 1]);
 		}
 
-		// Gets all the tasks required to build the project.
-		std::vector<std::shared_ptr<BuildTask>> tasks = toolchain->GetTasks(fileInfos, configurationHash, outputFile, versionInfo);
+		scheduler.AddDependency(hostJob, job);
 
-		// Register individual tasks for each build stage.
-		for (int i = 0; i < (int)BuildStage::COUNT; i++)
-		{
-			JobHandle stageJob = buildStageHostJobs[i];
+		buildStageHostJobs.push_back(job);
+	}
+
+	// Gets all the tasks required to build the project.
+	std::vector<std::shared_ptr<BuildTask>> tasks = state.ToolchainInstance->GetTasks(state.FileInfos, state.ConfigurationHash, state.OutputFile, state.VersionInfo);
 
-			std::vector<std::shared_ptr<BuildTask>> parallelTasks;
-			std::vector<std::shared_ptr<BuildTask>> distributableTasks;
-			std::vector<std::shared_ptr<BuildTask>> sequentialTasks;
+	// Tasks we have never run before are assumed to take an average amount of time.
+	int64_t defaultCost = GetAverageTaskCost(tasks, *state.Database);
+
+	// Register individual tasks for each build stage.
+	for (int i = 0; i < (int)BuildStage::COUNT; i++)
+	{
+		JobHandle stageJob = buildStageHostJobs[i];
 
-			for (auto& task : tasks)
+		std::vector<std::shared_ptr<BuildTask>> parallelTasks;
+		std::vector<std::shared_ptr<BuildTask>> distributableTasks;
+		std::vector<std::shared_ptr<BuildTask>> sequentialTasks;
+
+		for (auto& task : tasks)
+		{
+			if (task->GetBuildState() == (BuildStage)i)
 			{
-				if (task->GetBuildState() == (BuildStage)i)
+				if (task->CanDistribute() && state.AcceleratorInstance)
 				{
-					if (task->CanDistribute() && accelerator)
-					{
-						assert(task->CanRunInParallel()); // Distributed tasks are by nature parallel.
-						distributableTasks.push_back(task);
-					}
-					else if (task->CanRunInParallel())
-					{
-						parallelTasks.push_back(task);
-					}
-					else
-					{
-						sequentialTasks.push_back(task);
-					}
+					assert(task->CanRunInParallel()); // Distributed tasks are by nature parallel.
+					distributableTasks.push_back(task);
+				}
+				else if (task->CanRunInParallel())
+				{
+					parallelTasks.push_back(task);
+				}
+				else
+				{
+					sequentialTasks.push_back(task);
 				}
 			}
-			
-			// Register parallel tasks first.
-			JobHandle parallelGorupJob = scheduler.CreateJob();
+		}
+		
+		// Register parallel tasks first.
+		JobHandle parallelGorupJob = scheduler.CreateJob();
+		if (i > 0)
+		{
+			scheduler.AddDependency(parallelGorupJob, buildStageHostJobs[i - 1]);
+		}
+		scheduler.AddDependency(stageJob, parallelGorupJob);
+
+		for (auto& task : parallelTasks)
+		{
+			JobHandle* parentJob = nullptr;
 			if (i > 0)
 			{
-				scheduler.AddDependency(parallelGorupJob, buildStageHostJobs[i - 1]);
+				parentJob = &buildStageHostJobs[i - 1];
 			}
-			scheduler.AddDependency(stageJob, parallelGorupJob);
+			QueueTask(
+				scheduler, 
+				parallelGorupJob, 
+				parentJob, 
+				task, 
+				state.bBuildFailed, 
+				&state.TotalJobs, 
+				&state.CurrentJobIndex,
+				state.Database.get(),
+				defaultCost
+			);
+		}
+
+		// Queue accelerator tasks.
+		if (state.AcceleratorInstance && distributableTasks.size() > 0)
+		{
+			std::shared_ptr<AccelerateTask> task = std::make_shared<AccelerateTask>(state.Project, distributableTasks, state.ToolchainInstance.get(), state.AcceleratorInstance);
 
-			for (auto& task : parallelTasks)
+			JobHandle* parentJob = nullptr;
+			if (i > 0)
 			{
-				JobHandle* parentJob = nullptr;
-				if (i > 0)
-				{
-					parentJob = &buildStageHostJobs[i - 1];
-				}
-				QueueTask(
-					scheduler, 
-					parallelGorupJob, 
-					parentJob, 
-					task, 
-					bBuildFailed, 
-					&totalJobs, 
-					&currentJobIndex
-				);
+				parentJob = &buildStageHostJobs[i - 1];
 			}
 
-			// Queue accelerator tasks.
-			if (accelerator && distributableTasks.size() > 0)
-			{
-				std::shared_ptr<AccelerateTask> task = std::make_shared<AccelerateTask>(project, distributableTasks, toolchain, accelerator);
+			QueueTask(
+				scheduler,
+				parallelGorupJob,
+				parentJob,
+				task,
+				state.bBuildFailed,
+				&state.TotalJobs,
+				&state.CurrentJobIndex,
+				state.Database.get(),
+				defaultCost
+			);
+		}
 
-				JobHandle* parentJob = nullptr;
-				if (i > 0)
-				{
-					parentJob = &buildStageHostJobs[i - 1];
-				}
+		// Register sequential tasks after.
+		JobHandle previousSequentialTask;
 
-				QueueTask(
-					scheduler,
-					parallelGorupJob,
-					parentJob,
-					task,
-					bBuildFailed,
-					&totalJobs,
-					&currentJobIndex
-				);
+		for (auto& task : sequentialTasks)
+		{
+			JobHandle* parentJob = nullptr;
+			if (i > 0)
+			{
+				parentJob = &buildStageHostJobs[i - 1];
 			}
 
-			// Register sequential tasks after.
-			JobHandle previousSequentialTask;
-
-			for (auto& task : sequentialTasks)
+			JobHandle taskJobHandle = QueueTask(
+				scheduler, 
+				stageJob, 
+				parentJob, 
+				task, 
+				state.bBuildFailed, 
+				&state.TotalJobs, 
+				&state.CurrentJobIndex,
+				state.Database.get(),
+				defaultCost
+			);
+
+			// Dependent on all parallel tasks finishing.
+			scheduler.AddDependency(taskJobHandle, parallelGorupJob);
+
+			// Also dependent on the previous task finishing.
+			if (previousSequentialTask.IsValid())
 			{
-				JobHandle* parentJob = nullptr;
-				if (i > 0)
-				{
-					parentJob = &buildStageHostJobs[i - 1];
-				}
-
-				JobHandle taskJobHandle = QueueTask(
-					scheduler, 
-					stageJob, 
-					parentJob, 
-					task, 
-					bBuildFailed, 
-					&totalJobs, 
-					&currentJobIndex
-				);
-
-				// Dependent on all parallel tasks finishing.
-				scheduler.AddDependency(taskJobHandle, parallelGorupJob);
-
-				// Also dependent on the previous task finishing.
-				if (previousSequentialTask.IsValid())
-				{
-					scheduler.AddDependency(taskJobHandle, previousSequentialTask);
-				}
-
-				previousSequentialTask = taskJobHandle;
+				scheduler.AddDependency(taskJobHandle, previousSequentialTask);
 			}
+
+			previousSequentialTask = taskJobHandle;
 		}
+	}
+
+	// The compile stage is not finished until the link gate has passed, so everything 
+	// up to it can run alongside the projects we depend on.
+	if (linkGateJob != nullptr)
+	{
+		scheduler.AddDependency(buildStageHostJobs[(int)BuildStage::Compile], *linkGateJob);
+	}
 
-		//scheduler.PrintJobTree();
-		scheduler.Enqueue(hostJob);
-		scheduler.Wait(hostJob);
+	scheduler.AddDependency(state.FinishJob, hostJob);
+	state.bTasksQueued = true;
 
-		if (bBuildFailed)
-		{
-			Log(LogSeverity::Fatal, "Build of '%s' failed.\n", project.Get_Project_Name().c_str());
-			return false;
-		}
+	//scheduler.PrintJobTree();
+	scheduler.Enqueue(hostJob);
+}
+
+bool Builder::FinishProject(ProjectBuildState& state)
+{
+	ProjectFile& project = state.Project;
 
-		// Save out the new manifest state.
-		if (!manifest.Write())
+	if (state.bSkipped)
+	{
+		return true;
+	}
+	
+	if (!state.bTasksQueued)
+	{
+		// A dependency failed, it will already have been reported.
+		if (state.bBuildFailed)
 		{
-			Log(LogSeverity::Fatal, "Failed to write manifest file '%s'.\n", manifestPath.ToString().c_str());
 			return false;
 		}
-			
-		auto elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
-		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime).count();
 
-		Log(LogSeverity::Info, "\n");
-		Log(LogSeverity::Info, "Completed in %.1f seconds\n", elapsedMs / 1000.0f);
+		Log(LogSeverity::SilentInfo, "%s is up to date.\n", project.Get_Project_Name().c_str());
+		return true;
 	}
-	
-	return true;
-}
 
-template <typename AcceleratorType>
-AcceleratorType* GetCachedAccelerator(ProjectFile& project)
-{
-	MB_UNUSED_PARAMETER(project);
+	state.ToolchainInstance->SetCompileCache(nullptr);
 
-	/*
-	static AcceleratorType* s_CachedAccelerator = nullptr;
-	if (s_CachedAccelerator == nullptr)
+	if (state.CompileCache)
 	{
-		s_CachedAccelerator = new AcceleratorType();
-		s_CachedAccelerator->Init();
+		Log(LogSeverity::Verbose, "Compile cache: %i hits, %i misses.\n", state.CompileCache->GetHitCount(), state.CompileCache->GetMissCount());
+		state.CompileCache->Trim();
 	}
 
-	return s_CachedAccelerator;*/
+	if (state.bBuildFailed)
+	{
+		Log(LogSeverity::Fatal, "Build of '%s' failed.\n", project.Get_Project_Name().c_str());
+		return false;
+	}
 
-	AcceleratorType* acc = new AcceleratorType();
-	acc->Init();
-	return acc;
+	// Save out the new manifest state.
+	if (!state.Manifest->Write())
+	{
+		Log(LogSeverity::Fatal, "Failed to write manifest file '%s'.\n", state.ManifestPath.ToString().c_str());
+		return false;
+	}
+		
+	auto elapsedTime = std::chrono::high_resolution_clock::now() - state.StartTime;
+	auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime).count();
+
+	Log(LogSeverity::Info, "\n");
+	Log(LogSeverity::Info, "Completed in %.1f seconds\n", elapsedMs / 1000.0f);
+
+	// Projects linking against our output need to see its new state.
+	BuilderFileInfo::InvalidateCachedPaths({ state.OutputFile.OutputPath });
+	
+	return true;
+}
+
+template <typename AcceleratorType>
+AcceleratorType* GetCachedAccelerator(BuilderToolchainCache& toolchainCache)
+{
+	// Accelerators hold no per-project state once they are initialized, so a 
+	// single instance of each is shared by every build in the process.
+	static std::unique_ptr<AcceleratorType> s_cachedAccelerator([&toolchainCache]() {
+		AcceleratorType* accelerator = new AcceleratorType();
+		accelerator->SetToolchainCache(&toolchainCache);
+		accelerator->Init();
+		accelerator->SetToolchainCache(nullptr);
+		return accelerator;
+	}());
+
+	return s_cachedAccelerator.get();
 }
 
 Accelerator* Builder::GetAccelerator(ProjectFile& project)
@@ -1076,8 +1396,8 @@ Accelerator* Builder::GetAccelerator(ProjectFile& project)
 		return nullptr;
 	}
 
-	Accelerator_Sndbs* sndbsAccelerator = GetCachedAccelerator<Accelerator_Sndbs>(project);
-	Accelerator_IncrediBuild* incrediBuildAccelerator = GetCachedAccelerator<Accelerator_IncrediBuild>(project);
+	Accelerator_Sndbs* sndbsAccelerator = GetCachedAccelerator<Accelerator_Sndbs>(m_toolchainCache);
+	Accelerator_IncrediBuild* incrediBuildAccelerator = GetCachedAccelerator<Accelerator_IncrediBuild>(m_toolchainCache);
 
 	switch (project.Get_Acceleration_Accelerator())
 	{
@@ -1125,19 +1445,10 @@ Accelerator* Builder::GetAccelerator(ProjectFile& project)
 template <typename ToolchainType>
 Toolchain* GetCachedToolchain(ProjectFile& project, uint64_t configurationHash)
 {
-	/*
-	static ToolchainType* s_CachedToolchain = nullptr;
-	if (s_CachedToolchain == nullptr)
-	{
-		s_CachedToolchain = new ToolchainType(project, configurationHash);
-	}
-	s_CachedToolchain->SetProjectInfo(project, configurationHash);
-	return s_CachedToolchain;
-	*/
-	ToolchainType* acc = nullptr;
-	acc = new ToolchainType(project, configurationHash);
-	acc->SetProjectInfo(project, configurationHash);
-	return acc;
+	// Toolchains reference the project they are building so can't be shared 
+	// between builds, the expensive part of creating one is finding the tools, 
+	// which is cached by the builders toolchain cache instead.
+	return new ToolchainType(project, configurationHash);
 }
 
 Toolchain* Builder::GetToolchain(ProjectFile& project, uint64_t configurationHash)
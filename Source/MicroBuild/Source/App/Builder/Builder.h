@@ -22,11 +22,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Builder/Toolchains/Toolchain.h"
 #include "App/Builder/Tasks/BuildTask.h"
 #include "App/Builder/SourceControl/SourceControlProvider.h"
+#include "App/Builder/BuilderToolchainCache.h"
 #include "App/App.h"
 
 namespace MicroBuild {
 
 class Accelerator;
+class BuilderDatabase;
 
 // Internal builder. Takes a project configuration and builds the file as it specifies.
 class Builder
@@ -50,7 +52,8 @@ protected:
 	Accelerator* GetAccelerator(ProjectFile& project);
 
 	// Queues the task with the given scheduler and parent job and sets
-	// a given flag on failure.
+	// a given flag on failure. The tasks cost is estimated from how long it took
+	// when it was last run, falling back to the given default.
 	JobHandle QueueTask(
 		JobScheduler& scheduler, 
 		JobHandle& groupJob, 
@@ -58,7 +61,15 @@ protected:
 		std::shared_ptr<BuildTask> task,
 		bool& bFailureFlag,
 		int* totalJobs,
-		std::atomic<int>* currentJobIndex);
+		std::atomic<int>* currentJobIndex,
+		BuilderDatabase* database,
+		int64_t defaultCost);
+
+	// Gets the average time, in milliseconds, that the given tasks took when they were
+	// last run. Used as the cost of any task that has not been run before.
+	int64_t GetAverageTaskCost(
+		const std::vector<std::shared_ptr<BuildTask>>& tasks,
+		BuilderDatabase& database);
 
 	// Generates a dependency list which needs to be satisifed in order to build the output. Build order and dependencies
 	// are usually handled by the IDE, but there are a handful of cases where we need to do it ourselves.
@@ -69,16 +80,37 @@ protected:
 		std::vector<ProjectFile*>& dependencyList, 
 		std::vector<ProjectFile*>& processedList);
 
-	void BuildDependencyTree(
-		bool& bFailed, 
-		JobScheduler& scheduler, 
-		JobHandle& rootHandle, 
-		WorkspaceFile& workspaceFile, 
-		std::vector<ProjectFile*> projectFiles, 
-		ProjectFile& project, 
+	// Holds the state of a project while its build jobs are in flight.
+	struct ProjectBuildState;
+
+	// Builds each of the given projects, which must be in dependency order. A project
+	// starts compiling as soon as the projects it depends on have run their pre-build
+	// steps, only its link stage waits for them to finish building.
+	bool BuildProjects(
+		WorkspaceFile& workspaceFile,
+		const std::vector<ProjectFile*>& buildList,
 		bool bRebuild,
-		bool bBuildPackageFiles,
-		std::vector<ProjectFile*>& processedList);
+		bool bBuildPackageFiles);
+
+	// Does everything required before a project's tasks can be queued: generating version
+	// info, running pre-build commands, setting up the toolchain and determining which 
+	// files are out of date. The scheduler is the one running the project's jobs,
+	// the up-to-date check fans out onto it.
+	bool PrepareProject(
+		JobScheduler& scheduler,
+		ProjectBuildState& state,
+		bool bRebuild,
+		bool bBuildPackageFiles);
+
+	// Queues all the tasks required to build a project. If a link gate job is given
+	// the link stage, and everything after it, will not run until it has completed.
+	void QueueProjectTasks(
+		JobScheduler& scheduler,
+		ProjectBuildState& state,
+		JobHandle* linkGateJob);
+
+	// Reports the result of a project once all its tasks have run and saves its state.
+	bool FinishProject(ProjectBuildState& state);
 
 	// Attempts to generate a changelog file from source control commit messages.
 	bool BuildChangelog(
@@ -112,6 +144,12 @@ protected:
 private:
 	App* m_app;
 
+	// Results of finding toolchains, shared by every project this builder builds.
+	BuilderToolchainCache m_toolchainCache;
+
+	// Results of source control queries, kept apart from the toolchain probes.
+	BuilderToolchainCache m_sourceControlCache;
+
 }; 
 
 }; // namespace MicroBuild
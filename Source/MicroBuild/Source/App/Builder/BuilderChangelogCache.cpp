@@ -0,0 +1,162 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+
+#include "App/Builder/BuilderChangelogCache.h"
+
+#include "Core/Helpers/BinaryBuffer.h"
+
+namespace MicroBuild {
+
+BuilderChangelogCache::BuilderChangelogCache()
+{
+}
+
+BuilderChangelogCache::~BuilderChangelogCache()
+{
+}
+
+bool BuilderChangelogCache::Load(const Platform::Path& path, const std::string& key)
+{
+	m_lastChangelist.clear();
+	m_groups.clear();
+	m_legacyText.clear();
+
+	std::vector<char> data;
+	if (!path.Exists() || !ReadBinaryFile(path, data))
+	{
+		return false;
+	}
+
+	BinaryBufferReader reader(data);
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	std::string storedKey;
+	uint32_t groupCount = 0;
+
+	bool bValid = 
+		reader.Read(magic) && magic == k_CacheMagic &&
+		reader.Read(version) && version == k_CacheVersion &&
+		reader.ReadString(storedKey) && storedKey == key &&
+		reader.ReadString(m_lastChangelist) &&
+		reader.ReadString(m_legacyText) &&
+		reader.Read(groupCount);
+
+	for (uint32_t i = 0; bValid && i < groupCount; i++)
+	{
+		Group group;
+		uint32_t commitCount = 0;
+
+		bValid = 
+			reader.ReadString(group.Version) &&
+			reader.Read(commitCount);
+
+		for (uint32_t j = 0; bValid && j < commitCount; j++)
+		{
+			std::string commit;
+			bValid = reader.ReadString(commit);
+			group.Commits.push_back(commit);
+		}
+
+		m_groups.push_back(group);
+	}
+
+	if (!bValid || !reader.AtEnd() || m_lastChangelist.empty())
+	{
+		m_lastChangelist.clear();
+		m_groups.clear();
+		m_legacyText.clear();
+		return false;
+	}
+
+	return true;
+}
+
+bool BuilderChangelogCache::Save(const Platform::Path& path, const std::string& key)
+{
+	BinaryBufferWriter writer;
+	writer.Write<uint32_t>(k_CacheMagic);
+	writer.Write<uint32_t>(k_CacheVersion);
+	writer.WriteString(key);
+	writer.WriteString(m_lastChangelist);
+	writer.WriteString(m_legacyText);
+
+	writer.Write<uint32_t>((uint32_t)m_groups.size());
+	for (const Group& group : m_groups)
+	{
+		writer.WriteString(group.Version);
+		writer.Write<uint32_t>((uint32_t)group.Commits.size());
+		for (const std::string& commit : group.Commits)
+		{
+			writer.WriteString(commit);
+		}
+	}
+
+	Platform::Path directory = path.GetDirectory();
+	if (!directory.Exists() && !directory.CreateAsDirectory())
+	{
+		return false;
+	}
+
+	return WriteBinaryFile(path, writer.GetBuffer());
+}
+
+void BuilderChangelogCache::Merge(
+	const std::string& lastChangelist,
+	std::vector<Group>& groups,
+	const std::string& legacyText)
+{
+	if (lastChangelist.empty() || groups.empty())
+	{
+		return;
+	}
+
+	if (!m_groups.empty())
+	{
+		Group& lastGroup = groups[groups.size() - 1];
+		lastGroup.Commits.insert(
+			lastGroup.Commits.end(), 
+			m_groups[0].Commits.begin(), 
+			m_groups[0].Commits.end());
+
+		groups.insert(groups.end(), m_groups.begin() + 1, m_groups.end());
+	}
+
+	m_groups.swap(groups);
+	m_lastChangelist = lastChangelist;
+	m_legacyText = legacyText + m_legacyText;
+}
+
+const std::string& BuilderChangelogCache::GetLastChangelist() const
+{
+	return m_lastChangelist;
+}
+
+std::vector<BuilderChangelogCache::Group>& BuilderChangelogCache::GetGroups()
+{
+	return m_groups;
+}
+
+const std::string& BuilderChangelogCache::GetLegacyText() const
+{
+	return m_legacyText;
+}
+
+}; // namespace MicroBuild
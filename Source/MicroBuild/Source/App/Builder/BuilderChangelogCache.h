@@ -0,0 +1,77 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Platform/Path.h"
+
+namespace MicroBuild {
+
+// Persistent state of a changelog generated from source control history. It holds
+// the groups built from every changelist up to the last one processed, so later 
+// builds only have to query and process the changelists made since.
+class BuilderChangelogCache
+{
+public:
+	struct Group
+	{
+		std::string Version;
+		std::vector<std::string> Commits;
+	};
+
+	BuilderChangelogCache();
+	~BuilderChangelogCache();
+
+	// Loads the state stored in the given file. Returns false and leaves the state
+	// empty if there is none, or it was generated with a different key.
+	bool Load(const Platform::Path& path, const std::string& key);
+
+	// Writes the state to the given file.
+	bool Save(const Platform::Path& path, const std::string& key);
+
+	// Merges in the groups built from changelists made after the last one 
+	// processed. Changelists older than the first new group belong to the
+	// last of the new groups.
+	void Merge(
+		const std::string& lastChangelist,
+		std::vector<Group>& groups,
+		const std::string& legacyText);
+
+	// Id of the newest changelist that has been processed.
+	const std::string& GetLastChangelist() const;
+
+	// Groups from newest to oldest. The first holds the changelists made since the
+	// most recent changelog update, it has no version of its own.
+	std::vector<Group>& GetGroups();
+
+	const std::string& GetLegacyText() const;
+
+private:
+	enum
+	{
+		k_CacheMagic = 0x4C43424D, // MBCL
+		k_CacheVersion = 1,
+	};
+
+	std::string m_lastChangelist;
+	std::vector<Group> m_groups;
+	std::string m_legacyText;
+
+};
+
+}; // namespace MicroBuild
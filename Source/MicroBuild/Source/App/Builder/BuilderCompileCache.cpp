@@ -0,0 +1,505 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+
+#include "App/Builder/BuilderCompileCache.h"
+#include "App/Builder/BuilderDatabase.h"
+#include "App/Builder/BuilderFileInfo.h"
+
+#include "Core/Helpers/Strings.h"
+#include "Core/Helpers/StringConverter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace MicroBuild {
+
+namespace {
+
+bool ReadBinaryFile(const Platform::Path& path, std::vector<char>& data)
+{
+	FILE* file = fopen(path.ToString().c_str(), "rb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	fseek(file, 0, SEEK_SET);
+
+	bool bSuccess = (length >= 0);
+	if (bSuccess)
+	{
+		data.resize((size_t)length);
+		bSuccess = (fread(data.data(), 1, data.size(), file) == data.size());
+	}
+
+	fclose(file);
+	return bSuccess;
+}
+
+bool WriteBinaryFile(const Platform::Path& path, const char* data, size_t length)
+{
+	FILE* file = fopen(path.ToString().c_str(), "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	bool bSuccess = (fwrite(data, 1, length, file) == length);
+	fclose(file);
+
+	return bSuccess;
+}
+
+template <typename Type>
+void WriteValue(std::vector<char>& output, Type value)
+{
+	const char* data = reinterpret_cast<const char*>(&value);
+	output.insert(output.end(), data, data + sizeof(Type));
+}
+
+template <typename Type>
+bool ReadValue(const std::vector<char>& buffer, size_t& offset, Type& value)
+{
+	if (offset + sizeof(Type) > buffer.size())
+	{
+		return false;
+	}
+	memcpy(&value, buffer.data() + offset, sizeof(Type));
+	offset += sizeof(Type);
+	return true;
+}
+
+}; // namespace
+
+BuilderCompileCache::BuilderCompileCache(const Platform::Path& directory, uint64_t maxSize)
+	: m_directory(directory)
+	, m_maxSize(maxSize)
+	, m_hitCount(0)
+	, m_missCount(0)
+	, m_storeCount(0)
+{
+}
+
+BuilderCompileCache::~BuilderCompileCache()
+{
+}
+
+bool BuilderCompileCache::Init()
+{
+	if (!m_directory.Exists() && !m_directory.CreateAsDirectory())
+	{
+		return false;
+	}
+	return true;
+}
+
+int BuilderCompileCache::GetHitCount()
+{
+	return m_hitCount;
+}
+
+int BuilderCompileCache::GetMissCount()
+{
+	return m_missCount;
+}
+
+uint64_t BuilderCompileCache::GetKey(const std::string& compilerIdentity, const std::vector<std::string>& arguments)
+{
+	uint64_t key = Strings::HashBuffer64(compilerIdentity.data(), compilerIdentity.size());
+	for (const std::string& argument : arguments)
+	{
+		key = Strings::HashBuffer64(argument.data(), argument.size(), key);
+	}
+	return key;
+}
+
+Platform::Path BuilderCompileCache::GetEntryPath(uint64_t key, const std::string& extension)
+{
+	// Entries are split into sub-directories based on the first byte of their key to keep
+	// directory sizes sane.
+	std::string name = Strings::Format("%016llx", key);
+
+	return m_directory
+		.AppendFragment(name.substr(0, 2), true)
+		.AppendFragment(name + "." + extension, true);
+}
+
+uint64_t BuilderCompileCache::GetBlobKey(uint64_t key, const DependencySet& set)
+{
+	uint64_t blobKey = key;
+	for (auto& dependency : set)
+	{
+		std::string path = dependency.first.ToString();
+		blobKey = Strings::HashBuffer64(path.data(), path.size(), blobKey);
+		blobKey = Strings::HashBuffer64(&dependency.second, sizeof(uint64_t), blobKey);
+	}
+	return blobKey;
+}
+
+bool BuilderCompileCache::GetContentHash(BuilderFileInfo& file, const Platform::Path& path, uint64_t& hash)
+{
+	uint64_t modifiedTime = BuilderFileInfo::GetCachedModifiedTime(path);
+	if (modifiedTime == 0)
+	{
+		return false;
+	}
+
+	hash = file.Database->GetContentHash(path, modifiedTime);
+	return true;
+}
+
+bool BuilderCompileCache::ReadManifest(const Platform::Path& path, std::vector<DependencySet>& sets)
+{
+	std::string data;
+	if (!Strings::ReadFile(path, data))
+	{
+		return false;
+	}
+
+	// Manifest is stored as plain text, each set starts with a "set <count>" line followed
+	// by "<hash> <path>" lines for each dependency.
+	std::vector<std::string> lines = Strings::Split('\n', data, false, true);
+	for (size_t i = 0; i < lines.size(); i++)
+	{
+		unsigned int count = 0;
+		if (sscanf(lines[i].c_str(), "set %u", &count) != 1 || i + count >= lines.size())
+		{
+			return false;
+		}
+
+		DependencySet set;
+		for (unsigned int j = 0; j < count; j++)
+		{
+			const std::string& line = lines[++i];
+
+			size_t split = line.find(' ');
+			if (split == std::string::npos)
+			{
+				return false;
+			}
+
+			uint64_t hash = 0;
+			if (!StringCast<std::string, uint64_t>(line.substr(0, split), hash))
+			{
+				return false;
+			}
+
+			set.push_back(std::make_pair(Platform::Path(line.substr(split + 1)), hash));
+		}
+
+		sets.push_back(set);
+	}
+
+	return true;
+}
+
+bool BuilderCompileCache::WriteManifest(const Platform::Path& path, const std::vector<DependencySet>& sets)
+{
+	std::string data;
+	for (const DependencySet& set : sets)
+	{
+		data += Strings::Format("set %u\n", (unsigned int)set.size());
+		for (auto& dependency : set)
+		{
+			data += Strings::Format("%llu %s\n", dependency.second, dependency.first.ToString().c_str());
+		}
+	}
+
+	return WriteEntry(path, std::vector<char>(data.begin(), data.end()));
+}
+
+bool BuilderCompileCache::WriteEntry(const Platform::Path& path, const std::vector<char>& data)
+{
+	Platform::Path directory = path.GetDirectory();
+	if (!directory.Exists() && !directory.CreateAsDirectory())
+	{
+		return false;
+	}
+
+	std::string tempPath = path.ToString() + ".tmp";
+	if (!WriteBinaryFile(tempPath, data.data(), data.size()))
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	remove(path.ToString().c_str());
+	return (rename(tempPath.c_str(), path.ToString().c_str()) == 0);
+}
+
+bool BuilderCompileCache::Retrieve(uint64_t key, BuilderFileInfo& file, const std::vector<Platform::Path>& outputs, std::string& output)
+{
+	if (file.Database == nullptr)
+	{
+		m_missCount++;
+		return false;
+	}
+
+	std::vector<DependencySet> sets;
+	{
+		std::lock_guard<std::mutex> lock(m_manifestMutex);
+		if (!ReadManifest(GetEntryPath(key, "manifest"), sets))
+		{
+			m_missCount++;
+			return false;
+		}
+	}
+
+	for (const DependencySet& set : sets)
+	{
+		bool bMatches = true;
+
+		for (auto& dependency : set)
+		{
+			uint64_t hash = 0;
+			if (!GetContentHash(file, dependency.first, hash) || hash != dependency.second)
+			{
+				bMatches = false;
+				break;
+			}
+		}
+
+		if (!bMatches)
+		{
+			continue;
+		}
+
+		Platform::Path blobPath = GetEntryPath(GetBlobKey(key, set), "blob");
+
+		std::vector<char> blob;
+		if (!ReadBinaryFile(blobPath, blob))
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		uint32_t magic = 0;
+		uint32_t version = 0;
+		uint32_t outputLength = 0;
+		uint32_t fileCount = 0;
+
+		if (!ReadValue(blob, offset, magic) ||
+			!ReadValue(blob, offset, version) ||
+			!ReadValue(blob, offset, outputLength) ||
+			magic != k_BlobMagic ||
+			version != k_BlobVersion ||
+			offset + outputLength > blob.size())
+		{
+			continue;
+		}
+
+		output.assign(blob.data() + offset, outputLength);
+		offset += outputLength;
+
+		if (!ReadValue(blob, offset, fileCount) || fileCount != outputs.size())
+		{
+			continue;
+		}
+
+		bool bRestored = true;
+
+		for (uint32_t i = 0; i < fileCount && bRestored; i++)
+		{
+			uint64_t size = 0;
+			if (!ReadValue(blob, offset, size) ||
+				offset + size > blob.size() ||
+				!WriteBinaryFile(outputs[i], blob.data() + offset, (size_t)size))
+			{
+				bRestored = false;
+			}
+			offset += (size_t)size;
+		}
+
+		if (bRestored)
+		{
+			// Trim evicts by modified time, so mark the entry as recently used.
+			GetEntryPath(key, "manifest").Touch();
+			blobPath.Touch();
+
+			m_hitCount++;
+			return true;
+		}
+	}
+
+	m_missCount++;
+	return false;
+}
+
+bool BuilderCompileCache::Store(uint64_t key, BuilderFileInfo& file, const std::vector<Platform::Path>& outputs, const std::string& output)
+{
+	if (file.Database == nullptr)
+	{
+		return false;
+	}
+
+	// Dependency lists emitted by compilers generally include the outputs as well,
+	// strip them and any duplicates out.
+	DependencySet set;
+	std::vector<Platform::Path> seen(outputs.begin(), outputs.end());
+
+	for (const Platform::Path& path : file.OutputDependencyPaths)
+	{
+		if (path.IsEmpty() || std::find(seen.begin(), seen.end(), path) != seen.end())
+		{
+			continue;
+		}
+		seen.push_back(path);
+
+		uint64_t hash = 0;
+		if (!GetContentHash(file, path, hash))
+		{
+			return false;
+		}
+
+		set.push_back(std::make_pair(path, hash));
+	}
+
+	Platform::Path blobPath = GetEntryPath(GetBlobKey(key, set), "blob");
+	bool bBlobExists = blobPath.Exists();
+
+	if (!bBlobExists)
+	{
+		std::vector<char> blob;
+		WriteValue<uint32_t>(blob, k_BlobMagic);
+		WriteValue<uint32_t>(blob, k_BlobVersion);
+		WriteValue<uint32_t>(blob, (uint32_t)output.size());
+		blob.insert(blob.end(), output.begin(), output.end());
+		WriteValue<uint32_t>(blob, (uint32_t)outputs.size());
+
+		for (const Platform::Path& path : outputs)
+		{
+			std::vector<char> data;
+			if (!ReadBinaryFile(path, data))
+			{
+				return false;
+			}
+
+			WriteValue<uint64_t>(blob, (uint64_t)data.size());
+			blob.insert(blob.end(), data.begin(), data.end());
+		}
+
+		if (!WriteEntry(blobPath, blob))
+		{
+			return false;
+		}
+	}
+
+	// Put the new set at the front of the manifest so its checked first next time.
+	{
+		std::lock_guard<std::mutex> lock(m_manifestMutex);
+
+		Platform::Path manifestPath = GetEntryPath(key, "manifest");
+
+		std::vector<DependencySet> sets;
+		if (!ReadManifest(manifestPath, sets))
+		{
+			sets.clear();
+		}
+
+		// Nothing to do if this was restored from the cache in the first place.
+		if (bBlobExists && sets.size() > 0 && sets[0] == set)
+		{
+			return true;
+		}
+
+		sets.erase(std::remove(sets.begin(), sets.end(), set), sets.end());
+		sets.insert(sets.begin(), set);
+
+		if (sets.size() > k_MaxDependencySets)
+		{
+			sets.resize(k_MaxDependencySets);
+		}
+
+		if (!WriteManifest(manifestPath, sets))
+		{
+			return false;
+		}
+	}
+
+	m_storeCount++;
+	return true;
+}
+
+void BuilderCompileCache::Trim()
+{
+	if (m_storeCount == 0)
+	{
+		return;
+	}
+
+	struct CacheFile
+	{
+		Platform::Path Path;
+		uint64_t Size;
+		uint64_t ModifiedTime;
+	};
+
+	std::vector<CacheFile> files;
+	uint64_t totalSize = 0;
+
+	for (const std::string& directoryName : m_directory.GetDirectories())
+	{
+		Platform::Path directory = m_directory.AppendFragment(directoryName, true);
+
+		for (const std::string& fileName : directory.GetFiles())
+		{
+			CacheFile file;
+			file.Path = directory.AppendFragment(fileName, true);
+			file.Size = file.Path.GetSize();
+			file.ModifiedTime = file.Path.GetModifiedTimeNs();
+
+			totalSize += file.Size;
+			files.push_back(file);
+		}
+	}
+
+	if (totalSize <= m_maxSize)
+	{
+		return;
+	}
+
+	// Evict the least recently used entries first, down to 90% of the limit so we don't end up trimming
+	// on every build.
+	std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) -> bool {
+		return a.ModifiedTime < b.ModifiedTime;
+	});
+
+	uint64_t targetSize = m_maxSize - (m_maxSize / 10);
+
+	for (const CacheFile& file : files)
+	{
+		if (totalSize <= targetSize)
+		{
+			break;
+		}
+
+		if (file.Path.Delete())
+		{
+			totalSize -= file.Size;
+		}
+	}
+
+	Log(LogSeverity::Verbose, "Compile cache trimmed to %llu bytes.\n", totalSize);
+}
+
+}; // namespace MicroBuild
@@ -0,0 +1,106 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Platform/Path.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace MicroBuild {
+
+struct BuilderFileInfo;
+
+// Local content-addressed cache of compiler outputs, allows object files to be
+// restored rather than recompiled when the compiler, its arguments and the
+// contents of every file the translation unit depends on are unchanged.
+//
+// Each compile is identified by a key made from the compiler identity and its
+// argument list. The key maps to a manifest holding the last few dependency
+// sets seen for it (paths and content hashes). If all the files in one of
+// those sets still match, the set resolves to a blob containing the compiler
+// output text and the contents of each output file.
+class BuilderCompileCache
+{
+public:
+	BuilderCompileCache(const Platform::Path& directory, uint64_t maxSize);
+	~BuilderCompileCache();
+
+	// Creates the cache directory if it does not exist.
+	bool Init();
+
+	// Calculates the key that identifies a compile with the given compiler and arguments.
+	uint64_t GetKey(const std::string& compilerIdentity, const std::vector<std::string>& arguments);
+
+	// Attempts to restore the outputs of a previous compile with the same key and
+	// dependency contents. Returns true and writes the output files on success, the
+	// output text the compiler originally emitted is stored in output.
+	bool Retrieve(uint64_t key, BuilderFileInfo& file, const std::vector<Platform::Path>& outputs, std::string& output);
+
+	// Stores the outputs of a successful compile. The files dependencies must have
+	// been extracted into its OutputDependencyPaths.
+	bool Store(uint64_t key, BuilderFileInfo& file, const std::vector<Platform::Path>& outputs, const std::string& output);
+
+	// Evicts the least recently used entries until the cache is within its 
+	// maximum size. Entries are touched whenever they are retrieved.
+	void Trim();
+
+	// Gets the number of cache hits and misses since construction.
+	int GetHitCount();
+	int GetMissCount();
+
+private:
+	enum
+	{
+		k_BlobMagic = 0x4342424D, // MBBC
+		k_BlobVersion = 1,
+		k_MaxDependencySets = 4,
+	};
+
+	typedef std::vector<std::pair<Platform::Path, uint64_t>> DependencySet;
+
+	Platform::Path GetEntryPath(uint64_t key, const std::string& extension);
+
+	// Reads and writes the list of dependency sets stored for a key.
+	bool ReadManifest(const Platform::Path& path, std::vector<DependencySet>& sets);
+	bool WriteManifest(const Platform::Path& path, const std::vector<DependencySet>& sets);
+
+	// Gets the current content hash of the given file.
+	bool GetContentHash(BuilderFileInfo& file, const Platform::Path& path, uint64_t& hash);
+
+	// Gets the key of the blob a dependency set resolves to.
+	uint64_t GetBlobKey(uint64_t key, const DependencySet& set);
+
+	// Writes data to the given path via a temporary file so readers never see
+	// a partially written entry.
+	bool WriteEntry(const Platform::Path& path, const std::vector<char>& data);
+
+private:
+	Platform::Path m_directory;
+	uint64_t m_maxSize;
+
+	std::mutex m_manifestMutex;
+
+	std::atomic<int> m_hitCount;
+	std::atomic<int> m_missCount;
+	std::atomic<int> m_storeCount;
+
+};
+
+}; // namespace MicroBuild
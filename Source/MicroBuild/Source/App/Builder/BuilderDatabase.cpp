@@ -0,0 +1,583 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+
+#include "App/Builder/BuilderDatabase.h"
+#include "App/Builder/BuilderFileInfo.h"
+
+#include "Core/Helpers/Strings.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace MicroBuild {
+
+namespace {
+
+template <typename Type>
+void WriteValue(std::vector<char>& output, Type value)
+{
+	const char* data = reinterpret_cast<const char*>(&value);
+	output.insert(output.end(), data, data + sizeof(Type));
+}
+
+template <typename Type>
+bool ReadValue(const std::vector<char>& buffer, size_t& offset, size_t end, Type& value)
+{
+	if (offset + sizeof(Type) > end)
+	{
+		return false;
+	}
+	memcpy(&value, buffer.data() + offset, sizeof(Type));
+	offset += sizeof(Type);
+	return true;
+}
+
+// Records are a one byte type followed by the payload size and payload.
+// Writes the header of a record and returns the offset of its size
+// field so it can be patched once the payload is written.
+size_t BeginRecord(std::vector<char>& output, uint8_t type)
+{
+	WriteValue<uint8_t>(output, type);
+	size_t sizeOffset = output.size();
+	WriteValue<uint32_t>(output, 0);
+	return sizeOffset;
+}
+
+void EndRecord(std::vector<char>& output, size_t sizeOffset)
+{
+	uint32_t size = (uint32_t)(output.size() - sizeOffset - sizeof(uint32_t));
+	memcpy(output.data() + sizeOffset, &size, sizeof(uint32_t));
+}
+
+}; // namespace
+
+BuilderDatabase::BuilderDatabase(const Platform::Path& path, bool bHashContents)
+	: m_path(path)
+	, m_bHashContents(bHashContents)
+	, m_file(nullptr)
+	, m_recordCount(0)
+{
+}
+
+BuilderDatabase::~BuilderDatabase()
+{
+	Close();
+}
+
+Platform::Path BuilderDatabase::GetPath() const
+{
+	return m_path;
+}
+
+bool BuilderDatabase::Open()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_paths.clear();
+	m_pathIndices.clear();
+	m_entries.clear();
+	m_fileStamps.clear();
+	m_durations.clear();
+	m_recordCount = 0;
+
+	bool bNeedsRewrite = true;
+
+	FILE* file = fopen(m_path.ToString().c_str(), "rb");
+	if (file != nullptr)
+	{
+		// Pull the whole file in with a single read, everything after this
+		// is done in memory.
+		std::vector<char> buffer;
+
+		fseek(file, 0, SEEK_END);
+		long length = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		if (length > 0)
+		{
+			buffer.resize((size_t)length);
+			if (fread(buffer.data(), 1, buffer.size(), file) != buffer.size())
+			{
+				buffer.clear();
+			}
+		}
+
+		fclose(file);
+
+		bNeedsRewrite = !Load(buffer);
+	}
+
+	// Compact if records have been superceded enough times that the file is mostly
+	// dead weight.
+	if (m_recordCount > k_CompactMinimumRecords &&
+		m_recordCount > (m_entries.size() + m_fileStamps.size() + m_durations.size()) * 2)
+	{
+		bNeedsRewrite = true;
+	}
+
+	if (bNeedsRewrite)
+	{
+		if (!Compact())
+		{
+			Log(LogSeverity::Warning, "Failed to write build database '%s'.\n", m_path.ToString().c_str());
+			return false;
+		}
+	}
+
+	m_file = fopen(m_path.ToString().c_str(), "ab");
+	if (m_file == nullptr)
+	{
+		Log(LogSeverity::Warning, "Failed to open build database '%s' for writing.\n", m_path.ToString().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void BuilderDatabase::Close()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_file != nullptr)
+	{
+		fclose(m_file);
+		m_file = nullptr;
+	}
+}
+
+bool BuilderDatabase::Load(const std::vector<char>& buffer)
+{
+	size_t offset = 0;
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+
+	if (!ReadValue(buffer, offset, buffer.size(), magic) ||
+		!ReadValue(buffer, offset, buffer.size(), version) ||
+		magic != k_Magic ||
+		version != k_Version)
+	{
+		return false;
+	}
+
+	while (offset < buffer.size())
+	{
+		uint8_t type = 0;
+		uint32_t size = 0;
+
+		if (!ReadValue(buffer, offset, buffer.size(), type) ||
+			!ReadValue(buffer, offset, buffer.size(), size) ||
+			offset + size > buffer.size())
+		{
+			// Truncated record, most likely from being interrupted mid-write.
+			return false;
+		}
+
+		size_t end = offset + size;
+
+		switch ((RecordType)type)
+		{
+		case RecordType::Path:
+			{
+				std::string path(buffer.data() + offset, size);
+				m_pathIndices[path] = (uint32_t)m_paths.size();
+				m_paths.push_back(path);
+				break;
+			}
+		case RecordType::Entry:
+			{
+				uint32_t keyIndex = 0;
+				uint32_t dependencyCount = 0;
+				Entry entry;
+
+				if (!ReadValue(buffer, offset, end, keyIndex) ||
+					!ReadValue(buffer, offset, end, entry.Hash) ||
+					!ReadValue(buffer, offset, end, dependencyCount) ||
+					keyIndex >= m_paths.size())
+				{
+					return false;
+				}
+
+				entry.Dependencies.resize(dependencyCount);
+				for (uint32_t i = 0; i < dependencyCount; i++)
+				{
+					if (!ReadValue(buffer, offset, end, entry.Dependencies[i].first) ||
+						!ReadValue(buffer, offset, end, entry.Dependencies[i].second) ||
+						entry.Dependencies[i].first >= m_paths.size())
+					{
+						return false;
+					}
+				}
+
+				m_entries[keyIndex] = std::move(entry);
+				m_recordCount++;
+				break;
+			}
+		case RecordType::FileStamp:
+			{
+				uint32_t pathIndex = 0;
+				FileStamp stamp;
+
+				if (!ReadValue(buffer, offset, end, pathIndex) ||
+					!ReadValue(buffer, offset, end, stamp.ModifiedTime) ||
+					!ReadValue(buffer, offset, end, stamp.ContentHash) ||
+					pathIndex >= m_paths.size())
+				{
+					return false;
+				}
+
+				m_fileStamps[pathIndex] = stamp;
+				m_recordCount++;
+				break;
+			}
+		case RecordType::Duration:
+			{
+				uint32_t keyIndex = 0;
+				uint64_t duration = 0;
+
+				if (!ReadValue(buffer, offset, end, keyIndex) ||
+					!ReadValue(buffer, offset, end, duration) ||
+					keyIndex >= m_paths.size())
+				{
+					return false;
+				}
+
+				m_durations[keyIndex] = duration;
+				m_recordCount++;
+				break;
+			}
+		default:
+			{
+				return false;
+			}
+		}
+
+		offset = end;
+	}
+
+	return true;
+}
+
+bool BuilderDatabase::Compact()
+{
+	std::vector<char> output;
+	WriteHeader(output);
+
+	for (const std::string& path : m_paths)
+	{
+		size_t sizeOffset = BeginRecord(output, (uint8_t)RecordType::Path);
+		output.insert(output.end(), path.begin(), path.end());
+		EndRecord(output, sizeOffset);
+	}
+
+	for (auto& pair : m_entries)
+	{
+		WriteEntry(pair.first, pair.second, output);
+	}
+
+	for (auto& pair : m_fileStamps)
+	{
+		WriteFileStamp(pair.first, pair.second, output);
+	}
+
+	for (auto& pair : m_durations)
+	{
+		WriteDuration(pair.first, pair.second, output);
+	}
+
+	m_recordCount = m_entries.size() + m_fileStamps.size() + m_durations.size();
+
+	// Write to a temporary file and swap it in so an interrupted compaction
+	// does not lose the existing database.
+	std::string path = m_path.ToString();
+	std::string tempPath = path + ".tmp";
+
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	bool bSuccess = (fwrite(output.data(), 1, output.size(), file) == output.size());
+	fclose(file);
+
+	if (!bSuccess)
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	remove(path.c_str());
+	return (rename(tempPath.c_str(), path.c_str()) == 0);
+}
+
+void BuilderDatabase::WriteHeader(std::vector<char>& output)
+{
+	WriteValue<uint32_t>(output, k_Magic);
+	WriteValue<uint32_t>(output, k_Version);
+}
+
+void BuilderDatabase::WriteEntry(uint32_t keyIndex, const Entry& entry, std::vector<char>& output)
+{
+	size_t sizeOffset = BeginRecord(output, (uint8_t)RecordType::Entry);
+
+	WriteValue<uint32_t>(output, keyIndex);
+	WriteValue<uint64_t>(output, entry.Hash);
+	WriteValue<uint32_t>(output, (uint32_t)entry.Dependencies.size());
+
+	for (auto& dependency : entry.Dependencies)
+	{
+		WriteValue<uint32_t>(output, dependency.first);
+		WriteValue<uint64_t>(output, dependency.second);
+	}
+
+	EndRecord(output, sizeOffset);
+}
+
+void BuilderDatabase::WriteFileStamp(uint32_t pathIndex, const FileStamp& stamp, std::vector<char>& output)
+{
+	size_t sizeOffset = BeginRecord(output, (uint8_t)RecordType::FileStamp);
+
+	WriteValue<uint32_t>(output, pathIndex);
+	WriteValue<uint64_t>(output, stamp.ModifiedTime);
+	WriteValue<uint64_t>(output, stamp.ContentHash);
+
+	EndRecord(output, sizeOffset);
+}
+
+void BuilderDatabase::WriteDuration(uint32_t keyIndex, uint64_t duration, std::vector<char>& output)
+{
+	size_t sizeOffset = BeginRecord(output, (uint8_t)RecordType::Duration);
+
+	WriteValue<uint32_t>(output, keyIndex);
+	WriteValue<uint64_t>(output, duration);
+
+	EndRecord(output, sizeOffset);
+}
+
+uint32_t BuilderDatabase::InternPath(const std::string& path, std::vector<char>& output)
+{
+	auto iter = m_pathIndices.find(path);
+	if (iter != m_pathIndices.end())
+	{
+		return iter->second;
+	}
+
+	uint32_t index = (uint32_t)m_paths.size();
+	m_pathIndices[path] = index;
+	m_paths.push_back(path);
+
+	size_t sizeOffset = BeginRecord(output, (uint8_t)RecordType::Path);
+	output.insert(output.end(), path.begin(), path.end());
+	EndRecord(output, sizeOffset);
+
+	return index;
+}
+
+bool BuilderDatabase::Append(const std::vector<char>& data)
+{
+	if (m_file == nullptr)
+	{
+		return false;
+	}
+
+	if (fwrite(data.data(), 1, data.size(), m_file) != data.size())
+	{
+		return false;
+	}
+
+	// Flush each record as it's written so an aborted build keeps the state of
+	// everything that completed.
+	return (fflush(m_file) == 0);
+}
+
+bool BuilderDatabase::Contains(const Platform::Path& key)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto iter = m_pathIndices.find(key.ToString());
+	if (iter == m_pathIndices.end())
+	{
+		return false;
+	}
+
+	return m_entries.find(iter->second) != m_entries.end();
+}
+
+bool BuilderDatabase::Find(const Platform::Path& key, uint64_t& hash, std::vector<BuilderDependencyInfo>& dependencies)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto pathIter = m_pathIndices.find(key.ToString());
+	if (pathIter == m_pathIndices.end())
+	{
+		return false;
+	}
+
+	auto entryIter = m_entries.find(pathIter->second);
+	if (entryIter == m_entries.end())
+	{
+		return false;
+	}
+
+	const Entry& entry = entryIter->second;
+
+	hash = entry.Hash;
+
+	dependencies.clear();
+	dependencies.reserve(entry.Dependencies.size());
+
+	for (auto& dependency : entry.Dependencies)
+	{
+		BuilderDependencyInfo info;
+		info.SourcePath = m_paths[dependency.first];
+		info.Hash = dependency.second;
+		dependencies.push_back(info);
+	}
+
+	return true;
+}
+
+bool BuilderDatabase::Store(const Platform::Path& key, uint64_t hash, const std::vector<BuilderDependencyInfo>& dependencies)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<char> output;
+
+	uint32_t keyIndex = InternPath(key.ToString(), output);
+
+	Entry entry;
+	entry.Hash = hash;
+	entry.Dependencies.reserve(dependencies.size());
+
+	for (const BuilderDependencyInfo& dependency : dependencies)
+	{
+		uint32_t pathIndex = InternPath(dependency.SourcePath.ToString(), output);
+		entry.Dependencies.push_back(std::make_pair(pathIndex, dependency.Hash));
+	}
+
+	WriteEntry(keyIndex, entry, output);
+
+	m_entries[keyIndex] = std::move(entry);
+	m_recordCount++;
+
+	return Append(output);
+}
+
+bool BuilderDatabase::FindDuration(const Platform::Path& key, uint64_t& duration)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto pathIter = m_pathIndices.find(key.ToString());
+	if (pathIter == m_pathIndices.end())
+	{
+		return false;
+	}
+
+	auto durationIter = m_durations.find(pathIter->second);
+	if (durationIter == m_durations.end())
+	{
+		return false;
+	}
+
+	duration = durationIter->second;
+	return true;
+}
+
+bool BuilderDatabase::StoreDuration(const Platform::Path& key, uint64_t duration)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<char> output;
+
+	uint32_t keyIndex = InternPath(key.ToString(), output);
+	WriteDuration(keyIndex, duration, output);
+
+	m_durations[keyIndex] = duration;
+	m_recordCount++;
+
+	return Append(output);
+}
+
+bool BuilderDatabase::HashesContents() const
+{
+	return m_bHashContents;
+}
+
+uint64_t BuilderDatabase::GetContentHash(const Platform::Path& path, uint64_t modifiedTime)
+{
+	std::string pathString = path.ToString();
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto pathIter = m_pathIndices.find(pathString);
+		if (pathIter != m_pathIndices.end())
+		{
+			auto stampIter = m_fileStamps.find(pathIter->second);
+			if (stampIter != m_fileStamps.end() && stampIter->second.ModifiedTime == modifiedTime)
+			{
+				return stampIter->second.ContentHash;
+			}
+		}
+	}
+
+	// Timestamp has changed (or we've never seen the file), so hash the contents. This
+	// is done outside the lock as it can take a while for large files.
+	FILE* file = fopen(pathString.c_str(), "rb");
+	if (file == nullptr)
+	{
+		return 0;
+	}
+
+	FileStamp stamp;
+	stamp.ModifiedTime = modifiedTime;
+	stamp.ContentHash = 0;
+
+	std::vector<char> buffer(k_HashChunkSize);
+	while (true)
+	{
+		size_t bytesRead = fread(buffer.data(), 1, buffer.size(), file);
+		if (bytesRead == 0)
+		{
+			break;
+		}
+		stamp.ContentHash = Strings::HashBuffer64(buffer.data(), bytesRead, stamp.ContentHash);
+	}
+
+	fclose(file);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::vector<char> output;
+		uint32_t pathIndex = InternPath(pathString, output);
+		WriteFileStamp(pathIndex, stamp, output);
+
+		m_fileStamps[pathIndex] = stamp;
+		m_recordCount++;
+
+		Append(output);
+	}
+
+	return stamp.ContentHash;
+}
+
+}; // namespace MicroBuild
@@ -0,0 +1,148 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Platform/Path.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace MicroBuild {
+
+struct BuilderDependencyInfo;
+
+// Stores the incremental build state (state hash and dependency list) of
+// every output in a project in a single append-only binary file.
+//
+// The file is a fixed header followed by a flat stream of records. Paths
+// are interned, each one is written once as a string record and referenced
+// by index afterwards. Entry records store the state hash of an output and
+// the index/hash pairs of its dependencies. Storing an entry that already
+// exists simply appends a new record which supercedes the old one, the file
+// is compacted on load once superceded records start to dominate it.
+//
+// When content hashing is enabled the database also stores the modification 
+// time and content hash last seen for each file, so file contents only need
+// to be rehashed when their timestamp changes.
+//
+// It also keeps how long the task producing each output took the last time 
+// it ran, which the builder uses to start the longest chains of work first.
+class BuilderDatabase
+{
+public:
+	BuilderDatabase(const Platform::Path& path, bool bHashContents);
+	~BuilderDatabase();
+
+	// Reads all records from disk and prepares the database for appending.
+	bool Open();
+
+	// Flushes and closes the database file.
+	void Close();
+
+	// Returns true if a record exists for the given output key.
+	bool Contains(const Platform::Path& key);
+
+	// Retrieves the hash and dependencies last stored for the given key.
+	bool Find(const Platform::Path& key, uint64_t& hash, std::vector<BuilderDependencyInfo>& dependencies);
+
+	// Stores the hash and dependencies for the given key, replacing any
+	// previous record.
+	bool Store(const Platform::Path& key, uint64_t hash, const std::vector<BuilderDependencyInfo>& dependencies);
+
+	// Retrieves how long, in milliseconds, the task producing the given output 
+	// took the last time it ran.
+	bool FindDuration(const Platform::Path& key, uint64_t& duration);
+
+	// Stores how long, in milliseconds, the task producing the given output took.
+	bool StoreDuration(const Platform::Path& key, uint64_t duration);
+
+	// Gets the path of the database file.
+	Platform::Path GetPath() const;
+
+	// Returns true if file state should be determined from file contents 
+	// rather than just modification times.
+	bool HashesContents() const;
+
+	// Gets a hash of the contents of the given file. The stored hash is 
+	// reused if the file has not been modified since it was calculated.
+	uint64_t GetContentHash(const Platform::Path& path, uint64_t modifiedTime);
+
+private:
+	enum
+	{
+		k_Magic = 0x4244424D, // MBDB
+		k_Version = 3,
+		k_CompactMinimumRecords = 256,
+		k_HashChunkSize = 64 * 1024,
+	};
+
+	enum class RecordType : uint8_t
+	{
+		Path = 1,
+		Entry = 2,
+		FileStamp = 3,
+		Duration = 4,
+	};
+
+	struct Entry
+	{
+		uint64_t Hash;
+		std::vector<std::pair<uint32_t, uint64_t>> Dependencies;
+	};
+
+	struct FileStamp
+	{
+		uint64_t ModifiedTime;
+		uint64_t ContentHash;
+	};
+
+	// Parses the contents of the database file into memory. Stops at the
+	// first malformed or truncated record.
+	bool Load(const std::vector<char>& buffer);
+
+	// Rewrites the file so it only contains live records.
+	bool Compact();
+
+	// Gets the interned index of the given path, appending a path record
+	// if it has not been seen before.
+	uint32_t InternPath(const std::string& path, std::vector<char>& output);
+
+	void WriteHeader(std::vector<char>& output);
+	void WriteEntry(uint32_t keyIndex, const Entry& entry, std::vector<char>& output);
+	void WriteFileStamp(uint32_t pathIndex, const FileStamp& stamp, std::vector<char>& output);
+	void WriteDuration(uint32_t keyIndex, uint64_t duration, std::vector<char>& output);
+	bool Append(const std::vector<char>& data);
+
+private:
+	Platform::Path m_path;
+	bool m_bHashContents;
+	FILE* m_file;
+	std::mutex m_mutex;
+
+	std::vector<std::string> m_paths;
+	std::unordered_map<std::string, uint32_t> m_pathIndices;
+	std::unordered_map<uint32_t, Entry> m_entries;
+	std::unordered_map<uint32_t, FileStamp> m_fileStamps;
+	std::unordered_map<uint32_t, uint64_t> m_durations;
+
+	size_t m_recordCount;
+
+};
+
+}; // namespace MicroBuild
@@ -19,17 +19,21 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "PCH.h"
 
 #include "App/Builder/BuilderFileInfo.h"
+#include "App/Builder/BuilderDatabase.h"
 
-#include "Core/Config/ConfigFile.h"
+#include "Core/Helpers/Strings.h"
+#include "Core/Parallel/Jobs/JobScheduler.h"
+#include "Core/Platform/Platform.h"
+
+#include <set>
 
 namespace MicroBuild {
 	
-std::map<uint64_t, std::time_t> BuilderFileInfo::m_modifiedTimeCache;
-std::map<uint64_t, bool> BuilderFileInfo::m_fileExistsCache;
-std::mutex BuilderFileInfo::m_fileCacheLock;
+BuilderFileInfo::FileCacheShard BuilderFileInfo::m_fileCacheShards[BuilderFileInfo::k_FileCacheShardCount];
 
 BuilderFileInfo::BuilderFileInfo()
-	: bOutOfDate(false)
+	: Database(nullptr)
+	, bOutOfDate(false)
 	, Hash(0)
 	, ErrorCount(0)
 	, WarningCount(0)
@@ -56,120 +60,231 @@ void BuilderFileInfo::AddMessage(const ToolchainOutputMessage& message)
 
 bool BuilderFileInfo::LoadManifest()
 {
-	ConfigFile file;
+	if (Database == nullptr)
+	{
+		return false;
+	}
 
-	std::vector<Platform::Path> includePaths;
-	includePaths.push_back(ManifestPath.GetDirectory());
+	return Database->Find(ManifestPath, Hash, Dependencies);
+}
 
-	if (!file.Parse(ManifestPath, includePaths))
+bool BuilderFileInfo::StoreManifest()
+{
+	if (Database == nullptr)
 	{
 		return false;
 	}
 
-	file.Resolve();
+	return Database->Store(ManifestPath, Hash, Dependencies);
+}
 
-	Hash = file.GetCastedValue<uint64_t>("Manifest", "Hash", 0);
+BuilderFileInfo::FileCacheShard& BuilderFileInfo::GetFileCacheShard(const std::string& key)
+{
+	return m_fileCacheShards[Strings::Hash64(key) % k_FileCacheShardCount];
+}
 
-	Dependencies.clear();
+bool BuilderFileInfo::CanCacheModifiedTime(const Platform::Path& path)
+{
+	// We only permit caching of source-code file-types, as other file-types may be updated during the build.
+	return	path.IsIncludeFile() || 
+			path.IsSourceFile() ||
+			path.IsResourceFile() ||
+			path.IsXamlFile() ||
+			path.IsImageFile() ||
+			path.GetExtension() == "";
+}
+
+uint64_t BuilderFileInfo::GetCachedModifiedTime(const Platform::Path& path)
+{
+	bool bIsDirectory = false;
+	uint64_t time = 0;
+
+	if (!CanCacheModifiedTime(path))
+	{
+		path.GetFileState(bIsDirectory, time);
+		return time;
+	}
+
+	std::string key = path.ToString();
+	FileCacheShard& shard = GetFileCacheShard(key);
 
-	std::vector<std::pair<std::string, std::string>> pairs = file.GetPairs("Dependencies");
-	for (auto& pair : pairs)
 	{
-		BuilderDependencyInfo dependency;
-		dependency.SourcePath = pair.second;
-		if (!StringCast<std::string, uint64_t>(pair.first, dependency.Hash))
+		std::lock_guard<std::mutex> lock(shard.Lock);
+
+		auto iter = shard.Entries.find(key);
+		if (iter != shard.Entries.end() && iter->second.bModifiedTimeValid)
 		{
-			continue;
+			return iter->second.ModifiedTime;
 		}
-		Dependencies.push_back(dependency);
 	}
 
-	return true;
-}
+	// Stat outside the lock, the same stat also answers any later existance query.
+	bool bExists = path.GetFileState(bIsDirectory, time);
 
-bool BuilderFileInfo::StoreManifest()
-{
-	ConfigFile file;
-	file.SetOrAddValue("Manifest", "Hash", CastToString(Hash));
+	std::lock_guard<std::mutex> lock(shard.Lock);
 
-	for (BuilderDependencyInfo& dependency : Dependencies)
+	CachedFileState& state = shard.Entries[key];
+	if (state.bModifiedTimeValid)
 	{
-		file.SetOrAddValue("Dependencies", CastToString(dependency.Hash), dependency.SourcePath.ToString());
+		// Another thread got there first, keep the value everyone else has seen.
+		return state.ModifiedTime;
 	}
 
-	return file.Serialize(ManifestPath);
+	state.bModifiedTimeValid = true;
+	state.ModifiedTime = time;
+
+	if (!state.bExistsValid)
+	{
+		state.bExistsValid = true;
+		state.bExists = bExists;
+	}
+
+	return time;
 }
 
-std::time_t BuilderFileInfo::GetCachedModifiedTime(const Platform::Path& path)
+bool BuilderFileInfo::GetCachedPathExists(const Platform::Path& path)
 {
-	std::string extension = path.GetExtension();
+	std::string key = path.ToString();
+	FileCacheShard& shard = GetFileCacheShard(key);
 
-	// We only permit caching of source-code file-types, as other file-types may be updated during the build.
-	if (path.IsIncludeFile() || 
-		path.IsSourceFile() ||
-		path.IsResourceFile() ||
-		path.IsXamlFile() ||
-		path.IsImageFile() ||
-		extension == "")
 	{
-		std::lock_guard<std::mutex> lock(m_fileCacheLock);
+		std::lock_guard<std::mutex> lock(shard.Lock);
 
-		uint64_t key = Strings::Hash64(path.ToString());
-
-		auto iter = m_modifiedTimeCache.find(key);
-		if (iter != m_modifiedTimeCache.end())
+		auto iter = shard.Entries.find(key);
+		if (iter != shard.Entries.end() && iter->second.bExistsValid)
 		{
-			return iter->second;
+			return iter->second.bExists;
 		}
+	}
 
-		std::time_t time = path.GetModifiedTime();
-		
-		m_modifiedTimeCache[key] = time;
+	bool bIsDirectory = false;
+	uint64_t time = 0;
+	bool bExists = path.GetFileState(bIsDirectory, time);
 
-		return time;
+	std::lock_guard<std::mutex> lock(shard.Lock);
+
+	CachedFileState& state = shard.Entries[key];
+	if (state.bExistsValid)
+	{
+		return state.bExists;
 	}
-	else
+
+	state.bExistsValid = true;
+	state.bExists = bExists;
+
+	if (!state.bModifiedTimeValid && CanCacheModifiedTime(path))
 	{
-		return path.GetModifiedTime();
+		state.bModifiedTimeValid = true;
+		state.ModifiedTime = time;
 	}
+
+	return bExists;
 }
 
-bool BuilderFileInfo::GetCachedPathExists(const Platform::Path& path)
+std::vector<Platform::Path> BuilderFileInfo::GetCachedPaths()
 {
-	std::lock_guard<std::mutex> lock(m_fileCacheLock);
+	std::vector<Platform::Path> result;
+
+	for (FileCacheShard& shard : m_fileCacheShards)
+	{
+		std::lock_guard<std::mutex> lock(shard.Lock);
+
+		for (auto& pair : shard.Entries)
+		{
+			if (pair.second.bModifiedTimeValid)
+			{
+				result.push_back(pair.first);
+			}
+		}
+	}
 
-	uint64_t key = Strings::Hash64(path.ToString());
-		
-	auto iter = m_fileExistsCache.find(key);
-	if (iter != m_fileExistsCache.end())
+	return result;
+}
+
+void BuilderFileInfo::InvalidateCachedPaths(const std::vector<Platform::Path>& paths)
+{
+	for (auto& path : paths)
 	{
-		return iter->second;
+		std::string key = path.ToString();
+
+		{
+			FileCacheShard& shard = GetFileCacheShard(key);
+			std::lock_guard<std::mutex> lock(shard.Lock);
+			shard.Entries.erase(key);
+		}
+
+		// Children hash to any shard, but each shard is sorted by path, so 
+		// anything inside the path is a single run starting at the first 
+		// entry with the directory prefix.
+		std::string prefix = key + "/";
+
+		for (FileCacheShard& shard : m_fileCacheShards)
+		{
+			std::lock_guard<std::mutex> lock(shard.Lock);
+
+			auto iter = shard.Entries.lower_bound(prefix);
+			while (iter != shard.Entries.end() && iter->first.compare(0, prefix.size(), prefix) == 0)
+			{
+				iter = shard.Entries.erase(iter);
+			}
+		}
 	}
+}
 
-	bool bState = path.Exists();
+void BuilderFileInfo::ClearCache(bool bModifiedTimes)
+{
+	for (FileCacheShard& shard : m_fileCacheShards)
+	{
+		std::lock_guard<std::mutex> lock(shard.Lock);
 
-	m_fileExistsCache[key] = bState;
+		if (bModifiedTimes)
+		{
+			shard.Entries.clear();
+			continue;
+		}
 
-	return bState;
+		auto iter = shard.Entries.begin();
+		while (iter != shard.Entries.end())
+		{
+			if (iter->second.bModifiedTimeValid)
+			{
+				iter->second.bExistsValid = false;
+				++iter;
+			}
+			else
+			{
+				iter = shard.Entries.erase(iter);
+			}
+		}
+	}
 }
 
-uint64_t BuilderFileInfo::CalculateFileHash(const Platform::Path& path, uint64_t configurationHash)
+uint64_t BuilderFileInfo::CalculateFileHash(const Platform::Path& path, uint64_t configurationHash, BuilderDatabase* database)
 {
-	configurationHash = Strings::Hash64(Strings::Format("%llu", GetCachedModifiedTime(path)), configurationHash);
+	uint64_t state = GetCachedModifiedTime(path);
+
+	if (database != nullptr && database->HashesContents() && state != 0)
+	{
+		state = database->GetContentHash(path, state);
+	}
+
+	configurationHash = Strings::Hash64(Strings::Format("%llu", state), configurationHash);
 	configurationHash = Strings::Hash64(path.ToString(), configurationHash);	
 	return configurationHash;
 }
 
 bool BuilderFileInfo::CheckOutOfDate(BuilderFileInfo& info, uint64_t configurationHash, bool bNoIntermediateFiles)
 {
+	bool bHasManifest = (info.Database != nullptr && info.Database->Contains(info.ManifestPath));
+
 	if (!bNoIntermediateFiles && 
-		(!GetCachedPathExists(info.ManifestPath) ||
+		(!bHasManifest ||
 		 !GetCachedPathExists(info.OutputPath)))
 	{
 		info.bOutOfDate = true;
-		if (!GetCachedPathExists(info.ManifestPath))
+		if (!bHasManifest)
 		{
-			Log(LogSeverity::Verbose, "[%s] Out of date because manifest path is non-existant.\n", info.SourcePath.GetFilename().c_str());
+			Log(LogSeverity::Verbose, "[%s] Out of date because manifest is non-existant.\n", info.SourcePath.GetFilename().c_str());
 		}
 		else if (!GetCachedPathExists(info.OutputPath))
 		{
@@ -195,7 +310,7 @@ bool BuilderFileInfo::CheckOutOfDate(BuilderFileInfo& info, uint64_t configurati
 		{
 			for (const BuilderDependencyInfo& dependencyInfo : info.Dependencies)
 			{
-				uint64_t dependencyHash = CalculateFileHash(dependencyInfo.SourcePath, configurationHash);
+				uint64_t dependencyHash = CalculateFileHash(dependencyInfo.SourcePath, configurationHash, info.Database);
 
 				if (!GetCachedPathExists(dependencyInfo.SourcePath) ||
 					 dependencyInfo.Hash != dependencyHash)
@@ -222,14 +337,23 @@ std::vector<BuilderFileInfo> BuilderFileInfo::GetMultipleFileInfos(
 	Platform::Path rootDirectory,
 	Platform::Path outputDirectory,
 	uint64_t configurationHash,
-	bool bNoIntermediateFiles
+	bool bNoIntermediateFiles,
+	BuilderDatabase* database,
+	JobScheduler* scheduler
 )
 {
-	std::vector<BuilderFileInfo> result;
-
-	for (const Platform::Path& path : paths)
+	std::vector<BuilderFileInfo> result(paths.size());
+	std::vector<Platform::Path> baseDirectories;
+	std::set<std::string> seenBaseDirectories;
+
+	// Naming is cheap and creates directories, so do it up front on this 
+	// thread. Only the stat-heavy hashing and out-of-date checks are spread
+	// across workers.
+	for (size_t i = 0; i < paths.size(); i++)
 	{
-		BuilderFileInfo info;
+		const Platform::Path& path = paths[i];
+		BuilderFileInfo& info = result[i];
+
 		info.SourcePath = path;
 
 		Platform::Path relativePath = rootDirectory.RelativeTo(path);
@@ -237,19 +361,51 @@ std::vector<BuilderFileInfo> BuilderFileInfo::GetMultipleFileInfos(
 
 		info.OutputPath				= outputDirectory.AppendFragment(path.ChangeExtension("o").GetFilename(), true);
 		info.ManifestPath			= info.OutputPath.ChangeExtension("build.manifest");
+		info.Database				= database;
 		info.bOutOfDate				= false;
-		info.Hash					= CalculateFileHash(info.SourcePath, configurationHash);
 
 		Platform::Path baseDirectory = info.OutputPath.GetDirectory();
-		//if (!baseDirectory.Exists())
+		if (seenBaseDirectories.insert(baseDirectory.ToString()).second)
+		{
+			baseDirectories.push_back(baseDirectory);
+		}
+	}
+
+	for (const Platform::Path& baseDirectory : baseDirectories)
+	{
 		if (!GetCachedPathExists(baseDirectory))
 		{
 			baseDirectory.CreateAsDirectory();
 		}
+	}
 
+	auto scanFile = [&](BuilderFileInfo& info)
+	{
+		info.Hash = CalculateFileHash(info.SourcePath, configurationHash, database);
 		info.bOutOfDate = CheckOutOfDate(info, configurationHash, bNoIntermediateFiles);
+	};
 
-		result.push_back(info);
+	if (scheduler == nullptr || result.size() < k_ParallelScanThreshold || Platform::GetConcurrencyFactor() <= 1)
+	{
+		for (BuilderFileInfo& info : result)
+		{
+			scanFile(info);
+		}
+	}
+	else
+	{
+		int batchCount = (int)((result.size() + k_ParallelScanBatchSize - 1) / k_ParallelScanBatchSize);
+
+		// We are normally running on one of the scheduler's workers, which
+		// helps out with the batches rather than blocking on them.
+		scheduler->ParallelFor(batchCount, [&](int batch) {
+			size_t start = (size_t)batch * k_ParallelScanBatchSize;
+			size_t end = std::min(start + k_ParallelScanBatchSize, result.size());
+			for (size_t i = start; i < end; i++)
+			{
+				scanFile(result[i]);
+			}
+		});
 	}
 
 	return result;
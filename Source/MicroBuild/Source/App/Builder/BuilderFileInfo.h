@@ -26,6 +26,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace MicroBuild {
 
+class BuilderDatabase;
+class JobScheduler;
+
 // Stores information on a dependency of a MetadataFileInfo
 // structure.
 struct BuilderDependencyInfo
@@ -41,9 +44,41 @@ public:
 struct BuilderFileInfo 
 {
 private:
-	static std::map<uint64_t, std::time_t> m_modifiedTimeCache;
-	static std::map<uint64_t, bool> m_fileExistsCache;
-	static std::mutex m_fileCacheLock;
+	enum
+	{
+		k_FileCacheShardCount = 64,
+
+		// Lists shorter than this are scanned on the calling thread, it's not
+		// worth booting workers for them.
+		k_ParallelScanThreshold = 64,
+		k_ParallelScanBatchSize = 32,
+	};
+
+	// Cached result of a single stat of a path.
+	struct CachedFileState
+	{
+		bool		bExistsValid;
+		bool		bExists;
+		bool		bModifiedTimeValid;
+		uint64_t	ModifiedTime;
+	};
+
+	// The file cache is split into shards by path hash so threads scanning
+	// different files rarely contend on the same lock. Each shard is kept
+	// sorted by path so directory invalidation can prefix-scan it.
+	struct FileCacheShard
+	{
+		std::mutex Lock;
+		std::map<std::string, CachedFileState> Entries;
+	};
+
+	static FileCacheShard m_fileCacheShards[k_FileCacheShardCount];
+
+	static FileCacheShard& GetFileCacheShard(const std::string& key);
+
+	// Returns true if the modified time of the given path can be cached for
+	// the whole build.
+	static bool CanCacheModifiedTime(const Platform::Path& path);
 
 public:
 
@@ -55,9 +90,13 @@ public:
 	// The file that is output when the source file is compiled.
 	Platform::Path						OutputPath;
 
-	// Manifest file used to keep track of incremental build state.
+	// Key of this files incremental build state in the build database. Other
+	// intermediate files (response files etc) are also named after it.
 	Platform::Path						ManifestPath;
 
+	// Database that stores the incremental build state of this file.
+	BuilderDatabase*					Database;
+
 	// True if the source file needs its metadata regenerating.
 	bool								bOutOfDate;
 
@@ -87,34 +126,50 @@ public:
 	// Adds a message to the file info.
 	void AddMessage(const ToolchainOutputMessage& message);
 
-	// Loads hash and dependency data from the manifest file.
+	// Loads hash and dependency data from the build database.
 	bool LoadManifest();
 
-	// Stores hash and dependency data into the manifest file.
+	// Stores hash and dependency data into the build database.
 	bool StoreManifest();
 
 	// Calculates the state-hash for a given file. Used to figure
-	// out of a file is stale and needs regenerating.
-	static uint64_t CalculateFileHash(const Platform::Path& path, uint64_t configurationHash);
+	// out of a file is stale and needs regenerating. If the database
+	// hashes contents the hash is derived from the file contents rather
+	// than its modification time.
+	static uint64_t CalculateFileHash(const Platform::Path& path, uint64_t configurationHash, BuilderDatabase* database);
 
 	// Goes through a list of source files an generates an array of FileInfo
-	// structures for them using the given properties.
+	// structures for them using the given properties. Large lists are scanned
+	// in parallel on the given scheduler if one is provided.
 	static std::vector<BuilderFileInfo> GetMultipleFileInfos(
 		const std::vector<Platform::Path>& paths,
 		Platform::Path rootDirectory,
 		Platform::Path outputDirectory,
 		uint64_t configurationHash,
-		bool bNoIntermediateFiles
+		bool bNoIntermediateFiles,
+		BuilderDatabase* database,
+		JobScheduler* scheduler = nullptr
 	);
 
 	// Checks if a given file info is out of date.
 	static bool CheckOutOfDate(BuilderFileInfo& file, uint64_t configurationHash, bool bNoIntermediateFiles);
 
-	// Gets the modified time for a given file, and stores 
-	static std::time_t GetCachedModifiedTime(const Platform::Path& path);
+	// Gets the modified time for a given file in nanoseconds, and stores 
+	static uint64_t GetCachedModifiedTime(const Platform::Path& path);
 
 	// Gets the existance state for a given file.
 	static bool GetCachedPathExists(const Platform::Path& path);
+
+	// Gets the paths of all files whose modified time is currently cached.
+	static std::vector<Platform::Path> GetCachedPaths();
+
+	// Discards the cached state of the given paths, and of anything inside 
+	// them if they are directories.
+	static void InvalidateCachedPaths(const std::vector<Platform::Path>& paths);
+
+	// Discards all cached existance states, and the cached modified times 
+	// if bModifiedTimes is set.
+	static void ClearCache(bool bModifiedTimes);
 };
 
 // Individual command line execution for a build step.
@@ -128,6 +183,10 @@ struct BuildAction
 	std::string StatusMessage;
 	int ExitCode;
 
+	// Optional, run before the tool. If it returns true the action has already been
+	// satisfied (eg. restored from a cache) and the tool is not run.
+	std::function<bool(BuildAction& Action)> PreProcessDelegate;
+
 	std::function<bool(BuildAction& Action)> PostProcessDelegate;
 
 	BuildAction()
@@ -0,0 +1,217 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "PCH.h"
+
+#include "App/Builder/BuilderToolchainCache.h"
+
+#include "Core/Helpers/Strings.h"
+#include "Core/Helpers/BinaryBuffer.h"
+
+#include <cstdio>
+
+namespace MicroBuild {
+
+BuilderToolchainCache::BuilderToolchainCache()
+{
+}
+
+BuilderToolchainCache::~BuilderToolchainCache()
+{
+}
+
+void BuilderToolchainCache::Open(const Platform::Path& path)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_path == path)
+	{
+		return;
+	}
+
+	m_path = path;
+	m_entries.clear();
+
+	if (!Load())
+	{
+		m_entries.clear();
+	}
+}
+
+bool BuilderToolchainCache::Find(const std::string& key, std::map<std::string, std::string>& values)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto iter = m_entries.find(Strings::Hash64(key));
+	if (iter == m_entries.end())
+	{
+		return false;
+	}
+
+	for (const FileStamp& stamp : iter->second.Files)
+	{
+		if (stamp.Path.GetModifiedTimeNs() != stamp.ModifiedTime ||
+			stamp.Path.GetSize() != stamp.Size)
+		{
+			m_entries.erase(iter);
+			return false;
+		}
+	}
+
+	values = iter->second.Values;
+	return true;
+}
+
+void BuilderToolchainCache::Store(const std::string& key, const std::map<std::string, std::string>& values, const std::vector<Platform::Path>& files)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	Entry entry;
+	entry.Values = values;
+
+	for (const Platform::Path& path : files)
+	{
+		FileStamp stamp;
+		stamp.Path = path;
+		stamp.ModifiedTime = path.GetModifiedTimeNs();
+		stamp.Size = path.GetSize();
+		entry.Files.push_back(stamp);
+	}
+
+	m_entries[Strings::Hash64(key)] = entry;
+
+	if (!m_path.IsEmpty() && !Save())
+	{
+		Log(LogSeverity::Warning, "Failed to write cache '%s'.\n", m_path.ToString().c_str());
+	}
+}
+
+bool BuilderToolchainCache::Load()
+{
+	std::vector<char> data;
+	if (m_path.IsEmpty() || !m_path.Exists())
+	{
+		return true;
+	}
+	if (!ReadBinaryFile(m_path, data))
+	{
+		return false;
+	}
+
+	// Values and paths are stored length prefixed, so they are read back 
+	// exactly as they were written whatever characters they contain.
+	BinaryBufferReader reader(data);
+
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	uint32_t entryCount = 0;
+
+	bool bValid = 
+		reader.Read(magic) && magic == k_CacheMagic &&
+		reader.Read(version) && version == k_CacheVersion &&
+		reader.Read(entryCount);
+
+	for (uint32_t i = 0; bValid && i < entryCount; i++)
+	{
+		uint64_t key = 0;
+		uint32_t valueCount = 0;
+		uint32_t fileCount = 0;
+		Entry entry;
+
+		bValid = 
+			reader.Read(key) &&
+			reader.Read(valueCount);
+
+		for (uint32_t j = 0; bValid && j < valueCount; j++)
+		{
+			std::string name;
+			std::string value;
+			bValid = 
+				reader.ReadString(name) &&
+				reader.ReadString(value);
+			entry.Values[name] = value;
+		}
+
+		bValid = bValid && reader.Read(fileCount);
+
+		for (uint32_t j = 0; bValid && j < fileCount; j++)
+		{
+			FileStamp stamp;
+			std::string path;
+			bValid = 
+				reader.ReadString(path) &&
+				reader.Read(stamp.ModifiedTime) &&
+				reader.Read(stamp.Size);
+			stamp.Path = path;
+			entry.Files.push_back(stamp);
+		}
+
+		m_entries[key] = entry;
+	}
+
+	return bValid && reader.AtEnd();
+}
+
+bool BuilderToolchainCache::Save()
+{
+	BinaryBufferWriter writer;
+	writer.Write<uint32_t>(k_CacheMagic);
+	writer.Write<uint32_t>(k_CacheVersion);
+
+	writer.Write<uint32_t>((uint32_t)m_entries.size());
+	for (auto& pair : m_entries)
+	{
+		writer.Write<uint64_t>(pair.first);
+
+		writer.Write<uint32_t>((uint32_t)pair.second.Values.size());
+		for (auto& value : pair.second.Values)
+		{
+			writer.WriteString(value.first);
+			writer.WriteString(value.second);
+		}
+
+		writer.Write<uint32_t>((uint32_t)pair.second.Files.size());
+		for (const FileStamp& stamp : pair.second.Files)
+		{
+			writer.WriteString(stamp.Path.ToString());
+			writer.Write<uint64_t>(stamp.ModifiedTime);
+			writer.Write<uint64_t>(stamp.Size);
+		}
+	}
+
+	Platform::Path directory = m_path.GetDirectory();
+	if (!directory.Exists() && !directory.CreateAsDirectory())
+	{
+		return false;
+	}
+
+	// Write through a temporary file so other processes never read a partially
+	// written cache.
+	std::string tempPath = m_path.ToString() + ".tmp";
+	if (!WriteBinaryFile(tempPath, writer.GetBuffer()))
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+
+	remove(m_path.ToString().c_str());
+	return (rename(tempPath.c_str(), m_path.ToString().c_str()) == 0);
+}
+
+}; // namespace MicroBuild
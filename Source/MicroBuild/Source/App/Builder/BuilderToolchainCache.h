@@ -0,0 +1,88 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Platform/Path.h"
+
+#include <map>
+#include <mutex>
+
+namespace MicroBuild {
+
+// Persistent cache of the results of probing the environment, such as 
+// searching for toolchains and accelerators. Finding a toolchain usually means
+// searching the path and running the compiler to ask for its version, which is
+// a measurable part of the time taken by builds that otherwise have nothing to do.
+//
+// Each entry is keyed on a string describing the probe, which should contain
+// everything from the environment the probe depends on. Entries also store
+// the modification time and size of the files they found, if any of them 
+// have changed the entry is discarded and the probe run again. Values are 
+// stored verbatim, so they can hold any text the probe produced.
+class BuilderToolchainCache
+{
+public:
+	BuilderToolchainCache();
+	~BuilderToolchainCache();
+
+	// Sets the file the cache is persisted to and loads any entries already
+	// stored in it. Does nothing if the cache is already open with the same file.
+	void Open(const Platform::Path& path);
+
+	// Retrieves the values stored by a previous probe with the given key. Returns
+	// false if there are none or any of the files they depend on have changed.
+	bool Find(const std::string& key, std::map<std::string, std::string>& values);
+
+	// Stores the values found by a probe and the files they were derived from.
+	void Store(const std::string& key, const std::map<std::string, std::string>& values, const std::vector<Platform::Path>& files);
+
+private:
+	enum
+	{
+		k_CacheMagic = 0x4354424D, // MBTC
+		k_CacheVersion = 1,
+	};
+
+	struct FileStamp
+	{
+		Platform::Path Path;
+		uint64_t ModifiedTime;
+		uint64_t Size;
+	};
+
+	struct Entry
+	{
+		std::map<std::string, std::string> Values;
+		std::vector<FileStamp> Files;
+	};
+
+	// Reads and writes all entries from the cache file.
+	bool Load();
+	bool Save();
+
+private:
+	Platform::Path m_path;
+	std::mutex m_mutex;
+
+	std::map<uint64_t, Entry> m_entries;
+
+};
+
+}; // namespace MicroBuild
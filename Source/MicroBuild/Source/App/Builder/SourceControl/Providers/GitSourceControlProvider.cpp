@@ -19,13 +19,31 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "PCH.h"
 
 #include "App/Builder/SourceControl/Providers/GitSourceControlProvider.h"
+#include "App/Builder/BuilderToolchainCache.h"
 #include "Core/Platform/Process.h"
 #include "Core/Helpers/Strings.h"
 #include "Core/Helpers/StringConverter.h"
 
+#include <cstring>
+
 namespace MicroBuild {
 
-GitSourceControlProvider::GitSourceControlProvider()
+namespace {
+
+void GetDirectoriesRecursive(const Platform::Path& directory, std::vector<Platform::Path>& output)
+{
+	output.push_back(directory);
+
+	for (const std::string& name : directory.GetDirectories())
+	{
+		GetDirectoriesRecursive(directory.AppendFragment(name, true), output);
+	}
+}
+
+}; // namespace
+
+GitSourceControlProvider::GitSourceControlProvider(BuilderToolchainCache* cache)
+	: m_cache(cache)
 {
 	std::vector<std::string> formatTags;
 	formatTags.push_back("%h");		// abbreviated commit hash.
@@ -41,6 +59,40 @@ GitSourceControlProvider::GitSourceControlProvider()
 		m_logFormat += tag;
 		m_logFormat += seperator;
 	}
+
+	// History is read with -z so records are null terminated, and with the full
+	// hash so it can be used to resume reading the history later.
+	m_historyFormat = "%H%x01%an%x01%B%x01%at";
+}
+
+bool GitSourceControlProvider::ParseHistoryRecord(const char* record, size_t length, SourceControlChangelist& changelist)
+{
+	const char* fields[4];
+	size_t fieldLengths[4];
+
+	const char* end = record + length;
+	const char* start = record;
+
+	for (int i = 0; i < 4; i++)
+	{
+		const char* seperator = (i < 3) ? (const char*)memchr(start, '\x01', end - start) : end;
+		if (seperator == nullptr)
+		{
+			return false;
+		}
+
+		fields[i] = start;
+		fieldLengths[i] = seperator - start;
+		start = seperator + 1;
+	}
+
+	changelist.Id.assign(fields[0], fieldLengths[0]);
+	changelist.Author.assign(fields[1], fieldLengths[1]);
+	changelist.Description.assign(fields[2], fieldLengths[2]);
+
+	changelist.Date = (time_t)strtoll(std::string(fields[3], fieldLengths[3]).c_str(), nullptr, 10);
+
+	return true;
 }
 
 bool GitSourceControlProvider::ParseChangelists(const std::string& output, std::vector<SourceControlChangelist>& changelists)
@@ -53,8 +105,7 @@ bool GitSourceControlProvider::ParseChangelists(const std::string& output, std::
 		list.Author = splitValues[i + 1];
 		list.Description = splitValues[i + 2];
 
-		// TODO: Reliant on undefined behaviour (time_t is not assured to be a long), please fix asap.
-		list.Date = (time_t)strtol(splitValues[i + 3].c_str(), nullptr, 10);
+		list.Date = (time_t)strtoll(splitValues[i + 3].c_str(), nullptr, 10);
 
 		changelists.push_back(list);
 	}
@@ -72,7 +123,7 @@ bool GitSourceControlProvider::RunGitCommand(const std::vector<std::string>& arg
 	std::string stdeo = process.ReadToEnd();
 	if (process.GetExitCode() != 0)
 	{
-		printf("%s", stdeo.c_str());
+		Log(LogSeverity::SilentInfo, "%s", stdeo.c_str());
 		return false;
 	}
 
@@ -84,6 +135,49 @@ bool GitSourceControlProvider::RunGitCommand(const std::vector<std::string>& arg
 	return true;
 }
 
+bool GitSourceControlProvider::GetCacheKey(const std::string& query, bool bAllRefs, std::string& key, std::vector<Platform::Path>& files)
+{
+	if (m_cache == nullptr)
+	{
+		return false;
+	}
+
+	// Worktrees and submodules keep their refs elsewhere, they are just not cached.
+	Platform::Path gitDirectory = m_rootPath.AppendFragment(".git", true);
+	if (!gitDirectory.IsDirectory())
+	{
+		return false;
+	}
+
+	Platform::Path headPath = gitDirectory.AppendFragment("HEAD", true);
+
+	std::string head;
+	if (!Strings::ReadFile(headPath, head))
+	{
+		return false;
+	}
+	head = Strings::Trim(head);
+
+	files.push_back(headPath);
+	files.push_back(gitDirectory.AppendFragment("packed-refs", true));
+
+	if (head.compare(0, 5, "ref: ") == 0)
+	{
+		files.push_back(gitDirectory.AppendFragment(head.substr(5), true));
+	}
+
+	// Loose refs are updated by renaming them into place, which also changes the
+	// modification time of the directory they are in.
+	if (bAllRefs)
+	{
+		GetDirectoriesRecursive(gitDirectory.AppendFragment("refs", true), files);
+	}
+
+	key = Strings::Format("git|%s|%s|%s", m_rootPath.ToString().c_str(), query.c_str(), head.c_str());
+
+	return true;
+}
+
 bool GitSourceControlProvider::Connect(const Platform::Path& rootPath)
 {
 	m_rootPath = rootPath;
@@ -107,6 +201,20 @@ bool GitSourceControlProvider::Connect(const Platform::Path& rootPath)
 
 bool GitSourceControlProvider::GetChangelist(const Platform::Path& path, SourceControlChangelist& changelist)
 {
+	std::string cacheKey;
+	std::vector<Platform::Path> cacheFiles;
+	std::map<std::string, std::string> cacheValues;
+
+	bool bCacheable = GetCacheKey("changelist|" + path.ToString(), false, cacheKey, cacheFiles);
+	if (bCacheable && m_cache->Find(cacheKey, cacheValues))
+	{
+		changelist.Id = cacheValues["Id"];
+		changelist.Author = cacheValues["Author"];
+		changelist.Description = cacheValues["Description"];
+		changelist.Date = (time_t)strtoll(cacheValues["Date"].c_str(), nullptr, 10);
+		return true;
+	}
+
 	std::vector<std::string> arguments;
 
 	arguments.push_back("log");
@@ -138,11 +246,32 @@ bool GitSourceControlProvider::GetChangelist(const Platform::Path& path, SourceC
 
 	changelist = allChangelists[0];
 
+	if (bCacheable)
+	{
+		cacheValues["Id"] = changelist.Id;
+		cacheValues["Author"] = changelist.Author;
+		cacheValues["Description"] = changelist.Description;
+		cacheValues["Date"] = Strings::Format("%lld", (long long)changelist.Date);
+		m_cache->Store(cacheKey, cacheValues, cacheFiles);
+	}
+
 	return true;
 }
 
 bool GitSourceControlProvider::GetTotalChangelists(int& totalChangelists)
 {
+	// Counts changelists reachable from any ref, so it has to be cached against all of them.
+	std::string cacheKey;
+	std::vector<Platform::Path> cacheFiles;
+	std::map<std::string, std::string> cacheValues;
+
+	bool bCacheable = GetCacheKey("total-changelists", true, cacheKey, cacheFiles);
+	if (bCacheable && m_cache->Find(cacheKey, cacheValues))
+	{
+		totalChangelists = CastFromString<int>(cacheValues["Count"]);
+		return true;
+	}
+
 	std::vector<std::string> arguments;
 
 	arguments.push_back("rev-list");
@@ -159,30 +288,97 @@ bool GitSourceControlProvider::GetTotalChangelists(int& totalChangelists)
 
 	totalChangelists = CastFromString<int>(output);
 
+	if (bCacheable)
+	{
+		cacheValues["Count"] = CastToString(totalChangelists);
+		m_cache->Store(cacheKey, cacheValues, cacheFiles);
+	}
+
 	return true;
 }
 
-bool GitSourceControlProvider::GetHistory(const Platform::Path& path, std::vector<SourceControlChangelist>& history, int count, int offset)
+bool GitSourceControlProvider::GetHistory(const Platform::Path& path, const std::string& sinceId, const HistoryCallback& callback)
 {
 	std::vector<std::string> arguments;
 
 	arguments.push_back("log");
-	arguments.push_back(Strings::Format("--max-count=%i", count));
-	arguments.push_back(Strings::Format("--skip=%i", offset));
-	arguments.push_back(Strings::Format("--pretty=\"%s\"", m_logFormat.c_str()));
+	arguments.push_back("-z");
+	arguments.push_back(Strings::Format("--format=%s", m_historyFormat.c_str()));
+
+	if (!sinceId.empty())
+	{
+		// Make sure the history hasn't been rewritten since, otherwise the range 
+		// below would silently leave out changelists.
+		if (!RunGitCommand({ "merge-base", "--is-ancestor", sinceId, "HEAD" }, m_rootPath))
+		{
+			return false;
+		}
+
+		arguments.push_back(sinceId + "..HEAD");
+	}
+
 	arguments.push_back("--");
 	arguments.push_back(path.ToString());
 
-	std::string output = "";
-
-	if (!RunGitCommand(arguments, m_rootPath, &output))
+	Platform::Process process;
+	if (!process.Open("git", m_rootPath, arguments, true))
 	{
 		Log(LogSeverity::Warning, "Failed to execute git command.\n");
 		return false;
 	}
 
-	if (!ParseChangelists(output, history))
+	// Changelists are parsed as the log is produced, rather than holding the whole
+	// history in memory, which can be very large on old repositories.
+	std::vector<char> buffer(64 * 1024);
+	std::string pending;
+
+	SourceControlChangelist changelist;
+
+	while (true)
 	{
+		size_t bytesRead = process.Read(buffer.data(), buffer.size());
+		bool bAtEnd = (bytesRead < buffer.size());
+
+		pending.append(buffer.data(), bytesRead);
+
+		size_t offset = 0;
+		while (true)
+		{
+			size_t end = pending.find('\0', offset);
+			if (end == std::string::npos)
+			{
+				// The last record isn't null terminated.
+				if (bAtEnd && offset < pending.size())
+				{
+					end = pending.size();
+				}
+				else
+				{
+					break;
+				}
+			}
+
+			if (ParseHistoryRecord(pending.data() + offset, end - offset, changelist))
+			{
+				callback(changelist);
+			}
+
+			offset = std::min(end + 1, pending.size());
+		}
+
+		pending.erase(0, offset);
+
+		if (bAtEnd)
+		{
+			break;
+		}
+	}
+
+	process.Wait();
+
+	if (process.GetExitCode() != 0)
+	{
+		Log(LogSeverity::Warning, "Failed to execute git command.\n");
 		return false;
 	}
 
@@ -21,6 +21,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Builder/SourceControl/SourceControlProvider.h"
 
 namespace MicroBuild {
+
+class BuilderToolchainCache;
 	
 // Provides an interface to interact with and query a git server.
 class GitSourceControlProvider 
@@ -28,12 +30,14 @@ class GitSourceControlProvider
 {
 public:
 
-	GitSourceControlProvider();
+	// If a cache is given the results of queries are stored in it, and reused until
+	// the state of the repository changes.
+	GitSourceControlProvider(BuilderToolchainCache* cache = nullptr);
 	
 	virtual bool Connect(const Platform::Path& rootPath) override;
 	virtual bool GetChangelist(const Platform::Path& path, SourceControlChangelist& changelistId) override;
 	virtual bool GetTotalChangelists(int& totalChangelists) override;
-	virtual bool GetHistory(const Platform::Path& path, std::vector<SourceControlChangelist>& history, int count, int offset) override;
+	virtual bool GetHistory(const Platform::Path& path, const std::string& sinceId, const HistoryCallback& callback) override;
 	virtual bool Checkout(const Platform::Path& path) override;
 	virtual bool Commit(const std::vector<Platform::Path>& files, const std::string& commitMessage) override;
 	virtual bool Exists(const Platform::Path& path, bool& bExists) override;
@@ -56,9 +60,30 @@ private:
 		std::vector<SourceControlChangelist>& changelists
 	);
 
+	// Parses a single changelist out of a record in m_historyFormat format.
+	bool ParseHistoryRecord(
+		const char* record,
+		size_t length,
+		SourceControlChangelist& changelist
+	);
+
+	// Gets the key and the files that the result of a query should be cached 
+	// against. The key contains the contents of HEAD, the files are HEAD, the ref
+	// it points to and packed-refs. If bAllRefs is set every directory of loose
+	// refs is included. Returns false if the query can't be cached.
+	bool GetCacheKey(
+		const std::string& query,
+		bool bAllRefs,
+		std::string& key,
+		std::vector<Platform::Path>& files
+	);
+
+	BuilderToolchainCache* m_cache;
+
 	Platform::Path m_rootPath;
 
 	std::string m_logFormat;
+	std::string m_historyFormat;
 
 }; 
 
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Platform/Path.h"
 
 #include <ctime>
+#include <functional>
 
 namespace MicroBuild {
 	
@@ -48,9 +49,13 @@ public:
 	// Queries the path for all changelists that effect it, including sub-paths.
 	virtual bool GetTotalChangelists(int& totalChangelists) = 0;
 
-	// Queries the history for a given path. Returns true on success. Offset and Count can be
-	// used to page through the history in chunks.
-	virtual bool GetHistory(const Platform::Path& path, std::vector<SourceControlChangelist>& history, int count, int offset) = 0;
+	// Called with each changelist read from the history, newest first.
+	typedef std::function<void(const SourceControlChangelist& changelist)> HistoryCallback;
+
+	// Queries the history for a given path, passing each changelist to the callback as it is
+	// read. If sinceId is not empty only changelists made after it are read, this fails if it is
+	// not part of the current history. Returns true on success.
+	virtual bool GetHistory(const Platform::Path& path, const std::string& sinceId, const HistoryCallback& callback) = 0;
 
 	// Attempts to checkout the given file. File is checked out to the default changelist.
 	virtual bool Checkout(const Platform::Path& path) = 0;
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "App/Builder/Tasks/AccelerateTask.h"
 #include "Core/Platform/Process.h"
+#include "Core/Helpers/Time.h"
 
 namespace MicroBuild {
 
@@ -35,6 +36,8 @@ AccelerateTask::AccelerateTask(ProjectFile& projectFile, std::vector<std::shared
 
 bool AccelerateTask::Execute()
 {	
+	Time::TimedScope scope(Strings::Format("Distributing %i tasks", (int)m_tasks.size()), GetBuildStateName());
+
 	int jobIndex = 0, totalJobs = 0;
 	GetTaskProgress(jobIndex, totalJobs);
 
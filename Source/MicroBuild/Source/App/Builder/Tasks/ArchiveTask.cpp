@@ -42,4 +42,9 @@ BuildAction ArchiveTask::GetAction()
 	return action;
 }
 
+Platform::Path ArchiveTask::GetHistoryKey()
+{
+	return m_outputFile.OutputPath;
+}
+
 }; // namespace MicroBuild
@@ -37,6 +37,7 @@ public:
 	ArchiveTask(std::vector<BuilderFileInfo>& sourceFiles, Toolchain* toolchain, ProjectFile& project, BuilderFileInfo& outputFile);
 
 	virtual BuildAction GetAction() override;
+	virtual Platform::Path GetHistoryKey() override;
 
 }; 
 
@@ -20,12 +20,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "App/Builder/Tasks/BuildTask.h"
 
+#include "Core/Helpers/Time.h"
+
 namespace MicroBuild {
 	
 BuildTask::BuildTask(BuildStage stage, bool bCanRunInParallel, bool bGiveJobIndex, bool bCanDistribute)
 	: m_stage(stage)
 	, m_bCanRunInParallel(bCanRunInParallel)
 	, m_bCanDistribute(bCanDistribute)
+	, m_threadId(-1)
 	, m_jobIndex(-1)
 	, m_totalJobs(-1)
 	, m_bGiveJobIndex(bGiveJobIndex)
@@ -48,6 +51,11 @@ bool BuildTask::CanDistribute()
 	return m_bCanDistribute;
 }
 
+Platform::Path BuildTask::GetHistoryKey()
+{
+	return Platform::Path();
+}
+
 bool BuildTask::ShouldGiveJobIndex()
 {
 	return m_bGiveJobIndex;
@@ -58,7 +66,7 @@ int BuildTask::GetTaskThreadId()
 	return m_threadId;
 }
 
-void BuildTask::GetTaskThreadId(int id)
+void BuildTask::SetTaskThreadId(int id)
 {
 	m_threadId = id;
 }
@@ -80,6 +88,23 @@ int BuildTask::GetSubTaskCount()
 	return m_subTaskCount;
 }
 
+const char* BuildTask::GetBuildStateName()
+{
+	switch (m_stage)
+	{
+	case BuildStage::PreBuild:			return "PreBuild";
+	case BuildStage::PreBuildUser:		return "PreBuildUser";
+	case BuildStage::PchCompile:		return "PchCompile";
+	case BuildStage::Compile:			return "Compile";
+	case BuildStage::PreLink:			return "PreLink";
+	case BuildStage::PreLinkUser:		return "PreLinkUser";
+	case BuildStage::Link:				return "Link";
+	case BuildStage::PostBuildUser:		return "PostBuildUser";
+	case BuildStage::PostBuild:			return "PostBuild";
+	default:							return "Unknown";
+	}
+}
+
 void BuildTask::TaskLog(LogSeverity Severity, int subTaskIndex, const char* format, ...)
 {
 	va_list list;
@@ -116,14 +141,29 @@ bool BuildTask::Execute()
 {
 	BuildAction action = GetAction();
 
+	std::string scopeName = Strings::Trim(action.StatusMessage);
+	if (scopeName.empty())
+	{
+		scopeName = action.Tool.GetFilename();
+	}
+	Time::TimedScope scope(scopeName, GetBuildStateName());
+
 	int jobIndex = 0, totalJobs = 0;
 	GetTaskProgress(jobIndex, totalJobs);
 
+	bool bSatisfied = (action.PreProcessDelegate && action.PreProcessDelegate(action));
+
 	if (!action.StatusMessage.empty())
 	{
 		TaskLog(LogSeverity::SilentInfo, 0, "%s", action.StatusMessage.c_str());
 	}
 
+	if (bSatisfied)
+	{
+		action.ExitCode = 0;
+		return action.PostProcessDelegate(action);
+	}
+
 	Platform::Process process;
 	if (!process.Open(action.Tool, action.Tool.GetDirectory(), action.Arguments, true))
 	{
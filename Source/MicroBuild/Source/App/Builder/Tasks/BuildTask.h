@@ -110,7 +110,7 @@ public:
 
 	// Gets or sets the index of the thread we are executing on.
 	int GetTaskThreadId();
-	void GetTaskThreadId(int id);
+	void SetTaskThreadId(int id);
 
 	// Gets or sets the current task progress state to use when printing.
 	void SetTaskProgress(int jobIndex, int totalJobs);
@@ -123,9 +123,17 @@ public:
 	// of the task is given + this count above it for printing sub task details.
 	int GetSubTaskCount();
 
+	// Gets a human readable name for the stage this task runs in, used when
+	// recording trace events.
+	const char* GetBuildStateName();
+
 	// Gets the action that this build task performs.
 	virtual BuildAction GetAction() = 0;
 
+	// Gets the path of the output this task produces, used to record how long the 
+	// task takes between builds. Tasks without a single output return an empty path.
+	virtual Platform::Path GetHistoryKey();
+
 }; 
 
 }; // namespace MicroBuild
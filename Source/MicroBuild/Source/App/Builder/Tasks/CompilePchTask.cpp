@@ -42,4 +42,9 @@ BuildAction CompilePchTask::GetAction()
 	return action;
 }
 
+Platform::Path CompilePchTask::GetHistoryKey()
+{
+	return m_file.OutputPath;
+}
+
 }; // namespace MicroBuild
@@ -36,6 +36,7 @@ public:
 	CompilePchTask(Toolchain* toolchain, ProjectFile& project, BuilderFileInfo file);
 
 	virtual BuildAction GetAction() override;
+	virtual Platform::Path GetHistoryKey() override;
 
 }; 
 
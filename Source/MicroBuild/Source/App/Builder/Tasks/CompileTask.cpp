@@ -42,4 +42,9 @@ BuildAction CompileTask::GetAction()
 	return action;
 }
 
+Platform::Path CompileTask::GetHistoryKey()
+{
+	return m_file.OutputPath;
+}
+
 }; // namespace MicroBuild
@@ -37,6 +37,7 @@ public:
 	CompileTask(Toolchain* toolchain, ProjectFile& project, BuilderFileInfo& file, BuilderFileInfo pchFile);
 
 	virtual BuildAction GetAction() override;
+	virtual Platform::Path GetHistoryKey() override;
 
 }; 
 
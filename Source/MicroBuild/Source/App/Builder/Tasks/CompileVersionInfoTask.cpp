@@ -42,4 +42,9 @@ BuildAction CompileVersionInfoTask::GetAction()
 	return action;
 }
 
+Platform::Path CompileVersionInfoTask::GetHistoryKey()
+{
+	return m_file.OutputPath;
+}
+
 }; // namespace MicroBuild
@@ -37,6 +37,7 @@ public:
 	CompileVersionInfoTask(Toolchain* toolchain, ProjectFile& project, BuilderFileInfo file, VersionNumberInfo versionInfo);
 
 	virtual BuildAction GetAction() override;
+	virtual Platform::Path GetHistoryKey() override;
 
 }; 
 
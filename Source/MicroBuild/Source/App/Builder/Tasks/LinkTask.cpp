@@ -42,4 +42,9 @@ BuildAction LinkTask::GetAction()
 	return action;
 }
 
+Platform::Path LinkTask::GetHistoryKey()
+{
+	return m_outputFile.OutputPath;
+}
+
 }; // namespace MicroBuild
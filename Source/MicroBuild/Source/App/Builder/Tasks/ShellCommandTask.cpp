@@ -56,7 +56,7 @@ BuildAction ShellCommandTask::GetAction()
         } 
         if (LogGetVerbose())
         {
-            printf("%s", action.Output.c_str());
+            Log(LogSeverity::SilentInfo, "%s", action.Output.c_str());
         }        
         m_toolchain->PrintMessages(action.FileInfo);
 		return (action.ExitCode == 0);
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Builder/Toolchains/Cpp/Clang/Toolchain_Clang.h"
 #include "App/Builder/Toolchains/Cpp/Microsoft/Toolchain_Microsoft.h"
 #include "Core/Platform/Process.h"
+#include "Core/Platform/Platform.h"
 
 namespace MicroBuild {
 
@@ -54,6 +55,19 @@ bool Toolchain_Clang::FindToolchain()
 	}
 #endif
 
+	// Reuse the results of a previous probe if the tools it found are unchanged.
+	std::string probeKey = Strings::Format("Clang|%s", Platform::GetEnvironmentVariable("PATH").c_str());
+
+	std::map<std::string, std::string> probe;
+	if (FindCachedProbe(probeKey, probe))
+	{
+		m_compilerPath = probe["CompilerPath"];
+		m_archiverPath = probe["ArchiverPath"];
+		m_linkerPath = m_compilerPath;
+		m_version = probe["Version"];
+		return true;
+	}
+
 	if (!Platform::Path::FindFile("clang++", m_compilerPath, additionalDirs))
 	{
 		return false;
@@ -87,10 +101,15 @@ bool Toolchain_Clang::FindToolchain()
 		std::vector<std::string> split = Strings::Split(' ', versionLine);
 		if (split.size() >= 3)
 		{
-			m_version = split[2];
+			m_version = Strings::Trim(split[2]);
 		}
 	}	
 
+	probe["CompilerPath"] = m_compilerPath.ToString();
+	probe["ArchiverPath"] = m_archiverPath.ToString();
+	probe["Version"] = m_version;
+	StoreProbe(probeKey, probe, { m_compilerPath, m_archiverPath });
+
 	return true;
 }
 
@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Builder/Toolchains/Cpp/Gcc/Toolchain_Gcc.h"
 #include "App/Builder/Toolchains/Cpp/Gcc/Toolchain_GccOutputParser.h"
 #include "Core/Platform/Process.h"
+#include "Core/Platform/Platform.h"
 
 namespace MicroBuild {
 	
@@ -31,6 +32,7 @@ Toolchain_Gcc::Toolchain_Gcc(ProjectFile& file, uint64_t configurationHash)
 {
 	m_useStartEndGroup = true;
 	m_bGeneratesPchObject = false;
+	m_bCanCacheCompiles = true;
 }
 
 bool Toolchain_Gcc::Init() 
@@ -73,6 +75,23 @@ bool Toolchain_Gcc::FindToolchain()
 #else
 	additionalDirs.push_back("/usr/bin");
 #endif
+
+	// Reuse the results of a previous probe if the tools it found are unchanged.
+	std::string probeKey = Strings::Format("Gcc|%s|%s|%s", 
+		compilerName.c_str(), 
+		archiverName.c_str(), 
+		Platform::GetEnvironmentVariable("PATH").c_str());
+
+	std::map<std::string, std::string> probe;
+	if (FindCachedProbe(probeKey, probe))
+	{
+		m_compilerPath = probe["CompilerPath"];
+		m_archiverPath = probe["ArchiverPath"];
+		m_windowsResourceCompilerPath = probe["ResourceCompilerPath"];
+		m_linkerPath = m_compilerPath;
+		m_version = probe["Version"];
+		return true;
+	}
 	
 	if (!Platform::Path::FindFile(compilerName, m_compilerPath, additionalDirs))
 	{
@@ -109,10 +128,16 @@ bool Toolchain_Gcc::FindToolchain()
 		size_t lastSpace = versionLine.find_last_of(' ');
 		if (lastSpace != std::string::npos)
 		{
-			m_version = versionLine.substr(lastSpace + 1);
+			m_version = Strings::Trim(versionLine.substr(lastSpace + 1));
 		}
 	}	
 
+	probe["CompilerPath"] = m_compilerPath.ToString();
+	probe["ArchiverPath"] = m_archiverPath.ToString();
+	probe["ResourceCompilerPath"] = m_windowsResourceCompilerPath.ToString();
+	probe["Version"] = m_version;
+	StoreProbe(probeKey, probe, { m_compilerPath, m_archiverPath, m_windowsResourceCompilerPath });
+
 	return true;
 }
 	
@@ -413,6 +438,12 @@ void Toolchain_Gcc::GetSourceCompileArguments(const BuilderFileInfo& file, std::
 	args.push_back(Strings::Quoted(file.SourcePath.ToString()));
 }
 
+void Toolchain_Gcc::GetCompileOutputs(const BuilderFileInfo& file, std::vector<Platform::Path>& outputs)
+{
+	outputs.push_back(file.OutputPath);
+	outputs.push_back(file.OutputPath.ChangeExtension("d"));
+}
+
 void Toolchain_Gcc::GetLinkArguments(const std::vector<BuilderFileInfo>& sourceFiles, std::vector<std::string>& args) 
 {
 	Platform::Path outputPath = GetOutputPath();
@@ -768,7 +799,7 @@ void Toolchain_Gcc::GetCompileVersionInfoAction(BuildAction& action, BuilderFile
 
 	action.PostProcessDelegate = [this](BuildAction& action) -> bool
 	{
-		printf("%s", action.Output.c_str());
+		Log(LogSeverity::SilentInfo, "%s", action.Output.c_str());
 		if (action.ExitCode != 0)
 		{
 			return false;
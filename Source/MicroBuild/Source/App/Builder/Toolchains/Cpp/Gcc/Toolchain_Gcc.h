@@ -63,6 +63,9 @@ protected:
 
 	// Gets arguments to send to compiler for generating an object file.
 	virtual void GetSourceCompileArguments(const BuilderFileInfo& file, std::vector<std::string>& args) override;
+
+	// Gets all the files written when compiling the given file, the object and its dependency file.
+	virtual void GetCompileOutputs(const BuilderFileInfo& file, std::vector<Platform::Path>& outputs) override;
 	
 	// Gets arguments to send to linker for generating an executable file.
 	virtual void GetLinkArguments(const std::vector<BuilderFileInfo>& sourceFiles, std::vector<std::string>& args) override;
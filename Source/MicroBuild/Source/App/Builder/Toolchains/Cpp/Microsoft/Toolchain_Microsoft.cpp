@@ -1107,7 +1107,7 @@ void Toolchain_Microsoft::GetCompileVersionInfoAction(BuildAction& action, Build
 
 	action.PostProcessDelegate = [this](BuildAction& action) -> bool
 	{
-		printf("%s", action.Output.c_str());
+		Log(LogSeverity::SilentInfo, "%s", action.Output.c_str());
 		if (action.ExitCode != 0)
 		{
 			return false;
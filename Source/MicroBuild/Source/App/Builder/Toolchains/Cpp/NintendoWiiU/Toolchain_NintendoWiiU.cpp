@@ -614,7 +614,7 @@ bool Toolchain_NintendoWiiU::RplExportAll(const std::vector<BuilderFileInfo>& fi
 	std::string output = process.ReadToEnd();
 	if (process.GetExitCode() != 0)
 	{
-		printf("%s", output.c_str());
+		Log(LogSeverity::SilentInfo, "%s", output.c_str());
 		return false;
 	}	
 
@@ -709,7 +709,7 @@ bool Toolchain_NintendoWiiU::PrepRPL(const std::vector<BuilderFileInfo>& files,
 
 	if (process.GetExitCode() != 0)
 	{
-		printf("%s", output.c_str());
+		Log(LogSeverity::SilentInfo, "%s", output.c_str());
 		return false;
 	}	
 
@@ -766,7 +766,7 @@ bool Toolchain_NintendoWiiU::MakeRPL(const std::vector<BuilderFileInfo>& files,
 
 	if (process.GetExitCode() != 0)
 	{
-		printf("%s", output.c_str());
+		Log(LogSeverity::SilentInfo, "%s", output.c_str());
 		return false;
 	}	
 
@@ -800,7 +800,7 @@ void Toolchain_NintendoWiiU::GetLinkAction(BuildAction& action, std::vector<Buil
 
 	action.PostProcessDelegate = [this, files](BuildAction& action) -> bool
 	{
-		printf("%s", action.Output.c_str());
+		Log(LogSeverity::SilentInfo, "%s", action.Output.c_str());
 		if (action.ExitCode != 0)
 		{
 			return false;
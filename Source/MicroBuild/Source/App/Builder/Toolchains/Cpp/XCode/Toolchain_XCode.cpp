@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "PCH.h"
 #include "App/Builder/Toolchains/Cpp/XCode/Toolchain_XCode.h"
 #include "Core/Platform/Process.h"
+#include "Core/Platform/Platform.h"
 
 namespace MicroBuild {
 	
@@ -61,41 +62,61 @@ bool Toolchain_XCode::FindXCodeExe(const std::string& exeName, Platform::Path& o
 
 bool Toolchain_XCode::FindToolchain()
 {
-	if (!FindXCodeExe("clang++", m_compilerPath))
+	// Reuse the results of a previous probe if the tools it found are unchanged.
+	std::string probeKey = Strings::Format("XCode|%s|%s", 
+		Platform::GetEnvironmentVariable("DEVELOPER_DIR").c_str(),
+		Platform::GetEnvironmentVariable("PATH").c_str());
+
+	std::map<std::string, std::string> probe;
+	if (FindCachedProbe(probeKey, probe))
 	{
-		Log(LogSeverity::Warning, "Could not find clang++ in xcode toolchain.\n");
-		return false;
+		m_compilerPath = probe["CompilerPath"];
+		m_archiverPath = probe["ArchiverPath"];
+		m_version = probe["Version"];
 	}
-	if (!FindXCodeExe("libtool", m_archiverPath))
+	else
 	{
-		Log(LogSeverity::Warning, "Could not find ar in xcode toolchain.\n");
-		return false;
-	}
-
-	m_linkerPath = m_compilerPath;
+		if (!FindXCodeExe("clang++", m_compilerPath))
+		{
+			Log(LogSeverity::Warning, "Could not find clang++ in xcode toolchain.\n");
+			return false;
+		}
+		if (!FindXCodeExe("libtool", m_archiverPath))
+		{
+			Log(LogSeverity::Warning, "Could not find ar in xcode toolchain.\n");
+			return false;
+		}
 
-	Platform::Process process;
+		Platform::Process process;
 
-	std::vector<std::string> args;
-	args.push_back("--version");
-	if (!process.Open(m_compilerPath, m_compilerPath.GetDirectory(), args, true))
-	{
-		Log(LogSeverity::Warning, "Could not execute clang++ to gain version number.\n");
-		return false;
-	}
+		std::vector<std::string> args;
+		args.push_back("--version");
+		if (!process.Open(m_compilerPath, m_compilerPath.GetDirectory(), args, true))
+		{
+			Log(LogSeverity::Warning, "Could not execute clang++ to gain version number.\n");
+			return false;
+		}
 
-	m_version = "Unknown Version";
+		m_version = "Unknown Version";
 
-	std::vector<std::string> lines = Strings::Split('\n', process.ReadToEnd());
-	if (lines.size() > 0)
-	{
-		std::string versionLine = lines[0];
-		std::vector<std::string> split = Strings::Split(' ', versionLine);
-		if (split.size() > 4)
+		std::vector<std::string> lines = Strings::Split('\n', process.ReadToEnd());
+		if (lines.size() > 0)
 		{
-			m_version = split[3];
-		}
-	}	
+			std::string versionLine = lines[0];
+			std::vector<std::string> split = Strings::Split(' ', versionLine);
+			if (split.size() > 4)
+			{
+				m_version = Strings::Trim(split[3]);
+			}
+		}	
+
+		probe["CompilerPath"] = m_compilerPath.ToString();
+		probe["ArchiverPath"] = m_archiverPath.ToString();
+		probe["Version"] = m_version;
+		StoreProbe(probeKey, probe, { "/usr/bin/xcodebuild", m_compilerPath, m_archiverPath });
+	}
+
+	m_linkerPath = m_compilerPath;
 
 	// Find the base include and library paths for the toolchain.
 	Platform::Path baseUsrPath = m_compilerPath.GetDirectory().GetDirectory();
@@ -26,6 +26,9 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Builder/Tasks/LinkTask.h"
 #include "App/Builder/Tasks/ShellCommandTask.h"
 
+#include "App/Builder/BuilderCompileCache.h"
+#include "App/Builder/BuilderToolchainCache.h"
+
 #include "Core/Platform/Process.h"
 
 namespace MicroBuild {
@@ -36,9 +39,12 @@ Toolchain::Toolchain(ProjectFile& file, uint64_t configurationHash)
 	, m_bRequiresCompileStep(true)
 	, m_bRequiresVersionInfo(false)
 	, m_bGeneratesPchObject(true)
+	, m_bCanCacheCompiles(false)
 	, m_description("")
 	, m_projectFile(file)
 	, m_configurationHash(configurationHash)
+	, m_compileCache(nullptr)
+	, m_toolchainCache(nullptr)
 {
 	MB_UNUSED_PARAMETER(file);
 }
@@ -83,6 +89,261 @@ bool Toolchain::RequiresVersionInfo()
 	return false;
 }
 
+void Toolchain::SetCompileCache(BuilderCompileCache* cache)
+{
+	m_compileCache = cache;
+}
+
+void Toolchain::SetToolchainCache(BuilderToolchainCache* cache)
+{
+	m_toolchainCache = cache;
+}
+
+bool Toolchain::FindCachedProbe(const std::string& key, std::map<std::string, std::string>& values)
+{
+	if (m_toolchainCache == nullptr)
+	{
+		return false;
+	}
+	return m_toolchainCache->Find(key, values);
+}
+
+void Toolchain::StoreProbe(const std::string& key, const std::map<std::string, std::string>& values, const std::vector<Platform::Path>& files)
+{
+	if (m_toolchainCache != nullptr)
+	{
+		m_toolchainCache->Store(key, values, files);
+	}
+}
+
+std::string Toolchain::GetCompilerIdentity()
+{
+	return Strings::Format("%s|%s|%llu", 
+		m_description.c_str(), 
+		m_compilerPath.ToString().c_str(), 
+		m_compilerPath.GetModifiedTimeNs()
+	);
+}
+
+void Toolchain::GetCompileOutputs(const BuilderFileInfo& file, std::vector<Platform::Path>& outputs)
+{
+	outputs.push_back(file.OutputPath);
+}
+
+bool Toolchain::CreateUnityFiles(std::vector<Platform::Path>& sourceFiles)
+{
+	if (!m_projectFile.Get_UnityBuild_UseUnityBuild() || !RequiresCompileStep())
+	{
+		return true;
+	}
+
+	size_t filesPerUnit = (size_t)std::max(1, m_projectFile.Get_UnityBuild_FilesPerUnit());
+	uint64_t maxUnitSize = (uint64_t)std::max(0, m_projectFile.Get_UnityBuild_MaxUnitSize()) * 1024;
+
+	Platform::Path precompiledSourcePath = m_projectFile.Get_Build_PrecompiledSource();
+	Platform::Path precompiledHeaderPath = m_projectFile.Get_Build_PrecompiledHeader();
+	std::vector<Platform::Path> excludedFiles = m_projectFile.Get_UnityBuild_ExcludedFile();
+
+	Platform::Path unityDirectory = m_projectFile.Get_Project_IntermediateDirectory().AppendFragment("Unity", true);
+	if (!unityDirectory.Exists())
+	{
+		if (!unityDirectory.CreateAsDirectory())
+		{
+			Log(LogSeverity::Fatal, "Failed to create unity directory '%s'.\n", unityDirectory.ToString().c_str());
+			return false;
+		}
+	}
+
+	// Group files by directory and language. C and C++ files are never mixed, and 
+	// adding or removing a file only effects the units of its own directory.
+	std::map<std::string, std::vector<Platform::Path>> groups;
+	std::vector<Platform::Path> result;
+
+	for (auto& path : sourceFiles)
+	{
+		bool bCanGroup = 
+			(path.IsCFile() || path.IsCppFile()) &&
+			path != precompiledSourcePath &&
+			std::find(excludedFiles.begin(), excludedFiles.end(), path) == excludedFiles.end();
+
+		if (!bCanGroup)
+		{
+			result.push_back(path);
+			continue;
+		}
+
+		Platform::Path directory = path.GetDirectory();
+		std::string groupName = Strings::Format("Unity_%s_%08x_%s", 
+			directory.GetFilename().c_str(), 
+			Strings::Hash(directory.ToString()), 
+			path.IsCFile() ? "c" : "cpp"
+		);
+
+		groups[groupName].push_back(path);
+	}
+
+	std::vector<std::string> existingFiles = unityDirectory.GetFiles();
+	std::vector<std::string> writtenFiles;
+
+	for (auto& pair : groups)
+	{
+		const std::string& groupName = pair.first;
+		std::vector<Platform::Path>& files = pair.second;
+		std::string extension = files[0].IsCFile() ? "c" : "cpp";
+
+		std::sort(files.begin(), files.end());
+		
+		std::map<std::string, size_t> fileIndices;
+		std::vector<bool> fileAssigned(files.size(), false);
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			fileIndices[files[i].ToString()] = i;
+		}
+
+		std::vector<std::vector<size_t>> units;
+		std::vector<uint64_t> unitSizes;
+
+		// Keep files in the unit they were previously assigned to, so adding or 
+		// removing a file doesn't change the contents of every other unit.
+		std::string prefix = groupName + "_";
+		std::string suffix = "." + extension;
+
+		for (auto& existingFile : existingFiles)
+		{
+			if (existingFile.size() <= prefix.size() + suffix.size() ||
+				existingFile.compare(0, prefix.size(), prefix) != 0 ||
+				existingFile.compare(existingFile.size() - suffix.size(), suffix.size(), suffix) != 0)
+			{
+				continue;
+			}
+
+			std::string indexString = existingFile.substr(prefix.size(), existingFile.size() - prefix.size() - suffix.size());
+			if (indexString.find_first_not_of("0123456789") != std::string::npos)
+			{
+				continue;
+			}
+
+			size_t unitIndex = (size_t)CastFromString<int>(indexString);
+			if (unitIndex >= units.size())
+			{
+				units.resize(unitIndex + 1);
+				unitSizes.resize(unitIndex + 1, 0);
+			}
+
+			std::string contents;
+			if (!Strings::ReadFile(unityDirectory.AppendFragment(existingFile, true), contents))
+			{
+				continue;
+			}
+
+			std::vector<std::string> lines = Strings::Split('\n', contents);
+			for (auto& line : lines)
+			{
+				if (line.size() < 11 || line.compare(0, 10, "#include \"") != 0 || line.back() != '"')
+				{
+					continue;
+				}
+
+				auto iter = fileIndices.find(line.substr(10, line.size() - 11));
+				if (iter == fileIndices.end() || fileAssigned[iter->second] || units[unitIndex].size() >= filesPerUnit)
+				{
+					continue;
+				}
+
+				units[unitIndex].push_back(iter->second);
+				unitSizes[unitIndex] += files[iter->second].GetSize();
+				fileAssigned[iter->second] = true;
+			}
+		}
+
+		// Place any new files in the first unit with space for them.
+		for (size_t i = 0; i < files.size(); i++)
+		{
+			if (fileAssigned[i])
+			{
+				continue;
+			}
+
+			uint64_t fileSize = files[i].GetSize();
+			size_t unitIndex = 0;
+
+			for (; unitIndex < units.size(); unitIndex++)
+			{
+				if (units[unitIndex].empty())
+				{
+					break;
+				}
+				if (units[unitIndex].size() < filesPerUnit && 
+					(maxUnitSize == 0 || unitSizes[unitIndex] + fileSize <= maxUnitSize))
+				{
+					break;
+				}
+			}
+
+			if (unitIndex >= units.size())
+			{
+				units.resize(unitIndex + 1);
+				unitSizes.resize(unitIndex + 1, 0);
+			}
+
+			units[unitIndex].push_back(i);
+			unitSizes[unitIndex] += fileSize;
+		}
+
+		// Write out each unit, only touching the file if its contents have changed 
+		// so unchanged units stay up to date.
+		for (size_t unitIndex = 0; unitIndex < units.size(); unitIndex++)
+		{
+			std::vector<size_t>& unit = units[unitIndex];
+			if (unit.empty())
+			{
+				continue;
+			}
+
+			std::sort(unit.begin(), unit.end());
+
+			std::string contents = "// Unity file generated by MicroBuild, do not modify.\n";
+			// The precompiled header is built as C++, so C units can't include it.
+			if (!precompiledHeaderPath.IsEmpty() && extension == "cpp")
+			{
+				contents += Strings::Format("#include \"%s\"\n", precompiledHeaderPath.GetFilename().c_str());
+			}
+			for (size_t fileIndex : unit)
+			{
+				contents += Strings::Format("#include \"%s\"\n", files[fileIndex].ToString().c_str());
+			}
+
+			std::string unityFilename = Strings::Format("%s_%i.%s", groupName.c_str(), (int)unitIndex, extension.c_str());
+			Platform::Path unityPath = unityDirectory.AppendFragment(unityFilename, true);
+
+			std::string existingContents;
+			if (!Strings::ReadFile(unityPath, existingContents) || existingContents != contents)
+			{
+				if (!Strings::WriteFile(unityPath, contents))
+				{
+					Log(LogSeverity::Fatal, "Failed to write unity file '%s'.\n", unityPath.ToString().c_str());
+					return false;
+				}
+			}
+
+			writtenFiles.push_back(unityFilename);
+			result.push_back(unityPath);
+		}
+	}
+
+	// Remove units that are no longer used.
+	for (auto& existingFile : existingFiles)
+	{
+		if (std::find(writtenFiles.begin(), writtenFiles.end(), existingFile) == writtenFiles.end())
+		{
+			unityDirectory.AppendFragment(existingFile, true).Delete();
+		}
+	}
+
+	sourceFiles = result;
+	return true;
+}
+
 std::vector<std::shared_ptr<BuildTask>> Toolchain::GetTasks(std::vector<BuilderFileInfo>& files, uint64_t configurationHash, BuilderFileInfo& outputFile, VersionNumberInfo& versionInfo)
 {
 	std::vector<std::shared_ptr<BuildTask>> tasks;
@@ -142,6 +403,7 @@ std::vector<std::shared_ptr<BuildTask>> Toolchain::GetTasks(std::vector<BuilderF
 		versionInfoFile.SourcePath			= "";
 		versionInfoFile.OutputPath			= m_projectFile.Get_Project_IntermediateDirectory().AppendFragment(Strings::Format("%s_VersionInfo.generated.o", m_projectFile.Get_Project_Name().c_str()), true);
 		versionInfoFile.ManifestPath		= m_projectFile.Get_Project_IntermediateDirectory().AppendFragment(Strings::Format("%s_VersionInfo.generated.manifest", m_projectFile.Get_Project_Name().c_str()), true);
+		versionInfoFile.Database			= outputFile.Database;
 		versionInfoFile.Hash				= 0;
 		versionInfoFile.bOutOfDate			= BuilderFileInfo::CheckOutOfDate(versionInfoFile, Strings::Hash64(CastToString(versionInfo.TotalChangelists), configurationHash), false);
 
@@ -188,7 +450,7 @@ void Toolchain::UpdateDependencyManifest(BuilderFileInfo& fileInfo, std::vector<
 	{	
 		BuilderDependencyInfo dependency;
 		dependency.SourcePath = path;
-		dependency.Hash = BuilderFileInfo::CalculateFileHash(dependency.SourcePath, m_configurationHash);
+		dependency.Hash = BuilderFileInfo::CalculateFileHash(dependency.SourcePath, m_configurationHash, fileInfo.Database);
 
 		bool bAlreadyExists = false;
 
@@ -375,7 +637,7 @@ void Toolchain::GetCompilePchAction(BuildAction& action, BuilderFileInfo& fileIn
 		}
 		if (LogGetVerbose())
 		{
-			printf("%s", action.Output.c_str());
+			Log(LogSeverity::SilentInfo, "%s", action.Output.c_str());
 		}
 		PrintMessages(action.FileInfo);
 		if (action.FileInfo.ErrorCount > 0 || (action.FileInfo.WarningCount > 0 && m_projectFile.Get_Flags_CompilerWarningsFatal()))
@@ -403,15 +665,42 @@ void Toolchain::GetCompileAction(BuildAction& action, BuilderFileInfo& fileInfo,
 	action.WorkingDirectory = m_compilerPath.GetDirectory();
 	action.FileInfo = fileInfo;
 
-	action.PostProcessDelegate = [this, &pchFileInfo](BuildAction& action) -> bool
+	uint64_t cacheKey = 0;
+	if (m_compileCache != nullptr && m_bCanCacheCompiles)
+	{
+		cacheKey = m_compileCache->GetKey(GetCompilerIdentity(), action.Arguments);
+
+		action.PreProcessDelegate = [this, cacheKey](BuildAction& action) -> bool
+		{
+			std::vector<Platform::Path> outputs;
+			GetCompileOutputs(action.FileInfo, outputs);
+
+			if (m_compileCache->Retrieve(cacheKey, action.FileInfo, outputs, action.Output))
+			{
+				action.StatusMessage = Strings::Format("Restoring: %s\n", action.FileInfo.SourcePath.GetFilename().c_str());
+				return true;
+			}
+
+			return false;
+		};
+	}
+
+	action.PostProcessDelegate = [this, &pchFileInfo, cacheKey](BuildAction& action) -> bool
 	{
+		// Output may be modified during parsing, so keep the original for the cache.
+		std::string rawOutput;
+		if (cacheKey != 0)
+		{
+			rawOutput = action.Output;
+		}
+
 		if (!ParseOutput(action.FileInfo, action.Output))
 		{
 			return false;
 		}
 		if (LogGetVerbose())
 		{
-			printf("%s", action.Output.c_str());
+			Log(LogSeverity::SilentInfo, "%s", action.Output.c_str());
 		}
 		PrintMessages(action.FileInfo);
 		if (action.FileInfo.ErrorCount > 0 || (action.FileInfo.WarningCount > 0 && m_projectFile.Get_Flags_CompilerWarningsFatal()))
@@ -427,6 +716,14 @@ void Toolchain::GetCompileAction(BuildAction& action, BuilderFileInfo& fileInfo,
 		inheritsFromFiles.push_back(&pchFileInfo);
 		UpdateDependencyManifest(action.FileInfo, action.FileInfo.OutputDependencyPaths, inheritsFromFiles);
 
+		if (cacheKey != 0)
+		{
+			std::vector<Platform::Path> outputs;
+			GetCompileOutputs(action.FileInfo, outputs);
+
+			m_compileCache->Store(cacheKey, action.FileInfo, outputs, rawOutput);
+		}
+
 		return true;
 	};
 }
@@ -461,7 +758,7 @@ void Toolchain::GetArchiveAction(BuildAction& action, std::vector<BuilderFileInf
 		}
 		if (LogGetVerbose())
 		{
-			printf("%s", action.Output.c_str());
+			Log(LogSeverity::SilentInfo, "%s", action.Output.c_str());
 		}
 		PrintMessages(action.FileInfo);
 		if (action.FileInfo.ErrorCount > 0 || (action.FileInfo.WarningCount > 0 && m_projectFile.Get_Flags_LinkerWarningsFatal()))
@@ -480,7 +777,7 @@ void Toolchain::GetArchiveAction(BuildAction& action, std::vector<BuilderFileInf
 			{
 				BuilderDependencyInfo info;
 				info.SourcePath = sourceFile.OutputPath;
-				info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash);
+				info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash, action.FileInfo.Database);
 				action.FileInfo.Dependencies.push_back(info);
 			}
 
@@ -492,7 +789,7 @@ void Toolchain::GetArchiveAction(BuildAction& action, std::vector<BuilderFileInf
 
 				BuilderDependencyInfo info;
 				info.SourcePath = pchObjectPath;
-				info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash);
+				info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash, action.FileInfo.Database);
 				action.FileInfo.Dependencies.push_back(info);
 			}
 		}
@@ -504,7 +801,7 @@ void Toolchain::GetArchiveAction(BuildAction& action, std::vector<BuilderFileInf
 			{
 				BuilderDependencyInfo info;
 				info.SourcePath = sourceFile.SourcePath;
-				info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash);
+				info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash, action.FileInfo.Database);
 				action.FileInfo.Dependencies.push_back(info);
 			}
 		}
@@ -535,7 +832,7 @@ void Toolchain::GetLinkAction(BuildAction& action, std::vector<BuilderFileInfo>&
 		}
 		if (LogGetVerbose())
 		{
-			printf("%s", action.Output.c_str());
+			Log(LogSeverity::SilentInfo, "%s", action.Output.c_str());
 		}
 		PrintMessages(action.FileInfo);
 		if (action.FileInfo.ErrorCount > 0 || (action.FileInfo.WarningCount > 0 && m_projectFile.Get_Flags_LinkerWarningsFatal()))
@@ -568,7 +865,7 @@ void Toolchain::UpdateLinkDependencies(const std::vector<BuilderFileInfo>& files
 		{
 			BuilderDependencyInfo info;
 			info.SourcePath = fullPath;
-			info.Hash = BuilderFileInfo::CalculateFileHash(fullPath, m_configurationHash);
+			info.Hash = BuilderFileInfo::CalculateFileHash(fullPath, m_configurationHash, outputFile.Database);
 			outputFile.Dependencies.push_back(info);
 		}
 		else if (library.IsAbsolute())
@@ -584,7 +881,7 @@ void Toolchain::UpdateLinkDependencies(const std::vector<BuilderFileInfo>& files
 		{
 			BuilderDependencyInfo info;
 			info.SourcePath = sourceFile.OutputPath;
-			info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash);
+			info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash, outputFile.Database);
 			outputFile.Dependencies.push_back(info);
 		}
 
@@ -596,7 +893,7 @@ void Toolchain::UpdateLinkDependencies(const std::vector<BuilderFileInfo>& files
 
 			BuilderDependencyInfo info;
 			info.SourcePath = pchObjectPath;
-			info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash);
+			info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash, outputFile.Database);
 			outputFile.Dependencies.push_back(info);
 		}
 
@@ -608,7 +905,7 @@ void Toolchain::UpdateLinkDependencies(const std::vector<BuilderFileInfo>& files
 
 			BuilderDependencyInfo info;
 			info.SourcePath = versionInfoPath;
-			info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash);
+			info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash, outputFile.Database);
 			outputFile.Dependencies.push_back(info);
 		}
 	}
@@ -620,7 +917,7 @@ void Toolchain::UpdateLinkDependencies(const std::vector<BuilderFileInfo>& files
 		{
 			BuilderDependencyInfo info;
 			info.SourcePath = sourceFile.SourcePath;
-			info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash);
+			info.Hash = BuilderFileInfo::CalculateFileHash(info.SourcePath, m_configurationHash, outputFile.Database);
 			outputFile.Dependencies.push_back(info);
 		}	
 	}	
@@ -702,6 +999,36 @@ bool Toolchain::GetResponseFileAction(BuildAction& action, const Platform::Path&
 	return true;
 }
 
+void Toolchain::GetCompileCommand(const BuilderFileInfo& file, bool bPch, Platform::Path& tool, std::vector<std::string>& args)
+{
+	GetBaseCompileArguments(file, args);
+
+	if (bPch)
+	{
+		GetPchCompileArguments(file, args);
+	}
+	else
+	{
+		GetSourceCompileArguments(file, args);
+	}
+
+	tool = m_compilerPath;
+}
+
+void Toolchain::GetOutputCommand(const std::vector<BuilderFileInfo>& files, Platform::Path& tool, std::vector<std::string>& args)
+{
+	if (m_projectFile.Get_Project_OutputType() == EOutputType::StaticLib)
+	{
+		GetArchiveArguments(files, args);
+		tool = m_archiverPath;
+	}
+	else
+	{
+		GetLinkArguments(files, args);
+		tool = m_linkerPath;
+	}
+}
+
 Platform::Path Toolchain::GetOutputPath()
 {
 	return m_projectFile.Get_Project_OutputDirectory()
@@ -29,6 +29,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 namespace MicroBuild {
 	
 class BuildTask;
+class BuilderCompileCache;
+class BuilderToolchainCache;
 
 // Stores some general version number information that the builder embeds in the output file.
 struct VersionNumberInfo
@@ -48,6 +50,7 @@ protected:
 	bool m_bRequiresCompileStep;
 	bool m_bRequiresVersionInfo;
 	bool m_bGeneratesPchObject;
+	bool m_bCanCacheCompiles;
 	std::string m_description;
 	ProjectFile& m_projectFile;
 	
@@ -60,7 +63,18 @@ protected:
 
 	uint64_t m_configurationHash;
 
+	BuilderCompileCache* m_compileCache;
+	BuilderToolchainCache* m_toolchainCache;
+
 protected:
+
+	// Retrieves the results of a previous probe for this toolchain from the toolchain 
+	// cache. Returns false if there are none or they are out of date.
+	bool FindCachedProbe(const std::string& key, std::map<std::string, std::string>& values);
+
+	// Stores the results of probing for this toolchain in the toolchain cache, files
+	// should contain every tool that was found.
+	void StoreProbe(const std::string& key, const std::map<std::string, std::string>& values, const std::vector<Platform::Path>& files);
 	
 	// Extracts dependencies from stdout capture and updates the entries in the manifest.
 	void UpdateDependencyManifest(BuilderFileInfo& fileInfo, std::vector<Platform::Path>& dependencies, std::vector<BuilderFileInfo*> inherits);
@@ -83,6 +97,13 @@ protected:
 	// Gets arguments to send to archiver for generating an library file.
 	virtual void GetArchiveArguments(const std::vector<BuilderFileInfo>& sourceFiles, std::vector<std::string>& args);
 
+	// Gets all the files written when compiling the given file, these are what is stored
+	// in the compile cache.
+	virtual void GetCompileOutputs(const BuilderFileInfo& file, std::vector<Platform::Path>& outputs);
+
+	// Gets a string that uniquely identifies the compiler being used.
+	std::string GetCompilerIdentity();
+
 	// Updates the output files dependencies based on a linking operation.
 	virtual void UpdateLinkDependencies(const std::vector<BuilderFileInfo>& files, BuilderFileInfo& outputFile);
 
@@ -117,6 +138,19 @@ public:
 	// Returns true if we require an version info generation step.
 	bool RequiresVersionInfo();
 
+	// Sets the cache that compile outputs are restored from and stored to, or
+	// nullptr to always compile.
+	void SetCompileCache(BuilderCompileCache* cache);
+
+	// Sets the cache that the results of finding the toolchain are stored in, or 
+	// nullptr to always probe for the toolchain. Must be set before Init is called.
+	void SetToolchainCache(BuilderToolchainCache* cache);
+
+	// Combines the source files of the project into unity files if the project is
+	// configured to use them. The grouped files are replaced in the list by the unity
+	// files that include them. Returns false if the unity files could not be written.
+	bool CreateUnityFiles(std::vector<Platform::Path>& sourceFiles);
+
 	// Gets all the build tasks required to buidl the current project.
 	virtual std::vector<std::shared_ptr<BuildTask>> GetTasks(std::vector<BuilderFileInfo>& files, uint64_t configurationHash, BuilderFileInfo& outputFile, VersionNumberInfo& versionInfo);
 
@@ -139,6 +173,15 @@ public:
 	// Links all the source files provided into a sinmgle executable.
 	virtual void GetLinkAction(BuildAction& action, std::vector<BuilderFileInfo>& files, BuilderFileInfo& outputFile);
 
+	// Gets the tool and arguments used to compile the given file, or to generate the
+	// precompiled header if bPch is set. Used when generating build files for external 
+	// build tools.
+	void GetCompileCommand(const BuilderFileInfo& file, bool bPch, Platform::Path& tool, std::vector<std::string>& args);
+
+	// Gets the tool and arguments used to archive or link the given files into the
+	// project output. Used when generating build files for external build tools.
+	void GetOutputCommand(const std::vector<BuilderFileInfo>& files, Platform::Path& tool, std::vector<std::string>& args);
+
 	// Some general paths that most toolchains use, this just makes them a bit cleaner to access.
 	Platform::Path GetOutputPath();
 	Platform::Path GetPchPath();
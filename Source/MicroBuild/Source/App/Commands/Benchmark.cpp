@@ -0,0 +1,633 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "PCH.h"
+
+#include "App/App.h"
+#include "App/Commands/Benchmark.h"
+
+#include "Core/Commands/CommandLineParser.h"
+#include "Core/Commands/CommandComboArgument.h"
+#include "Core/Commands/CommandPathArgument.h"
+#include "Core/Commands/CommandStringArgument.h"
+#include "Core/Helpers/TextStream.h"
+#include "Core/Helpers/Strings.h"
+#include "Core/Platform/Process.h"
+
+#include <chrono>
+
+namespace MicroBuild {
+
+namespace {
+
+// Parses a numeric argument, logging an error if its not a valid number or
+// is smaller than the minimum.
+bool ParseCount(const std::string& value, const char* name, int minimum, int& result)
+{
+	char* end = nullptr;
+	long parsed = strtol(value.c_str(), &end, 10);
+
+	if (value.empty() || *end != '\0' || parsed < minimum || parsed > INT_MAX)
+	{
+		Log(LogSeverity::Fatal, "%s must be a number greater than or equal to %i.\n", name, minimum);
+		return false;
+	}
+
+	result = (int)parsed;
+	return true;
+}
+
+}; // namespace
+
+BenchmarkCommand::BenchmarkCommand(App* app)
+	: m_app(app)
+	, m_projects(0)
+	, m_files(0)
+	, m_headers(0)
+	, m_layers(0)
+	, m_modifyCount(0)
+{
+	SetName("benchmark");
+	SetShortName("m");
+	SetDescription("Generates a synthetic workspace and times generating, "
+				   "building and cleaning it.");
+
+	CommandPathArgument* directory = new CommandPathArgument();
+	directory->SetName("Directory");
+	directory->SetShortName("o");
+	directory->SetDescription("Directory that the synthetic workspace should "
+							  "be generated in.");
+	directory->SetExpectsDirectory(true);
+	directory->SetExpectsExisting(false);
+	directory->SetRequired(true);
+	directory->SetPositional(true);
+	directory->SetOutput(&m_directory);
+	RegisterArgument(directory);
+
+	CommandStringArgument* projects = new CommandStringArgument();
+	projects->SetName("Projects");
+	projects->SetShortName("n");
+	projects->SetDescription("Number of projects to generate, including the "
+							 "executable.");
+	projects->SetRequired(false);
+	projects->SetPositional(false);
+	projects->SetDefault("16");
+	projects->SetOutput(&m_projectCount);
+	RegisterArgument(projects);
+
+	CommandStringArgument* files = new CommandStringArgument();
+	files->SetName("Files");
+	files->SetShortName("f");
+	files->SetDescription("Number of source files to generate in each project.");
+	files->SetRequired(false);
+	files->SetPositional(false);
+	files->SetDefault("32");
+	files->SetOutput(&m_fileCount);
+	RegisterArgument(files);
+
+	CommandStringArgument* headers = new CommandStringArgument();
+	headers->SetName("Headers");
+	headers->SetShortName("i");
+	headers->SetDescription("Number of headers in each project, every source "
+							"file includes all of them.");
+	headers->SetRequired(false);
+	headers->SetPositional(false);
+	headers->SetDefault("8");
+	headers->SetOutput(&m_headerCount);
+	RegisterArgument(headers);
+
+	CommandStringArgument* depth = new CommandStringArgument();
+	depth->SetName("Depth");
+	depth->SetShortName("d");
+	depth->SetDescription("Number of layers of libraries the executable "
+						  "depends on.");
+	depth->SetRequired(false);
+	depth->SetPositional(false);
+	depth->SetDefault("4");
+	depth->SetOutput(&m_depth);
+	RegisterArgument(depth);
+
+	CommandComboArgument* builder = new CommandComboArgument();
+	builder->SetName("Builder");
+	builder->SetShortName("b");
+	builder->SetDescription("Which builder to benchmark, make uses the "
+							"generated makefiles, internal invokes the internal "
+							"build tool directly.");
+	builder->SetOptions({ "all", "make", "internal" });
+	builder->SetRequired(false);
+	builder->SetPositional(false);
+	builder->SetDefault("all");
+	builder->SetOutput(&m_builder);
+	RegisterArgument(builder);
+
+	CommandPathArgument* results = new CommandPathArgument();
+	results->SetName("Results");
+	results->SetShortName("r");
+	results->SetDescription("File the results should be written to as json, "
+							"defaults to Results.json in the workspace directory.");
+	results->SetExpectsDirectory(false);
+	results->SetExpectsExisting(false);
+	results->SetRequired(false);
+	results->SetPositional(false);
+	results->SetDefault(Platform::Path(""));
+	results->SetOutput(&m_resultsPath);
+	RegisterArgument(results);
+}
+
+std::string BenchmarkCommand::GetProjectName(int index)
+{
+	if (index == m_projects - 1)
+	{
+		return "Application";
+	}
+	return Strings::Format("Library_%03i", index);
+}
+
+bool BenchmarkCommand::GenerateWorkspace()
+{
+	if (!m_directory.Exists() && !m_directory.CreateAsDirectory())
+	{
+		Log(LogSeverity::Fatal, "Failed to create '%s'.\n", m_directory.ToString().c_str());
+		return false;
+	}
+
+	Platform::Path projectsDirectory = m_directory.AppendFragment("Projects", true);
+	if (projectsDirectory.Exists() && !projectsDirectory.Delete())
+	{
+		Log(LogSeverity::Fatal, "Failed to delete '%s'.\n", projectsDirectory.ToString().c_str());
+		return false;
+	}
+
+	// Workspace file.
+	{
+		TextStream stream;
+		stream.WriteLine("; Synthetic workspace generated by MicroBuild benchmark.");
+		stream.WriteLine("");
+		stream.WriteLine("[MicroBuild]");
+		stream.WriteLine("RequiredVersion=0.1");
+		stream.WriteLine("");
+		stream.WriteLine("[Workspace]");
+		stream.WriteLine("Name=Benchmark");
+		stream.WriteLine("Location=$(Workspace.Directory)/ProjectFiles");
+		stream.WriteLine("StartProject=%s", GetProjectName(m_projects - 1).c_str());
+		stream.WriteLine("UseInternalBuildTool=True");
+		stream.WriteLine("");
+		stream.WriteLine("[Projects]");
+		stream.WriteLine("Project=$(Workspace.Directory)/Projects/*/Project.ini");
+		stream.WriteLine("");
+		stream.WriteLine("[Configurations]");
+		stream.WriteLine("Configuration=Debug");
+		stream.WriteLine("");
+		stream.WriteLine("[Platforms]");
+		stream.WriteLine("Platform=x64");
+
+		Platform::Path path = m_directory.AppendFragment("Workspace.ini", true);
+		if (!stream.WriteToFile(path))
+		{
+			Log(LogSeverity::Fatal, "Failed to write '%s'.\n", path.ToString().c_str());
+			return false;
+		}
+	}
+
+	for (size_t layer = 0; layer < m_projectLayers.size(); layer++)
+	{
+		for (int projectIndex : m_projectLayers[layer])
+		{
+			std::string projectName = GetProjectName(projectIndex);
+			bool bExecutable = (projectIndex == m_projects - 1);
+
+			Platform::Path projectDirectory = projectsDirectory.AppendFragment(projectName, true);
+			Platform::Path includeDirectory = projectDirectory.AppendFragment("Include", true).AppendFragment(projectName, true);
+			Platform::Path sourceDirectory = projectDirectory.AppendFragment("Source", true);
+
+			if (!includeDirectory.CreateAsDirectory() ||
+				!sourceDirectory.CreateAsDirectory())
+			{
+				Log(LogSeverity::Fatal, "Failed to create directories for '%s'.\n", projectName.c_str());
+				return false;
+			}
+
+			std::vector<std::string> dependencies;
+			if (layer > 0)
+			{
+				for (int dependencyIndex : m_projectLayers[layer - 1])
+				{
+					dependencies.push_back(GetProjectName(dependencyIndex));
+				}
+			}
+
+			// Project file.
+			TextStream project;
+			project.WriteLine("; Synthetic project generated by MicroBuild benchmark.");
+			project.WriteLine("");
+			project.WriteLine("[MicroBuild]");
+			project.WriteLine("RequiredVersion=0.1");
+			project.WriteLine("");
+			project.WriteLine("[Project]");
+			project.WriteLine("Name=%s", projectName.c_str());
+			project.WriteLine("Group=Benchmark");
+			project.WriteLine("Location=$(Workspace.Directory)/ProjectFiles/$(Name)");
+			project.WriteLine("OutputDirectory=$(Workspace.Directory)/ProjectFiles/Bin/$(Name)");
+			project.WriteLine("IntermediateDirectory=$(Workspace.Directory)/ProjectFiles/Obj/$(Name)");
+			project.WriteLine("OutputType=%s", bExecutable ? "ConsoleApp" : "StaticLib");
+			project.WriteLine("OutputName=$(Name)");
+			project.WriteLine("OutputExtension=%s", bExecutable ? "$(Target.ExeExtension)" : "$(Target.StaticLibExtension)");
+			project.WriteLine("Language=Cpp");
+			project.WriteLine("RootNamespace=$(Name)");
+			project.WriteLine("");
+			project.WriteLine("[Dependencies]");
+			for (const std::string& dependency : dependencies)
+			{
+				project.WriteLine("Dependency=%s", dependency.c_str());
+			}
+			project.WriteLine("");
+			project.WriteLine("[Files]");
+			project.WriteLine("File=$(Project.Directory)/Include/**.h");
+			project.WriteLine("File=$(Project.Directory)/Source/**.cpp");
+			project.WriteLine("");
+			project.WriteLine("[Build]");
+			project.WriteLine("OptimizationLevel=Debug");
+			project.WriteLine("");
+			project.WriteLine("[SearchPaths]");
+			project.WriteLine("IncludeDirectory=$(Project.Directory)/Include/");
+
+			// Headers include each other transitively, so every library in a
+			// lower layer needs to be on the include path.
+			for (size_t lowerLayer = 0; lowerLayer < layer; lowerLayer++)
+			{
+				for (int dependencyIndex : m_projectLayers[lowerLayer])
+				{
+					project.WriteLine("IncludeDirectory=$(Workspace.Directory)/Projects/%s/Include/", GetProjectName(dependencyIndex).c_str());
+				}
+			}
+
+			Platform::Path projectPath = projectDirectory.AppendFragment("Project.ini", true);
+			if (!project.WriteToFile(projectPath))
+			{
+				Log(LogSeverity::Fatal, "Failed to write '%s'.\n", projectPath.ToString().c_str());
+				return false;
+			}
+
+			// Headers, the first header of each project pulls in the headers of
+			// its dependencies so changes propagate up through every layer.
+			for (int headerIndex = 0; headerIndex < m_headers; headerIndex++)
+			{
+				std::string headerName = Strings::Format("Header_%03i", headerIndex);
+
+				TextStream header;
+				header.WriteLine("// Generated by MicroBuild benchmark.");
+				header.WriteLine("#pragma once");
+				header.WriteLine("");
+				if (headerIndex == 0)
+				{
+					for (const std::string& dependency : dependencies)
+					{
+						header.WriteLine("#include \"%s/Header_000.h\"", dependency.c_str());
+					}
+					header.WriteLine("");
+				}
+				header.WriteLine("inline int %s_%s(int value)", projectName.c_str(), headerName.c_str());
+				header.WriteLine("{");
+				header.WriteLine("\treturn value + %i;", headerIndex);
+				header.WriteLine("}");
+
+				Platform::Path headerPath = includeDirectory.AppendFragment(headerName + ".h", true);
+				if (!header.WriteToFile(headerPath))
+				{
+					Log(LogSeverity::Fatal, "Failed to write '%s'.\n", headerPath.ToString().c_str());
+					return false;
+				}
+			}
+
+			// Source files.
+			for (int fileIndex = 0; fileIndex < m_files; fileIndex++)
+			{
+				std::string functionName = Strings::Format("%s_File_%03i", projectName.c_str(), fileIndex);
+
+				TextStream source;
+				source.WriteLine("// Generated by MicroBuild benchmark.");
+				for (int headerIndex = 0; headerIndex < m_headers; headerIndex++)
+				{
+					source.WriteLine("#include \"%s/Header_%03i.h\"", projectName.c_str(), headerIndex);
+				}
+				source.WriteLine("");
+				source.WriteLine("int %s(int value)", functionName.c_str());
+				source.WriteLine("{");
+				source.WriteLine("\tint result = value;");
+				for (int headerIndex = 0; headerIndex < m_headers; headerIndex++)
+				{
+					source.WriteLine("\tresult += %s_Header_%03i(result);", projectName.c_str(), headerIndex);
+				}
+				source.WriteLine("\treturn result;");
+				source.WriteLine("}");
+
+				Platform::Path sourcePath = sourceDirectory.AppendFragment(Strings::Format("File_%03i.cpp", fileIndex), true);
+				if (!source.WriteToFile(sourcePath))
+				{
+					Log(LogSeverity::Fatal, "Failed to write '%s'.\n", sourcePath.ToString().c_str());
+					return false;
+				}
+			}
+
+			if (bExecutable)
+			{
+				TextStream main;
+				main.WriteLine("// Generated by MicroBuild benchmark.");
+				main.WriteLine("int main(int argc, char* argv[])");
+				main.WriteLine("{");
+				main.WriteLine("\t(void)argc;");
+				main.WriteLine("\t(void)argv;");
+				main.WriteLine("\treturn 0;");
+				main.WriteLine("}");
+
+				Platform::Path mainPath = sourceDirectory.AppendFragment("Main.cpp", true);
+				if (!main.WriteToFile(mainPath))
+				{
+					Log(LogSeverity::Fatal, "Failed to write '%s'.\n", mainPath.ToString().c_str());
+					return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool BenchmarkCommand::ModifySourceFile()
+{
+	std::string projectName = GetProjectName(m_projectLayers[0][0]);
+
+	Platform::Path sourcePath = m_directory
+		.AppendFragment("Projects", true)
+		.AppendFragment(projectName, true)
+		.AppendFragment("Source", true)
+		.AppendFragment(m_files > 0 ? "File_000.cpp" : "Main.cpp", true);
+
+	std::string contents;
+	if (!Strings::ReadFile(sourcePath, contents))
+	{
+		Log(LogSeverity::Fatal, "Failed to read '%s'.\n", sourcePath.ToString().c_str());
+		return false;
+	}
+
+	// Change the contents rather than just the timestamp so the file is
+	// treated as modified even when content hashing is enabled.
+	contents += Strings::Format("// Modification %i\n", ++m_modifyCount);
+
+	if (!Strings::WriteFile(sourcePath, contents))
+	{
+		Log(LogSeverity::Fatal, "Failed to write '%s'.\n", sourcePath.ToString().c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool BenchmarkCommand::RunStage(
+	const std::string& builder,
+	const std::string& stage,
+	const Platform::Path& tool,
+	const std::vector<std::string>& arguments,
+	std::vector<StageResult>& results)
+{
+	Log(LogSeverity::Info, "[%s] %s ...\n", builder.c_str(), stage.c_str());
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	bool bSuccess = false;
+	std::string output;
+
+	Platform::Process process;
+	if (process.Open(tool, m_directory, arguments, true))
+	{
+		output = process.ReadToEnd();
+		bSuccess = (process.GetExitCode() == 0);
+	}
+
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	StageResult result;
+	result.Builder = builder;
+	result.Stage = stage;
+	result.Seconds = std::chrono::duration<double>(endTime - startTime).count();
+	result.bSuccess = bSuccess;
+	results.push_back(result);
+
+	if (!bSuccess)
+	{
+		Log(LogSeverity::Fatal, "[%s] %s failed:\n%s\n", builder.c_str(), stage.c_str(), output.c_str());
+	}
+
+	return bSuccess;
+}
+
+bool BenchmarkCommand::RunBuilder(const std::string& builder, std::vector<StageResult>& results)
+{
+	Platform::Path projectFilesDirectory = m_directory.AppendFragment("ProjectFiles", true);
+	if (projectFilesDirectory.Exists() && !projectFilesDirectory.Delete())
+	{
+		Log(LogSeverity::Fatal, "Failed to delete '%s'.\n", projectFilesDirectory.ToString().c_str());
+		return false;
+	}
+
+	Platform::Path microBuildPath = Platform::Path::GetExecutablePath();
+	std::string workspacePath = m_directory.AppendFragment("Workspace.ini", true).ToString();
+
+	if (!RunStage(builder, "Generate", microBuildPath, { "Generate", "make", workspacePath }, results))
+	{
+		return false;
+	}
+
+	Platform::Path buildTool;
+	std::vector<std::string> buildArguments;
+	std::vector<std::vector<std::string>> cleanArguments;
+
+	if (builder == "make")
+	{
+		if (!Platform::Path::FindFile("make", buildTool))
+		{
+			Log(LogSeverity::Fatal, "Unable to find make on the path.\n");
+			return false;
+		}
+
+		buildArguments = { "-C", projectFilesDirectory.ToString(), "config=Debug_x64" };
+		cleanArguments.push_back({ "-C", projectFilesDirectory.ToString(), "config=Debug_x64", "clean" });
+	}
+	else
+	{
+		buildTool = microBuildPath;
+		buildArguments = { "Build", workspacePath, GetProjectName(m_projects - 1), "-c=Debug", "-p=x64" };
+
+		for (int i = 0; i < m_projects; i++)
+		{
+			cleanArguments.push_back({ "Clean", workspacePath, GetProjectName(i), "-c=Debug", "-p=x64" });
+		}
+	}
+
+	if (!RunStage(builder, "CleanBuild", buildTool, buildArguments, results) ||
+		!RunStage(builder, "NoOpBuild", buildTool, buildArguments, results) ||
+		!ModifySourceFile() ||
+		!RunStage(builder, "IncrementalBuild", buildTool, buildArguments, results))
+	{
+		return false;
+	}
+
+	// The internal builder only cleans a single project per invocation, so
+	// the time for every invocation is summed into a single result.
+	std::vector<StageResult> cleanResults;
+	for (const std::vector<std::string>& arguments : cleanArguments)
+	{
+		if (!RunStage(builder, "Clean", buildTool, arguments, cleanResults))
+		{
+			results.push_back(cleanResults.back());
+			return false;
+		}
+	}
+
+	StageResult cleanResult = cleanResults[0];
+	for (size_t i = 1; i < cleanResults.size(); i++)
+	{
+		cleanResult.Seconds += cleanResults[i].Seconds;
+	}
+	results.push_back(cleanResult);
+
+	return true;
+}
+
+bool BenchmarkCommand::WriteResults(const std::vector<StageResult>& results)
+{
+	TextStream stream(true);
+	stream.WriteLine("{");
+	stream.Indent();
+	stream.WriteLine("\"version\": %.2f,", MB_VERSION);
+	stream.WriteLine("\"workspace\": {");
+	stream.Indent();
+	stream.WriteLine("\"projects\": %i,", m_projects);
+	stream.WriteLine("\"files\": %i,", m_files);
+	stream.WriteLine("\"headers\": %i,", m_headers);
+	stream.WriteLine("\"depth\": %i", m_layers);
+	stream.Undent();
+	stream.WriteLine("},");
+	stream.WriteLine("\"results\": [");
+	stream.Indent();
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const StageResult& result = results[i];
+		stream.WriteLine("{ \"builder\": \"%s\", \"stage\": \"%s\", \"seconds\": %.6f, \"success\": %s }%s",
+			result.Builder.c_str(),
+			result.Stage.c_str(),
+			result.Seconds,
+			result.bSuccess ? "true" : "false",
+			i + 1 < results.size() ? "," : "");
+	}
+	stream.Undent();
+	stream.WriteLine("]");
+	stream.Undent();
+	stream.WriteLine("}");
+
+	if (!stream.WriteToFile(m_resultsPath))
+	{
+		Log(LogSeverity::Fatal, "Failed to write results to '%s'.\n", m_resultsPath.ToString().c_str());
+		return false;
+	}
+
+	Log(LogSeverity::Info, "Results written to '%s'.\n", m_resultsPath.ToString().c_str());
+	return true;
+}
+
+bool BenchmarkCommand::Invoke(CommandLineParser* parser)
+{
+	MB_UNUSED_PARAMETER(parser);
+
+	int depth = 0;
+	if (!ParseCount(m_projectCount, "Projects", 1, m_projects) ||
+		!ParseCount(m_fileCount, "Files", 0, m_files) ||
+		!ParseCount(m_headerCount, "Headers", 0, m_headers) ||
+		!ParseCount(m_depth, "Depth", 1, depth))
+	{
+		return false;
+	}
+
+	if (m_resultsPath.IsEmpty())
+	{
+		m_resultsPath = m_directory.AppendFragment("Results.json", true);
+	}
+
+	// Spread the libraries evenly over each layer, the executable gets a
+	// layer of its own on top.
+	int libraryCount = m_projects - 1;
+	m_layers = std::min(depth, libraryCount);
+
+	m_projectLayers.clear();
+	m_projectLayers.resize(m_layers + 1);
+	for (int i = 0; i < libraryCount; i++)
+	{
+		m_projectLayers[(i * m_layers) / libraryCount].push_back(i);
+	}
+	m_projectLayers[m_layers].push_back(m_projects - 1);
+
+	Log(LogSeverity::Info, "Generating workspace with %i projects, %i files, %i headers and %i layers in '%s'.\n",
+		m_projects, m_files, m_headers, m_layers, m_directory.ToString().c_str());
+
+	if (!GenerateWorkspace())
+	{
+		return false;
+	}
+
+	std::vector<std::string> builders;
+	if (m_builder == "all" || m_builder == "make")
+	{
+		builders.push_back("make");
+	}
+	if (m_builder == "all" || m_builder == "internal")
+	{
+		builders.push_back("internal");
+	}
+
+	bool bSuccess = true;
+	std::vector<StageResult> results;
+
+	for (const std::string& builder : builders)
+	{
+		if (!RunBuilder(builder, results))
+		{
+			bSuccess = false;
+		}
+	}
+
+	Log(LogSeverity::Info, "\n");
+	for (const StageResult& result : results)
+	{
+		Log(LogSeverity::Info, "%-10s %-18s %10.3f s%s\n",
+			result.Builder.c_str(),
+			result.Stage.c_str(),
+			result.Seconds,
+			result.bSuccess ? "" : " (failed)");
+	}
+	Log(LogSeverity::Info, "\n");
+
+	if (!WriteResults(results))
+	{
+		return false;
+	}
+
+	return bSuccess;
+}
+
+}; // namespace MicroBuild
@@ -0,0 +1,103 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+#include "Core/Commands/Command.h"
+#include "Core/Platform/Path.h"
+
+namespace MicroBuild {
+
+class App;
+
+// Generates a large synthetic workspace and times how long each stage of 
+// working with it takes, generating, clean builds, no-op builds, incremental
+// builds and cleans. Used to measure the overhead MicroBuild itself adds to
+// a build and to catch regressions in it.
+//
+// The workspace is made out of layers of static libraries, each library
+// includes headers from the libraries in the layer below it, topped off with
+// a single executable that depends on the final layer. Every stage is run as 
+// a seperate process so that each measurement includes startup costs, the 
+// same as it would when invoked by a user or ide.
+class BenchmarkCommand : public Command
+{
+public:
+	BenchmarkCommand(App* app);
+
+protected:
+	virtual bool Invoke(CommandLineParser* parser) override;
+
+	// Result of a single timed stage.
+	struct StageResult
+	{
+		std::string Builder;
+		std::string Stage;
+		double Seconds;
+		bool bSuccess;
+	};
+
+	// Writes out the workspace, projects and source files to benchmark.
+	bool GenerateWorkspace();
+
+	// Modifies a single source file in the lowest library layer.
+	bool ModifySourceFile();
+
+	// Runs all stages for the given builder and appends their results.
+	bool RunBuilder(const std::string& builder, std::vector<StageResult>& results);
+
+	// Runs a single process and records how long it took to complete.
+	bool RunStage(
+		const std::string& builder,
+		const std::string& stage,
+		const Platform::Path& tool,
+		const std::vector<std::string>& arguments,
+		std::vector<StageResult>& results);
+
+	// Writes the results out as json.
+	bool WriteResults(const std::vector<StageResult>& results);
+
+	// Gets the name of the project at the given index.
+	std::string GetProjectName(int index);
+
+private:
+	App* m_app;
+
+	Platform::Path m_directory;
+	Platform::Path m_resultsPath;
+	std::string m_builder;
+
+	std::string m_projectCount;
+	std::string m_fileCount;
+	std::string m_headerCount;
+	std::string m_depth;
+
+	int m_projects;
+	int m_files;
+	int m_headers;
+	int m_layers;
+
+	int m_modifyCount;
+
+	// Indices of the projects in each layer, the last entry is the executable.
+	std::vector<std::vector<int>> m_projectLayers;
+
+};
+
+}; // namespace MicroBuild
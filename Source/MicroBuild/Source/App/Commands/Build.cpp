@@ -23,7 +23,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Ides/IdeHelper.h"
 #include "App/Commands/Clean.h"
 #include "App/Commands/Build.h"
+#include "App/Commands/Server.h"
 #include "Schemas/Database/DatabaseFile.h"
+#include "Schemas/Project/ProjectSnapshotCache.h"
+#include "App/Plugin/PluginManager.h"
 
 #include "App/Builder/Builder.h"
 
@@ -34,6 +37,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Commands/CommandStringArgument.h"
 #include "Core/Commands/CommandMapArgument.h"
 #include "Core/Helpers/Time.h"
+#include "Core/Platform/Platform.h"
+#include "Core/Parallel/Jobs/JobScheduler.h"
 
 namespace MicroBuild {
 
@@ -140,196 +145,347 @@ bool BuildCommand::IndirectInvoke(
 	m_platform = platform;
 	m_buildPackageFiles = bBuildPackageFiles;
 
-	return Invoke(parser);
+	MB_UNUSED_PARAMETER(parser);
+
+	return Run();
 }
 
 bool BuildCommand::Invoke(CommandLineParser* parser)
 {
 	MB_UNUSED_PARAMETER(parser);
 
+	// Hand the build over to the build server if one is running for this workspace.
+	BuildServerRequest request;
+	request.WorkspacePath = m_workspaceFilePath;
+	request.ProjectName = m_projectName;
+	request.Configuration = m_configuration;
+	request.Platform = m_platform;
+	request.SetArguments = m_setArguments;
+	request.bRebuild = m_rebuild;
+	request.bBuildDependencies = m_buildDependencies;
+	request.bVerbose = LogGetVerbose();
+	request.Environment = Platform::GetEnvironmentVariables();
+
+	bool bResult = false;
+	if (ServerCommand::ForwardRequest(request, bResult))
+	{
+		return bResult;
+	}
+
+	return Run();
+}
+
+bool BuildCommand::Run()
+{
 	Time::TimedScope timingScope;
 
-	EPlatform platformId = CastFromString<EPlatform>(m_platform);
+	BuildWorkspace workspace;
+	if (!LoadWorkspace(workspace, m_workspaceFilePath, m_configuration, m_platform, m_setArguments))
+	{
+		return false;
+	}
+
+	if (!workspace.bGenerated)
+	{
+		return true;
+	}
+
+	return BuildProject(workspace, m_projectName, m_rebuild, m_buildDependencies, m_buildPackageFiles);
+}
+
+bool BuildCommand::LoadWorkspace(
+	BuildWorkspace& workspace,
+	const Platform::Path& workspacePath,
+	const std::string& configuration,
+	const std::string& platform,
+	const std::map<std::string, std::string>& setArguments)
+{
+	Time::TimedScope scope("Load Workspace", "Build");
+
+	WorkspaceFile& workspaceFile = workspace.Workspace;
+
+	EPlatform platformId = CastFromString<EPlatform>(platform);
 
 	// Load the workspace.
 	std::vector<Platform::Path> includePaths;
-	includePaths.push_back(m_workspaceFilePath.GetDirectory());
+	includePaths.push_back(workspacePath.GetDirectory());
 
-	if (m_workspaceFile.Parse(m_workspaceFilePath, includePaths))
+	if (!workspaceFile.Parse(workspacePath, includePaths))
 	{
-		m_workspaceFile.Resolve();
-		if (!m_workspaceFile.Validate())
+		return false;
+	}
+
+	workspace.SourceFiles = workspaceFile.GetSourceFiles();
+
+	workspaceFile.Resolve();
+	if (!workspaceFile.Validate())
+	{
+		return false;
+	}
+	
+	// Fire plugin events!
+	{
+		PluginPostProcessWorkspaceFileData eventData;
+		eventData.File = &workspaceFile;
+		m_app->GetPluginManager()->OnEvent(EPluginEvent::PostProcessWorkspaceFile, &eventData);
+
+		// Reresolve in case it was changed.
+		workspaceFile.Resolve();
+		if (!workspaceFile.Validate())
 		{
 			return false;
 		}
-		
-		// Fire plugin events!
+	}
+
+	if (!workspaceFile.IsConfigurationValid(configuration, platform))
+	{
+		Log(LogSeverity::Fatal,
+			"Configuration %s|%s is not valid.\n",
+			configuration.c_str(),
+			platform.c_str());
+
+		return false;
+	}
+
+	// Database file to do all file manipulation through.
+	Platform::Path databaseFileLocation =
+		workspaceFile.Get_Workspace_Location()
+		.AppendFragment("workspace.mb", true);
+
+	workspace.SourceFiles.push_back(databaseFileLocation);
+
+	// If database doesn't exist there is nothing to build.
+	if (!databaseFileLocation.Exists())
+	{
+		Log(LogSeverity::Info,
+			"Workspace database does not exist, nothing to clean.\n",
+			databaseFileLocation.ToString().c_str());
+
+		workspace.bGenerated = false;
+		return true;
+	}
+
+	DatabaseFile databaseFile(databaseFileLocation, "");
+
+	if (!databaseFile.Read())
+	{
+		Log(LogSeverity::Fatal,
+			"Failed to read workspace database '%s'.\n",
+			databaseFileLocation.ToString().c_str());
+
+		return false;
+	}
+
+	// Base configuration.
+	workspaceFile.Set_Target_IDE(databaseFile.Get_Target_IDE());
+	workspaceFile.Set_Target_Configuration(configuration);
+	workspaceFile.Set_Target_Platform(platformId);
+	workspaceFile.Set_Target_PlatformName(IdeHelper::ResolvePlatformName(platformId));
+
+	for (auto& pair : setArguments)
+	{
+		workspaceFile.SetOrAddValue("", pair.first, pair.second, true);
+	}
+
+	workspaceFile.Resolve();
+
+	if (!workspaceFile.Validate())
+	{
+		return false;
+	}
+
+	if (!workspaceFile.IsConfigurationValid(configuration, platform))
+	{
+		Log(LogSeverity::Fatal,
+			"Configuration %s|%s is not valid.\n",
+			configuration.c_str(),
+			platform.c_str());
+
+		return false;
+	}
+
+	// Reuse file expansions from previous runs where their directories are unchanged.
+	BaseConfigFile::OpenExpandedPathCache(
+		workspaceFile.Get_Workspace_Location().AppendFragment("paths.cache", true));
+
+	// Projects resolved by previous runs are restored rather than parsed 
+	// again if nothing they were resolved from has changed.
+	std::string snapshotContext = Strings::Format("build|%s|%s|%s|%s@%llu|%s",
+		configuration.c_str(),
+		platform.c_str(),
+		databaseFile.Get_Target_IDE().c_str(),
+		Platform::Path::GetExecutablePath().ToString().c_str(),
+		(unsigned long long)Platform::Path::GetExecutablePath().GetModifiedTimeNs(),
+		m_app->GetPluginManager()->GetIdentity().c_str());
+
+	for (auto& pair : setArguments)
+	{
+		snapshotContext += Strings::Format("|%s=%s", pair.first.c_str(), pair.second.c_str());
+	}
+
+	ProjectSnapshotCache snapshotCache;
+	snapshotCache.Open(
+		workspaceFile.Get_Workspace_Location().AppendFragment("Snapshots", true),
+		snapshotContext);
+
+	std::vector<Platform::Path> workspaceSourceFiles = workspace.SourceFiles;
+
+	// Load all projects.
+	std::vector<Platform::Path> projectPaths =
+		workspaceFile.Get_Projects_Project();
+
+	std::vector<ProjectFile>& projectFiles = workspace.Projects;
+	projectFiles.resize(projectPaths.size());
+
+	std::vector<std::vector<Platform::Path>> projectSourceFiles;
+	projectSourceFiles.resize(projectPaths.size());
+
+	std::vector<char> projectParsed;
+	projectParsed.resize(projectPaths.size(), false);
+
+	std::vector<char> projectRestored;
+	projectRestored.resize(projectPaths.size(), false);
+
+	// Projects are independent of each other so parse and resolve them all
+	// in parallel.
+	std::atomic<bool> bFailed(false);
+
+	JobScheduler scheduler(Platform::GetConcurrencyFactor());
+	scheduler.ParallelFor((int)projectPaths.size(), [&](int i) {
+
+		if (snapshotCache.Load(projectPaths[i], projectFiles[i]))
 		{
-			PluginPostProcessWorkspaceFileData eventData;
-			eventData.File = &m_workspaceFile;
-			m_app->GetPluginManager()->OnEvent(EPluginEvent::PostProcessWorkspaceFile, &eventData);
+			projectParsed[i] = true;
+			projectRestored[i] = true;
+			projectSourceFiles[i] = projectFiles[i].GetSourceFiles();
+			return;
+		}
+
+		std::vector<Platform::Path> subIncludePaths;
+		subIncludePaths.push_back(projectPaths[i].GetDirectory());
+		subIncludePaths.insert(
+			subIncludePaths.end(),
+			includePaths.begin(), includePaths.end()
+		);
+
+		if (projectFiles[i].Parse(projectPaths[i], subIncludePaths))
+		{
+			projectParsed[i] = true;
+			projectSourceFiles[i] = projectFiles[i].GetSourceFiles();
+
+			projectFiles[i].Merge(workspaceFile);
+			projectFiles[i].Set_Target_Configuration(configuration);
+			projectFiles[i].Set_Target_Platform(platformId);
+			projectFiles[i].Set_Target_PlatformName(IdeHelper::ResolvePlatformName(platformId));
+			projectFiles[i].Set_Target_MicroBuildExecutable(Platform::Path::GetExecutablePath());
+			projectFiles[i].Set_Target_MicroBuildDirectory(Platform::Path::GetExecutablePath().GetDirectory());
+			projectFiles[i].Set_Target_IDE(databaseFile.Get_Target_IDE());
 
-			// Reresolve in case it was changed.
-			m_workspaceFile.Resolve();
-			if (!m_workspaceFile.Validate())
+			projectFiles[i].Resolve();
+
+			if (!projectFiles[i].Validate())
 			{
-				return false;
+				bFailed = true;
 			}
 		}
-	
-		if (!m_workspaceFile.IsConfigurationValid(m_configuration, m_platform))
-		{
-			Log(LogSeverity::Fatal,
-				"Configuration %s|%s is not valid.\n",
-				m_configuration.c_str(),
-				m_platform.c_str());
+	});
 
-			return false;
-		}
+	BaseConfigFile::SaveExpandedPathCache();
 
-		// Database file to do all file manipulation through.
-		Platform::Path databaseFileLocation =
-			m_workspaceFile.Get_Workspace_Location()
-			.AppendFragment("workspace.mb", true);
+	if (bFailed)
+	{
+		return false;
+	}
 
-		// If database already exists then build the workspace.
-		if (databaseFileLocation.Exists())
+	for (auto& sourceFiles : projectSourceFiles)
+	{
+		workspace.SourceFiles.insert(workspace.SourceFiles.end(), sourceFiles.begin(), sourceFiles.end());
+	}
+
+	// Fire plugin events! Plugins aren't expected to be thread safe, so these
+	// are always done in order. Restored projects already have their changes.
+	for (unsigned int i = 0; i < projectFiles.size(); i++)
+	{
+		if (!projectParsed[i] || projectRestored[i])
 		{
-			DatabaseFile databaseFile(databaseFileLocation, "");
+			continue;
+		}
 
-			if (databaseFile.Read())
-			{
-				// Base configuration.
-				m_workspaceFile.Set_Target_IDE(databaseFile.Get_Target_IDE());
-				m_workspaceFile.Set_Target_Configuration(m_configuration);
-				m_workspaceFile.Set_Target_Platform(platformId);
-				m_workspaceFile.Set_Target_PlatformName(IdeHelper::ResolvePlatformName(platformId));
-
-				for (auto& pair : m_setArguments)
-				{
-					m_workspaceFile.SetOrAddValue("", pair.first, pair.second, true);
-				}
-
-				m_workspaceFile.Resolve();
-
-				if (!m_workspaceFile.Validate())
-				{
-					return false;
-				}
-
-				if (!m_workspaceFile.IsConfigurationValid(m_configuration, m_platform))
-				{
-					Log(LogSeverity::Fatal,
-						"Configuration %s|%s is not valid.\n",
-						m_configuration.c_str(),
-						m_platform.c_str());
-
-					return false;
-				}
-
-				// Load all projects.
-				std::vector<Platform::Path> projectPaths =
-					m_workspaceFile.Get_Projects_Project();
-
-				std::vector<ProjectFile> projectFiles;
-				projectFiles.resize(projectPaths.size());
-
-				ProjectFile* buildProjectFile = nullptr;
-
-				for (unsigned int i = 0; i < projectPaths.size(); i++)
-				{
-					std::vector<Platform::Path> subIncludePaths;
-					subIncludePaths.push_back(projectPaths[i].GetDirectory());
-					subIncludePaths.insert(
-						subIncludePaths.end(),
-						includePaths.begin(), includePaths.end()
-					);
-
-					if (projectFiles[i].Parse(projectPaths[i], subIncludePaths))
-					{
-						projectFiles[i].Merge(m_workspaceFile);
-						projectFiles[i].Set_Target_Configuration(m_configuration);
-						projectFiles[i].Set_Target_Platform(platformId);
-						projectFiles[i].Set_Target_PlatformName(IdeHelper::ResolvePlatformName(platformId));
-						projectFiles[i].Set_Target_MicroBuildExecutable(Platform::Path::GetExecutablePath());
-						projectFiles[i].Set_Target_MicroBuildDirectory(Platform::Path::GetExecutablePath().GetDirectory());
-						projectFiles[i].Set_Target_IDE(databaseFile.Get_Target_IDE());
-
-						projectFiles[i].Resolve();
-
-						if (!projectFiles[i].Validate())
-						{
-							return false;
-						}
-					
-						// Fire plugin events!
-						{
-							PluginPostProcessProjectFileData eventData;
-							eventData.File = &projectFiles[i];
-							m_app->GetPluginManager()->OnEvent(EPluginEvent::PostProcessProjectFile, &eventData);
-
-							// Reresolve in case it was changed.
-							projectFiles[i].Resolve();
-							if (!projectFiles[i].Validate())
-							{
-								return false;
-							}
-						}
-
-						if (projectFiles[i].Get_Project_Name() == m_projectName)
-						{
-							buildProjectFile = &projectFiles[i];
-						}
-					}
-				}
-
-				if (buildProjectFile != nullptr)
-				{					
-					std::vector<ProjectFile*> configProjectFiles;	
-					for (unsigned int i = 0; i < projectFiles.size(); i++)
-					{
-						configProjectFiles.push_back(&projectFiles[i]);
-					}
-
-					if (!IdeHelper::UpdateAutoLinkDependencies(m_workspaceFile, configProjectFiles))
-					{
-						return false;
-					}
-
-					Builder builder(m_app);
-					if (builder.Build(m_workspaceFile, configProjectFiles, *buildProjectFile, m_rebuild, m_buildDependencies, m_buildPackageFiles))
-					{
-						return true;
-					}
-				}
-				else
-				{
-					Log(LogSeverity::Fatal,
-						"Failed to find project '%s' in workspace.",
-						m_projectName.c_str());
-					return false;
-				}
-			}
-			else
-			{
-				Log(LogSeverity::Fatal,
-					"Failed to read workspace database '%s'.\n",
-					databaseFileLocation.ToString().c_str());
+		PluginPostProcessProjectFileData eventData;
+		eventData.File = &projectFiles[i];
+		m_app->GetPluginManager()->OnEvent(EPluginEvent::PostProcessProjectFile, &eventData);
+	}
 
-				return false;
-			}
+	// Reresolve in case they were changed, then snapshot the result.
+	scheduler.ParallelFor((int)projectFiles.size(), [&](int i) {
+		if (!projectParsed[i] || projectRestored[i])
+		{
+			return;
 		}
-		else
+
+		projectFiles[i].Resolve();
+		if (!projectFiles[i].Validate())
 		{
-			Log(LogSeverity::Info,
-				"Workspace database does not exist, nothing to clean.\n",
-				databaseFileLocation.ToString().c_str());
+			bFailed = true;
+			return;
+		}
+
+		std::vector<Platform::Path> sourceFiles = projectSourceFiles[i];
+		sourceFiles.insert(sourceFiles.end(), workspaceSourceFiles.begin(), workspaceSourceFiles.end());
+
+		snapshotCache.Store(projectPaths[i], projectFiles[i], sourceFiles);
+	});
+
+	if (bFailed)
+	{
+		return false;
+	}
+
+	std::vector<ProjectFile*> configProjectFiles;	
+	for (unsigned int i = 0; i < projectFiles.size(); i++)
+	{
+		configProjectFiles.push_back(&projectFiles[i]);
+	}
+
+	if (!IdeHelper::UpdateAutoLinkDependencies(workspaceFile, configProjectFiles))
+	{
+		return false;
+	}
+
+	workspace.bGenerated = true;
+	return true;
+}
 
-			return true;
+bool BuildCommand::BuildProject(
+	BuildWorkspace& workspace,
+	const std::string& projectName,
+	bool bRebuild,
+	bool bBuildDependencies,
+	bool bBuildPackageFiles)
+{
+	ProjectFile* buildProjectFile = nullptr;
+
+	std::vector<ProjectFile*> configProjectFiles;	
+	for (unsigned int i = 0; i < workspace.Projects.size(); i++)
+	{
+		configProjectFiles.push_back(&workspace.Projects[i]);
+
+		if (workspace.Projects[i].Get_Project_Name() == projectName)
+		{
+			buildProjectFile = &workspace.Projects[i];
 		}
 	}
 
-	return false;
+	if (buildProjectFile == nullptr)
+	{
+		Log(LogSeverity::Fatal,
+			"Failed to find project '%s' in workspace.",
+			projectName.c_str());
+		return false;
+	}
+
+	Builder builder(m_app);
+	return builder.Build(workspace.Workspace, configProjectFiles, *buildProjectFile, bRebuild, bBuildDependencies, bBuildPackageFiles);
 }
 
-}; // namespace MicroBuild
\ No newline at end of file
+}; // namespace MicroBuild
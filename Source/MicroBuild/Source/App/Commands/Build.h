@@ -21,17 +21,55 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Core/Commands/Command.h"
 #include "Core/Platform/Path.h"
 #include "Schemas/Workspace/WorkspaceFile.h"
+#include "Schemas/Project/ProjectFile.h"
 
 namespace MicroBuild {
 
 class App;
 
+// Workspace and project files parsed and resolved for a single configuration
+// and platform, everything a build needs before it can start.
+struct BuildWorkspace
+{
+	WorkspaceFile Workspace;
+	std::vector<ProjectFile> Projects;
+
+	// Every file that was read when loading the workspace, if any of these
+	// change the workspace needs to be loaded again.
+	std::vector<Platform::Path> SourceFiles;
+
+	// False if the workspace has not been generated yet, so there is nothing
+	// that can be built.
+	bool bGenerated;
+
+	BuildWorkspace()
+		: bGenerated(false)
+	{
+	}
+};
+
 // Invokes the internal build tool to build the given project in a workspace.
 class BuildCommand : public Command
 {
 public:
 	BuildCommand(App* app);
 
+	// Parses and resolves the workspace and all its projects for the given 
+	// configuration and platform.
+	bool LoadWorkspace(
+		BuildWorkspace& workspace,
+		const Platform::Path& workspacePath,
+		const std::string& configuration,
+		const std::string& platform,
+		const std::map<std::string, std::string>& setArguments);
+
+	// Builds the project with the given name in a previously loaded workspace.
+	bool BuildProject(
+		BuildWorkspace& workspace,
+		const std::string& projectName,
+		bool bRebuild,
+		bool bBuildDependencies,
+		bool bBuildPackageFiles);
 
 	// Indirectly invokes this command with the given parameters.
 	bool IndirectInvoke(
@@ -47,10 +85,12 @@ public:
 protected:
 	virtual bool Invoke(CommandLineParser* parser) override;
 
+	// Loads the workspace and builds the project using the current arguments.
+	bool Run();
+
 private:
 	App* m_app;
 
-	WorkspaceFile m_workspaceFile;
 	Platform::Path m_workspaceFilePath;
 
 	std::string m_projectName;
@@ -22,12 +22,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Ides/IdeType.h"
 #include "App/Commands/Generate.h"
 #include "Schemas/Database/DatabaseFile.h"
+#include "Schemas/Project/ProjectSnapshotCache.h"
+#include "App/Plugin/PluginManager.h"
 
 #include "Core/Commands/CommandLineParser.h"
 #include "Core/Commands/CommandComboArgument.h"
 #include "Core/Commands/CommandPathArgument.h"
 #include "Core/Commands/CommandFlagArgument.h"
 #include "Core/Helpers/Time.h"
+#include "Core/Parallel/Jobs/JobScheduler.h"
 
 namespace MicroBuild {
 
@@ -130,14 +133,41 @@ bool GenerateCommand::Invoke(CommandLineParser* parser)
 			}
 		}
 
+		// Reuse file expansions from previous runs where their directories are unchanged.
+		BaseConfigFile::OpenExpandedPathCache(
+			m_workspaceFile.Get_Workspace_Location().AppendFragment("paths.cache", true));
+
+		// Projects resolved by previous runs are restored rather than parsed
+		// again if nothing they were resolved from has changed.
+		ProjectSnapshotCache snapshotCache;
+		snapshotCache.Open(
+			m_workspaceFile.Get_Workspace_Location().AppendFragment("Snapshots", true),
+			Strings::Format("generate|%s|%s@%llu|%s",
+				m_targetIde.c_str(),
+				Platform::Path::GetExecutablePath().ToString().c_str(),
+				(unsigned long long)Platform::Path::GetExecutablePath().GetModifiedTimeNs(),
+				m_app->GetPluginManager()->GetIdentity().c_str()));
+
+		std::vector<Platform::Path> workspaceSourceFiles = m_workspaceFile.GetSourceFiles();
+
 		// Load all projects.
 		std::vector<Platform::Path> projectPaths =
 			m_workspaceFile.Get_Projects_Project();
 
 		m_projectFiles.resize(projectPaths.size());
 
-		for (unsigned int i = 0; i < projectPaths.size(); i++)
-		{
+		// Projects are independent of each other so parse and resolve them 
+		// all in parallel.
+		std::atomic<bool> bFailed(false);
+
+		JobScheduler scheduler(Platform::GetConcurrencyFactor());
+		scheduler.ParallelFor((int)projectPaths.size(), [&](int i) {
+
+			if (snapshotCache.Load(projectPaths[i], m_projectFiles[i]))
+			{
+				return;
+			}
+
 			std::vector<Platform::Path> subIncludePaths;
 			subIncludePaths.push_back(projectPaths[i].GetDirectory());
 			subIncludePaths.insert(
@@ -145,32 +175,46 @@ bool GenerateCommand::Invoke(CommandLineParser* parser)
 				includePaths.begin(), includePaths.end()
 			);
 
-			if (m_projectFiles[i].Parse(projectPaths[i], subIncludePaths))
+			if (!m_projectFiles[i].Parse(projectPaths[i], subIncludePaths))
 			{
-				m_projectFiles[i].Merge(m_workspaceFile);
+				bFailed = true;
+				return;
+			}
 
-				// Base configuration.
-				m_projectFiles[i].Set_Target_IDE(m_targetIde);
-				m_projectFiles[i].Set_Target_MicroBuildExecutable(Platform::Path::GetExecutablePath());
-				m_projectFiles[i].Set_Target_MicroBuildDirectory(Platform::Path::GetExecutablePath().GetDirectory());
+			m_projectFiles[i].Merge(m_workspaceFile);
 
-				m_projectFiles[i].Resolve();
-				if (!m_projectFiles[i].Validate())
-				{
-					return false;
-				}
+			// Base configuration.
+			m_projectFiles[i].Set_Target_IDE(m_targetIde);
+			m_projectFiles[i].Set_Target_MicroBuildExecutable(Platform::Path::GetExecutablePath());
+			m_projectFiles[i].Set_Target_MicroBuildDirectory(Platform::Path::GetExecutablePath().GetDirectory());
 
-				// Fire plugin events!
-				{
-					PluginPostProcessProjectFileData eventData;
-					eventData.File = &m_projectFiles[i];
-					m_app->GetPluginManager()->OnEvent(EPluginEvent::PostProcessProjectFile, &eventData);
-				}
-			}
-			else
+			m_projectFiles[i].Resolve();
+			if (!m_projectFiles[i].Validate())
 			{
-				return false;
+				bFailed = true;
+				return;
 			}
+
+			std::vector<Platform::Path> sourceFiles = m_projectFiles[i].GetSourceFiles();
+			sourceFiles.insert(sourceFiles.end(), workspaceSourceFiles.begin(), workspaceSourceFiles.end());
+
+			snapshotCache.Store(projectPaths[i], m_projectFiles[i], sourceFiles);
+		});
+
+		BaseConfigFile::SaveExpandedPathCache();
+
+		if (bFailed)
+		{
+			return false;
+		}
+
+		// Fire plugin events! Plugins aren't expected to be thread safe, so
+		// these are always done in order.
+		for (unsigned int i = 0; i < m_projectFiles.size(); i++)
+		{
+			PluginPostProcessProjectFileData eventData;
+			eventData.File = &m_projectFiles[i];
+			m_app->GetPluginManager()->OnEvent(EPluginEvent::PostProcessProjectFile, &eventData);
 		}
 
 		// Find and generate project files for our chosen ide.
@@ -0,0 +1,567 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+
+#include "App/App.h"
+#include "App/Commands/Build.h"
+#include "App/Commands/Server.h"
+
+#include "App/Builder/BuilderFileInfo.h"
+
+#include "Core/Commands/CommandLineParser.h"
+#include "Core/Commands/CommandPathArgument.h"
+#include "Core/Commands/CommandFlagArgument.h"
+#include "Core/Helpers/Strings.h"
+#include "Core/Platform/Platform.h"
+
+namespace MicroBuild {
+
+BuildServerRequest::BuildServerRequest()
+	: bRebuild(false)
+	, bBuildDependencies(true)
+	, bVerbose(false)
+	, bStop(false)
+{
+}
+
+std::string BuildServerRequest::Serialize() const
+{
+	std::string result;
+	result += "Workspace=" + WorkspacePath.ToString() + "\n";
+	result += "Project=" + ProjectName + "\n";
+	result += "Configuration=" + Configuration + "\n";
+	result += "Platform=" + Platform + "\n";
+	result += Strings::Format("Rebuild=%i\n", bRebuild ? 1 : 0);
+	result += Strings::Format("BuildDependencies=%i\n", bBuildDependencies ? 1 : 0);
+	result += Strings::Format("Verbose=%i\n", bVerbose ? 1 : 0);
+	result += Strings::Format("Stop=%i\n", bStop ? 1 : 0);
+
+	for (auto& pair : SetArguments)
+	{
+		result += "Define=" + pair.first + "=" + pair.second + "\n";
+	}
+
+	for (auto& pair : Environment)
+	{
+		if (pair.second.find_first_of("\r\n") == std::string::npos)
+		{
+			result += "Environment=" + pair.first + "=" + pair.second + "\n";
+		}
+	}
+
+	return result;
+}
+
+bool BuildServerRequest::Deserialize(const std::string& data)
+{
+	std::vector<std::string> lines = Strings::Split('\n', data, false, true);
+	for (auto& line : lines)
+	{
+		size_t splitIndex = line.find('=');
+		if (splitIndex == std::string::npos)
+		{
+			return false;
+		}
+
+		std::string key = line.substr(0, splitIndex);
+		std::string value = line.substr(splitIndex + 1);
+
+		if (key == "Workspace")
+		{
+			WorkspacePath = value;
+		}
+		else if (key == "Project")
+		{
+			ProjectName = value;
+		}
+		else if (key == "Configuration")
+		{
+			Configuration = value;
+		}
+		else if (key == "Platform")
+		{
+			Platform = value;
+		}
+		else if (key == "Rebuild")
+		{
+			bRebuild = (value == "1");
+		}
+		else if (key == "BuildDependencies")
+		{
+			bBuildDependencies = (value == "1");
+		}
+		else if (key == "Verbose")
+		{
+			bVerbose = (value == "1");
+		}
+		else if (key == "Stop")
+		{
+			bStop = (value == "1");
+		}
+		else if (key == "Define")
+		{
+			size_t defineSplitIndex = value.find('=');
+			if (defineSplitIndex == std::string::npos)
+			{
+				return false;
+			}
+
+			SetArguments[value.substr(0, defineSplitIndex)] = value.substr(defineSplitIndex + 1);
+		}
+		else if (key == "Environment")
+		{
+			size_t environmentSplitIndex = value.find('=');
+			if (environmentSplitIndex == std::string::npos)
+			{
+				return false;
+			}
+
+			Environment[value.substr(0, environmentSplitIndex)] = value.substr(environmentSplitIndex + 1);
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+ServerCommand::ServerCommand(App* app)
+	: m_app(app)
+	, m_stop(false)
+{
+	SetName("server");
+	SetShortName("s");
+	SetDescription("Runs a resident build server for the given workspace. While "
+				   "it is running build commands for the workspace are performed "
+				   "by the server, which keeps workspace, project and file state "
+				   "in memory between builds.");
+
+	CommandPathArgument* workspaceFile = new CommandPathArgument();
+	workspaceFile->SetName("WorkspaceFile");
+	workspaceFile->SetShortName("w");
+	workspaceFile->SetDescription("The workspace file that the server should "
+								  "build projects for.");
+	workspaceFile->SetExpectsDirectory(false);
+	workspaceFile->SetExpectsExisting(true);
+	workspaceFile->SetRequired(true);
+	workspaceFile->SetPositional(true);
+	workspaceFile->SetOutput(&m_workspaceFilePath);
+	RegisterArgument(workspaceFile);
+
+	CommandFlagArgument* stop = new CommandFlagArgument();
+	stop->SetName("Stop");
+	stop->SetShortName("x");
+	stop->SetDescription("Stops the server currently running for the workspace.");
+	stop->SetRequired(false);
+	stop->SetPositional(false);
+	stop->SetDefault(false);
+	stop->SetOutput(&m_stop);
+	RegisterArgument(stop);
+}
+
+ServerCommand::~ServerCommand()
+{
+}
+
+std::string ServerCommand::GetEndpointName(const Platform::Path& workspacePath)
+{
+	return Strings::Format("%016llx", Strings::Hash64(workspacePath.ToString()));
+}
+
+bool ServerCommand::ForwardRequest(const BuildServerRequest& request, bool& bResult)
+{
+	Platform::LocalSocket socket;
+	if (!socket.Connect(GetEndpointName(request.WorkspacePath)))
+	{
+		return false;
+	}
+
+	if (!socket.Send(request.Serialize()))
+	{
+		return false;
+	}
+
+	// Print output as the server sends it, until we get the final result.
+	std::string message;
+	while (socket.Receive(message))
+	{
+		if (message.empty())
+		{
+			continue;
+		}
+
+		if (message[0] == 'L')
+		{
+			printf("%s", message.c_str() + 1);
+			fflush(stdout);
+		}
+		else if (message[0] == 'R')
+		{
+			bResult = (message == "R1");
+			return true;
+		}
+		else if (message[0] == 'D')
+		{
+			Log(LogSeverity::Verbose, "Build server declined request: %s\n", message.c_str() + 1);
+			return false;
+		}
+	}
+
+	Log(LogSeverity::Fatal, "Lost connection to build server.\n");
+
+	bResult = false;
+	return true;
+}
+
+bool ServerCommand::Invoke(CommandLineParser* parser)
+{
+	MB_UNUSED_PARAMETER(parser);
+
+	if (m_stop)
+	{
+		BuildServerRequest request;
+		request.WorkspacePath = m_workspaceFilePath;
+		request.bStop = true;
+
+		bool bResult = false;
+		if (!ForwardRequest(request, bResult))
+		{
+			Log(LogSeverity::Info, "No build server is running for '%s'.\n", m_workspaceFilePath.ToString().c_str());
+			return true;
+		}
+
+		Log(LogSeverity::Info, "Stopped build server for '%s'.\n", m_workspaceFilePath.ToString().c_str());
+		return bResult;
+	}
+
+	if (!m_watcher.Init())
+	{
+		Log(LogSeverity::Fatal, "File watching is not supported on this platform, build server cannot be run.\n");
+		return false;
+	}
+
+	Platform::LocalSocket listener;
+	if (!listener.Listen(GetEndpointName(m_workspaceFilePath)))
+	{
+		Log(LogSeverity::Fatal, "Failed to start build server for '%s', is one already running?\n", m_workspaceFilePath.ToString().c_str());
+		return false;
+	}
+
+	Log(LogSeverity::Info, "Build server running for '%s'.\n", m_workspaceFilePath.ToString().c_str());
+
+	while (true)
+	{
+		ProcessChanges(0);
+
+		Platform::LocalSocket client;
+		if (!listener.Accept(client, 100))
+		{
+			continue;
+		}
+
+		std::string data;
+		BuildServerRequest request;
+
+		if (!client.Receive(data) || 
+			!request.Deserialize(data) ||
+			request.WorkspacePath != m_workspaceFilePath)
+		{
+			Log(LogSeverity::Warning, "Ignored malformed request from client.\n");
+			continue;
+		}
+
+		if (request.bStop)
+		{
+			client.Send("R1");
+			break;
+		}
+
+		// Make sure we have seen every change made before the request was sent.
+		ProcessChanges(0);
+
+		ProcessRequest(client, request);
+	}
+
+	Log(LogSeverity::Info, "Build server stopped.\n");
+	return true;
+}
+
+bool ServerCommand::ProcessRequest(Platform::LocalSocket& client, const BuildServerRequest& request)
+{
+	Log(LogSeverity::Info, "Building '%s' (%s|%s).\n", request.ProjectName.c_str(), request.Configuration.c_str(), request.Platform.c_str());
+
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Route all output produced by the build back to the client.
+	std::mutex sendMutex;
+	LogSetSink([&client, &sendMutex](LogSeverity severity, const std::string& message) {
+		MB_UNUSED_PARAMETER(severity);
+		std::lock_guard<std::mutex> lock(sendMutex);
+		client.Send("L" + message);
+	});
+
+	bool bPreviousVerbose = LogGetVerbose();
+	LogSetVerbose(request.bVerbose);
+
+	std::string key = request.Configuration + "|" + request.Platform;
+	for (auto& pair : request.SetArguments)
+	{
+		key += "|" + pair.first + "=" + pair.second;
+	}
+
+	BuildCommand command(m_app);
+	bool bResult = true;
+
+	std::unique_ptr<BuildWorkspace>& workspace = m_workspaces[key];
+	if (workspace == nullptr)
+	{
+		workspace.reset(new BuildWorkspace());
+
+		if (!command.LoadWorkspace(*workspace, m_workspaceFilePath, request.Configuration, request.Platform, request.SetArguments))
+		{
+			bResult = false;
+		}
+	}
+	else
+	{
+		Log(LogSeverity::Verbose, "Using resident workspace state.\n");
+	}
+
+	// The workspace is kept, it is still valid for clients with our environment.
+	std::string mismatch;
+	if (bResult && !IsEnvironmentCompatible(*workspace, request, mismatch))
+	{
+		LogSetVerbose(bPreviousVerbose);
+		LogSetSink(nullptr);
+
+		WatchDependencies(*workspace);
+
+		Log(LogSeverity::Info, "Declined, client environment differs in %s.\n", mismatch.c_str());
+
+		client.Send("D" + mismatch);
+		return false;
+	}
+
+	if (bResult && workspace->bGenerated)
+	{
+		bResult = command.BuildProject(*workspace, request.ProjectName, request.bRebuild, request.bBuildDependencies, false);
+	}
+
+	LogSetVerbose(bPreviousVerbose);
+	LogSetSink(nullptr);
+
+	// Outputs were written by the build, so their cached state is no longer 
+	// valid. Sources are kept, they are invalidated as they change.
+	BuilderFileInfo::ClearCache(false);
+
+	if (bResult)
+	{
+		WatchDependencies(*workspace);
+	}
+	else
+	{
+		m_workspaces.erase(key);
+	}
+
+	auto elapsedTime = std::chrono::high_resolution_clock::now() - startTime;
+	auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime).count();
+
+	Log(bResult ? LogSeverity::Info : LogSeverity::Warning, "%s in %.1f seconds.\n", bResult ? "Completed" : "Failed", elapsedMs / 1000.0f);
+
+	client.Send(bResult ? "R1" : "R0");
+	return bResult;
+}
+
+bool ServerCommand::IsEnvironmentCompatible(const BuildWorkspace& workspace, const BuildServerRequest& request, std::string& mismatch)
+{
+	std::set<std::string> names = workspace.Workspace.GetEnvironmentLookups();
+	names.insert("PATH");
+
+	for (auto& project : workspace.Projects)
+	{
+		const std::set<std::string>& projectNames = project.GetEnvironmentLookups();
+		names.insert(projectNames.begin(), projectNames.end());
+	}
+
+	for (auto& name : names)
+	{
+		auto iter = request.Environment.find(name);
+		std::string clientValue = (iter == request.Environment.end() ? "" : iter->second);
+
+		if (clientValue != Platform::GetEnvironmentVariable(name))
+		{
+			mismatch = name;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ServerCommand::WatchDependencies(BuildWorkspace& workspace)
+{
+	std::vector<Platform::Path> directories;
+
+	for (auto& path : workspace.SourceFiles)
+	{
+		directories.push_back(path.GetDirectory());
+	}
+
+	// Watch every directory between each project file and the files it 
+	// contains, so new files that wildcards could match are noticed.
+	for (auto& project : workspace.Projects)
+	{
+		std::string projectDirectory = project.Get_Project_Directory().ToString();
+
+		for (auto& file : project.Get_Files_File())
+		{
+			Platform::Path directory = file.GetDirectory();
+			directories.push_back(directory);
+
+			if (directory.ToString().compare(0, projectDirectory.size() + 1, projectDirectory + "/") != 0)
+			{
+				continue;
+			}
+
+			while (directory.ToString() != projectDirectory)
+			{
+				directory = directory.GetDirectory();
+				directories.push_back(directory);
+			}
+		}
+	}
+
+	// Watch the directories of every file the builder has state cached for, 
+	// anything we can't watch has to be dropped from the cache.
+	for (auto& path : BuilderFileInfo::GetCachedPaths())
+	{
+		directories.push_back(path.GetDirectory());
+	}
+
+	std::sort(directories.begin(), directories.end());
+	directories.erase(std::unique(directories.begin(), directories.end()), directories.end());
+
+	std::vector<Platform::Path> unwatchable;
+
+	for (auto& directory : directories)
+	{
+		if (!m_watcher.Watch(directory))
+		{
+			unwatchable.push_back(directory);
+		}
+	}
+
+	if (!unwatchable.empty())
+	{
+		Log(LogSeverity::Verbose, "Unable to watch %i directories, their state will not be kept.\n", (int)unwatchable.size());
+		BuilderFileInfo::InvalidateCachedPaths(unwatchable);
+	}
+}
+
+void ServerCommand::ProcessChanges(int timeoutMs)
+{
+	std::vector<Platform::FileChange> changes;
+	bool bOverflow = false;
+
+	if (!m_watcher.Poll(changes, bOverflow, timeoutMs))
+	{
+		return;
+	}
+
+	if (bOverflow)
+	{
+		Log(LogSeverity::Verbose, "File change queue overflowed, discarding all resident state.\n");
+
+		m_workspaces.clear();
+		BuilderFileInfo::ClearCache(true);
+		return;
+	}
+
+	if (changes.empty())
+	{
+		return;
+	}
+
+	std::vector<Platform::Path> changedPaths;
+	for (auto& change : changes)
+	{
+		changedPaths.push_back(change.FilePath);
+	}
+
+	BuilderFileInfo::InvalidateCachedPaths(changedPaths);
+
+	// A workspace is stale if any of its files changed, or if anything was 
+	// added or removed that its wildcards might match. Files coming and 
+	// going in output directories are expected during builds so are ignored.
+	for (auto iter = m_workspaces.begin(); iter != m_workspaces.end(); )
+	{
+		BuildWorkspace& workspace = *iter->second;
+		bool bStale = false;
+
+		for (auto& change : changes)
+		{
+			if (std::find(workspace.SourceFiles.begin(), workspace.SourceFiles.end(), change.FilePath) != workspace.SourceFiles.end())
+			{
+				bStale = true;
+				break;
+			}
+
+			if (change.Type == Platform::FileChangeType::Modified)
+			{
+				continue;
+			}
+
+			std::string changedPath = change.FilePath.ToString();
+			bool bInOutputDirectory = false;
+
+			for (auto& project : workspace.Projects)
+			{
+				std::string intermediateDirectory = project.Get_Project_IntermediateDirectory().ToString() + "/";
+				std::string outputDirectory = project.Get_Project_OutputDirectory().ToString() + "/";
+
+				if (changedPath.compare(0, intermediateDirectory.size(), intermediateDirectory) == 0 ||
+					changedPath.compare(0, outputDirectory.size(), outputDirectory) == 0)
+				{
+					bInOutputDirectory = true;
+					break;
+				}
+			}
+
+			if (!bInOutputDirectory)
+			{
+				bStale = true;
+				break;
+			}
+		}
+
+		if (bStale)
+		{
+			Log(LogSeverity::Verbose, "Workspace files changed, state will be reloaded on next build.\n");
+			iter = m_workspaces.erase(iter);
+		}
+		else
+		{
+			iter++;
+		}
+	}
+}
+
+}; // namespace MicroBuild
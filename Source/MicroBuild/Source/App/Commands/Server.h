@@ -0,0 +1,109 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "Core/Commands/Command.h"
+#include "Core/Platform/Path.h"
+#include "Core/Platform/FileWatcher.h"
+#include "Core/Platform/LocalSocket.h"
+
+#include <memory>
+
+namespace MicroBuild {
+
+class App;
+struct BuildWorkspace;
+
+// Request sent from a client process to a running build server.
+struct BuildServerRequest
+{
+	Platform::Path WorkspacePath;
+	std::string ProjectName;
+	std::string Configuration;
+	std::string Platform;
+	std::map<std::string, std::string> SetArguments;
+
+	// Environment of the client. Values containing newlines aren't sent.
+	std::map<std::string, std::string> Environment;
+
+	bool bRebuild;
+	bool bBuildDependencies;
+	bool bVerbose;
+	bool bStop;
+
+	BuildServerRequest();
+
+	std::string Serialize() const;
+	bool Deserialize(const std::string& data);
+};
+
+// Runs a resident build server for a workspace. The server keeps the parsed
+// workspace and project files, and the file state gathered by the builder, in
+// memory between builds. Changes to files are tracked by watching the
+// directories everything was loaded from, so only state that has actually gone
+// stale is thrown away. Build commands for the workspace are forwarded to the
+// server while it is running.
+class ServerCommand : public Command
+{
+public:
+	ServerCommand(App* app);
+	~ServerCommand();
+
+	// Sends a request to the server running for the requested workspace. Returns
+	// false if no server is running, otherwise bResult holds the result of the
+	// request and all output has already been logged. Also returns false if the 
+	// server declined the request.
+	static bool ForwardRequest(const BuildServerRequest& request, bool& bResult);
+
+protected:
+	virtual bool Invoke(CommandLineParser* parser) override;
+
+	// Gets the name of the endpoint a server for the given workspace listens on.
+	static std::string GetEndpointName(const Platform::Path& workspacePath);
+
+	// Performs a build request and sends all output back to the client.
+	bool ProcessRequest(Platform::LocalSocket& client, const BuildServerRequest& request);
+
+	// Returns false if the client's environment differs from ours in PATH or 
+	// any variable the workspace resolved a token with. Compilers are found
+	// and tokens are resolved with our environment, so a client whose 
+	// environment differs has to build in its own process.
+	bool IsEnvironmentCompatible(const BuildWorkspace& workspace, const BuildServerRequest& request, std::string& mismatch);
+
+	// Reads any pending file changes and discards everything they make stale.
+	void ProcessChanges(int timeoutMs);
+
+	// Starts watching everything the given workspace and the builder's file 
+	// state depend on.
+	void WatchDependencies(BuildWorkspace& workspace);
+
+private:
+	App* m_app;
+
+	Platform::Path m_workspaceFilePath;
+	bool m_stop;
+
+	Platform::FileWatcher m_watcher;
+
+	// Loaded workspaces keyed by configuration, platform and defines.
+	std::map<std::string, std::unique_ptr<BuildWorkspace>> m_workspaces;
+
+};
+
+}; // namespace MicroBuild
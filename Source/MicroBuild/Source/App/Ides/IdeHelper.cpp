@@ -19,6 +19,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "PCH.h"
 #include "App/Ides/IdeHelper.h"
 
+#include "App/Builder/Toolchains/Cpp/Clang/Toolchain_Clang.h"
+#include "App/Builder/Toolchains/Cpp/Gcc/Toolchain_Gcc.h"
+#include "Core/Parallel/Jobs/JobScheduler.h"
+
 namespace MicroBuild {
 namespace IdeHelper {
 
@@ -243,6 +247,195 @@ bool UpdateAutoLinkDependencies(
 	return true;
 }
 
+bool CanGenerateBuildRules(ProjectFile& projectFile)
+{
+	if (projectFile.Get_Project_Language() != ELanguage::Cpp ||
+		projectFile.Get_Project_OutputType() == EOutputType::Container)
+	{
+		return false;
+	}
+
+	switch (projectFile.Get_Target_Platform())
+	{
+	case EPlatform::x86:
+	case EPlatform::x64:
+	case EPlatform::ARM:
+	case EPlatform::ARM64:
+		break;
+	default:
+		return false;
+	}
+
+	switch (projectFile.Get_Build_PlatformToolset())
+	{
+	case EPlatformToolset::Clang:
+	case EPlatformToolset::GCC:
+		return true;
+#if defined(MB_PLATFORM_LINUX)
+	case EPlatformToolset::Default:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+bool GetBuildRules(
+	WorkspaceFile& workspaceFile,
+	BuildProjectPair& pair,
+	BuildWorkspaceMatrix& matrix,
+	BuilderToolchainCache& toolchainCache,
+	BuildRuleSet& output)
+{
+	ProjectFile& projectFile = pair.projectFile;
+
+	// Matches the selection the builder makes, linux defaults to clang.
+	if (projectFile.Get_Build_PlatformToolset() == EPlatformToolset::GCC)
+	{
+		output.toolchain = std::make_shared<Toolchain_Gcc>(projectFile, 0);
+	}
+	else
+	{
+		output.toolchain = std::make_shared<Toolchain_Clang>(projectFile, 0);
+	}
+
+	output.toolchain->SetToolchainCache(&toolchainCache);
+
+	if (!output.toolchain->Init())
+	{
+		Log(LogSeverity::Fatal, "Toolchain '%s' not available to compile '%s', are you sure its installed?\n", 
+			output.toolchain->GetDescription().c_str(), 
+			projectFile.Get_Project_Name().c_str());
+		return false;
+	}
+
+	// Find the projects we depend on in this configuration.
+	std::vector<ProjectFile*> configProjectFiles;
+	std::vector<BuildProjectPair*> configPairs;
+	for (BuildProjectMatrix& projectMatrix : matrix)
+	{
+		for (BuildProjectPair& projectPair : projectMatrix)
+		{
+			if (projectPair.config == pair.config && projectPair.platform == pair.platform)
+			{
+				configProjectFiles.push_back(&projectPair.projectFile);
+				configPairs.push_back(&projectPair);
+			}
+		}
+	}
+
+	output.dependencies.clear();
+
+	for (const std::string& dependency : projectFile.Get_Dependencies_Dependency())
+	{
+		ProjectFile* projectDependency = nullptr;
+		if (!GetProjectDependency(
+			workspaceFile,
+			configProjectFiles,
+			&projectFile,
+			projectDependency,
+			dependency))
+		{
+			return false;
+		}
+
+		size_t index = std::find(configProjectFiles.begin(), configProjectFiles.end(), projectDependency) - configProjectFiles.begin();
+
+		BuildRuleDependency info;
+		info.projectFile = projectDependency;
+		info.hasRules = configPairs[index]->shouldBuild && CanGenerateBuildRules(*projectDependency);
+		info.outputPath = projectDependency->Get_Project_OutputDirectory()
+			.AppendFragment(
+				Strings::Format("%s%s", 
+					projectDependency->Get_Project_OutputName().c_str(), 
+					projectDependency->Get_Project_OutputExtension().c_str()
+				),
+				true
+			);
+
+		output.dependencies.push_back(info);
+	}
+
+	// Collect the files to compile.
+	std::vector<Platform::Path> sourceFiles;
+	for (const Platform::Path& path : projectFile.Get_Files_File())
+	{
+		if (path.IsSourceFile())
+		{
+			sourceFiles.push_back(path);
+		}
+	}
+
+	if (!output.toolchain->CreateUnityFiles(sourceFiles))
+	{
+		return false;
+	}
+
+	Platform::Path intermediateDirectory = 
+		projectFile.Get_Project_IntermediateDirectory();
+
+	Platform::Path precompiledSourcePath = 
+		projectFile.Get_Build_PrecompiledSource();
+
+	output.files.clear();
+	output.hasPrecompiledSource = false;
+
+	for (Platform::Path& path : sourceFiles)
+	{
+		BuilderFileInfo info;
+		info.SourcePath = path;
+		info.OutputPath = intermediateDirectory.AppendFragment(path.ChangeExtension("o").GetFilename(), true);
+		info.ManifestPath = info.OutputPath.ChangeExtension("build.manifest");
+		info.Database = nullptr;
+		info.bOutOfDate = true;
+		info.Hash = 0;
+
+		// The precompiled source is compiled seperately, the same as the builder.
+		if (path == precompiledSourcePath)
+		{
+			output.precompiledSourceFile = info;
+			output.hasPrecompiledSource = true;
+		}
+		else
+		{
+			output.files.push_back(info);
+		}
+	}
+
+	return true;
+}
+
+std::string FormatCommandLine(
+	const Platform::Path& tool,
+	const std::vector<std::string>& args)
+{
+	std::string result = tool.ToString();
+	if (result.find(' ') != std::string::npos)
+	{
+		result = Strings::Quoted(result);
+	}
+
+	// Most arguments are already quoted by the toolchain, anything else with
+	// a space in it needs to be quoted for the shell.
+	for (const std::string& arg : args)
+	{
+		result += " ";
+
+		if (arg.find(' ') != std::string::npos &&
+			arg.find('"') == std::string::npos &&
+			arg.find('\'') == std::string::npos)
+		{
+			result += Strings::Quoted(arg);
+		}
+		else
+		{
+			result += arg;
+		}
+	}
+
+	return result;
+}
+
 bool CreateBuildMatrix(
 	WorkspaceFile& workspaceFile,
 	std::vector<ProjectFile>& projectFiles,
@@ -254,43 +447,56 @@ bool CreateBuildMatrix(
 	std::vector<EPlatform> platforms =
 		workspaceFile.Get_Platforms_Platform();
 
-	for (ProjectFile& file : projectFiles)
+	size_t pairCount = configurations.size() * platforms.size();
+	size_t outputOffset = output.size();
+
+	for (size_t i = 0; i < projectFiles.size(); i++)
 	{
-		BuildProjectMatrix projectMatrix;
-		projectMatrix.resize(configurations.size() * platforms.size());
+		output.push_back(BuildProjectMatrix());
+		output.back().resize(pairCount);
+	}
 
-		int configIndex = 0;
+	// Resolve each project/configuration/platform combination and extract the 
+	// information that we require. Each one is independent so they are all
+	// resolved in parallel.
+	std::atomic<bool> bFailed(false);
 
-		// Resolve each configuration/platform combination and extract the 
-		// information that we require.
-		for (std::string& config : configurations)
-		{
-			for (EPlatform& platform : platforms)
-			{
-				BuildProjectPair& pair = projectMatrix[configIndex++];
+	JobScheduler scheduler(Platform::GetConcurrencyFactor());
+	scheduler.ParallelFor((int)(projectFiles.size() * pairCount), [&](int index) {
+		
+		size_t projectIndex = index / pairCount;
+		size_t configIndex = (index % pairCount) / platforms.size();
+		size_t platformIndex = index % platforms.size();
 
-				pair.projectFile = file;
-				pair.projectFile.Set_Target_Configuration(config);
-				pair.projectFile.Set_Target_Platform(platform);
-				pair.projectFile.Set_Target_PlatformName(IdeHelper::ResolvePlatformName(platform));
-				pair.projectFile.Set_Target_MicroBuildExecutable(Platform::Path::GetExecutablePath());
-				pair.projectFile.Set_Target_MicroBuildDirectory(Platform::Path::GetExecutablePath().GetDirectory());
+		std::string& config = configurations[configIndex];
+		EPlatform platform = platforms[platformIndex];
 
-				pair.config = config;
-				pair.platform = platform;
+		BuildProjectPair& pair = output[outputOffset + projectIndex][index % pairCount];
 
-				pair.projectFile.Resolve();
-				if (!pair.projectFile.Validate())
-				{
-					return false;
-				}
+		pair.projectFile = projectFiles[projectIndex];
+		pair.projectFile.Set_Target_Configuration(config);
+		pair.projectFile.Set_Target_Platform(platform);
+		pair.projectFile.Set_Target_PlatformName(IdeHelper::ResolvePlatformName(platform));
+		pair.projectFile.Set_Target_MicroBuildExecutable(Platform::Path::GetExecutablePath());
+		pair.projectFile.Set_Target_MicroBuildDirectory(Platform::Path::GetExecutablePath().GetDirectory());
 
-				pair.shouldBuild = pair.projectFile.Get_Project_ShouldBuild();
-				pair.shouldDeploy = pair.projectFile.Get_Project_ShouldDeploy();
-			}
+		pair.config = config;
+		pair.platform = platform;
+
+		pair.projectFile.Resolve();
+		if (!pair.projectFile.Validate())
+		{
+			bFailed = true;
+			return;
 		}
 
-		output.push_back(projectMatrix);
+		pair.shouldBuild = pair.projectFile.Get_Project_ShouldBuild();
+		pair.shouldDeploy = pair.projectFile.Get_Project_ShouldDeploy();
+	});
+
+	if (bFailed)
+	{
+		return false;
 	}
 
 	// We do auto-link dependency resolution here to be somewhat lazy, 
@@ -22,8 +22,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "Schemas/Workspace/WorkspaceFile.h"
 #include "Schemas/Project/ProjectFile.h"
 #include "Core/Helpers/TextStream.h"
+#include "App/Builder/BuilderFileInfo.h"
+
+#include <memory>
 
 namespace MicroBuild {
+
+class Toolchain;
+class BuilderToolchainCache;
+
 namespace IdeHelper {
 
 // Used to build a hierarchy of group folders in a workspace.
@@ -47,6 +54,26 @@ struct BuildProjectPair
 typedef std::vector<BuildProjectPair> BuildProjectMatrix;
 typedef std::vector<BuildProjectMatrix> BuildWorkspaceMatrix;
 
+// Describes a project that the build rules of another project depend on.
+struct BuildRuleDependency
+{
+	ProjectFile* projectFile;
+	bool hasRules;
+	Platform::Path outputPath;
+};
+
+// Describes what is required to build a project configuration, used by 
+// generators that write rules for external build tools rather than 
+// invoking the internal builder.
+struct BuildRuleSet
+{
+	std::shared_ptr<Toolchain> toolchain;
+	std::vector<BuilderFileInfo> files;
+	BuilderFileInfo precompiledSourceFile;
+	bool hasPrecompiledSource;
+	std::vector<BuildRuleDependency> dependencies;
+};
+
 // Expanded version of a vpath, the first value is the expanded path,
 // the second value is a concatination of all matched values.
 typedef std::pair<Platform::Path, std::string> VPathPair;
@@ -94,6 +121,26 @@ bool UpdateAutoLinkDependencies(
 	WorkspaceFile& workspaceFile,
 	std::vector<ProjectFile*>& configProjectFiles);
 
+// Returns true if build rules can be generated for the given project 
+// configuration, only the gcc and clang toolchains are supported.
+bool CanGenerateBuildRules(ProjectFile& projectFile);
+
+// Finds the toolchain, files and dependencies required to write build rules
+// for the given project configuration. Returns true on success, otherwise 
+// emits errors to stdout.
+bool GetBuildRules(
+	WorkspaceFile& workspaceFile,
+	BuildProjectPair& pair,
+	BuildWorkspaceMatrix& matrix,
+	BuilderToolchainCache& toolchainCache,
+	BuildRuleSet& output);
+
+// Formats a tool and its arguments into a command line that can be passed
+// to the shell by build rules.
+std::string FormatCommandLine(
+	const Platform::Path& tool,
+	const std::vector<std::string>& args);
+
 // Creates a build matrix that stores the configuration state of each
 // project file in each configuration/platform combination defined in
 // the workspace file.
@@ -221,12 +221,12 @@ bool MSBuild_ProjectFile::Generate(
 			project.Node("PropertyGroup")
 			.Attribute("Condition", "'$(Configuration)|$(Platform)'=='%s|%s'", matrix.config.c_str(), platformId.c_str());
 
-		for (Platform::Path& path : matrix.projectFile.Get_ForcedIncludes_ForcedInclude())
+		for (const Platform::Path& path : matrix.projectFile.Get_ForcedIncludes_ForcedInclude())
 		{
 			forcedIncludes.push_back("$(SolutionDir)\\" + solutionDirectory.RelativeTo(path).ToString());
 		}
 
-		for (Platform::Path& path : matrix.projectFile.Get_SearchPaths_IncludeDirectory())
+		for (const Platform::Path& path : matrix.projectFile.Get_SearchPaths_IncludeDirectory())
 		{
 			Platform::Path relativePath = solutionDirectory.RelativeTo(path).ToString();
 			if (relativePath.IsRelative())
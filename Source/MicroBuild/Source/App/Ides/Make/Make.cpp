@@ -20,6 +20,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Ides/Make/Make.h"
 #include "App/Ides/Make/Make_ProjectFile.h"
 #include "App/Ides/Make/Make_SolutionFile.h"
+#include "App/Builder/BuilderToolchainCache.h"
 #include "Core/Helpers/TextStream.h"
 #include "Core/Platform/Process.h"
 
@@ -45,6 +46,13 @@ bool Ide_Make::Generate(
 		return false;
 	}
 
+	// Native rules need the toolchain, share probe results with the builder.
+	BuilderToolchainCache toolchainCache;
+	if (workspaceFile.Get_Make_NativeRules())
+	{
+		toolchainCache.Open(workspaceFile.Get_Workspace_Location().AppendFragment("toolchain.cache", true));
+	}
+
 	int index = 0;
 	for (ProjectFile& file : projectFiles)
 	{
@@ -54,7 +62,9 @@ bool Ide_Make::Generate(
 			databaseFile,
 			workspaceFile,
 			file,
-			matrix[index]))
+			matrix[index],
+			&matrix,
+			&toolchainCache))
 		{
 			return false;
 		}
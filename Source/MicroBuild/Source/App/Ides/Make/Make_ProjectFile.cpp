@@ -18,6 +18,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "PCH.h"
 #include "App/Ides/Make/Make_ProjectFile.h"
+#include "App/Builder/Toolchains/Toolchain.h"
 
 namespace MicroBuild {
 
@@ -42,58 +43,16 @@ void Make_ProjectFile::WriteCommands(
 	}
 }
 
-bool Make_ProjectFile::Generate(
-	DatabaseFile& databaseFile,
+void Make_ProjectFile::WriteBuildRecipes(
+	TextStream& stream,
 	WorkspaceFile& workspaceFile,
 	ProjectFile& projectFile,
 	IdeHelper::BuildProjectMatrix& buildMatrix
 )
 {
-	Platform::Path solutionDirectory =
-		workspaceFile.Get_Workspace_Location();
-
 	Platform::Path projectDirectory =
 		projectFile.Get_Project_Location();
 
-	Platform::Path projectLocation =
-		projectDirectory.AppendFragment(
-			projectFile.Get_Project_Name() + ".Makefile", true);
-
-	std::vector<std::string> configurations =
-		workspaceFile.Get_Configurations_Configuration();
-
-	std::vector<EPlatform> platforms =
-		workspaceFile.Get_Platforms_Platform();
-
-	std::string projectGuid = Strings::Guid({
-		workspaceFile.Get_Workspace_Name(),
-		projectFile.Get_Project_Name() });
-
-	std::string projectName = 
-		projectFile.Get_Project_Name();
-
-	TextStream stream(true);
-
-	std::string defaultConfigId = 
-		configurations[0] + "_" + CastToString(platforms[0]);
-
-	// Files.
-	std::vector<Platform::Path> files = 
-		projectFile.Get_Files_File();
-
-	// Header
-	stream.WriteLine("ifndef config");
-	stream.Indent();
-		stream.WriteLine("config = %s", defaultConfigId.c_str());
-	stream.Undent();
-	stream.WriteLine("endif");
-	stream.WriteLine("");
-	stream.WriteLine("ifndef verbose");
-	stream.Indent();
-		stream.WriteLine("SILENT = @");
-	stream.Undent();
-	stream.WriteLine("endif");
-	stream.WriteLine("");
 	stream.WriteLine(".PHONY: build clean rebuild");
 	stream.WriteLine("");
 
@@ -142,6 +101,381 @@ bool Make_ProjectFile::Generate(
 	stream.WriteLine("clean:");	
 	stream.WriteLine("\t$(SILENT) $(MB_EXE) Clean $(MB_WORKSPACE_FILE) $(MB_PROJECT_NAME) -c=$(MB_PROJECT_CONFIG) -p=$(MB_PROJECT_PLATFORM) --silent");	
 	stream.WriteLine("");
+}
+
+std::string Make_ProjectFile::EscapePath(const Platform::Path& path)
+{
+	std::string value = path.ToString();
+
+	std::string result;
+	result.reserve(value.size());
+
+	for (char chr : value)
+	{
+		if (chr == '$')
+		{
+			result.push_back('$');
+		}
+		else if (chr == ' ' || chr == '#')
+		{
+			result.push_back('\\');
+		}
+		result.push_back(chr);
+	}
+
+	return result;
+}
+
+std::string Make_ProjectFile::EscapeCommand(const std::string& command)
+{
+	std::string result;
+	result.reserve(command.size());
+
+	for (char chr : command)
+	{
+		if (chr == '$')
+		{
+			result.push_back('$');
+		}
+		result.push_back(chr);
+	}
+
+	return result;
+}
+
+bool Make_ProjectFile::WriteNativeRules(
+	TextStream& stream,
+	WorkspaceFile& workspaceFile,
+	ProjectFile& projectFile,
+	IdeHelper::BuildProjectMatrix& buildMatrix,
+	IdeHelper::BuildWorkspaceMatrix& workspaceMatrix,
+	BuilderToolchainCache& toolchainCache
+)
+{
+	std::string projectName = 
+		projectFile.Get_Project_Name();
+
+	// Targets used when the makefile is invoked directly, the workspace 
+	// makefile includes every project and provides its own.
+	stream.WriteLine("ifndef MB_WORKSPACE_MAKEFILE");
+	stream.WriteLine("");
+	stream.WriteLine(".PHONY: all build clean rebuild");
+	stream.WriteLine("");
+	stream.WriteLine("all: build");
+	stream.WriteLine("\t@:");
+	stream.WriteLine("");
+	stream.WriteLine("build: %s", projectName.c_str());
+	stream.WriteLine("\t@:");
+	stream.WriteLine("");
+	stream.WriteLine("rebuild:");
+	stream.WriteLine("\t@$(MAKE) --no-print-directory -f $(firstword $(MAKEFILE_LIST)) clean");
+	stream.WriteLine("\t@$(MAKE) --no-print-directory -f $(firstword $(MAKEFILE_LIST)) build");
+	stream.WriteLine("");
+	stream.WriteLine("clean: %s_clean", projectName.c_str());
+	stream.WriteLine("\t@:");
+	stream.WriteLine("");
+	stream.WriteLine("endif");
+	stream.WriteLine("");
+	stream.WriteLine(".PHONY: %s %s_PreBuild %s_clean", projectName.c_str(), projectName.c_str(), projectName.c_str());
+	stream.WriteLine(".DELETE_ON_ERROR:");
+	stream.WriteLine("");
+
+	for (IdeHelper::BuildProjectPair& pair : buildMatrix)
+	{
+		std::string id = pair.config + "_" + CastToString(pair.platform);
+		stream.WriteLine("ifeq ($(config),%s)", id.c_str());
+		stream.WriteLine("");
+
+		bool bSupported = IdeHelper::CanGenerateBuildRules(pair.projectFile);
+
+		if (pair.shouldBuild && bSupported)
+		{
+			if (!WriteNativeConfiguration(
+				stream,
+				workspaceFile,
+				pair,
+				workspaceMatrix,
+				toolchainCache))
+			{
+				return false;
+			}
+		}
+		else
+		{
+			if (pair.shouldBuild && 
+				pair.projectFile.Get_Project_OutputType() != EOutputType::Container)
+			{
+				Log(LogSeverity::Warning, "Project '%s' (%s) does not use a toolchain supported by native make rules, it will not be built.\n",
+					projectName.c_str(),
+					id.c_str());
+			}
+
+			// Still define the targets so dependent projects can refer to them.
+			stream.WriteLine("%s:", projectName.c_str());
+			stream.WriteLine("\t@:");
+			stream.WriteLine("");
+			stream.WriteLine("%s_PreBuild:", projectName.c_str());
+			stream.WriteLine("\t@:");
+			stream.WriteLine("");
+			stream.WriteLine("%s_clean:", projectName.c_str());
+			stream.WriteLine("\t@:");
+			stream.WriteLine("");
+		}
+
+		stream.WriteLine("endif");
+		stream.WriteLine("");
+	}
+
+	return true;
+}
+
+bool Make_ProjectFile::WriteNativeConfiguration(
+	TextStream& stream,
+	WorkspaceFile& workspaceFile,
+	IdeHelper::BuildProjectPair& pair,
+	IdeHelper::BuildWorkspaceMatrix& workspaceMatrix,
+	BuilderToolchainCache& toolchainCache
+)
+{
+	ProjectFile& projectFile = pair.projectFile;
+
+	std::string projectName = 
+		projectFile.Get_Project_Name();
+
+	IdeHelper::BuildRuleSet rules;
+	if (!IdeHelper::GetBuildRules(
+		workspaceFile,
+		pair,
+		workspaceMatrix,
+		toolchainCache,
+		rules))
+	{
+		return false;
+	}
+
+	Toolchain* toolchain = rules.toolchain.get();
+
+	Platform::Path outputPath = toolchain->GetOutputPath();
+	Platform::Path pchPath = toolchain->GetPchPath();
+
+	std::string dependencyTargets;
+	std::string dependencyPreBuildTargets;
+	std::string dependencyOutputs;
+
+	for (IdeHelper::BuildRuleDependency& dependency : rules.dependencies)
+	{
+		std::string dependencyName = dependency.projectFile->Get_Project_Name();
+
+		dependencyTargets += " " + dependencyName;
+		dependencyPreBuildTargets += " " + dependencyName + "_PreBuild";
+
+		// Relink if a library we depend on is rebuilt.
+		EOutputType outputType = dependency.projectFile->Get_Project_OutputType();
+		if (dependency.hasRules && 
+			(outputType == EOutputType::StaticLib || outputType == EOutputType::DynamicLib))
+		{
+			dependencyOutputs += " " + EscapePath(dependency.outputPath);
+		}
+	}
+
+	// Variables.
+	std::string objects;
+	for (BuilderFileInfo& file : rules.files)
+	{
+		objects += " \\\n    " + EscapePath(file.OutputPath);
+	}
+
+	std::string depends = Strings::Format("$(%s_OBJECTS:.o=.d)", projectName.c_str());
+	if (rules.hasPrecompiledSource)
+	{
+		depends += " " + EscapePath(pchPath.ChangeExtension("d"));
+	}
+
+	stream.WriteLine("%s_OUTPUT = %s", projectName.c_str(), EscapePath(outputPath).c_str());
+	stream.WriteLine("%s_OBJECTS =%s", projectName.c_str(), objects.c_str());
+	stream.WriteLine("%s_DEPENDS = %s", projectName.c_str(), depends.c_str());
+	stream.WriteLine("%s_CLEAN = $(%s_OUTPUT) $(%s_OBJECTS) $(%s_DEPENDS)%s", 
+		projectName.c_str(), 
+		projectName.c_str(), 
+		projectName.c_str(), 
+		projectName.c_str(),
+		rules.hasPrecompiledSource ? (" " + EscapePath(pchPath)).c_str() : "");
+	stream.WriteLine("");
+
+	// Other projects are only known when included from the workspace makefile.
+	stream.WriteLine("ifdef MB_WORKSPACE_MAKEFILE");
+	stream.WriteLine("%s_DEPENDENCIES =%s", projectName.c_str(), dependencyTargets.c_str());
+	stream.WriteLine("%s_PREBUILD_DEPENDENCIES =%s", projectName.c_str(), dependencyPreBuildTargets.c_str());
+	stream.WriteLine("endif");
+	stream.WriteLine("");
+
+	stream.WriteLine("%s: $(%s_OUTPUT)", projectName.c_str(), projectName.c_str());
+	stream.WriteLine("\t@:");
+	stream.WriteLine("");
+
+	// Pre-build commands, these also wait for the pre-build commands of 
+	// the projects we depend on as they may generate headers we include.
+	stream.WriteLine("%s_PreBuild: | $(%s_PREBUILD_DEPENDENCIES)", projectName.c_str(), projectName.c_str());
+	stream.WriteLine("\t$(SILENT) mkdir -p %s %s", 
+		Strings::Quoted(EscapeCommand(projectFile.Get_Project_IntermediateDirectory().ToString())).c_str(),
+		Strings::Quoted(EscapeCommand(projectFile.Get_Project_OutputDirectory().ToString())).c_str());
+	for (auto& command : projectFile.Get_PreBuildCommands_Command())
+	{
+		stream.WriteLine("\t$(SILENT) %s", EscapeCommand(command).c_str());
+	}
+	stream.WriteLine("");
+
+	// Precompiled header.
+	std::string pchPrerequisite;
+
+	if (rules.hasPrecompiledSource)
+	{
+		Platform::Path tool;
+		std::vector<std::string> args;
+		toolchain->GetCompileCommand(rules.precompiledSourceFile, true, tool, args);
+
+		stream.WriteLine("%s: %s | %s_PreBuild",
+			EscapePath(pchPath).c_str(),
+			EscapePath(rules.precompiledSourceFile.SourcePath).c_str(),
+			projectName.c_str());
+		stream.WriteLine("\t@echo \"%s\"", rules.precompiledSourceFile.SourcePath.GetFilename().c_str());
+		stream.WriteLine("\t$(SILENT) %s", EscapeCommand(IdeHelper::FormatCommandLine(tool, args)).c_str());
+		stream.WriteLine("");
+
+		pchPrerequisite = " " + EscapePath(pchPath);
+	}
+
+	// Object files.
+	for (BuilderFileInfo& file : rules.files)
+	{
+		Platform::Path tool;
+		std::vector<std::string> args;
+		toolchain->GetCompileCommand(file, false, tool, args);
+
+		stream.WriteLine("%s: %s%s | %s_PreBuild",
+			EscapePath(file.OutputPath).c_str(),
+			EscapePath(file.SourcePath).c_str(),
+			pchPrerequisite.c_str(),
+			projectName.c_str());
+		stream.WriteLine("\t@echo \"%s\"", file.SourcePath.GetFilename().c_str());
+		stream.WriteLine("\t$(SILENT) %s", EscapeCommand(IdeHelper::FormatCommandLine(tool, args)).c_str());
+		stream.WriteLine("");
+	}
+
+	// Archive or link the project output, the pre-link and post-build commands
+	// only run when it is, the same as the builder.
+	{
+		Platform::Path tool;
+		std::vector<std::string> args;
+		toolchain->GetOutputCommand(rules.files, tool, args);
+
+		stream.WriteLine("$(%s_OUTPUT): $(%s_OBJECTS)%s | $(%s_DEPENDENCIES)", 
+			projectName.c_str(), 
+			projectName.c_str(), 
+			dependencyOutputs.c_str(),
+			projectName.c_str());
+		for (auto& command : projectFile.Get_PreLinkCommands_Command())
+		{
+			stream.WriteLine("\t$(SILENT) %s", EscapeCommand(command).c_str());
+		}
+		stream.WriteLine("\t@echo \"%s %s\"", 
+			projectFile.Get_Project_OutputType() == EOutputType::StaticLib ? "Archiving" : "Linking",
+			outputPath.GetFilename().c_str());
+		stream.WriteLine("\t$(SILENT) %s", EscapeCommand(IdeHelper::FormatCommandLine(tool, args)).c_str());
+		for (auto& command : projectFile.Get_PostBuildCommands_Command())
+		{
+			stream.WriteLine("\t$(SILENT) %s", EscapeCommand(command).c_str());
+		}
+		stream.WriteLine("");
+	}
+
+	stream.WriteLine("-include $(%s_DEPENDS)", projectName.c_str());
+	stream.WriteLine("");
+
+	stream.WriteLine("%s_clean:", projectName.c_str());
+	stream.WriteLine("\t$(SILENT) rm -f $(%s_CLEAN)", projectName.c_str());
+	stream.WriteLine("");
+
+	return true;
+}
+
+bool Make_ProjectFile::Generate(
+	DatabaseFile& databaseFile,
+	WorkspaceFile& workspaceFile,
+	ProjectFile& projectFile,
+	IdeHelper::BuildProjectMatrix& buildMatrix,
+	IdeHelper::BuildWorkspaceMatrix* workspaceMatrix,
+	BuilderToolchainCache* toolchainCache
+)
+{
+	Platform::Path solutionDirectory =
+		workspaceFile.Get_Workspace_Location();
+
+	Platform::Path projectDirectory =
+		projectFile.Get_Project_Location();
+
+	Platform::Path projectLocation =
+		projectDirectory.AppendFragment(
+			projectFile.Get_Project_Name() + ".Makefile", true);
+
+	std::vector<std::string> configurations =
+		workspaceFile.Get_Configurations_Configuration();
+
+	std::vector<EPlatform> platforms =
+		workspaceFile.Get_Platforms_Platform();
+
+	std::string projectGuid = Strings::Guid({
+		workspaceFile.Get_Workspace_Name(),
+		projectFile.Get_Project_Name() });
+
+	std::string projectName = 
+		projectFile.Get_Project_Name();
+
+	TextStream stream(true);
+
+	std::string defaultConfigId = 
+		configurations[0] + "_" + CastToString(platforms[0]);
+
+	// Files.
+	std::vector<Platform::Path> files = 
+		projectFile.Get_Files_File();
+
+	// Header
+	stream.WriteLine("ifndef config");
+	stream.Indent();
+		stream.WriteLine("config = %s", defaultConfigId.c_str());
+	stream.Undent();
+	stream.WriteLine("endif");
+	stream.WriteLine("");
+	stream.WriteLine("ifndef verbose");
+	stream.Indent();
+		stream.WriteLine("SILENT = @");
+	stream.Undent();
+	stream.WriteLine("endif");
+	stream.WriteLine("");
+	if (workspaceMatrix != nullptr && 
+		toolchainCache != nullptr &&
+		workspaceFile.Get_Make_NativeRules())
+	{
+		if (!WriteNativeRules(
+			stream,
+			workspaceFile,
+			projectFile,
+			buildMatrix,
+			*workspaceMatrix,
+			*toolchainCache))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		WriteBuildRecipes(
+			stream,
+			workspaceFile,
+			projectFile,
+			buildMatrix);
+	}
 
 	// Generate result.
 	if (!databaseFile.StoreFile(
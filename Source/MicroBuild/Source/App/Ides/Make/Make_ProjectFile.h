@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 namespace MicroBuild {
 
+class BuilderToolchainCache;
+
 // Contains the code required to generate a Makefile file.
 class Make_ProjectFile
 {
@@ -31,16 +33,53 @@ public:
 	~Make_ProjectFile();
 
 	// Generates a basic msbuild solution file that links to the given
-	// project files.
+	// project files. If the workspace matrix and toolchain cache are given 
+	// and the workspace enables native rules, the makefile compiles and 
+	// links the project itself rather than invoking MicroBuild.
 	bool Generate(
 		DatabaseFile& databaseFile,
 		WorkspaceFile& workspaceFile,
 		ProjectFile& projectFile,
-		IdeHelper::BuildProjectMatrix& buildMatrix
+		IdeHelper::BuildProjectMatrix& buildMatrix,
+		IdeHelper::BuildWorkspaceMatrix* workspaceMatrix = nullptr,
+		BuilderToolchainCache* toolchainCache = nullptr
 	);
 
 private:
 
+	// Writes recipes that invoke MicroBuild to build the project.
+	void WriteBuildRecipes(
+		TextStream& stream,
+		WorkspaceFile& workspaceFile,
+		ProjectFile& projectFile,
+		IdeHelper::BuildProjectMatrix& buildMatrix
+	);
+
+	// Writes rules that compile and link the project directly, for every 
+	// configuration it can be built in.
+	bool WriteNativeRules(
+		TextStream& stream,
+		WorkspaceFile& workspaceFile,
+		ProjectFile& projectFile,
+		IdeHelper::BuildProjectMatrix& buildMatrix,
+		IdeHelper::BuildWorkspaceMatrix& workspaceMatrix,
+		BuilderToolchainCache& toolchainCache
+	);
+
+	bool WriteNativeConfiguration(
+		TextStream& stream,
+		WorkspaceFile& workspaceFile,
+		IdeHelper::BuildProjectPair& pair,
+		IdeHelper::BuildWorkspaceMatrix& workspaceMatrix,
+		BuilderToolchainCache& toolchainCache
+	);
+
+	// Escapes a path so it can be used as a target or prerequisite.
+	std::string EscapePath(const Platform::Path& path);
+
+	// Escapes a command so it can be used in a recipe.
+	std::string EscapeCommand(const std::string& command);
+
 	void WriteCommands(
 		TextStream& stream,
 		const std::vector<std::string>& commands
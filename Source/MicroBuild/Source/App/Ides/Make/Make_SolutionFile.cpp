@@ -72,9 +72,15 @@ bool Make_SolutionFile::Generate(
 	std::string defaultConfigId = 
 		configurations[0] + "_" + CastToString(platforms[0]);
 
-	// Header
-	stream.WriteLine(".NOTPARALLEL:");
-	stream.WriteLine("");
+	bool bNativeRules = workspaceFile.Get_Make_NativeRules();
+
+	// Header, native rules are scheduled by make in a single graph so can
+	// be built in parallel.
+	if (!bNativeRules)
+	{
+		stream.WriteLine(".NOTPARALLEL:");
+		stream.WriteLine("");
+	}
 	stream.WriteLine("ifndef config");
 	stream.Indent();
 		stream.WriteLine("config = %s", defaultConfigId.c_str());
@@ -89,41 +95,44 @@ bool Make_SolutionFile::Generate(
 	stream.WriteLine("");
 
 	// Write out each config options.
-	for (auto config : configurations)
+	if (!bNativeRules)
 	{
-		for (auto platform : platforms)
+		for (auto config : configurations)
 		{
-			std::string id = config + "_" + CastToString(platform);
-			stream.WriteLine("ifeq ($(config),%s)", id.c_str());
-			stream.Indent();
-
-			for (IdeHelper::BuildProjectMatrix& matrix : buildMatrix)
+			for (auto platform : platforms)
 			{
-				for (IdeHelper::BuildProjectPair& pair : matrix)
+				std::string id = config + "_" + CastToString(platform);
+				stream.WriteLine("ifeq ($(config),%s)", id.c_str());
+				stream.Indent();
+
+				for (IdeHelper::BuildProjectMatrix& matrix : buildMatrix)
 				{
-					if (pair.config == config && 
-						pair.platform == platform)
+					for (IdeHelper::BuildProjectPair& pair : matrix)
 					{
-						if (pair.shouldBuild)
-						{
-							stream.WriteLine("%s_config = %s", 
-								pair.projectFile.Get_Project_Name().c_str(),
-								id.c_str());
-						}
-						else
+						if (pair.config == config && 
+							pair.platform == platform)
 						{
-							stream.WriteLine("%s_config = ", 
-								pair.projectFile.Get_Project_Name().c_str());
+							if (pair.shouldBuild)
+							{
+								stream.WriteLine("%s_config = %s", 
+									pair.projectFile.Get_Project_Name().c_str(),
+									id.c_str());
+							}
+							else
+							{
+								stream.WriteLine("%s_config = ", 
+									pair.projectFile.Get_Project_Name().c_str());
+							}
 						}
 					}
 				}
-			}
 
-			stream.Undent();
-			stream.WriteLine("endif");
+				stream.Undent();
+				stream.WriteLine("endif");
+			}
 		}
+		stream.WriteLine("");
 	}
-	stream.WriteLine("");
 
 	// Write out all recipies.
 	stream.Write("PROJECTS := ");
@@ -138,65 +147,91 @@ bool Make_SolutionFile::Generate(
 	stream.WriteLine("");
 	stream.WriteLine("all: $(PROJECTS)");
 
-	// Write out project recipies.
-	for (ProjectFile& file : projectFiles)
+	if (bNativeRules)
 	{
-		std::string projectName = file.Get_Project_Name();
+		// Include every project so make sees the files of all of them in one graph.
+		stream.WriteLine("");
+		stream.WriteLine("MB_WORKSPACE_MAKEFILE = 1");
+		stream.WriteLine("MB_WORKSPACE_DIR := $(dir $(lastword $(MAKEFILE_LIST)))");
+		stream.WriteLine("");
 
-		Platform::Path projectLocation;
-			projectLocation = file.Get_Project_Location().
+		for (ProjectFile& file : projectFiles)
+		{
+			Platform::Path projectLocation = file.Get_Project_Location().
 				AppendFragment(file.Get_Project_Name() + ".Makefile", true);
 
-		Platform::Path relativeLocation =
-			solutionDirectory.RelativeTo(projectLocation);
+			Platform::Path relativeLocation =
+				solutionDirectory.RelativeTo(projectLocation);
 
-		/*
-		std::vector<std::string> dependencyNames;
-		for (std::string dependency : file.Get_Dependencies_Dependency())
+			stream.WriteLine("include $(MB_WORKSPACE_DIR)%s", relativeLocation.ToString().c_str());
+		}
+
+		stream.WriteLine("");
+		stream.WriteLine("clean: $(addsuffix _clean,$(PROJECTS))");
+		stream.WriteLine("\t@:");
+	}
+	else
+	{
+		// Write out project recipies.
+		for (ProjectFile& file : projectFiles)
 		{
-			ProjectFile* projectDependency = nullptr;
-			if (!IdeHelper::GetProjectDependency(
-				workspaceFile, 
-				projectFiles, 
-				&file, 
-				projectDependency, 
-				dependency))
+			std::string projectName = file.Get_Project_Name();
+
+			Platform::Path projectLocation;
+				projectLocation = file.Get_Project_Location().
+					AppendFragment(file.Get_Project_Name() + ".Makefile", true);
+
+			Platform::Path relativeLocation =
+				solutionDirectory.RelativeTo(projectLocation);
+
+			/*
+			std::vector<std::string> dependencyNames;
+			for (std::string dependency : file.Get_Dependencies_Dependency())
 			{
-				return false;
-			}
+				ProjectFile* projectDependency = nullptr;
+				if (!IdeHelper::GetProjectDependency(
+					workspaceFile, 
+					projectFiles, 
+					&file, 
+					projectDependency, 
+					dependency))
+				{
+					return false;
+				}
 
-			dependencyNames.push_back(projectDependency->Get_Project_Name());
+				dependencyNames.push_back(projectDependency->Get_Project_Name());
+			}
+			*/
+
+			stream.WriteLine("");
+			//stream.WriteLine("%s: %s", projectName.c_str(), Strings::Join(dependencyNames, " ").c_str());
+			stream.WriteLine("%s: ", projectName.c_str());
+			stream.WriteLine("ifneq (,$(%s_config))", projectName.c_str());
+			stream.WriteLine("\t@echo \"==== Building %s ($(%s_config)) ====\"", projectName.c_str(), projectName.c_str());
+			stream.WriteLine("\t@${MAKE} --no-print-directory -C %s -f %s config=$(%s_config)", 					
+				relativeLocation.GetDirectory().ToString().c_str(),
+				relativeLocation.GetFilename().c_str(),
+				projectName.c_str());
+			stream.WriteLine("endif");
 		}
-		*/
 
+		// Clean recipie
 		stream.WriteLine("");
-		//stream.WriteLine("%s: %s", projectName.c_str(), Strings::Join(dependencyNames, " ").c_str());
-		stream.WriteLine("%s: ", projectName.c_str());
-		stream.WriteLine("ifneq (,$(%s_config))", projectName.c_str());
-		stream.WriteLine("\t@echo \"==== Building %s ($(%s_config)) ====\"", projectName.c_str(), projectName.c_str());
-		stream.WriteLine("\t@${MAKE} --no-print-directory -C %s -f %s config=$(%s_config)", 					
-			relativeLocation.GetDirectory().ToString().c_str(),
-			relativeLocation.GetFilename().c_str(),
-			projectName.c_str());
-		stream.WriteLine("endif");
-	}
-
-	// Clean recipie
-	stream.WriteLine("");
-	stream.WriteLine("clean:");
-	for (ProjectFile& file : projectFiles)
-	{
-		Platform::Path projectLocation;
-			projectLocation = file.Get_Project_Location().
-				AppendFragment(file.Get_Project_Name() + ".Makefile", true);
+		stream.WriteLine("clean:");
+		for (ProjectFile& file : projectFiles)
+		{
+			Platform::Path projectLocation;
+				projectLocation = file.Get_Project_Location().
+					AppendFragment(file.Get_Project_Name() + ".Makefile", true);
 
-		Platform::Path relativeLocation =
-			solutionDirectory.RelativeTo(projectLocation);
+			Platform::Path relativeLocation =
+				solutionDirectory.RelativeTo(projectLocation);
 
-		stream.WriteLine("\t@${MAKE} --no-print-directory -C %s -f %s clean", 
-			relativeLocation.GetDirectory().ToString().c_str(),
-			relativeLocation.GetFilename().c_str()
-		);
+			stream.WriteLine("\t@${MAKE} --no-print-directory -C %s -f %s clean", 
+				relativeLocation.GetDirectory().ToString().c_str(),
+				relativeLocation.GetFilename().c_str()
+			);
+		}
 	}
 
 	// Help recipie	
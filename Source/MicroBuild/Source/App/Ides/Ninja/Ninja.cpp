@@ -0,0 +1,140 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "App/Ides/Ninja/Ninja.h"
+#include "App/Ides/Ninja/Ninja_ProjectFile.h"
+#include "App/Ides/Ninja/Ninja_SolutionFile.h"
+#include "App/Builder/BuilderToolchainCache.h"
+
+namespace MicroBuild {
+
+Ide_Ninja::Ide_Ninja()
+{
+	SetShortName("ninja");
+}
+
+Ide_Ninja::~Ide_Ninja()
+{
+}
+
+std::string Ide_Ninja::EscapePath(const Platform::Path& path)
+{
+	std::string value = path.ToString();
+
+	std::string result;
+	result.reserve(value.size());
+
+	for (char chr : value)
+	{
+		if (chr == '$' || chr == ' ' || chr == ':')
+		{
+			result.push_back('$');
+		}
+		result.push_back(chr);
+	}
+
+	return result;
+}
+
+std::string Ide_Ninja::EscapeValue(const std::string& value)
+{
+	std::string result;
+	result.reserve(value.size());
+
+	for (char chr : value)
+	{
+		if (chr == '$')
+		{
+			result.push_back('$');
+		}
+		result.push_back(chr);
+	}
+
+	return result;
+}
+
+std::string Ide_Ninja::GetTargetName(ProjectFile& projectFile)
+{
+	return projectFile.Get_Project_Name();
+}
+
+std::string Ide_Ninja::GetPreBuildTargetName(ProjectFile& projectFile)
+{
+	return projectFile.Get_Project_Name() + "_PreBuild";
+}
+
+Platform::Path Ide_Ninja::GetBuildDirectory(
+	WorkspaceFile& workspaceFile,
+	const std::string& config,
+	EPlatform platform)
+{
+	return workspaceFile.Get_Workspace_Location()
+		.AppendFragment("Ninja", true)
+		.AppendFragment(config + "_" + CastToString(platform), true);
+}
+
+bool Ide_Ninja::Generate(
+	DatabaseFile& databaseFile,
+	WorkspaceFile& workspaceFile,
+	std::vector<ProjectFile>& projectFiles)
+{
+	IdeHelper::BuildWorkspaceMatrix matrix;
+	if (!IdeHelper::CreateBuildMatrix(workspaceFile, projectFiles, matrix))
+	{
+		return false;
+	}
+
+	// Share probe results with the builder, so we don't have to run the 
+	// compiler for every project configuration.
+	BuilderToolchainCache toolchainCache;
+	toolchainCache.Open(workspaceFile.Get_Workspace_Location().AppendFragment("toolchain.cache", true));
+
+	int index = 0;
+	for (ProjectFile& file : projectFiles)
+	{
+		Ninja_ProjectFile projectFile;
+
+		if (!projectFile.Generate(
+			databaseFile,
+			workspaceFile,
+			file,
+			matrix[index],
+			matrix,
+			toolchainCache))
+		{
+			return false;
+		}
+
+		index++;
+	}
+
+	Ninja_SolutionFile solutionFile;
+
+	if (!solutionFile.Generate(
+		databaseFile,
+		workspaceFile,
+		projectFiles,
+		matrix))
+	{
+		return false;
+	}
+	return true;
+}
+
+}; // namespace MicroBuild
@@ -0,0 +1,64 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "App/Ides/IdeType.h"
+
+namespace MicroBuild {
+
+// Permits generating of ninja build files.
+class Ide_Ninja 
+	: public IdeType
+{
+public:
+
+	Ide_Ninja();
+	~Ide_Ninja();
+
+	virtual bool Generate(
+		DatabaseFile& databaseFile,
+		WorkspaceFile& workspaceFile,
+		std::vector<ProjectFile>& projectFiles) override;
+
+	// Escapes a path so it can be used as an input or output of a build statement.
+	static std::string EscapePath(const Platform::Path& path);
+
+	// Escapes a string so it can be used as the value of a variable.
+	static std::string EscapeValue(const std::string& value);
+
+	// Gets the name of the phony target that builds the given project.
+	static std::string GetTargetName(ProjectFile& projectFile);
+
+	// Gets the name of the phony target that runs the pre-build commands of the 
+	// given project and of everything it depends on.
+	static std::string GetPreBuildTargetName(ProjectFile& projectFile);
+
+	// Gets the directory the build.ninja file for the given configuration is written to.
+	static Platform::Path GetBuildDirectory(
+		WorkspaceFile& workspaceFile,
+		const std::string& config,
+		EPlatform platform);
+
+protected:
+
+private:
+
+};
+
+}; // namespace MicroBuild
@@ -0,0 +1,289 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "App/Ides/Ninja/Ninja.h"
+#include "App/Ides/Ninja/Ninja_ProjectFile.h"
+#include "App/Builder/Toolchains/Toolchain.h"
+
+namespace MicroBuild {
+
+Ninja_ProjectFile::Ninja_ProjectFile()
+{
+}
+
+Ninja_ProjectFile::~Ninja_ProjectFile()
+{
+}
+
+Platform::Path Ninja_ProjectFile::GetNinjaFilePath(ProjectFile& projectFile)
+{
+	return projectFile.Get_Project_Location().AppendFragment(
+		Strings::Format("%s.%s_%s.ninja",
+			projectFile.Get_Project_Name().c_str(),
+			projectFile.Get_Target_Configuration().c_str(),
+			CastToString(projectFile.Get_Target_Platform()).c_str()),
+		true);
+}
+
+void Ninja_ProjectFile::WriteCommands(
+	TextStream& stream,
+	const Platform::Path& output,
+	const std::vector<std::string>& commands,
+	const std::string& inputs,
+	const std::string& description
+)
+{
+	stream.WriteLine("build %s: command%s", 
+		Ide_Ninja::EscapePath(output).c_str(),
+		inputs.c_str());
+	stream.Indent();
+		stream.WriteLine("command = %s", Ide_Ninja::EscapeValue(Strings::Join(commands, " && ")).c_str());
+		stream.WriteLine("desc = %s", Ide_Ninja::EscapeValue(description).c_str());
+	stream.Undent();
+	stream.WriteNewLine();
+}
+
+bool Ninja_ProjectFile::GenerateConfiguration(
+	DatabaseFile& databaseFile,
+	WorkspaceFile& workspaceFile,
+	IdeHelper::BuildProjectPair& pair,
+	IdeHelper::BuildWorkspaceMatrix& workspaceMatrix,
+	BuilderToolchainCache& toolchainCache
+)
+{
+	ProjectFile& projectFile = pair.projectFile;
+
+	std::string projectName = 
+		projectFile.Get_Project_Name();
+
+	std::string configId = 
+		pair.config + "_" + CastToString(pair.platform);
+
+	IdeHelper::BuildRuleSet rules;
+	if (!IdeHelper::GetBuildRules(
+		workspaceFile,
+		pair,
+		workspaceMatrix,
+		toolchainCache,
+		rules))
+	{
+		return false;
+	}
+
+	Toolchain* toolchain = rules.toolchain.get();
+
+	Platform::Path intermediateDirectory = 
+		projectFile.Get_Project_IntermediateDirectory();
+
+	std::string dependencyTargets;
+	std::string dependencyPreBuildTargets;
+	std::string dependencyOutputs;
+
+	for (IdeHelper::BuildRuleDependency& dependency : rules.dependencies)
+	{
+		dependencyTargets += " " + Ide_Ninja::EscapePath(Ide_Ninja::GetTargetName(*dependency.projectFile));
+		dependencyPreBuildTargets += " " + Ide_Ninja::EscapePath(Ide_Ninja::GetPreBuildTargetName(*dependency.projectFile));
+
+		// Relink if a library we depend on is rebuilt.
+		EOutputType outputType = dependency.projectFile->Get_Project_OutputType();
+		if (dependency.hasRules && 
+			(outputType == EOutputType::StaticLib || outputType == EOutputType::DynamicLib))
+		{
+			dependencyOutputs += " " + Ide_Ninja::EscapePath(dependency.outputPath);
+		}
+	}
+
+	TextStream stream(true);
+
+	stream.WriteLine("# Generated by MicroBuild for %s (%s), do not modify.", projectName.c_str(), configId.c_str());
+	stream.WriteNewLine();
+
+	// Pre-build commands, these also wait for the pre-build commands of 
+	// the projects we depend on as they may generate headers we include.
+	std::string preBuildTarget = Ide_Ninja::EscapePath(Ide_Ninja::GetPreBuildTargetName(projectFile));
+	std::string preBuildInputs;
+
+	if (dependencyPreBuildTargets.size() > 0)
+	{
+		preBuildInputs = " ||" + dependencyPreBuildTargets;
+	}
+
+	std::vector<std::string> preBuildCommands = projectFile.Get_PreBuildCommands_Command();
+	if (preBuildCommands.size() > 0)
+	{
+		Platform::Path preBuildOutput = intermediateDirectory.AppendFragment(projectName + ".prebuild", true);
+		WriteCommands(stream, preBuildOutput, preBuildCommands, preBuildInputs, "Running pre-build commands for " + projectName);
+
+		stream.WriteLine("build %s: phony %s%s", preBuildTarget.c_str(), Ide_Ninja::EscapePath(preBuildOutput).c_str(), preBuildInputs.c_str());
+	}
+	else
+	{
+		stream.WriteLine("build %s: phony%s", preBuildTarget.c_str(), preBuildInputs.c_str());
+	}
+	stream.WriteNewLine();
+
+	// Precompiled header.
+	std::string compileImplicitInputs;
+
+	if (rules.hasPrecompiledSource)
+	{
+		Platform::Path pchPath = toolchain->GetPchPath();
+
+		Platform::Path tool;
+		std::vector<std::string> args;
+		toolchain->GetCompileCommand(rules.precompiledSourceFile, true, tool, args);
+
+		stream.WriteLine("build %s: compile %s || %s",
+			Ide_Ninja::EscapePath(pchPath).c_str(),
+			Ide_Ninja::EscapePath(rules.precompiledSourceFile.SourcePath).c_str(),
+			preBuildTarget.c_str());
+		stream.Indent();
+			stream.WriteLine("command = %s", Ide_Ninja::EscapeValue(IdeHelper::FormatCommandLine(tool, args)).c_str());
+			stream.WriteLine("depfile = %s", Ide_Ninja::EscapeValue(pchPath.ChangeExtension("d").ToString()).c_str());
+			stream.WriteLine("desc = %s", Ide_Ninja::EscapeValue(rules.precompiledSourceFile.SourcePath.GetFilename()).c_str());
+		stream.Undent();
+		stream.WriteNewLine();
+
+		compileImplicitInputs = " | " + Ide_Ninja::EscapePath(pchPath);
+	}
+
+	// Object files.
+	std::string objectInputs;
+
+	for (BuilderFileInfo& file : rules.files)
+	{
+		Platform::Path tool;
+		std::vector<std::string> args;
+		toolchain->GetCompileCommand(file, false, tool, args);
+
+		stream.WriteLine("build %s: compile %s%s || %s",
+			Ide_Ninja::EscapePath(file.OutputPath).c_str(),
+			Ide_Ninja::EscapePath(file.SourcePath).c_str(),
+			compileImplicitInputs.c_str(),
+			preBuildTarget.c_str());
+		stream.Indent();
+			stream.WriteLine("command = %s", Ide_Ninja::EscapeValue(IdeHelper::FormatCommandLine(tool, args)).c_str());
+			stream.WriteLine("depfile = %s", Ide_Ninja::EscapeValue(file.OutputPath.ChangeExtension("d").ToString()).c_str());
+			stream.WriteLine("desc = %s", Ide_Ninja::EscapeValue(file.SourcePath.GetFilename()).c_str());
+		stream.Undent();
+		stream.WriteNewLine();
+
+		objectInputs += " " + Ide_Ninja::EscapePath(file.OutputPath);
+	}
+
+	// Archive or link the project output, the pre-link and post-build commands
+	// only run when it is, the same as the builder.
+	Platform::Path outputPath = toolchain->GetOutputPath();
+	{
+		Platform::Path tool;
+		std::vector<std::string> args;
+		toolchain->GetOutputCommand(rules.files, tool, args);
+
+		std::vector<std::string> commands = projectFile.Get_PreLinkCommands_Command();
+		commands.push_back(IdeHelper::FormatCommandLine(tool, args));
+
+		std::vector<std::string> postBuildCommands = projectFile.Get_PostBuildCommands_Command();
+		commands.insert(commands.end(), postBuildCommands.begin(), postBuildCommands.end());
+
+		std::string implicitInputs;
+		if (dependencyOutputs.size() > 0)
+		{
+			implicitInputs = " |" + dependencyOutputs;
+		}
+
+		std::string orderOnlyInputs;
+		if (dependencyTargets.size() > 0)
+		{
+			orderOnlyInputs = " ||" + dependencyTargets;
+		}
+
+		stream.WriteLine("build %s: output%s%s%s",
+			Ide_Ninja::EscapePath(outputPath).c_str(),
+			objectInputs.c_str(),
+			implicitInputs.c_str(),
+			orderOnlyInputs.c_str());
+		stream.Indent();
+			stream.WriteLine("command = %s", Ide_Ninja::EscapeValue(Strings::Join(commands, " && ")).c_str());
+			stream.WriteLine("desc = %s %s", 
+				projectFile.Get_Project_OutputType() == EOutputType::StaticLib ? "Archiving" : "Linking",
+				Ide_Ninja::EscapeValue(outputPath.GetFilename()).c_str());
+		stream.Undent();
+		stream.WriteNewLine();
+	}
+
+	stream.WriteLine("build %s: phony %s", 
+		Ide_Ninja::EscapePath(Ide_Ninja::GetTargetName(projectFile)).c_str(),
+		Ide_Ninja::EscapePath(outputPath).c_str());
+
+	Platform::Path ninjaFilePath = GetNinjaFilePath(projectFile);
+
+	if (!databaseFile.StoreFile(
+		workspaceFile,
+		ninjaFilePath,
+		stream.ToString().c_str()))
+	{
+		return false;
+	}
+
+	return true;
+}
+
+bool Ninja_ProjectFile::Generate(
+	DatabaseFile& databaseFile,
+	WorkspaceFile& workspaceFile,
+	ProjectFile& projectFile,
+	IdeHelper::BuildProjectMatrix& buildMatrix,
+	IdeHelper::BuildWorkspaceMatrix& workspaceMatrix,
+	BuilderToolchainCache& toolchainCache
+)
+{
+	for (IdeHelper::BuildProjectPair& pair : buildMatrix)
+	{
+		if (!pair.shouldBuild)
+		{
+			continue;
+		}
+
+		if (!IdeHelper::CanGenerateBuildRules(pair.projectFile))
+		{
+			if (pair.projectFile.Get_Project_OutputType() != EOutputType::Container)
+			{
+				Log(LogSeverity::Warning, "Project '%s' (%s_%s) does not use a toolchain supported by the ninja generator, it will not be built.\n",
+					projectFile.Get_Project_Name().c_str(),
+					pair.config.c_str(),
+					CastToString(pair.platform).c_str());
+			}
+			continue;
+		}
+
+		if (!GenerateConfiguration(
+			databaseFile,
+			workspaceFile,
+			pair,
+			workspaceMatrix,
+			toolchainCache))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+}; // namespace MicroBuild
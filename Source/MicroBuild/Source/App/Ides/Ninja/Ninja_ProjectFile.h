@@ -0,0 +1,72 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "App/Ides/IdeType.h"
+
+namespace MicroBuild {
+
+class BuilderToolchainCache;
+
+// Contains the code required to generate the ninja file for each configuration
+// of a project.
+class Ninja_ProjectFile
+{
+public:
+
+	Ninja_ProjectFile();
+	~Ninja_ProjectFile();
+
+	// Generates a ninja file for each configuration of the project that contains
+	// a build statement for every object file and one for the project output.
+	bool Generate(
+		DatabaseFile& databaseFile,
+		WorkspaceFile& workspaceFile,
+		ProjectFile& projectFile,
+		IdeHelper::BuildProjectMatrix& buildMatrix,
+		IdeHelper::BuildWorkspaceMatrix& workspaceMatrix,
+		BuilderToolchainCache& toolchainCache
+	);
+
+	// Gets the path of the ninja file generated for the given project configuration.
+	static Platform::Path GetNinjaFilePath(ProjectFile& projectFile);
+
+private:
+
+	bool GenerateConfiguration(
+		DatabaseFile& databaseFile,
+		WorkspaceFile& workspaceFile,
+		IdeHelper::BuildProjectPair& pair,
+		IdeHelper::BuildWorkspaceMatrix& workspaceMatrix,
+		BuilderToolchainCache& toolchainCache
+	);
+
+	// Writes a build statement that runs the given commands. The output is never
+	// created so the commands run on every build, the same as the builder.
+	void WriteCommands(
+		TextStream& stream,
+		const Platform::Path& output,
+		const std::vector<std::string>& commands,
+		const std::string& inputs,
+		const std::string& description
+	);
+
+};
+
+}; // namespace MicroBuild
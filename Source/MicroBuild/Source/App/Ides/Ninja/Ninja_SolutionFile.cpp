@@ -0,0 +1,148 @@
+/*
+MicroBuild
+Copyright (C) 2016 TwinDrills
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "PCH.h"
+#include "App/Ides/Ninja/Ninja.h"
+#include "App/Ides/Ninja/Ninja_ProjectFile.h"
+#include "App/Ides/Ninja/Ninja_SolutionFile.h"
+
+namespace MicroBuild {
+
+Ninja_SolutionFile::Ninja_SolutionFile()
+{
+}
+
+Ninja_SolutionFile::~Ninja_SolutionFile()
+{
+}
+
+bool Ninja_SolutionFile::Generate(
+	DatabaseFile& databaseFile,
+	WorkspaceFile& workspaceFile,
+	std::vector<ProjectFile>& projectFiles,
+	IdeHelper::BuildWorkspaceMatrix& buildMatrix
+)
+{
+	MB_UNUSED_PARAMETER(projectFiles);
+
+	std::vector<std::string> configurations =
+		workspaceFile.Get_Configurations_Configuration();
+
+	std::vector<EPlatform> platforms =
+		workspaceFile.Get_Platforms_Platform();
+
+	for (auto config : configurations)
+	{
+		for (auto platform : platforms)
+		{
+			Platform::Path buildDirectory = 
+				Ide_Ninja::GetBuildDirectory(workspaceFile, config, platform);
+
+			Platform::Path buildLocation = 
+				buildDirectory.AppendFragment("build.ninja", true);
+
+			TextStream stream(true);
+
+			stream.WriteLine("# Generated by MicroBuild for %s (%s_%s), do not modify.", 
+				workspaceFile.Get_Workspace_Name().c_str(),
+				config.c_str(),
+				CastToString(platform).c_str());
+			stream.WriteNewLine();
+
+			// deps = gcc requires 1.3.
+			stream.WriteLine("ninja_required_version = 1.3");
+			stream.WriteLine("builddir = %s", Ide_Ninja::EscapeValue(buildDirectory.ToString()).c_str());
+			stream.WriteNewLine();
+
+			// Rules are shared by all projects, the commands themselves are 
+			// stored in variables on each build statement.
+			stream.WriteLine("rule compile");
+			stream.Indent();
+				stream.WriteLine("command = $command");
+				stream.WriteLine("depfile = $depfile");
+				stream.WriteLine("deps = gcc");
+				stream.WriteLine("description = Compiling $desc");
+			stream.Undent();
+			stream.WriteNewLine();
+
+			stream.WriteLine("rule output");
+			stream.Indent();
+				stream.WriteLine("command = $command");
+				stream.WriteLine("description = $desc");
+			stream.Undent();
+			stream.WriteNewLine();
+
+			stream.WriteLine("rule command");
+			stream.Indent();
+				stream.WriteLine("command = $command");
+				stream.WriteLine("description = $desc");
+			stream.Undent();
+			stream.WriteNewLine();
+
+			// Projects.
+			std::string defaultTargets;
+
+			for (IdeHelper::BuildProjectMatrix& matrix : buildMatrix)
+			{
+				for (IdeHelper::BuildProjectPair& pair : matrix)
+				{
+					if (pair.config != config || 
+						pair.platform != platform)
+					{
+						continue;
+					}
+
+					ProjectFile& projectFile = pair.projectFile;
+
+					std::string target = Ide_Ninja::EscapePath(Ide_Ninja::GetTargetName(projectFile));
+
+					if (pair.shouldBuild && IdeHelper::CanGenerateBuildRules(projectFile))
+					{
+						stream.WriteLine("subninja %s", 
+							Ide_Ninja::EscapePath(Ninja_ProjectFile::GetNinjaFilePath(projectFile)).c_str());
+
+						defaultTargets += " " + target;
+					}
+					else
+					{
+						// Still define the targets so dependent projects can refer to them.
+						stream.WriteLine("build %s: phony", target.c_str());
+						stream.WriteLine("build %s: phony", 
+							Ide_Ninja::EscapePath(Ide_Ninja::GetPreBuildTargetName(projectFile)).c_str());
+					}
+				}
+			}
+			stream.WriteNewLine();
+
+			stream.WriteLine("build all: phony%s", defaultTargets.c_str());
+			stream.WriteLine("default all");
+
+			if (!databaseFile.StoreFile(
+				workspaceFile,
+				buildLocation,
+				stream.ToString().c_str()))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+}; // namespace MicroBuild
@@ -732,7 +732,7 @@ bool XCode_ProjectFile::Write_XCBuildConfiguration(
         if (matrix.projectFile.Get_SearchPaths_IncludeDirectory().size() > 0)
         {
             PlistNode& headersDirNode = settingsNode.Array("HEADER_SEARCH_PATHS");
-            for (Platform::Path& path : matrix.projectFile.Get_SearchPaths_IncludeDirectory())
+            for (const Platform::Path& path : matrix.projectFile.Get_SearchPaths_IncludeDirectory())
             {
                 headersDirNode.Node("").Value("%s", projectBaseDirectory.RelativeTo(path).ToString().c_str());
             }
@@ -741,7 +741,7 @@ bool XCode_ProjectFile::Write_XCBuildConfiguration(
         if (matrix.projectFile.Get_SearchPaths_LibraryDirectory().size() > 0)
         {
             PlistNode& librariesDirNode = settingsNode.Array("LIBRARY_SEARCH_PATHS");
-            for (Platform::Path& path : matrix.projectFile.Get_SearchPaths_LibraryDirectory())
+            for (const Platform::Path& path : matrix.projectFile.Get_SearchPaths_LibraryDirectory())
             {
                 librariesDirNode.Node("").Value("%s", projectBaseDirectory.RelativeTo(path).ToString().c_str());
             }
@@ -840,12 +840,12 @@ bool XCode_ProjectFile::Write_XCBuildConfiguration(
         std::string compilerArguments = "";
         std::string linkerArguments = "";
         
-		for (Platform::Path& path : matrix.projectFile.Get_ForcedIncludes_ForcedInclude())
+		for (const Platform::Path& path : matrix.projectFile.Get_ForcedIncludes_ForcedInclude())
 		{
             compilerArguments += " -include " + Strings::Quoted(projectBaseDirectory.RelativeTo(path).ToString());
 		}
         
-		for (Platform::Path& path : matrix.projectFile.Get_Libraries_Library())
+		for (const Platform::Path& path : matrix.projectFile.Get_Libraries_Library())
 		{
 			if (path.IsRelative())
 			{
@@ -56,9 +56,20 @@ bool PackagerType::CopyPackageFilesToFolder(
 	std::map<Platform::Path, Platform::Path> fileMap;
 
 	std::vector<std::pair<std::string, std::string>> packageMap = projectFile.Get_PackageFiles();
+
+	// Match every filter in one go so filters sharing a directory only walk it once.
+	std::vector<Platform::Path> filters;
 	for (auto& pair : packageMap)
 	{
-		std::vector<Platform::Path> files = Platform::Path::MatchFilter(pair.first);
+		filters.push_back(pair.first);
+	}
+
+	std::vector<std::vector<Platform::Path>> matches = Platform::Path::MatchFilters(filters);
+
+	for (size_t i = 0; i < packageMap.size(); i++)
+	{
+		auto& pair = packageMap[i];
+		std::vector<Platform::Path>& files = matches[i];
 		
 		size_t wildcardOffset = pair.first.find('*');
 		Platform::Path common;
@@ -61,6 +61,11 @@ std::string Plugin::GetFileName()
 	return m_fileName;
 }
 
+Platform::Path Plugin::GetPath()
+{
+	return m_path;
+}
+
 void Plugin::RegisterCallback(EPluginEvent Event, PluginCallbackSignature FuncPtr)
 {
 	PluginCallback callback;
@@ -111,6 +116,7 @@ bool Plugin::Load(Platform::Path& path)
 		}
 
 		m_fileName = path.GetBaseName();
+		m_path = path;
 
 		//Log(LogSeverity::Info, "\tName: %s\n", m_pluginInterface->GetName().c_str());
 		//Log(LogSeverity::Info, "\tDescription: %s\n", m_pluginInterface->GetDescription().c_str());
@@ -42,6 +42,9 @@ public:
 	// Gets the file name of this plugin.
 	std::string GetFileName();
 
+	// Gets the path the plugin was loaded from.
+	Platform::Path GetPath();
+
 	// Loads the plugin.
 	bool Load(Platform::Path& path);
 
@@ -72,6 +75,7 @@ private:
 	PluginManager* m_manager;
 
 	std::string m_fileName;
+	Platform::Path m_path;
 
 };
 
@@ -21,6 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "App/Plugin/PluginManager.h"
 #include "Core/Platform/Path.h"
 #include "Core/Helpers/Strings.h"
+#include "Core/Helpers/Time.h"
 
 namespace MicroBuild {
 
@@ -125,6 +126,21 @@ std::vector<Plugin*> PluginManager::GetPlugins()
 	return m_plugins;
 }
 
+std::string PluginManager::GetIdentity()
+{
+	std::string result;
+
+	for (Plugin* plugin : m_plugins)
+	{
+		result += Strings::Format("%s=%s@%llu;",
+			plugin->GetFileName().c_str(),
+			plugin->GetPath().ToString().c_str(),
+			(unsigned long long)plugin->GetPath().GetModifiedTimeNs());
+	}
+
+	return result;
+}
+
 App* PluginManager::GetApp()
 {
 	return m_app;
@@ -132,6 +148,21 @@ App* PluginManager::GetApp()
 
 bool PluginManager::OnEvent(EPluginEvent Event, PluginEventData* Data)
 {
+	if (m_plugins.empty())
+	{
+		return true;
+	}
+
+	const char* eventName = "Unknown";
+	switch (Event)
+	{
+	case PostProcessWorkspaceFile:	eventName = "PostProcessWorkspaceFile";		break;
+	case PostProcessProjectFile:	eventName = "PostProcessProjectFile";		break;
+	case IbtPopulateCompileFiles:	eventName = "IbtPopulateCompileFiles";		break;
+	}
+
+	Time::TimedScope scope(Strings::Format("Plugin Event: %s", eventName), "Plugins");
+
 	for (Plugin* plugin : m_plugins)
 	{
 		if (!plugin->OnEvent(Event, Data))
@@ -42,6 +42,10 @@ public:
 	// Gets a list of all plugins that are currently loaded.
 	std::vector<Plugin*> GetPlugins();
 
+	// Gets a string identifying the loaded plugins, it changes if any plugin
+	// is loaded, unloaded or rebuilt.
+	std::string GetIdentity();
+
 	// Fires any registered events of the given type.
 	bool OnEvent(EPluginEvent Event, PluginEventData* Data);
 